@@ -0,0 +1,534 @@
+/**
+ * @file    alignment.cpp
+ * @brief   Pairwise alignment of nucleotide sequences
+ * @author  Bryan Bartley
+ * @email   bartleyba@sbolstandard.org
+ *
+ * <!--------------------------------------------------------------------------
+ * This file is part of libSBOL.  Please visit http://sbolstandard.org for more
+ * information about SBOL, and the latest version of libSBOL.
+ *
+ *  Copyright 2016 University of Washington, WA, USA
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ------------------------------------------------------------------------->*/
+
+#include "document.h"
+
+#include <algorithm>
+#include <climits>
+
+// See sequence.cpp. The striped kernels use SSE2, which is part of the x86-64 baseline, or AVX2 where the processor supports it
+#if defined(__SSE2__) || defined(_M_X64)
+#define SBOL_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SBOL_SIMD_AVX2
+#define SBOL_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(__AVX2__)
+#define SBOL_SIMD_AVX2
+#define SBOL_TARGET_AVX2
+#include <immintrin.h>
+#endif
+
+using namespace sbol;
+using namespace std;
+
+// Scoring scheme. A gap of k bases costs GAP_OPEN + (k - 1) * GAP_EXTEND. Ambiguous bases, eg, n, score 0 against any base,
+// so that an unresolved region of a sequencing read neither breaks nor extends an alignment.
+const int MATCH = 2;
+const int MISMATCH = 3;
+const int GAP_OPEN = 5;
+const int GAP_EXTEND = 2;
+
+// Bases are encoded as a, c, g, t (or u) = 0-3. Other symbols are AMBIGUOUS.
+const uint8_t AMBIGUOUS_BASE = 4;
+const int N_BASE_CODES = 5;
+
+vector<uint8_t> encode_bases(const string& nucleotides)
+{
+    vector<uint8_t> codes(nucleotides.size());
+    for (size_t i = 0; i < nucleotides.size(); ++i)
+    {
+        switch (nucleotides[i] | 0x20)
+        {
+            case 'a': codes[i] = 0; break;
+            case 'c': codes[i] = 1; break;
+            case 'g': codes[i] = 2; break;
+            case 't': case 'u': codes[i] = 3; break;
+            default: codes[i] = AMBIGUOUS_BASE;
+        }
+    }
+    return codes;
+};
+
+inline int substitution_score(uint8_t a, uint8_t b)
+{
+    if (a == AMBIGUOUS_BASE || b == AMBIGUOUS_BASE)
+        return 0;
+    return a == b ? MATCH : -MISMATCH;
+};
+
+// The score of the best local alignment, and the positions of its last aligned bases. Ties are broken in favor of the
+// earliest position in b, then in a. overflow is set if a 16-bit kernel saturated, in which case the score is not reliable.
+struct AlignmentEnd
+{
+    int score;
+    size_t a_end;
+    size_t b_end;
+    bool overflow;
+};
+
+// Smith-Waterman alignment with affine gaps (Gotoh), in linear memory. This is the reference for the striped kernels,
+// and it is used when they are unavailable or overflow.
+AlignmentEnd local_alignment_end(const uint8_t* a, size_t m, const uint8_t* b, size_t n)
+{
+    const int NEG = INT_MIN / 2;
+    vector<int> h(m, 0);    // The previous column of H
+    vector<int> e(m, NEG);  // The gap in a which is open at each row
+    AlignmentEnd best = { 0, 0, 0, false };
+    for (size_t j = 0; j < n; ++j)
+    {
+        int h_diag = 0;
+        int h_up = 0;
+        int f = NEG;
+        int column_max = 0;
+        size_t i_column_max = 0;
+        for (size_t i = 0; i < m; ++i)
+        {
+            f = max(f - GAP_EXTEND, h_up - GAP_OPEN);
+            int h_ij = max(max(0, h_diag + substitution_score(a[i], b[j])), max(e[i], f));
+            h_diag = h[i];
+            h[i] = h_ij;
+            h_up = h_ij;
+            e[i] = max(e[i] - GAP_EXTEND, h_ij - GAP_OPEN);
+            if (h_ij > column_max)
+            {
+                column_max = h_ij;
+                i_column_max = i;
+            }
+        }
+        if (column_max > best.score)
+        {
+            best.score = column_max;
+            best.a_end = i_column_max;
+            best.b_end = j;
+        }
+    }
+    return best;
+};
+
+// Builds the striped query profile used by Farrar's algorithm. Position i of a is held in lane i / seg_len of vector
+// i % seg_len, so the dependency between neighbouring positions runs between vectors rather than between lanes. Padding
+// positions past the end of a score too low to be part of any alignment.
+vector<int16_t> striped_profile(const uint8_t* a, size_t m, size_t seg_len, size_t n_lanes)
+{
+    vector<int16_t> profile(N_BASE_CODES * seg_len * n_lanes);
+    for (int code = 0; code < N_BASE_CODES; ++code)
+        for (size_t i = 0; i < seg_len; ++i)
+            for (size_t lane = 0; lane < n_lanes; ++lane)
+            {
+                size_t pos = lane * seg_len + i;
+                profile[(code * seg_len + i) * n_lanes + lane] = pos < m ? substitution_score(a[pos], code) : SHRT_MIN / 2;
+            }
+    return profile;
+};
+
+// Finds the first position in a whose score in a striped column equals the column's maximum. matching_lanes has a bit
+// set for each lane in which the maximum occurs, so only the first of those lanes is searched.
+size_t striped_position(const vector<int16_t>& h, size_t seg_len, size_t n_lanes, unsigned matching_lanes, int score)
+{
+    size_t lane = 0;
+    while (!(matching_lanes & (1u << lane)))
+        ++lane;
+    size_t i = 0;
+    while (h[i * n_lanes + lane] != score)
+        ++i;
+    return lane * seg_len + i;
+};
+
+#ifdef SBOL_SIMD_SSE2
+// Shifts the 16-bit lanes of a vector up by the given number of lanes, shifting in the lowest score
+inline __m128i shift_lanes_sse2(__m128i x, int n_shift)
+{
+    switch (n_shift)
+    {
+        case 1: return _mm_or_si128(_mm_slli_si128(x, 2), _mm_setr_epi16(SHRT_MIN, 0, 0, 0, 0, 0, 0, 0));
+        case 2: return _mm_or_si128(_mm_slli_si128(x, 4), _mm_setr_epi16(SHRT_MIN, SHRT_MIN, 0, 0, 0, 0, 0, 0));
+        default: return _mm_or_si128(_mm_slli_si128(x, 8), _mm_setr_epi16(SHRT_MIN, SHRT_MIN, SHRT_MIN, SHRT_MIN, 0, 0, 0, 0));
+    }
+};
+
+// Striped Smith-Waterman with 8 lanes of 16-bit scores. Farrar's lazy loop, which corrects vertical gaps that cross from
+// one lane to the next, degrades when the sequences are similar, because a gap opened from a high-scoring cell stays
+// competitive for many rows. That is the usual case for a Build and its Design, so vertical gaps are instead resolved with
+// a prefix scan (Daily, 2016): the scores without vertical gaps are computed first, gaps within each lane are carried
+// down the lane, gaps between lanes are carried across in log2(lanes) steps, and the column is then completed in a
+// second pass. The cost is independent of the scores.
+AlignmentEnd local_alignment_end_sse2(const uint8_t* a, size_t m, const uint8_t* b, size_t n)
+{
+    const size_t n_lanes = 8;
+    size_t seg_len = (m + n_lanes - 1) / n_lanes;
+    vector<int16_t> profile = striped_profile(a, m, seg_len, n_lanes);
+    vector<int16_t> h_load(seg_len * n_lanes, 0);
+    vector<int16_t> h_store(seg_len * n_lanes, 0);
+    vector<int16_t> e(seg_len * n_lanes, SHRT_MIN);
+    vector<int16_t> f(seg_len * n_lanes, SHRT_MIN);
+    const __m128i gap_open = _mm_set1_epi16(GAP_OPEN);
+    const __m128i gap_extend = _mm_set1_epi16(GAP_EXTEND);
+    const __m128i zero = _mm_setzero_si128();
+    AlignmentEnd best = { 0, 0, 0, false };
+    for (size_t j = 0; j < n; ++j)
+    {
+        const int16_t* scores = &profile[b[j] * seg_len * n_lanes];
+        __m128i v_h = _mm_slli_si128(_mm_loadu_si128((const __m128i*)&h_store[(seg_len - 1) * n_lanes]), 2);
+        __m128i v_h_above = _mm_set1_epi16(SHRT_MIN);
+        __m128i v_f = _mm_set1_epi16(SHRT_MIN);
+        h_load.swap(h_store);
+
+        // Scores without vertical gaps, and the vertical gaps within each lane
+        for (size_t i = 0; i < seg_len; ++i)
+        {
+            v_f = _mm_max_epi16(_mm_subs_epi16(v_f, gap_extend), _mm_subs_epi16(v_h_above, gap_open));
+            _mm_storeu_si128((__m128i*)&f[i * n_lanes], v_f);
+            __m128i v_e = _mm_loadu_si128((const __m128i*)&e[i * n_lanes]);
+            v_h = _mm_adds_epi16(v_h, _mm_loadu_si128((const __m128i*)(scores + i * n_lanes)));
+            v_h = _mm_max_epi16(_mm_max_epi16(v_h, zero), v_e);
+            _mm_storeu_si128((__m128i*)&h_store[i * n_lanes], v_h);
+            v_h_above = v_h;
+            v_h = _mm_loadu_si128((const __m128i*)&h_load[i * n_lanes]);
+        }
+
+        // Vertical gaps carried into each lane from the lanes above
+        v_f = _mm_max_epi16(_mm_subs_epi16(v_f, gap_extend), _mm_subs_epi16(v_h_above, gap_open));
+        __m128i v_carry = shift_lanes_sse2(v_f, 1);
+        for (int n_shift = 1; n_shift < (int)n_lanes; n_shift *= 2)
+        {
+            __m128i decay = _mm_set1_epi16((int16_t)min((size_t)SHRT_MAX, n_shift * seg_len * GAP_EXTEND));
+            v_carry = _mm_max_epi16(v_carry, _mm_subs_epi16(shift_lanes_sse2(v_carry, n_shift), decay));
+        }
+
+        __m128i v_max = zero;
+        for (size_t i = 0; i < seg_len; ++i)
+        {
+            v_f = _mm_max_epi16(_mm_loadu_si128((const __m128i*)&f[i * n_lanes]), v_carry);
+            v_h = _mm_max_epi16(_mm_loadu_si128((const __m128i*)&h_store[i * n_lanes]), v_f);
+            _mm_storeu_si128((__m128i*)&h_store[i * n_lanes], v_h);
+            v_max = _mm_max_epi16(v_max, v_h);
+            __m128i v_e = _mm_loadu_si128((const __m128i*)&e[i * n_lanes]);
+            _mm_storeu_si128((__m128i*)&e[i * n_lanes], _mm_max_epi16(_mm_subs_epi16(v_e, gap_extend), _mm_subs_epi16(v_h, gap_open)));
+            v_carry = _mm_subs_epi16(v_carry, gap_extend);
+        }
+
+        int16_t lanes[8];
+        _mm_storeu_si128((__m128i*)lanes, v_max);
+        int column_max = *max_element(lanes, lanes + n_lanes);
+        if (column_max > best.score)
+        {
+            best.score = column_max;
+            __m128i v_score = _mm_set1_epi16((int16_t)column_max);
+            __m128i v_matches = zero;
+            for (size_t i = 0; i < seg_len; ++i)
+                v_matches = _mm_or_si128(v_matches, _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i*)&h_store[i * n_lanes]), v_score));
+            unsigned byte_mask = _mm_movemask_epi8(v_matches);
+            unsigned matching_lanes = 0;
+            for (size_t lane = 0; lane < n_lanes; ++lane)
+                if (byte_mask & (1u << (2 * lane)))
+                    matching_lanes |= 1u << lane;
+            best.a_end = striped_position(h_store, seg_len, n_lanes, matching_lanes, column_max);
+            best.b_end = j;
+        }
+    }
+    best.overflow = best.score > SHRT_MAX - MATCH;
+    return best;
+};
+#endif
+
+#ifdef SBOL_SIMD_AVX2
+bool alignment_has_avx2()
+{
+#ifdef __GNUC__
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return true;
+#endif
+};
+
+// Shifts the 16-bit lanes of a vector up by the given number of lanes, across the 128-bit halves, shifting in the lowest score
+SBOL_TARGET_AVX2 __m256i shift_lanes_avx2(__m256i x, int n_shift)
+{
+    __m256i low_half = _mm256_permute2x128_si256(x, x, 0x08);  // The low half of x moved to the high half, with zeros below
+    switch (n_shift)
+    {
+        case 1: return _mm256_or_si256(_mm256_alignr_epi8(x, low_half, 14), _mm256_setr_epi16(SHRT_MIN, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0));
+        case 2: return _mm256_or_si256(_mm256_alignr_epi8(x, low_half, 12), _mm256_setr_epi16(SHRT_MIN, SHRT_MIN, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0));
+        case 4: return _mm256_or_si256(_mm256_alignr_epi8(x, low_half, 8), _mm256_setr_epi16(SHRT_MIN, SHRT_MIN, SHRT_MIN, SHRT_MIN, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0));
+        default: return _mm256_or_si256(low_half, _mm256_setr_epi16(SHRT_MIN, SHRT_MIN, SHRT_MIN, SHRT_MIN, SHRT_MIN, SHRT_MIN, SHRT_MIN, SHRT_MIN, 0, 0, 0, 0, 0, 0, 0, 0));
+    }
+};
+
+// As local_alignment_end_sse2, with 16 lanes
+SBOL_TARGET_AVX2 AlignmentEnd local_alignment_end_avx2(const uint8_t* a, size_t m, const uint8_t* b, size_t n)
+{
+    const size_t n_lanes = 16;
+    size_t seg_len = (m + n_lanes - 1) / n_lanes;
+    vector<int16_t> profile = striped_profile(a, m, seg_len, n_lanes);
+    vector<int16_t> h_load(seg_len * n_lanes, 0);
+    vector<int16_t> h_store(seg_len * n_lanes, 0);
+    vector<int16_t> e(seg_len * n_lanes, SHRT_MIN);
+    vector<int16_t> f(seg_len * n_lanes, SHRT_MIN);
+    const __m256i gap_open = _mm256_set1_epi16(GAP_OPEN);
+    const __m256i gap_extend = _mm256_set1_epi16(GAP_EXTEND);
+    const __m256i zero = _mm256_setzero_si256();
+    AlignmentEnd best = { 0, 0, 0, false };
+    for (size_t j = 0; j < n; ++j)
+    {
+        const int16_t* scores = &profile[b[j] * seg_len * n_lanes];
+        __m256i v_h = _mm256_andnot_si256(_mm256_set1_epi16(SHRT_MIN), shift_lanes_avx2(_mm256_loadu_si256((const __m256i*)&h_store[(seg_len - 1) * n_lanes]), 1));
+        __m256i v_h_above = _mm256_set1_epi16(SHRT_MIN);
+        __m256i v_f = _mm256_set1_epi16(SHRT_MIN);
+        h_load.swap(h_store);
+
+        // Scores without vertical gaps, and the vertical gaps within each lane
+        for (size_t i = 0; i < seg_len; ++i)
+        {
+            v_f = _mm256_max_epi16(_mm256_subs_epi16(v_f, gap_extend), _mm256_subs_epi16(v_h_above, gap_open));
+            _mm256_storeu_si256((__m256i*)&f[i * n_lanes], v_f);
+            __m256i v_e = _mm256_loadu_si256((const __m256i*)&e[i * n_lanes]);
+            v_h = _mm256_adds_epi16(v_h, _mm256_loadu_si256((const __m256i*)(scores + i * n_lanes)));
+            v_h = _mm256_max_epi16(_mm256_max_epi16(v_h, zero), v_e);
+            _mm256_storeu_si256((__m256i*)&h_store[i * n_lanes], v_h);
+            v_h_above = v_h;
+            v_h = _mm256_loadu_si256((const __m256i*)&h_load[i * n_lanes]);
+        }
+
+        // Vertical gaps carried into each lane from the lanes above
+        v_f = _mm256_max_epi16(_mm256_subs_epi16(v_f, gap_extend), _mm256_subs_epi16(v_h_above, gap_open));
+        __m256i v_carry = shift_lanes_avx2(v_f, 1);
+        for (int n_shift = 1; n_shift < (int)n_lanes; n_shift *= 2)
+        {
+            __m256i decay = _mm256_set1_epi16((int16_t)min((size_t)SHRT_MAX, n_shift * seg_len * GAP_EXTEND));
+            v_carry = _mm256_max_epi16(v_carry, _mm256_subs_epi16(shift_lanes_avx2(v_carry, n_shift), decay));
+        }
+
+        __m256i v_max = zero;
+        for (size_t i = 0; i < seg_len; ++i)
+        {
+            v_f = _mm256_max_epi16(_mm256_loadu_si256((const __m256i*)&f[i * n_lanes]), v_carry);
+            v_h = _mm256_max_epi16(_mm256_loadu_si256((const __m256i*)&h_store[i * n_lanes]), v_f);
+            _mm256_storeu_si256((__m256i*)&h_store[i * n_lanes], v_h);
+            v_max = _mm256_max_epi16(v_max, v_h);
+            __m256i v_e = _mm256_loadu_si256((const __m256i*)&e[i * n_lanes]);
+            _mm256_storeu_si256((__m256i*)&e[i * n_lanes], _mm256_max_epi16(_mm256_subs_epi16(v_e, gap_extend), _mm256_subs_epi16(v_h, gap_open)));
+            v_carry = _mm256_subs_epi16(v_carry, gap_extend);
+        }
+
+        int16_t lanes[16];
+        _mm256_storeu_si256((__m256i*)lanes, v_max);
+        int column_max = *max_element(lanes, lanes + n_lanes);
+        if (column_max > best.score)
+        {
+            best.score = column_max;
+            __m256i v_score = _mm256_set1_epi16((int16_t)column_max);
+            __m256i v_matches = zero;
+            for (size_t i = 0; i < seg_len; ++i)
+                v_matches = _mm256_or_si256(v_matches, _mm256_cmpeq_epi16(_mm256_loadu_si256((const __m256i*)&h_store[i * n_lanes]), v_score));
+            unsigned byte_mask = _mm256_movemask_epi8(v_matches);
+            unsigned matching_lanes = 0;
+            for (size_t lane = 0; lane < n_lanes; ++lane)
+                if (byte_mask & (1u << (2 * lane)))
+                    matching_lanes |= 1u << lane;
+            best.a_end = striped_position(h_store, seg_len, n_lanes, matching_lanes, column_max);
+            best.b_end = j;
+        }
+    }
+    best.overflow = best.score > SHRT_MAX - MATCH;
+    return best;
+};
+#endif
+
+AlignmentEnd find_alignment_end(const uint8_t* a, size_t m, const uint8_t* b, size_t n, bool vectorize)
+{
+    if (m == 0 || n == 0)
+        return { 0, 0, 0, false };
+    if (vectorize)
+    {
+        AlignmentEnd end = { 0, 0, 0, true };
+#if defined(SBOL_SIMD_AVX2)
+        if (alignment_has_avx2())
+            end = local_alignment_end_avx2(a, m, b, n);
+        else
+#endif
+#if defined(SBOL_SIMD_SSE2)
+            end = local_alignment_end_sse2(a, m, b, n);
+#endif
+        if (!end.overflow)
+            return end;
+    }
+    return local_alignment_end(a, m, b, n);
+};
+
+// Global alignment with affine gaps of a and b, restricted to the cells within a band around the diagonal which joins
+// their ends. Fills the aligned strings with the characters of a_str and b_str, and '-' for gaps, and returns the score.
+int banded_global_alignment(const uint8_t* a, const char* a_str, size_t m, const uint8_t* b, const char* b_str, size_t n, size_t band, string& a_aligned, string& b_aligned)
+{
+    const int NEG = INT_MIN / 2;
+    const uint8_t FROM_E = 1;          // H is a gap in a
+    const uint8_t FROM_F = 2;          // H is a gap in b
+    const uint8_t E_EXTENDED = 4;      // The gap in a extends a gap in the previous column
+    const uint8_t F_EXTENDED = 8;      // The gap in b extends a gap in the previous row
+
+    // Row i holds the columns j = i - band_below ... i + band_above
+    size_t band_below = band + (m > n ? m - n : 0);
+    size_t band_above = band + (n > m ? n - m : 0);
+    size_t width = band_below + band_above + 1;
+    vector<uint8_t> traceback((m + 1) * width, 0);
+    vector<int> h_prev(width + 2, NEG), e_prev(width + 2, NEG), f_prev(width + 2, NEG);
+    vector<int> h_row(width + 2, NEG), e_row(width + 2, NEG), f_row(width + 2, NEG);
+
+    // Cell (i, j) is at offset j - i + band_below + 1 of row i, so the cell above (i - 1, j) is at the next offset of row i - 1
+    for (size_t i = 0; i <= m; ++i)
+    {
+        fill(h_row.begin(), h_row.end(), NEG);
+        fill(e_row.begin(), e_row.end(), NEG);
+        fill(f_row.begin(), f_row.end(), NEG);
+        size_t j_begin = i > band_below ? i - band_below : 0;
+        size_t j_end = min(n, i + band_above);
+        for (size_t j = j_begin; j <= j_end; ++j)
+        {
+            size_t k = j + band_below + 1 - i;
+            uint8_t& tb = traceback[i * width + k - 1];
+            if (i == 0 && j == 0)
+            {
+                h_row[k] = 0;
+                continue;
+            }
+            int e_ij = NEG;
+            if (j > 0)
+            {
+                int e_open = h_row[k - 1] - GAP_OPEN;
+                int e_extend = e_row[k - 1] - GAP_EXTEND;
+                e_ij = max(e_open, e_extend);
+                if (e_extend > e_open)
+                    tb |= E_EXTENDED;
+            }
+            int f_ij = NEG;
+            if (i > 0)
+            {
+                int f_open = h_prev[k + 1] - GAP_OPEN;
+                int f_extend = f_prev[k + 1] - GAP_EXTEND;
+                f_ij = max(f_open, f_extend);
+                if (f_extend > f_open)
+                    tb |= F_EXTENDED;
+            }
+            int h_ij = NEG;
+            if (i > 0 && j > 0)
+                h_ij = h_prev[k] + substitution_score(a[i - 1], b[j - 1]);
+            if (e_ij > h_ij)
+            {
+                h_ij = e_ij;
+                tb |= FROM_E;
+            }
+            if (f_ij > h_ij)
+            {
+                h_ij = f_ij;
+                tb = (tb & ~FROM_E) | FROM_F;
+            }
+            h_row[k] = h_ij;
+            e_row[k] = e_ij;
+            f_row[k] = f_ij;
+        }
+        h_prev.swap(h_row);
+        e_prev.swap(e_row);
+        f_prev.swap(f_row);
+    }
+    int score = h_prev[n + band_below + 1 - m];
+
+    // Trace the alignment back from the last cell
+    a_aligned.clear();
+    b_aligned.clear();
+    size_t i = m;
+    size_t j = n;
+    enum { IN_H, IN_E, IN_F } state = IN_H;
+    while (i > 0 || j > 0)
+    {
+        uint8_t tb = traceback[i * width + j + band_below - i];
+        if (state == IN_H)
+        {
+            if (tb & FROM_E)
+                state = IN_E;
+            else if (tb & FROM_F)
+                state = IN_F;
+            else
+            {
+                a_aligned.push_back(a_str[--i]);
+                b_aligned.push_back(b_str[--j]);
+                continue;
+            }
+        }
+        if (state == IN_E)
+        {
+            a_aligned.push_back('-');
+            b_aligned.push_back(b_str[--j]);
+            if (!(tb & E_EXTENDED))
+                state = IN_H;
+        }
+        else
+        {
+            a_aligned.push_back(a_str[--i]);
+            b_aligned.push_back('-');
+            if (!(tb & F_EXTENDED))
+                state = IN_H;
+        }
+    }
+    reverse(a_aligned.begin(), a_aligned.end());
+    reverse(b_aligned.begin(), b_aligned.end());
+    return score;
+};
+
+SequenceAlignment sbol::align_sequences(const std::string& target, const std::string& query, bool vectorize)
+{
+    SequenceAlignment alignment = { 0, 0, 0, 0, 0, "", "" };
+    vector<uint8_t> a = encode_bases(target);
+    vector<uint8_t> b = encode_bases(query);
+
+    // Find where the best local alignment ends, then where it begins by aligning the reversed sequences up to that point
+    AlignmentEnd end = find_alignment_end(a.data(), a.size(), b.data(), b.size(), vectorize);
+    if (end.score <= 0)
+        return alignment;
+    vector<uint8_t> a_reversed(a.rend() - end.a_end - 1, a.rend());
+    vector<uint8_t> b_reversed(b.rend() - end.b_end - 1, b.rend());
+    AlignmentEnd start = find_alignment_end(a_reversed.data(), a_reversed.size(), b_reversed.data(), b_reversed.size(), vectorize);
+    alignment.score = end.score;
+    alignment.target_start = end.a_end - start.a_end;
+    alignment.target_end = end.a_end + 1;
+    alignment.query_start = end.b_end - start.b_end;
+    alignment.query_end = end.b_end + 1;
+
+    // Trace the alignment between its ends. The aligned regions are usually of similar length, eg, a Build and its Design, so
+    // a narrow band suffices; the band is widened until the alignment recovers the best local score.
+    size_t m = alignment.target_end - alignment.target_start;
+    size_t n = alignment.query_end - alignment.query_start;
+    for (size_t band = 32; ; band *= 2)
+    {
+        int score = banded_global_alignment(&a[alignment.target_start], &target[alignment.target_start], m,
+                                            &b[alignment.query_start], &query[alignment.query_start], n,
+                                            band, alignment.target, alignment.query);
+        if (score >= alignment.score || band >= max(m, n))
+            break;
+    }
+    return alignment;
+};
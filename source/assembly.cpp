@@ -28,7 +28,10 @@
 #include <stdio.h>
 #include <algorithm>
 #include <unordered_map>
+#include <unordered_set>
 #include <queue>
+#include <thread>
+#include <exception>
 
 using namespace std;
 using namespace sbol;
@@ -509,9 +512,11 @@ string Sequence::assemble(string composite_sequence)
         
         Range& r = *ranges[0];
         r.start.set((int)composite_sequence.size() + 1);
-        r.end.set((int)composite_sequence.size() + (int)seq.elements.get().size());
+        r.end.set((int)composite_sequence.size() + seq.length());
                   
         // Validate parent sequence element are same as this one
+        if (r.orientation.get() == SBOL_ORIENTATION_REVERSE_COMPLEMENT)
+            return seq.reverseComplement();
         return seq.elements.get();
     }
 
@@ -601,7 +606,11 @@ string Sequence::assemble(string composite_sequence)
             Range& r = *ranges[0];
             r.start.set((int)composite_sequence.size() + 1);
                                 
-            composite_sequence = composite_sequence + seq.assemble(composite_sequence);  // Recursive call
+            // A subcomponent on the reverse strand contributes the reverse complement of its sequence
+            std::string subcomponent_sequence = seq.assemble(composite_sequence);  // Recursive call
+            if (r.orientation.get() == SBOL_ORIENTATION_REVERSE_COMPLEMENT)
+                subcomponent_sequence = reverse_complement(subcomponent_sequence);
+            composite_sequence = composite_sequence + subcomponent_sequence;
             //composite_sequence = composite_sequence + seq.assemble();  // Recursive call
                                 
             r.end.set((int)composite_sequence.size());
@@ -1114,92 +1123,111 @@ int FunctionalComponent::isMasked()
     return 0;
 };
 
-vector<ComponentDefinition*> ComponentDefinition::applyToComponentHierarchy(void (*callback_fn)(ComponentDefinition *, void *), void* user_data)
-{
-    /* Assumes parent_component is an SBOL data structure of the general form ComponentDefinition(->Component->ComponentDefinition)n where n+1 is an integer describing how many hierarchical levels are in the SBOL structure */
-    /* Look at each of the ComponentDef's SequenceAnnotations, is the target base there? */
-    if (!doc)
-        throw SBOLError(SBOL_ERROR_MISSING_DOCUMENT, "Cannot traverse Component hierarchy without a Document");
-
-    bool GET_ALL = true;
-    vector<ComponentDefinition*> component_nodes;
-    if (components.size() == 0)
-    {
-//        cout << "Adding subcomponent : " << identity.get() << endl;
-        component_nodes.push_back(this);  // Add leaf components
+// Iteratively flattens a hierarchy of definitions, eg, ComponentDefinition(->Component->ComponentDefinition)n, in depth-first
+// pre-order. The callback, if any, is applied to each definition as it is visited. If unique is true, a definition shared by
+// several parents is visited once, otherwise it is visited once for every instance.
+template < class SBOLClass, class SubClass >
+vector<SBOLClass*> flatten_hierarchy(SBOLClass* root, OwnedObject<SubClass> SBOLClass::* subobjects, bool unique, void (*callback_fn)(SBOLClass *, void *), void* user_data)
+{
+    vector<SBOLClass*> nodes;
+    unordered_set<SBOLClass*> visited;
+    vector<SBOLClass*> stack = { root };
+    while (stack.size())
+    {
+        SBOLClass* node = stack.back();
+        stack.pop_back();
+        if (unique && !visited.insert(node).second)
+            continue;
+        nodes.push_back(node);
         if (callback_fn)
-            callback_fn(this, user_data);
-    }
-    else
-    {
-        if (GET_ALL)
+            callback_fn(node, user_data);
+
+        // Push children in reverse order, so they are visited in order
+        OwnedObject<SubClass>& children = node->*subobjects;
+        for (int i_child = children.size() - 1; i_child >= 0; --i_child)
         {
-//            cout << "Adding subcomponent : " << identity.get() << endl;
-            component_nodes.push_back(this);  // Add components with children
-            if (callback_fn)
-                callback_fn(this, user_data);
+            string definition_id = children[i_child].definition.get();
+            auto i_def = root->doc->SBOLObjects.find(definition_id);
+            SBOLClass* definition = NULL;
+            if (i_def != root->doc->SBOLObjects.end())
+                definition = dynamic_cast<SBOLClass*>(i_def->second);
+            else if (root->doc->find(definition_id))
+                definition = &root->doc->template get<SBOLClass>(definition_id);  // Resolves references by persistentIdentity
+            if (!definition)
+                throw SBOLError(SBOL_ERROR_NOT_FOUND, definition_id + " not found");
+            stack.push_back(definition);
         }
-        for (auto& subc : components)
+    }
+    return nodes;
+};
+
+// Applies a read-only callback to the nodes of a hierarchy, partitioning them across worker threads in contiguous blocks
+template < class SBOLClass >
+void apply_in_parallel(vector<SBOLClass*>& nodes, void (*callback_fn)(SBOLClass *, void *), void* user_data, int n_threads)
+{
+    size_t block_size = (nodes.size() + n_threads - 1) / n_threads;
+    vector<thread> workers;
+    vector<exception_ptr> errors(n_threads);
+    for (int i_thread = 0; i_thread < n_threads; ++i_thread)
+    {
+        size_t i_begin = i_thread * block_size;
+        size_t i_end = min(nodes.size(), i_begin + block_size);
+        if (i_begin >= i_end)
+            break;
+        workers.push_back(thread([&nodes, &errors, callback_fn, user_data, i_thread, i_begin, i_end]()
         {
-            if (!doc->find(subc.definition.get()))
+            try
             {
-//                std::cout << "Not found" << std::endl;
-                throw SBOLError(SBOL_ERROR_NOT_FOUND, subc.definition.get() + "not found");
+                for (size_t i_node = i_begin; i_node < i_end; ++i_node)
+                    callback_fn(nodes[i_node], user_data);
             }
-            ComponentDefinition& subcdef = doc->get<ComponentDefinition>(subc.definition.get());
-//            std::cout << subcdef.identity.get() << std::endl;
-//            cout << "Descending one level : " << subcdef.identity.get() << endl;
-            vector < sbol::ComponentDefinition* > subcomponents = subcdef.applyToComponentHierarchy(callback_fn, user_data);
-//            cout << "Found " << subcomponents.size() << " components" << std::endl;
-            component_nodes.reserve(component_nodes.size() + distance(subcomponents.begin(), subcomponents.end()));
-            component_nodes.insert(component_nodes.end(), subcomponents.begin(),subcomponents.end());
-        }
+            catch (...)
+            {
+                errors[i_thread] = current_exception();
+            }
+        }));
     }
-    return component_nodes;
+    for (auto & worker : workers)
+        worker.join();
+    for (auto & error : errors)
+        if (error)
+            rethrow_exception(error);
+};
+
+vector<ComponentDefinition*> ComponentDefinition::applyToComponentHierarchy(void (*callback_fn)(ComponentDefinition *, void *), void* user_data)
+{
+    if (!doc)
+        throw SBOLError(SBOL_ERROR_MISSING_DOCUMENT, "Cannot traverse Component hierarchy without a Document");
+    return flatten_hierarchy(this, &ComponentDefinition::components, false, callback_fn, user_data);
+};
+
+vector<ComponentDefinition*> ComponentDefinition::applyToUniqueComponentHierarchy(void (*callback_fn)(ComponentDefinition *, void *), void* user_data, int n_threads)
+{
+    if (!doc)
+        throw SBOLError(SBOL_ERROR_MISSING_DOCUMENT, "Cannot traverse Component hierarchy without a Document");
+    if (n_threads <= 1 || !callback_fn)
+        return flatten_hierarchy(this, &ComponentDefinition::components, true, callback_fn, user_data);
+    vector<ComponentDefinition*> cdefs = flatten_hierarchy< ComponentDefinition, Component >(this, &ComponentDefinition::components, true, NULL, NULL);
+    apply_in_parallel(cdefs, callback_fn, user_data, n_threads);
+    return cdefs;
 };
 
 vector<ModuleDefinition*> ModuleDefinition::applyToModuleHierarchy(void (*callback_fn)(ModuleDefinition *, void *), void* user_data)
 {
-    /* Assumes parent_component is an SBOL data structure of the general form ComponentDefinition(->Component->ComponentDefinition)n where n+1 is an integer describing how many hierarchical levels are in the SBOL structure */
-    /* Look at each of the ComponentDef's SequenceAnnotations, is the target base there? */
     if (!doc)
         throw SBOLError(SBOL_ERROR_MISSING_DOCUMENT, "Cannot traverse Component hierarchy without a Document");
-    
-    bool GET_ALL = true;
-    vector<ModuleDefinition*> module_nodes;
-    if (modules.size() == 0)
-    {
-        //        cout << "Adding subcomponent : " << identity.get() << endl;
-        module_nodes.push_back(this);  // Add leaf components
-        if (callback_fn)
-            callback_fn(this, user_data);
-    }
-    else
-    {
-        if (GET_ALL)
-        {
-            //            cout << "Adding subcomponent : " << identity.get() << endl;
-            module_nodes.push_back(this);  // Add components with children
-            if (callback_fn)
-                callback_fn(this, user_data);
-        }
-        for (auto& subm : modules)
-        {
-            if (!doc->find(subm.definition.get()))
-            {
-                //                std::cout << "Not found" << std::endl;
-                throw SBOLError(SBOL_ERROR_NOT_FOUND, subm.definition.get() + "not found");
-            }
-            ModuleDefinition& submdef = doc->get<ModuleDefinition>(subm.definition.get());
-            //            std::cout << subcdef.identity.get() << std::endl;
-            //            cout << "Descending one level : " << subcdef.identity.get() << endl;
-            vector < sbol::ModuleDefinition* > submodules = submdef.applyToModuleHierarchy(callback_fn, user_data);
-            //            cout << "Found " << subcomponents.size() << " components" << std::endl;
-            module_nodes.reserve(module_nodes.size() + distance(submodules.begin(), submodules.end()));
-            module_nodes.insert(module_nodes.end(), submodules.begin(),submodules.end());
-        }
-    }
-    return module_nodes;
+    return flatten_hierarchy(this, &ModuleDefinition::modules, false, callback_fn, user_data);
+};
+
+vector<ModuleDefinition*> ModuleDefinition::applyToUniqueModuleHierarchy(void (*callback_fn)(ModuleDefinition *, void *), void* user_data, int n_threads)
+{
+    if (!doc)
+        throw SBOLError(SBOL_ERROR_MISSING_DOCUMENT, "Cannot traverse Module hierarchy without a Document");
+    if (n_threads <= 1 || !callback_fn)
+        return flatten_hierarchy(this, &ModuleDefinition::modules, true, callback_fn, user_data);
+    vector<ModuleDefinition*> mdefs = flatten_hierarchy< ModuleDefinition, Module >(this, &ModuleDefinition::modules, true, NULL, NULL);
+    apply_in_parallel(mdefs, callback_fn, user_data, n_threads);
+    return mdefs;
 };
 
 
@@ -1635,7 +1663,7 @@ std::vector<ComponentDefinition*> ComponentDefinition::getPrimaryStructure()
 
 int Sequence::length()
 {
-    return elements.get().length();
+    return view().size();  // Does not copy or unpack the elements
 };
 
 // Driver function to sort the Ranges
@@ -1649,21 +1677,20 @@ bool compare_ranges(sbol::Range *a, sbol::Range *b)
     return false;
 }
 
-void is_regular(ComponentDefinition* cdef_node, void * user_data)
+// Checks the SequenceAnnotations of a single ComponentDefinition against its Sequence. Diagnostic messages are appended to the record.
+void check_regular(ComponentDefinition* cdef_node, Sequence& seq, VerificationRecord& record)
 {
-    // Assumes is_complete
+    // A ComponentDefinition without SequenceAnnotations is a leaf of the hierarchy and has no Ranges to check
+    if (cdef_node->sequenceAnnotations.size() == 0)
+        return;
 
-    struct ARG_LIST { bool * IS_REGULAR; string* msg; } args = *(struct ARG_LIST *)user_data;
-    
-    Sequence& seq = cdef_node->doc->get<Sequence>(cdef_node->sequences.get());
-    
     std::vector< sbol::Range* > ranges;  // Contains a list of primary sequence intervals for which new Components, CDefs, and Sequences will be instantiated
     for (auto & ann : cdef_node->sequenceAnnotations)
     {
         if ((ann.locations.size() == 0) || (ann.locations.size() > 1) || (ann.locations[0].type.compare(SBOL_RANGE)))
         {
-            *args.msg = *args.msg + "SequenceAnnotation " + ann.identity.get() + " is irregular. A regular SequenceAnnotation contains a single Range.\n";
-            *args.IS_REGULAR = false;
+            record.msg = record.msg + "SequenceAnnotation " + ann.identity.get() + " is irregular. A regular SequenceAnnotation contains a single Range.\n";
+            record.is_regular = false;
         }
         else
         {
@@ -1672,39 +1699,37 @@ void is_regular(ComponentDefinition* cdef_node, void * user_data)
             ranges.push_back(&r);
         }
     }
-    
+    if (ranges.size() == 0)
+        return;
+
     sort(ranges.begin(), ranges.end(), compare_ranges);
 
-    if (ranges.size() > 1)
+    for (auto i_r = ranges.begin(); i_r != std::prev(ranges.end()); ++i_r)
     {
-        std::vector < sbol::Range* > nested_ranges;
-        for (auto i_r = ranges.begin(); i_r != std::prev(ranges.end()); ++i_r)
+        Range& r_a = **i_r;
+        Range& r_b = **(std::next(i_r));
+        if (r_b.contains(r_a))
         {
-            Range& r_a = **i_r;
-            Range& r_b = **(std::next(i_r));
-            if (r_b.contains(r_a))
-            {
-                *args.msg = *args.msg + "Found nested Ranges. Range " + r_b.identity.get() + " contains " + r_a.identity.get() + "\n";
-                *args.IS_REGULAR = false;
-            }
-            else if (r_a.contains(r_b))
-            {
-                *args.msg = *args.msg + "Found nested Ranges. Range " + r_a.identity.get() + " contains " + r_b.identity.get() + "\n";
-                *args.IS_REGULAR = false;
-            }
-            else if (r_a.overlaps(r_b))
-            {
-                *args.msg = *args.msg + "Found overlappings Ranges. Range " + r_a.identity.get() + " and " + r_b.identity.get() + " overlap.\n";
-                *args.IS_REGULAR = false;
-            }
-            else if (!r_a.adjoins(r_b))
-            {
-                *args.msg = *args.msg + "Found gap between Ranges. Range " + r_a.identity.get() + " and " + r_b.identity.get() + " are separated by a gap.\n";
-                *args.IS_REGULAR = false;
-            }
+            record.msg = record.msg + "Found nested Ranges. Range " + r_b.identity.get() + " contains " + r_a.identity.get() + "\n";
+            record.is_regular = false;
+        }
+        else if (r_a.contains(r_b))
+        {
+            record.msg = record.msg + "Found nested Ranges. Range " + r_a.identity.get() + " contains " + r_b.identity.get() + "\n";
+            record.is_regular = false;
+        }
+        else if (r_a.overlaps(r_b))
+        {
+            record.msg = record.msg + "Found overlappings Ranges. Range " + r_a.identity.get() + " and " + r_b.identity.get() + " overlap.\n";
+            record.is_regular = false;
+        }
+        else if (!r_a.adjoins(r_b))
+        {
+            record.msg = record.msg + "Found gap between Ranges. Range " + r_a.identity.get() + " and " + r_b.identity.get() + " are separated by a gap.\n";
+            record.is_regular = false;
         }
     }
-    
+
     // Validate sum of Range intervals is equal to primary sequence length, in case there is a gap at the end or a Range's interval exceeds the primary sequence length
     int sum_of_ranges = 0;
     for (auto & r : ranges)
@@ -1713,57 +1738,78 @@ void is_regular(ComponentDefinition* cdef_node, void * user_data)
     }
     if (seq.length() != sum_of_ranges)
     {
-        *args.msg = *args.msg + "The sum of Range lengths is inconsistent with the Sequence length. (" + to_string(sum_of_ranges) + " != " + to_string(seq.length()) + ")\n";
-        *args.IS_REGULAR = false;
+        record.msg = record.msg + "The sum of Range lengths is inconsistent with the Sequence length. (" + to_string(sum_of_ranges) + " != " + to_string(seq.length()) + ")\n";
+        record.is_regular = false;
     }
-    
+
     // Check if Range's interval exceeds the primary sequence length
     Range& r_last = **std::prev(ranges.end());
     if (r_last.end.get() > seq.length())
     {
-        *args.msg = *args.msg + "The end coordinate of the last Range exceeds the end coordinate of the Sequence. (" + to_string(r_last.end.get()) + " != " + to_string(seq.length()) + ")\n";
-        *args.IS_REGULAR = false;
+        record.msg = record.msg + "The end coordinate of the last Range exceeds the end coordinate of the Sequence. (" + to_string(r_last.end.get()) + " != " + to_string(seq.length()) + ")\n";
+        record.is_regular = false;
     }
-    
-    if (!*args.IS_REGULAR)
+};
+
+void is_regular(ComponentDefinition* cdef_node, void * user_data)
+{
+    // Assumes is_complete
+    struct ARG_LIST { bool * IS_REGULAR; string* msg; } args = *(struct ARG_LIST *)user_data;
+
+    // Reuse the result of a previous check unless the ComponentDefinition, its children, or its Sequence have been modified since
+    Document& doc = *cdef_node->doc;
+    Sequence& seq = doc.get<Sequence>(cdef_node->sequences.get());
+    unsigned long long cdef_stamp = cdef_node->getModificationStamp();
+    unsigned long long seq_stamp = seq.getModificationStamp();
+    VerificationRecord& record = doc.verification_cache[cdef_node->identity.get()];
+    if (record.cdef_stamp != cdef_stamp || record.seq_stamp != seq_stamp)
     {
-        args.msg->erase(args.msg->length() - 1);  // Remove trailing newline
-        return;
+        record = { cdef_stamp, seq_stamp, true, "" };
+        check_regular(cdef_node, seq, record);
     }
-    
-    // Confirm regularity
-    *args.msg = "Regular.";
-    *args.IS_REGULAR = true;
-    return;
 
+    if (!record.is_regular)
+    {
+        *args.msg = *args.msg + record.msg;
+        *args.IS_REGULAR = false;
+    }
 };
 
 void is_complete(ComponentDefinition* cdef_node, void * user_data)
 {
-    
     struct ARG_LIST { bool * IS_COMPLETE; string* msg; } args = *(struct ARG_LIST *)user_data;
 
-    if (cdef_node->doc->find(cdef_node->sequences.get()))
+    // An exact identity is found in the Document's index. Otherwise the reference is resolved as is_regular resolves it,
+    // which accepts a persistentIdentity
+    Document& doc = *cdef_node->doc;
+    string seq_id = cdef_node->sequences.size() ? cdef_node->sequences.get() : "";
+    bool has_sequence = seq_id != "" && (doc.SBOLObjects.find(seq_id) != doc.SBOLObjects.end() || doc.find(seq_id));
+    if (seq_id != "" && !has_sequence)
     {
-        *args.msg = "Complete.";
-        *args.IS_COMPLETE = true;
-
+        try
+        {
+            doc.get<Sequence>(seq_id);
+            has_sequence = true;
+        }
+        catch (SBOLError&)
+        {
+        }
     }
-    else
+    if (!has_sequence)
     {
-        *args.msg = "Incomplete.";
+        *args.msg = *args.msg + "ComponentDefinition " + cdef_node->identity.get() + " does not have a Sequence in the Document.\n";
         *args.IS_COMPLETE = false;
-        return;
     }
 };
 
 
 bool ComponentDefinition::isRegular()
 {
-    string dummy;
-    isRegular(dummy);
-    std::cout << dummy << std::endl;
-    return isRegular(dummy);
+    string msg;
+    bool IS_REGULAR = isRegular(msg);
+    if (Config::getOption("verbose") == "True")
+        std::cout << msg << std::endl;
+    return IS_REGULAR;
 }
 
 bool ComponentDefinition::isRegular(std::string &msg)
@@ -1771,22 +1817,28 @@ bool ComponentDefinition::isRegular(std::string &msg)
     if (doc == NULL)
         throw SBOLError(SBOL_ERROR_MISSING_DOCUMENT, "ComponentDefinition " + identity.get() + " does not belong to a Document. Cannot verify complete.");
     
-    if (!isComplete())
+    if (!isComplete(msg))
         throw SBOLError(SBOL_ERROR_MISSING_DOCUMENT, "Incomplete. Cannot verify regular.");
     
-    bool IS_REGULAR;
+    // Shared sub-designs are checked only once
+    bool IS_REGULAR = true;
+    msg = "";
     struct ARG_LIST { bool * IS_REGULAR; string *msg; } args = { &IS_REGULAR, &msg };
-    vector<ComponentDefinition*> cdefs = this->applyToComponentHierarchy(is_regular,  &args);
-    msg = *args.msg;
+    applyToUniqueComponentHierarchy(is_regular, &args);
+    if (IS_REGULAR)
+        msg = "Regular.";
+    else
+        msg.erase(msg.length() - 1);  // Remove trailing newline
     return IS_REGULAR;
 };
 
 bool ComponentDefinition::isComplete()
 {
-    string dummy;
-    isComplete(dummy);
-    cout << dummy << endl;
-    return isComplete(dummy);
+    string msg;
+    bool IS_COMPLETE = isComplete(msg);
+    if (Config::getOption("verbose") == "True")
+        std::cout << msg << std::endl;
+    return IS_COMPLETE;
 }
 
 bool ComponentDefinition::isComplete(std::string &msg)
@@ -1794,10 +1846,14 @@ bool ComponentDefinition::isComplete(std::string &msg)
     if (doc == NULL)
         throw SBOLError(SBOL_ERROR_MISSING_DOCUMENT, "Cannot verify complete. ComponentDefinition " + identity.get() + " does not belong to a Document.");
     
-    bool IS_COMPLETE;
+    bool IS_COMPLETE = true;
+    msg = "";
     struct ARG_LIST { bool * IS_COMPLETE; string *msg; } args = { &IS_COMPLETE, &msg };
-    vector<ComponentDefinition*> cdefs = this->applyToComponentHierarchy(is_complete,  &args);
-    msg = *args.msg;
+    applyToUniqueComponentHierarchy(is_complete, &args);
+    if (IS_COMPLETE)
+        msg = "Complete.";
+    else
+        msg = "Incomplete. " + msg.erase(msg.length() - 1);
     return IS_COMPLETE;
 };
 
@@ -1809,177 +1865,160 @@ bool ComponentDefinition::isComplete(std::string &msg)
 //    return disassemble(dummy);
 //}
 
-void nest_ranges(std::vector < sbol::Range* > ranges, ComponentDefinition* cdef_node, std::string nucleotides)
+// State shared by every level of a disassembly, so the Document is only searched once for displayIds in use
+struct DisassemblyContext
+{
+    std::unordered_set<std::string> display_ids;  // displayIds already in use in the Document
+    int instance_count;  // Last instance number assigned to an autoconstructed flanking region
+    bool verbose;
+};
+
+// A Range on the primary sequence with its coordinates cached, so the sweep doesn't re-parse them from the property store
+struct RangeInterval
 {
-    std::cout << "Nesting Ranges" << std::endl;
-    if (ranges.size() <= 1)
+    int start;
+    int end;
+    sbol::Range* range;
+    ComponentDefinition* cdef_node;  // The ComponentDefinition whose SequenceAnnotation contains the Range
+};
+
+// Driver function to sort Ranges for the sweep. Ranges are sorted by start coordinate, then by descending
+// end coordinate, so an enclosing Range is always visited before the Ranges it contains
+bool compare_intervals(const RangeInterval& a, const RangeInterval& b)
+{
+    if (a.start != b.start)
+        return a.start < b.start;
+    return a.end > b.end;
+}
+
+void collect_display_ids(SBOLObject* obj, void* user_data)
+{
+    std::unordered_set<std::string>& display_ids = *(std::unordered_set<std::string>*)user_data;
+    auto i_id = obj->properties.find(SBOL_DISPLAY_ID);
+    if (i_id != obj->properties.end() && i_id->second.size() > 0)
     {
-        std::cout << "Stopping iteration" << std::endl;
-        return;
+        std::string display_id = i_id->second.front();
+        display_ids.insert(display_id.substr(1, display_id.length() - 2));  // Removes flanking " from the literal
+    }
+}
+
+// Instantiates a Sequence, ComponentDefinition and Component for a SequenceAnnotation that does not yet refer to a Component
+Component& instantiate_subcomponent(ComponentDefinition* cdef_node, SequenceAnnotation& ann, std::string elements)
+{
+    std::string display_id = ann.displayId.get();
+    size_t index = display_id.find("annotation");
+    if (index != std::string::npos)
+    {
+        display_id.replace(index, 10, "component");
     }
-    std::vector < sbol::Range* > processed_ranges;
-    std::vector < SequenceAnnotation* > removed_anns;
 
-    std::cout << "Iterating pairwise through Ranges" << std::endl;
-    Range& r_a = **ranges.begin();
-    Range& r_b = **std::next(ranges.begin());
+    Sequence& subseq = cdef_node->doc->sequences.create(display_id + "seq");
+    subseq.elements.set(elements);
+
+    ComponentDefinition& cd = cdef_node->doc->componentDefinitions.create(display_id);
+    cd.name.set(ann.name.get());
+    cd.sequences.set(subseq);
+    cd.roles.copy(ann.roles);
+    ann.roles.clear();
 
-    std::cout << cdef_node->identity.get() << std::endl;
-    std::cout << r_a.start.get() << r_a.end.get() << std::endl;
-    std::cout << r_b.start.get() << r_b.end.get() << std::endl;
+    Component& c = cdef_node->components.create(display_id);
+    c.definition.set(cd);
+    c.name.set(ann.name.get());
 
-    if (r_b.contains(r_a))
+    ann.component.set(c.identity.get());
+    return c;
+}
+
+// Autoconstructs a flanking SequenceAnnotation and Range to fill a gap between the Ranges of a ComponentDefinition
+Range& add_flanking_range(ComponentDefinition* cdef_node, int start, int end, DisassemblyContext& context)
+{
+    // Generate the displayId of the new SequenceAnnotation.  Check if an object with that displayId is already instantiated.
+    std::string display_id;
+    do
     {
-        // Nest ranges
-        std::cout << "Nesting Range A inside B" << std::endl;
-        std::cout << r_a.start.get() << "\t"  << r_a.end.get() << "\t"  << r_b.start.get() << "\t"  << r_b.end.get() << std::endl;
-    
-        SequenceAnnotation& ann_a = *(SequenceAnnotation*)r_a.parent;
-        SequenceAnnotation& ann_b = *(SequenceAnnotation*)r_b.parent;
-    
-        std::cout << "Removing old Annotation and Range ";
-        std::cout << ann_a.identity.get() << std::endl;
-        ann_a.locations.remove(r_a.identity.get());
-        cdef_node->sequenceAnnotations.remove(ann_a.identity.get());
-        std::cout << "Removed" << std::endl;
+        ++context.instance_count;
+        display_id = "annotation" + to_string(context.instance_count);
+    } while (context.display_ids.count(display_id));
+    context.display_ids.insert(display_id);
 
-        if (ann_b.component.size() == 0)
-        {
-            std::cout << "Instantiating new Component for annotation B : " << ann_b.identity.get() << std::endl;
-    
-            std::string display_id = ann_b.displayId.get();
-            size_t index = display_id.find("annotation");
-            if (index != std::string::npos)
-            {
-                display_id.replace(index, 10, "component");
-            }
-            std::cout << "Instantiating Sequence " << display_id << std::endl;
-            Sequence& subseq = cdef_node->doc->sequences.create(display_id + "seq");
-//            subseq.elements.set(nucleotides.substr(r_b.start.get() - 1, r_b.end.get() - r_b.start.get() + 1));
-    
-            std::cout << "Instantiating ComponentDefinition " << display_id << std::endl;
-            ComponentDefinition& cd = cdef_node->doc->componentDefinitions.create(display_id);
-            cd.name.set(ann_b.name.get());
-            cd.sequences.set(subseq);
-    
-            Component& c = cdef_node->components.create(display_id);
-            c.definition.set(cd);
-            c.name.set(ann_b.name.get());
-    
-            ann_b.component.set(c.identity.get());
-    
-                   std::cout << "Created subcomponent has been instantiated, creating nested Range" << std::endl;
-            SequenceAnnotation& new_ann = cd.sequenceAnnotations.create(ann_a.displayId.get());
-            Range& new_range = new_ann.locations.create<Range>(r_a.displayId.get());
-            new_range.start.set(r_a.start.get());
-            new_range.end.set(r_a.end.get());
-        }
-        else
-        {
-            std::cout << "Subcomponent already instantiated for B. Creating nested Range" << std::endl;
-            Component& c = cdef_node->components.get(ann_b.component.get());
-            ComponentDefinition& cd = cdef_node->doc->get<ComponentDefinition>(c.definition.get());
-            SequenceAnnotation& new_ann = cd.sequenceAnnotations.create(ann_a.displayId.get());
-            Range& new_range = new_ann.locations.create<Range>(r_a.displayId.get());
-            new_range.start.set(r_a.start.get());
-            new_range.end.set(r_a.end.get());
-            std::cout << "Created nested Range " << new_range.start.get() << new_range.end.get() << std::endl;
-    
-            // Should call recursive function here
-        }
-    
-        std::cout << "Freeing old Annotation and Range" << std::endl;
-        removed_anns.push_back(&ann_a);
-        for (auto i_r = std::next(ranges.begin()); i_r != ranges.end(); ++i_r)
-        {
-            processed_ranges.push_back(*i_r);
-        }
-    }
-    else if (r_a.contains(r_b))
+    if (context.verbose)
+        std::cout << "Adding flanking region from " << start << " to " << end << " in " << cdef_node->identity.get() << std::endl;
+
+    SequenceAnnotation& new_ann = cdef_node->sequenceAnnotations.create(display_id);
+    new_ann.roles.set(SO "0000239");  // Set to Sequence Ontology "flanking_sequence"
+    new_ann.name.set("flanking region " + to_string(context.instance_count));
+
+    Range& new_range = new_ann.locations.create<Range>("range" + to_string(context.instance_count));
+    new_range.start.set(start);
+    new_range.end.set(end);
+    new_range.parent = &new_ann;
+    return new_range;
+}
+
+// Sweeps once through the sorted Ranges of a ComponentDefinition, keeping a stack of the Ranges that enclose the current
+// position. A Range inside another is moved into the subcomponent of the enclosing Range, instantiating the subcomponent if
+// necessary, so the full nesting hierarchy is built in a single pass. A Range which partially overlaps the Range enclosing
+// it cannot be nested and is discarded.
+// @return The top-level Ranges, in sequential order
+std::vector < sbol::Range* > nest_ranges(std::vector < RangeInterval >& intervals, ComponentDefinition* cdef_node, std::string& nucleotides, int start_reference, DisassemblyContext& context)
+{
+    std::sort(intervals.begin(), intervals.end(), compare_intervals);
+
+    std::vector < sbol::Range* > top_level_ranges;
+    std::vector < RangeInterval > enclosing_intervals;  // Stack of open Ranges, innermost last
+    std::vector < SequenceAnnotation* > stale_anns;
+    for (auto & interval : intervals)
     {
-        std::cout << "Nesting Range B inside A" << std::endl;
-        std::cout << r_a.start.get() << "\t"  << r_a.end.get() << "\t"  << r_b.start.get() << "\t"  << r_b.end.get() << std::endl;
-    
-        SequenceAnnotation& ann_a = *(SequenceAnnotation*)r_a.parent;
-        SequenceAnnotation& ann_b = *(SequenceAnnotation*)r_b.parent;
-    
-//                std::cout << "Removing old Annotation and Range" << std::endl;
-        ann_b.locations.remove(r_b.identity.get());
-        cdef_node->sequenceAnnotations.remove(ann_b.identity.get());
-        
-        if (ann_a.component.size() == 0)
-        {
-            std::cout << "Instantiating new Component for annotation A : " << ann_a.identity.get() << std::endl;
-    
-            std::string display_id = ann_a.displayId.get();
-            size_t index = display_id.find("annotation");
-            if (index != std::string::npos)
-            {
-                display_id.replace(index, 10, "component");
-            }
-//                    std::cout << "Instantiating Sequence " << display_id << std::endl;
-            Sequence& subseq = cdef_node->doc->sequences.create(display_id + "seq");
-            subseq.elements.set(nucleotides.substr(r_a.start.get() - 1, r_a.end.get() - r_a.start.get() + 1));
-
-//                    std::cout << "Instantiating ComponentDefinition " << display_id << std::endl;
-            ComponentDefinition& cd = cdef_node->doc->componentDefinitions.create(display_id);
-            cd.name.set(ann_a.name.get());
-            cd.sequences.set(subseq);
-    
-            Component& c = cdef_node->components.create(display_id);
-            c.definition.set(cd);
-            c.name.set(ann_a.name.get());
-    
-            ann_a.component.set(c.identity.get());
-    
-//                    std::cout << "Now that subcompnent has been instantiated, creating nested Range" << std::endl;
-            SequenceAnnotation& new_ann = cd.sequenceAnnotations.create(ann_b.displayId.get());
-            Range& new_range = new_ann.locations.create<Range>(r_b.displayId.get());
-            new_range.start.set(r_b.start.get());
-            new_range.end.set(r_b.end.get());
+        // Close the Ranges that end before this one begins
+        while (enclosing_intervals.size() && enclosing_intervals.back().end < interval.start)
+            enclosing_intervals.pop_back();
 
-            std::cout << "Created nested Range " << new_range.start.get() << "\t" << new_range.end.get() << std::endl;
+        SequenceAnnotation& ann = *(SequenceAnnotation*)interval.range->parent;
+        if (enclosing_intervals.size() == 0)
+        {
+            top_level_ranges.push_back(interval.range);
+            enclosing_intervals.push_back(interval);
+            continue;
         }
-        else
+
+        RangeInterval& enclosing = enclosing_intervals.back();
+        if (interval.end > enclosing.end)
         {
-//                    std::cout << "Subcomponent already instantiated. Creating nested Range" << std::endl;
-            Component& c = cdef_node->components.get(ann_a.component.get());
-            ComponentDefinition& cd = cdef_node->doc->get<ComponentDefinition>(c.definition.get());
-            SequenceAnnotation& new_ann = cd.sequenceAnnotations.create(ann_b.displayId.get());
-            Range& new_range = new_ann.locations.create<Range>(r_b.displayId.get());
-            new_range.start.set(r_b.start.get());
-            new_range.end.set(r_b.end.get());
-            std::cout << "Created nested Range " << new_range.start.get() << "\t" << new_range.end.get() << std::endl;
+            if (context.verbose)
+                std::cout << "Discarding Range " << interval.range->identity.get() << " which overlaps " << enclosing.range->identity.get() << std::endl;
+            stale_anns.push_back(&ann);
+            continue;
         }
-    
-        std::cout << "Freeing old Annotation and Range" << std::endl;
-        processed_ranges.push_back(&r_a);
-        for (auto i_r = std::next(std::next(ranges.begin())); i_r != ranges.end(); ++i_r)
-            processed_ranges.push_back(*i_r);
-        removed_anns.push_back(&ann_b);
-    }
-    else
-    {
-        std::cout << "Range " << r_a.start.get() << "\t" << r_a.end.get() << " is Regular" << std::endl;
-        for (auto i_r = std::next(ranges.begin()); i_r != ranges.end(); ++i_r)
-            processed_ranges.push_back(*i_r);
+
+        // Nest this Range inside the subcomponent of the enclosing Range
+        SequenceAnnotation& enclosing_ann = *(SequenceAnnotation*)enclosing.range->parent;
+        if (enclosing_ann.component.size() == 0)
+            instantiate_subcomponent(enclosing.cdef_node, enclosing_ann, nucleotides.substr(enclosing.start - start_reference, enclosing.end - enclosing.start + 1));
+        Component& c = enclosing.cdef_node->components.get(enclosing_ann.component.get());
+        ComponentDefinition& cd = cdef_node->doc->get<ComponentDefinition>(c.definition.get());
+
+        if (context.verbose)
+            std::cout << "Nesting Range " << interval.start << "\t" << interval.end << " inside " << cd.identity.get() << std::endl;
+
+        SequenceAnnotation& new_ann = cd.sequenceAnnotations.create(ann.displayId.get());
+        new_ann.name.set(ann.name.get());
+        new_ann.roles.copy(ann.roles);
+        Range& new_range = new_ann.locations.create<Range>(interval.range->displayId.get());
+        new_range.start.set(interval.start);
+        new_range.end.set(interval.end);
+        new_range.parent = &new_ann;
+
+        stale_anns.push_back(&ann);
+        enclosing_intervals.push_back({ interval.start, interval.end, &new_range, &cd });
     }
-    std::cout << "Processed ranges" << std::endl;
-    for (auto i_r : processed_ranges)
-        std::cout << i_r << std::endl;
-    std::cout << "Removed ranges" << std::endl;
 
-    for (auto i_a : removed_anns)
+    // Free the old Annotations and Ranges
+    for (auto & stale_ann : stale_anns)
     {
-        SequenceAnnotation& ann = *i_a;
-        Range& r = ann.locations.get<Range>();
-        std::cout << &r << std::endl;
-        
+        cdef_node->sequenceAnnotations.remove(stale_ann->identity.get());
+        stale_ann->close();
     }
-
-    nest_ranges(processed_ranges, cdef_node, nucleotides);
-    for (auto & removed_ann : removed_anns)
-        removed_ann->close();
+    return top_level_ranges;
 }
 
 vector<SequenceAnnotation*> ComponentDefinition::sortSequenceAnnotations()
@@ -2003,362 +2042,92 @@ vector<SequenceAnnotation*> ComponentDefinition::sortSequenceAnnotations()
 };
 
 
-void disassemble(ComponentDefinition * cdef_node, int range_start)
+void disassemble(ComponentDefinition * cdef_node, int range_start, DisassemblyContext& context)
 {
-//    std::cout << "Dissembling " << cdef_node->identity.get() << " at " << range_start << std::endl;
+    if (context.verbose)
+        std::cout << "Disassembling " << cdef_node->identity.get() << " at " << range_start << std::endl;
 
-//    std::cout << "Getting sequence ";
     Sequence& seq = cdef_node->doc->get<Sequence>(cdef_node->sequences.get());
     std::string nucleotides = seq.elements.get();
     int start_reference = range_start;
     int end_reference = start_reference + nucleotides.length() - 1;
-    std::cout << nucleotides << std::endl;
 
     // Validate only one Range per SequenceAnnotation
-//    std::cout << "Validating ranges" << std::endl;
     if (cdef_node->sequenceAnnotations.size() == 0)
         return;
-    std::vector< sbol::Range* > ranges;
+    std::vector < RangeInterval > intervals;
     for (auto & ann : cdef_node->sequenceAnnotations)
     {
         if ((ann.locations.size() == 0) || (ann.locations.size() > 1) || (ann.locations[0].type.compare(SBOL_RANGE)))
             return;
         Range& r = ann.locations. template get<Range>();
         r.parent = &ann;  // This is a kludge.  For some reason the parent is not properly set, perhaps when copying the parent ComponentDefinition
-        ranges.push_back(&r);
+        intervals.push_back({ r.start.get(), r.end.get(), &r, cdef_node });
     }
-    
-//    std::cout << "Sorting " << to_string(ranges.size()) << " ranges" << std::endl;
-    sort(ranges.begin(), ranges.end(), compare_ranges);
-    
-//    std::cout << "Ranges sorted " << std::endl;
-    // Check if Ranges are ordered
-    for (auto & r : ranges)
-        std::cout << r->start.get() << "\t" << r->end.get() << std::endl;
 
-    std::vector < sbol::Range* > regularized_ranges;
-
-    if (ranges.size() == 1)
-    {
-//        std::cout << "Only one Range found" << std::endl;
+    // Remove nested and overlapping Ranges
+    std::vector < sbol::Range* > ranges = nest_ranges(intervals, cdef_node, nucleotides, start_reference, context);
 
-        // This needs to be fixed as the start and end depending where in the hierarchy the Range is located
-        Range& r = *ranges[0];
-        r.start.set(start_reference);
-        r.end.set(start_reference + seq.length() - 1);
-    }
-    else
-    {
-        // Remove nested and overlapping ranges, this should be implemented as a recursiv
-//        std::cout << "Checking for overlaps" << std::endl;
-
-        for (auto i_r = ranges.begin(); i_r != std::prev(ranges.end()); ++i_r)
-        {
-
-            Range& r_a = **i_r;
-            Range& r_b = **std::next(i_r);
-//            std::cout << "Iterating pairwise" << std::endl;
-            std::cout << r_a.start.get() << "\t" << r_a.end.get() << "\t" << r_b.start.get() << "\t" << r_b.end.get() << std::endl;
-
-            if (r_a.overlaps(r_b) && !r_a.contains(r_b) && !r_b.contains(r_a))
-            {
-                std::cout << "Overlapping ranges for Remove A or B?" << std::endl;
-                
-                SequenceAnnotation* ann_a = (SequenceAnnotation*)r_a.parent;
-                SequenceAnnotation* ann_b = (SequenceAnnotation*)r_b.parent;
-                std::cout << "A: " << ann_a->name.get() << "\t" << "B: " << ann_b->name.get() << std::endl;
-                char c = getchar();
-                if (c == 'A')
-                {
-                    regularized_ranges.push_back(&r_b);
-                    Location& loc = ann_a->locations.remove(r_a.identity.get());
-                }
-                else if (c == 'B')
-                {
-                    regularized_ranges.push_back(&r_a);
-                    Location& loc = ann_b->locations.remove(r_b.identity.get());
-                }
-                // Should call recursive function here
-            }
-            else if (i_r == (ranges.end() - 2))
-            {
-//                std::cout << "Adding two" << std::endl;
-
-                regularized_ranges.push_back(&r_a);
-                regularized_ranges.push_back(&r_b);
-            }
-            else
-            {
-//                std::cout << "Adding one" << std::endl;
-                regularized_ranges.push_back(&r_a);
-
-            }
-        }
-//        std::cout << "Freeing overlap annotations" << std::endl;
-
-        std::vector < SequenceAnnotation* > stale_anns;
-        for (auto & r : ranges)
-            if ( std::find(regularized_ranges.begin(), regularized_ranges.end(), r) == regularized_ranges.end() )
-            {
-                stale_anns.push_back((SequenceAnnotation*)r->parent);
-            }
-        for (auto & stale_ann : stale_anns)
-        {
-            cdef_node->sequenceAnnotations.remove(stale_ann->identity.get());
-            stale_ann->close();
-        }
-        
-
-
-        ranges = regularized_ranges;
-        for (auto & r : ranges)
-            std::cout << r->start.get() << "\t" << r->end.get() << std::endl;
-
-
-        nest_ranges(ranges, cdef_node, nucleotides);
-//        std::cout << "Leaving " << cdef_node->identity.get() << std::endl;
-
-    }
-
-    ranges.clear();
-    for (auto & ann : cdef_node->sequenceAnnotations)
-    {
-        Range& r = ann.locations. template get<Range>();
-        r.parent = &ann;  // This is a kludge.  For some reason the parent is not properly set, perhaps when copying the parent ComponentDefinition
-        ranges.push_back(&r);
-    }
-    
-//    std::cout << "Sorting " << to_string(ranges.size()) << " ranges" << std::endl;
-    sort(ranges.begin(), ranges.end(), compare_ranges);
-
-    for (auto & r : ranges)
-        std::cout << r->start.get() << "\t" << r->end.get() << std::endl;
-
-//    std::cout << "Checking for initial gap starting from " << start_reference << std::endl;
-    // Fill gap if first Range does not begin at the Sequence start
-    Range& r_first = **ranges.begin();
-    if (r_first.start.get() > start_reference)
-    {
-        int r_new_start = start_reference;
-        int r_new_end = r_first.start.get() - 1;
-        int l = r_new_end - r_new_start + 1;
-        string flanking_seq = nucleotides.substr(r_new_start - 1, l);
-//        std::cout << "Adding initial Range from " << r_new_start << " to " << r_new_end << std::endl;
-
-        // Generate URI of new SequenceAnnotation.  Check if an object with that URI is already instantiated.
-        int instance_count = 1;
-        string annotation_id = cdef_node->persistentIdentity.get() + "/annotation" + to_string(instance_count) + "/" + cdef_node->version.get();
-        while (cdef_node->doc->find_property_value(SBOL_DISPLAY_ID, "annotation" + to_string(instance_count)).size() > 0)
-        {
-            // Find the last instance assigned
-            ++instance_count;
-            annotation_id = cdef_node->persistentIdentity.get() +  "/annotation" + to_string(instance_count) + "/" + cdef_node->version.get();
-        }
-        SequenceAnnotation& new_ann = cdef_node->sequenceAnnotations.create("annotation" + to_string(instance_count));
-        new_ann.roles.set(SO "0000239");  // Set to Sequence Ontology "flanking_sequence"
-        new_ann.name.set("flanking region " + to_string(instance_count));
-
-        Range& new_range = new_ann.locations.create<Range>("range" + to_string(instance_count));
-        new_range.start.set(r_new_start);
-        new_range.end.set(r_new_end);
-        
-        // Append in order in the list of Ranges
-        ranges.insert(ranges.begin(), &new_range);
-    }
-    
-    // Check if Ranges are ordered
+    // Fill gaps before, between and after the top-level Ranges with flanking SequenceAnnotations / Ranges
+    std::vector < sbol::Range* > regularized_ranges;
+    int next_start = start_reference;  // The first coordinate not yet covered by a Range
     for (auto & r : ranges)
-        std::cout << r->start.get() << "\t" << r->end.get() << std::endl;
-
-    // Fill in gaps with flanking SequenceAnnotations / Ranges
-//    std::cout << "Filling gaps with flanking sequences" << std::endl;
-
-    std::vector < sbol::Range* > gapped_ranges = ranges;
-    ranges.clear();
-    for (auto i_r = gapped_ranges.begin(); i_r != std::prev(gapped_ranges.end()); ++i_r)
     {
-//        std::cout << "Iterating through Ranges" << std::endl;
-        Range& r_a = **i_r;
-        Range& r_b = **(std::next(i_r));
-        ranges.push_back(&r_a);
-        
-        if (!r_a.adjoins(r_b))
-        {
-//            std::cout << "Calculating gap" << std::endl;
-            int r_new_start = r_a.end.get() + 1;
-            int r_new_end = r_b.start.get() - 1;
-            int l = r_new_end - r_new_start + 1;
-            string flanking_seq = nucleotides.substr(r_new_start - start_reference - 1, l);
-//            std::cout << "Start: " << r_new_start << std::endl;
-//            std::cout << "End: " << r_new_end << std::endl;
-//
-//            std::cout << "Autoconstructing SequenceAnnotation" << std::endl;
-
-            // Generate URI of new SequenceAnnotation.  Check if an object with that URI is already instantiated.
-            int instance_count = 1;
-            string annotation_id = cdef_node->persistentIdentity.get() + "/annotation" + to_string(instance_count) + "/" + cdef_node->version.get();
-            while (cdef_node->doc->find_property_value(SBOL_DISPLAY_ID, "annotation" + to_string(instance_count)).size() > 0)
-            {
-                // Find the last instance assigned
-                ++instance_count;
-                annotation_id = cdef_node->persistentIdentity.get() +  "/annotation" + to_string(instance_count) + "/" + cdef_node->version.get();
-            }
-            SequenceAnnotation& new_ann = cdef_node->sequenceAnnotations.create("annotation" + to_string(instance_count));
-            new_ann.roles.set(SO "0000239");  // Set to Sequence Ontology "flanking_sequence"
-            new_ann.name.set("flanking region " + to_string(instance_count));
-
-//            std::cout << "Autoconstructing Range" << std::endl;
-
-            Range& new_range = new_ann.locations.create<Range>("range" + to_string(instance_count));
-            new_range.start.set(r_new_start);
-            new_range.end.set(r_new_end);
-            
-            // Append in order in the list of Ranges
-//            std::cout << "Inserting new range " << std::endl;
-            ranges.push_back(&new_range);
-
-        }
+        int r_start = r->start.get();
+        if (r_start > next_start)
+            regularized_ranges.push_back(&add_flanking_range(cdef_node, next_start, r_start - 1, context));
+        regularized_ranges.push_back(r);
+        next_start = r->end.get() + 1;
     }
-    ranges.push_back(gapped_ranges[gapped_ranges.size() - 1]); // Terminal range
-
-    for (auto & r : ranges)
-        std::cout << r->start.get() << "\t" << r->end.get() << std::endl;
-
-//    std::cout << "Checking if the Range interval exceeds primary sequence length" << std::endl;
 
     // Trim Range if Range's interval exceeds the primary sequence length
-    Range& r_last = **std::prev(ranges.end());
-    if (r_last.end.get() > (seq.length() + start_reference))
-    {
-//        std::cout << "Trimming end" << std::endl;
-
-        r_last.end.set(seq.length() + start_reference);
-    }
-    for (auto & r : ranges)
-        std::cout << r->start.get() << "\t" << r->end.get() << std::endl;
-
-    
-//    std::cout << "Checking for end gap" << std::endl;
-
-    // Another edge case: Check for a gap in SequenceAnnotations / Ranges at the very end
-    if (r_last.end.get() < seq.length())
+    Range& r_last = *regularized_ranges.back();
+    if (r_last.end.get() > end_reference)
     {
-        std::cout << "Filling end" << std::endl;
-
-        int r_new_start = r_last.end.get() + 1;  // Shift index by one to convert to zero-indexing
-        int r_new_end = r_last.end.get() + seq.length();
-        int l = r_new_end - r_new_start + 1;
-        string flanking_seq = nucleotides.substr(r_new_start - 1, l);
-        
-        // Insert flanking Component
-        int instance_count = 1;
-        string component_id = cdef_node->persistentIdentity.get() + "/component" + to_string(instance_count) + "/" + cdef_node->version.get();
-        
-        // Generate URI of new Component.  Check if an object with that URI is already instantiated.
-        instance_count = 1;
-        string annotation_id = cdef_node->persistentIdentity.get() + "/annotation" + to_string(instance_count) + "/" + cdef_node->version.get();
-        while (cdef_node->doc->find_property_value(SBOL_DISPLAY_ID, "annotation" + to_string(instance_count)).size() > 0)
-        {
-            // Find the last instance assigned
-            ++instance_count;
-            annotation_id = cdef_node->persistentIdentity.get() +  "/annotation" + to_string(instance_count) + "/" + cdef_node->version.get();
-        }
-        SequenceAnnotation& new_ann = cdef_node->sequenceAnnotations.create("annotation" + to_string(instance_count));
-        new_ann.roles.set(SO "0000239");  // Set to Sequence Ontology "flanking_sequence"
-        new_ann.name.set("flanking region " + to_string(instance_count));
-        
-        Range& new_range = new_ann.locations.create<Range>("range" + to_string(instance_count));
-        new_range.start.set(r_new_start);
-        new_range.end.set(r_new_end);
-        
-        // Append to end of list of Ranges
-        ranges.insert(ranges.end(), &new_range);
+        r_last.end.set(end_reference);
+        next_start = end_reference + 1;
     }
-    
-    // Check if Ranges are ordered
-    for (auto & r : ranges)
-        std::cout << r->start.get() << "\t" << r->end.get() << std::endl;
+    if (next_start <= end_reference)
+        regularized_ranges.push_back(&add_flanking_range(cdef_node, next_start, end_reference, context));
 
-//    std::cout << "Dissembling " << cdef_node->identity.get() << std::endl;
-
-    // Now that Ranges are regularized, instantiate Components and  the Sequence
+    // Now that Ranges are regularized, instantiate Components and the Sequence
     std::vector < ComponentDefinition* > primary_structure;
     std::vector < Component* > primary_structure_instances;
-    for (auto & i_r : ranges)
+    for (auto & i_r : regularized_ranges)
     {
         Range& r = *i_r;
         SequenceAnnotation& ann = *(SequenceAnnotation*)r.parent;
-        
-//        std::cout << r.start.get() << "\t" << r.end.get() << std::endl;
+        int r_start = r.start.get();
+        std::string subsequence = nucleotides.substr(r_start - start_reference, r.end.get() - r_start + 1);
 
         // If no corresponding Component for this SequenceAnnotation is defined
         if (ann.component.size() == 0)
         {
-            std::string display_id = ann.displayId.get();
-            size_t index = display_id.find("annotation");
-            if (index != std::string::npos)
-            {
-                display_id.replace(index, 10, "component");
-            }
-            
-//            std::cout << "Instantiating Sequence " << display_id << std::endl;
-            Sequence& subseq = cdef_node->doc->sequences.create(display_id + "seq");
-            subseq.elements.set(nucleotides.substr(r.start.get() - start_reference, r.end.get() - r.start.get() + 1));
-//            std::cout << "Setting sequence " << nucleotides.substr(r.start.get() - start_reference, r.end.get() - r.start.get() + 1) << std::endl;
-
-//            std::cout << "Instantiating ComponentDefinition " << display_id << std::endl;
-            ComponentDefinition& cd = cdef_node->doc->componentDefinitions.create(display_id);
-            cd.name.set(ann.name.get());
-            cd.sequences.set(subseq);
-            cd.roles.copy(ann.roles);
-            ann.roles.clear();
-            
-            Component& c = cdef_node->components.create(display_id);
-            c.definition.set(cd);
-            c.name.set(ann.name.get());
-            
-            ann.component.set(c.identity.get());
-            
-            primary_structure.push_back(&cd);
+            // A feature on the reverse strand is defined by the reverse complement of the region it annotates
+            if (r.orientation.get() == SBOL_ORIENTATION_REVERSE_COMPLEMENT)
+                subsequence = reverse_complement(subsequence);
+            Component& c = instantiate_subcomponent(cdef_node, ann, subsequence);
+            primary_structure.push_back(&cdef_node->doc->get<ComponentDefinition>(c.definition.get()));
             primary_structure_instances.push_back(&c);
         }
         else
         {
             Component& c = cdef_node->components.get(ann.component.get());
-//            std::cout << "Component " << c.identity.get() << " already instantiated. Retrieving from document" << std::endl;
-
             ComponentDefinition& sub_cdef = cdef_node->doc->get<ComponentDefinition>(c.definition.get());
             Sequence& subseq = cdef_node->doc->get<Sequence>(sub_cdef.sequences.get());
-            subseq.elements.set(nucleotides.substr(r.start.get() - start_reference, r.end.get() - r.start.get() + 1));
-//            std::cout << "Setting sequence " << nucleotides.substr(r.start.get() - start_reference, r.end.get() - r.start.get() + 1) << std::endl;
+            subseq.elements.set(subsequence);
 
             primary_structure.push_back(&sub_cdef);
             primary_structure_instances.push_back(&c);
-            
-            // Recurse into subcomponent, shift primary sequence start reference
-            int start_reference = i_r->start.get();
-            disassemble(&sub_cdef, start_reference);
 
+            // Recurse into subcomponent, shift primary sequence start reference
+            disassemble(&sub_cdef, r_start, context);
         }
     }
 
-//    // Check if Ranges are ordered
-//    for (auto & r : ranges)
-//    {
-//        std::cout << r->start.get() << "\t" << r->end.get() << std::endl;
-//    }
-//
-//    for (auto & c : primary_structure)
-//    {
-//        std::cout << c->displayId.get() <<  std::endl;
-//    }
-    
     // Set sequenceConstraints in primary sequence
     for (auto i_com = 1; i_com != primary_structure.size(); i_com++)
     {
-        ComponentDefinition& cd_upstream = *primary_structure[i_com - 1];
-        ComponentDefinition& cd_downstream = *primary_structure[i_com];
-        
         Component& constraint_subject = *primary_structure_instances[i_com - 1];
         Component& constraint_object = *primary_structure_instances[i_com];
         
@@ -2440,7 +2209,9 @@ void ComponentDefinition::disassemble(int range_start)
     if (!isComplete())
         throw SBOLError(SBOL_ERROR_MISSING_DOCUMENT, "Cannot disassemble. The design is incomplete, meaning some ComponentDefinitions or their Sequences are missing from the Document.");
     
-    ::disassemble(this,  range_start);
+    DisassemblyContext context = { {}, 0, Config::getOption("verbose") == "True" };
+    doc->apply(collect_display_ids, &context.display_ids);
+    ::disassemble(this, range_start, context);
     return;
 };
 
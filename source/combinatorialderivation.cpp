@@ -0,0 +1,506 @@
+/**
+ * @file    combinatorialderivation.cpp
+ * @brief   Enumeration of the designs specified by a CombinatorialDerivation
+ * @author  Bryan Bartley
+ * @email   bartleyba@sbolstandard.org
+ *
+ * <!--------------------------------------------------------------------------
+ * This file is part of libSBOL.  Please visit http://sbolstandard.org for more
+ * information about SBOL, and the latest version of libSBOL.
+ *
+ *  Copyright 2016 University of Washington, WA, USA
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ------------------------------------------------------------------------->*/
+
+#include "document.h"
+
+#include <algorithm>
+#include <climits>
+#include <thread>
+#include <exception>
+
+using namespace std;
+using namespace sbol;
+
+// Library sizes grow multiplicatively, so guard against a library which cannot be numbered
+unsigned long long checked_multiply(unsigned long long a, unsigned long long b)
+{
+    if (a != 0 && b > ULLONG_MAX / a)
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "The combinatorial library is too large to enumerate");
+    return a * b;
+};
+
+unsigned long long checked_add(unsigned long long a, unsigned long long b)
+{
+    if (b > ULLONG_MAX - a)
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "The combinatorial library is too large to enumerate");
+    return a + b;
+};
+
+DerivationEnumerator CombinatorialDerivation::enumerate(int max_repeats)
+{
+    return DerivationEnumerator(*this, max_repeats);
+};
+
+vector<Sequence*> CombinatorialDerivation::compile(int max_repeats)
+{
+    return enumerate(max_repeats).compile();
+};
+
+DerivationEnumerator::DerivationEnumerator(CombinatorialDerivation& derivation, int max_repeats) :
+    derivation(&derivation),
+    template_cdef(NULL),
+    ordered(false),
+    n_designs(0),
+    cursor(0)
+{
+    vector<string> ancestors;
+    initialize(max_repeats, ancestors);
+};
+
+DerivationEnumerator::DerivationEnumerator(CombinatorialDerivation& derivation, int max_repeats, vector<string>& ancestors) :
+    derivation(&derivation),
+    template_cdef(NULL),
+    ordered(false),
+    n_designs(0),
+    cursor(0)
+{
+    initialize(max_repeats, ancestors);
+};
+
+void DerivationEnumerator::initialize(int max_repeats, vector<string>& ancestors)
+{
+    if (!derivation->doc)
+        throw SBOLError(SBOL_ERROR_MISSING_DOCUMENT, "Cannot enumerate CombinatorialDerivation " + derivation->identity.get() + " because it does not belong to a Document");
+    if (max_repeats < 1)
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "The maximum number of repeats must be 1 or greater");
+    if (derivation->masterTemplate.size() == 0)
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot enumerate CombinatorialDerivation " + derivation->identity.get() + " because it does not have a template");
+    Document& doc = *derivation->doc;
+    template_cdef = &doc.get<ComponentDefinition>(derivation->masterTemplate.get());
+    ancestors.push_back(derivation->identity.get());
+
+    // Order the template Components by their SequenceConstraints, if there are any
+    vector<Component*> template_components;
+    if (template_cdef->sequenceConstraints.size() > 0)
+    {
+        ordered = true;
+        template_components = template_cdef->getInSequentialOrder();
+    }
+    for (auto & c : template_cdef->components)
+        if (find(template_components.begin(), template_components.end(), &c) == template_components.end())
+            template_components.push_back(&c);
+
+    unordered_map<string, VariableComponent*> variables;
+    for (auto & var : derivation->variableComponents)
+    {
+        if (var.variable.size() == 0 || template_cdef->components.find(var.variable.get()) == false)
+            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "VariableComponent " + var.identity.get() + " does not refer to a Component of the template " + template_cdef->identity.get());
+        variables[var.variable.get()] = &var;
+    }
+
+    n_designs = 1;
+    for (auto & c : template_components)
+    {
+        DerivationPosition position;
+        position.template_component = c->identity.get();
+        position.display_id = c->displayId.get();
+        if (variables.find(position.template_component) == variables.end())
+        {
+            // A template Component which is not variable is derived once, with the same definition
+            position.min_repeats = 1;
+            position.max_repeats = 1;
+            position.variants = { c->definition.get() };
+        }
+        else
+        {
+            VariableComponent& var = *variables[position.template_component];
+            string repeat = var.repeat.get();
+            if (repeat == SBOL_REPEAT_ONE)
+            {
+                position.min_repeats = 1;
+                position.max_repeats = 1;
+            }
+            else if (repeat == SBOL_REPEAT_ZERO_OR_ONE)
+            {
+                position.min_repeats = 0;
+                position.max_repeats = 1;
+            }
+            else if (repeat == SBOL_REPEAT_ZERO_OR_MORE)
+            {
+                position.min_repeats = 0;
+                position.max_repeats = max_repeats;
+            }
+            else if (repeat == SBOL_REPEAT_ONE_OR_MORE)
+            {
+                position.min_repeats = 1;
+                position.max_repeats = max_repeats;
+            }
+            else
+                throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "VariableComponent " + var.identity.get() + " has an invalid repeat operator " + repeat);
+
+            // The same variant may be listed directly and as a member of a Collection, but it is only enumerated once
+            vector<string> variants = var.variants.getAll();
+            for (auto & collection_id : var.variantCollections.getAll())
+            {
+                vector<string> members = doc.get<Collection>(collection_id).members.getAll();
+                variants.insert(variants.end(), members.begin(), members.end());
+            }
+            for (auto & variant : variants)
+                if (find(position.variants.begin(), position.variants.end(), variant) == position.variants.end())
+                    position.variants.push_back(variant);
+
+            for (auto & derivation_id : var.variantDerivations.getAll())
+            {
+                if (find(ancestors.begin(), ancestors.end(), derivation_id) != ancestors.end())
+                    throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "VariableComponent " + var.identity.get() + " cannot refer to CombinatorialDerivation " + derivation_id + ", because this would create a cyclic derivation");
+                CombinatorialDerivation& sub_derivation = doc.get<CombinatorialDerivation>(derivation_id);
+                position.derivations.push_back(shared_ptr<DerivationEnumerator>(new DerivationEnumerator(sub_derivation, max_repeats, ancestors)));
+            }
+        }
+
+        position.n_variants = position.variants.size();
+        for (auto & sub_derivation : position.derivations)
+            position.n_variants = checked_add(position.n_variants, sub_derivation->size());
+        if (position.n_variants == 0)
+            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "The VariableComponent for template Component " + position.template_component + " has no variants");
+
+        // Count the ways of choosing between min_repeats and max_repeats variants, in order and with replacement
+        position.n_options = 0;
+        unsigned long long n_choices = 1;
+        for (int n_repeats = 0; n_repeats <= position.max_repeats; ++n_repeats)
+        {
+            if (n_repeats >= position.min_repeats)
+                position.n_options = checked_add(position.n_options, n_choices);
+            if (n_repeats < position.max_repeats)
+                n_choices = checked_multiply(n_choices, position.n_variants);
+        }
+        n_designs = checked_multiply(n_designs, position.n_options);
+        positions.push_back(position);
+    }
+    ancestors.pop_back();
+};
+
+// Decomposes the index of a design into an option at each position. The last position varies fastest, so consecutive
+// designs share their leading structure.
+vector<unsigned long long> DerivationEnumerator::getOptions(unsigned long long index)
+{
+    if (index >= n_designs)
+        throw SBOLError(SBOL_ERROR_END_OF_LIST, "Design " + to_string(index) + " is out of range. The library contains " + to_string(n_designs) + " designs");
+    vector<unsigned long long> options(positions.size());
+    for (int i_position = positions.size() - 1; i_position >= 0; --i_position)
+    {
+        options[i_position] = index % positions[i_position].n_options;
+        index /= positions[i_position].n_options;
+    }
+    return options;
+};
+
+// Decomposes an option into the variants chosen for each repeat. Options are numbered by the number of repeats first,
+// then by the variants chosen.
+vector<unsigned long long> DerivationEnumerator::getChoices(DerivationPosition& position, unsigned long long option)
+{
+    unsigned long long n_choices = 1;
+    for (int n_repeats = 0; n_repeats < position.min_repeats; ++n_repeats)
+        n_choices *= position.n_variants;
+    int n_repeats = position.min_repeats;
+    while (option >= n_choices)
+    {
+        option -= n_choices;
+        n_choices *= position.n_variants;
+        ++n_repeats;
+    }
+    vector<unsigned long long> choices(n_repeats);
+    for (int i_repeat = n_repeats - 1; i_repeat >= 0; --i_repeat)
+    {
+        choices[i_repeat] = option % position.n_variants;
+        option /= position.n_variants;
+    }
+    return choices;
+};
+
+string DerivationEnumerator::getVariant(DerivationPosition& position, unsigned long long i_variant, bool materialize)
+{
+    if (i_variant < position.variants.size())
+        return position.variants[i_variant];
+    i_variant -= position.variants.size();
+    for (auto & sub_derivation : position.derivations)
+    {
+        if (i_variant < sub_derivation->size())
+            return materialize ? sub_derivation->derive(i_variant).identity.get() : sub_derivation->getURI(i_variant);
+        i_variant -= sub_derivation->size();
+    }
+    throw SBOLError(SBOL_ERROR_END_OF_LIST, "Variant is out of range");
+};
+
+vector<string> DerivationEnumerator::getVariants(unsigned long long index)
+{
+    vector<unsigned long long> options = getOptions(index);
+    vector<string> variants;
+    for (size_t i_position = 0; i_position < positions.size(); ++i_position)
+        for (auto & i_variant : getChoices(positions[i_position], options[i_position]))
+            variants.push_back(getVariant(positions[i_position], i_variant, false));
+    return variants;
+};
+
+// Forms an SBOL-compliant URI for an object derived from a CombinatorialDerivation, in the same namespace
+string derived_uri(CombinatorialDerivation& derivation, rdf_type type, string display_id)
+{
+    string prefix = derivation.persistentIdentity.get();
+    prefix = prefix.substr(0, prefix.rfind("/"));
+    string derivation_class = "/" + parseClassName(SBOL_COMBINATORIAL_DERIVATION);
+    if (Config::getOption("sbol_typed_uris").compare("True") == 0 && prefix.size() >= derivation_class.size() && prefix.compare(prefix.size() - derivation_class.size(), derivation_class.size(), derivation_class) == 0)
+        prefix = prefix.substr(0, prefix.size() - derivation_class.size()) + "/" + parseClassName(type);
+    string version = derivation.version.get();
+    if (version != "")
+        return prefix + "/" + display_id + "/" + version;
+    return prefix + "/" + display_id;
+};
+
+// Sets the identity of an object constructed outside the Document
+void set_derived_identity(Identified& obj, string uri, string display_id, string version)
+{
+    bool compliant = Config::getOption("sbol_compliant_uris").compare("True") == 0;
+    obj.identity.set(uri);
+    obj.persistentIdentity.set(compliant && version != "" ? uri.substr(0, uri.rfind("/")) : uri);
+    if (compliant)
+        obj.displayId.set(display_id);
+};
+
+string DerivationEnumerator::getURI(unsigned long long index)
+{
+    if (Config::getOption("sbol_compliant_uris").compare("True") == 0)
+        return derived_uri(*derivation, SBOL_COMPONENT_DEFINITION, derivation->displayId.get() + "_" + to_string(index));
+    return derivation->identity.get() + "_" + to_string(index);
+};
+
+// Constructs a design outside the Document, so designs can be constructed concurrently
+ComponentDefinition* DerivationEnumerator::construct(unsigned long long index, vector<vector<string>>& structure)
+{
+    string uri = getURI(index);
+    string display_id = derivation->displayId.get() + "_" + to_string(index);
+    string version = derivation->version.get();
+    bool compliant = Config::getOption("sbol_compliant_uris").compare("True") == 0;
+
+    ComponentDefinition* design = new ComponentDefinition(display_id, BIOPAX_DNA, version);
+    set_derived_identity(*design, uri, display_id, version);
+    design->properties[SBOL_TYPES] = template_cdef->properties.at(SBOL_TYPES);
+    design->properties[SBOL_ROLES] = template_cdef->properties.at(SBOL_ROLES);
+    design->wasDerivedFrom.set(derivation->identity.get());
+
+    // The design refers to its parts by URI, so the structure of the template and variants is shared, not copied
+    vector<Component*> instances;
+    for (size_t i_position = 0; i_position < positions.size(); ++i_position)
+    {
+        DerivationPosition& position = positions[i_position];
+        for (size_t i_repeat = 0; i_repeat < structure[i_position].size(); ++i_repeat)
+        {
+            string component_id = position.display_id;
+            if (position.max_repeats > 1)
+                component_id += "_" + to_string(i_repeat);
+            Component& c = design->components.create(compliant ? component_id : uri + "/" + component_id);
+            c.definition.set(structure[i_position][i_repeat]);
+            c.wasDerivedFrom.set(position.template_component);
+            instances.push_back(&c);
+        }
+    }
+    if (ordered)
+    {
+        for (size_t i_instance = 1; i_instance < instances.size(); ++i_instance)
+        {
+            string constraint_id = "constraint" + to_string(i_instance);
+            SequenceConstraint& sc = design->sequenceConstraints.create(compliant ? constraint_id : uri + "/" + constraint_id);
+            sc.subject.set(instances[i_instance - 1]->identity.get());
+            sc.object.set(instances[i_instance]->identity.get());
+            sc.restriction.set(SBOL_RESTRICTION_PRECEDES);
+        }
+    }
+    return design;
+};
+
+ComponentDefinition& DerivationEnumerator::next()
+{
+    if (!hasNext())
+        throw SBOLError(SBOL_ERROR_END_OF_LIST, "All designs in the library have been derived");
+    return derive(cursor++);
+};
+
+ComponentDefinition& DerivationEnumerator::derive(unsigned long long index)
+{
+    return *derive(index, 1)[0];
+};
+
+vector<ComponentDefinition*> DerivationEnumerator::derive(unsigned long long start, unsigned long long count, int n_threads)
+{
+    if (start > n_designs || count > n_designs - start)
+        throw SBOLError(SBOL_ERROR_END_OF_LIST, "Designs " + to_string(start) + " to " + to_string(start + count) + " are out of range. The library contains " + to_string(n_designs) + " designs");
+    Document& doc = *derivation->doc;
+
+    // Designs which were derived previously are retrieved from the Document. Designs from variantDerivations are
+    // materialized here, rather than by the worker threads, since this adds them to the Document
+    vector<ComponentDefinition*> designs(count, NULL);
+    vector<vector<vector<string>>> structures(count);
+    vector<size_t> pending;
+    for (size_t i_design = 0; i_design < count; ++i_design)
+    {
+        string uri = getURI(start + i_design);
+        if (doc.SBOLObjects.find(uri) != doc.SBOLObjects.end())
+        {
+            designs[i_design] = dynamic_cast<ComponentDefinition*>(doc.SBOLObjects[uri]);
+            if (!designs[i_design])
+                throw SBOLError(SBOL_ERROR_URI_NOT_UNIQUE, "Cannot derive " + uri + " because an object with this URI is already in the Document");
+            continue;
+        }
+        vector<unsigned long long> options = getOptions(start + i_design);
+        vector<vector<string>>& structure = structures[i_design];
+        structure.resize(positions.size());
+        for (size_t i_position = 0; i_position < positions.size(); ++i_position)
+            for (auto & i_variant : getChoices(positions[i_position], options[i_position]))
+                structure[i_position].push_back(getVariant(positions[i_position], i_variant, true));
+        pending.push_back(i_design);
+    }
+
+    // Construct the new designs in contiguous blocks, one block per thread
+    if (n_threads < 1)
+        n_threads = 1;
+    size_t block_size = (pending.size() + n_threads - 1) / n_threads;
+    vector<thread> workers;
+    vector<exception_ptr> errors(n_threads);
+    for (int i_thread = 0; i_thread < n_threads; ++i_thread)
+    {
+        size_t i_begin = i_thread * block_size;
+        size_t i_end = min(pending.size(), i_begin + block_size);
+        if (i_begin >= i_end)
+            break;
+        auto construct_block = [this, &designs, &structures, &pending, &errors, start, i_thread, i_begin, i_end]()
+        {
+            try
+            {
+                for (size_t i = i_begin; i < i_end; ++i)
+                    designs[pending[i]] = construct(start + pending[i], structures[pending[i]]);
+            }
+            catch (...)
+            {
+                errors[i_thread] = current_exception();
+            }
+        };
+        if (n_threads == 1)
+            construct_block();
+        else
+            workers.push_back(thread(construct_block));
+    }
+    for (auto & worker : workers)
+        worker.join();
+    for (auto & error : errors)
+    {
+        if (error)
+        {
+            for (auto & i_design : pending)
+                delete designs[i_design];
+            rethrow_exception(error);
+        }
+    }
+
+    for (auto & i_design : pending)
+        doc.add<ComponentDefinition>(*designs[i_design]);
+    return designs;
+};
+
+// Returns the primary structure of a variant, compiling it from its own subcomponents if it does not have a Sequence
+string DerivationEnumerator::compileVariant(string uri)
+{
+    Document& doc = *derivation->doc;
+    ComponentDefinition& cdef = doc.get<ComponentDefinition>(uri);
+    if (cdef.sequences.size() > 0)
+    {
+        Sequence& seq = doc.get<Sequence>(cdef.sequences.get());
+        if (seq.isPacked())
+            return seq.view().str();
+        return seq.elements.size() ? seq.elements.get() : "";
+    }
+    if (cdef.components.size() > 0)
+        return cdef.compile();
+    throw SBOLError(SBOL_ERROR_NOT_FOUND, "Cannot compile variant " + uri + ". It does not have a Sequence or subcomponents");
+};
+
+vector<Sequence*> DerivationEnumerator::compile(unsigned long long start, unsigned long long count)
+{
+    vector<ComponentDefinition*> designs = derive(start, count);
+    Document& doc = *derivation->doc;
+    bool compliant = Config::getOption("sbol_compliant_uris").compare("True") == 0;
+    bool typed = Config::getOption("sbol_typed_uris").compare("True") == 0;
+    string version = derivation->version.get();
+
+    unordered_map<string, string> variant_sequences;
+    vector<unordered_map<unsigned long long, string>> segments(positions.size());  // The compiled segment for each option at each position
+    vector<size_t> prefix_lengths(positions.size() + 1, 0);  // The length of the composite sequence up to each position
+    vector<unsigned long long> previous_options;
+    string composite_sequence;
+    vector<Sequence*> compiled_sequences;
+    for (unsigned long long i_design = 0; i_design < count; ++i_design)
+    {
+        // Keep the prefix shared with the previous design, and append segments for the positions which changed
+        vector<unsigned long long> options = getOptions(start + i_design);
+        size_t i_first = 0;
+        if (i_design > 0)
+            while (i_first < positions.size() && options[i_first] == previous_options[i_first])
+                ++i_first;
+        composite_sequence.resize(prefix_lengths[i_first]);
+        for (size_t i_position = i_first; i_position < positions.size(); ++i_position)
+        {
+            DerivationPosition& position = positions[i_position];
+            auto i_segment = segments[i_position].find(options[i_position]);
+            if (i_segment == segments[i_position].end())
+            {
+                string segment;
+                for (auto & i_variant : getChoices(position, options[i_position]))
+                {
+                    string variant = getVariant(position, i_variant, true);
+                    if (variant_sequences.find(variant) == variant_sequences.end())
+                        variant_sequences[variant] = compileVariant(variant);
+                    segment += variant_sequences[variant];
+                }
+                i_segment = segments[i_position].insert(make_pair(options[i_position], segment)).first;
+            }
+            composite_sequence += i_segment->second;
+            prefix_lengths[i_position + 1] = composite_sequence.size();
+        }
+        previous_options = options;
+
+        // A design which was compiled previously keeps its Sequence
+        ComponentDefinition& design = *designs[i_design];
+        if (design.sequences.size() > 0)
+        {
+            Sequence& seq = doc.get<Sequence>(design.sequences.get());
+            seq.elements.set(composite_sequence);
+            compiled_sequences.push_back(&seq);
+            continue;
+        }
+        string seq_id;
+        string display_id;
+        if (compliant)
+        {
+            display_id = typed ? design.displayId.get() : design.displayId.get() + "_seq";
+            seq_id = derived_uri(*derivation, SBOL_SEQUENCE, display_id);
+        }
+        else
+            seq_id = design.identity.get() + "_seq";
+        Sequence* seq = new Sequence(display_id, composite_sequence, SBOL_ENCODING_IUPAC, version);
+        set_derived_identity(*seq, seq_id, display_id, version);
+        doc.add<Sequence>(*seq);
+        design.sequences.set(seq_id);
+        compiled_sequences.push_back(seq);
+    }
+    return compiled_sequences;
+};
@@ -1,8 +1,12 @@
 #ifndef COMBINATORIALDERIVATION_INCLUDED
 #define COMBINATORIALDERIVATION_INCLUDED
 
+#include <memory>
+
 namespace sbol
 {
+    class DerivationEnumerator;
+
     /// The VariableComponent class can be used to specify a choice of ComponentDefinition objects for any new Component derived from a template Component in the template ComponentDefinition. This specification is made using the class properties variable, variants, variantCollections, and variantDerivations. While the variants, variantCollections, and variantDerivations properties are OPTIONAL, at least one of them MUST NOT be empty
     class SBOL_DECLSPEC VariableComponent : public Identified
     {
@@ -77,7 +81,103 @@ namespace sbol
         
         /// VariableComponent objects denote the choices available when deriving the library of variants specified by a CombinatorialDerivation
         OwnedObject < VariableComponent > variableComponents;
-        
+
+        /// Prepare to derive the ComponentDefinitions specified by this CombinatorialDerivation. The designs are not constructed until they are requested from the returned DerivationEnumerator, so large libraries may be enumerated one design, or one batch of designs, at a time. The CombinatorialDerivation, its template and its variants must belong to a Document.
+        /// @param max_repeats The maximum number of Components derived from a template Component whose repeat is SBOL_REPEAT_ZERO_OR_MORE or SBOL_REPEAT_ONE_OR_MORE. Since these operators are unbounded, a limit is required to enumerate them.
+        /// @return A lazy generator of the derived ComponentDefinitions
+        DerivationEnumerator enumerate(int max_repeats = 2);
+
+        /// Derive every ComponentDefinition specified by this CombinatorialDerivation and compile its Sequence. See DerivationEnumerator::compile.
+        /// @param max_repeats The maximum number of Components derived from a template Component with an unbounded repeat operator
+        /// @return The compiled Sequences, in the order of the designs
+        std::vector<Sequence*> compile(int max_repeats = 2);
+
+    };
+
+    /// @cond
+    // A template Component, and the alternatives for the Components which may be derived from it. A template Component which is not variable has a single alternative, its own definition, and is derived exactly once.
+    struct DerivationPosition
+    {
+        std::string template_component;
+        std::string display_id;
+        int min_repeats;
+        int max_repeats;
+        std::vector<std::string> variants;  // ComponentDefinitions from the variants and variantCollections properties
+        std::vector<std::shared_ptr<DerivationEnumerator>> derivations;  // Designs from the variantDerivations property follow the variants in the alphabet
+        unsigned long long n_variants;  // The size of the alphabet
+        unsigned long long n_options;   // The number of ways the Components at this position may be derived
+    };
+    /// @endcond
+
+    /// A lazily evaluated library of the ComponentDefinitions derived from a CombinatorialDerivation, which is returned by CombinatorialDerivation::enumerate. Designs are numbered from 0 to size() - 1 and are constructed only when they are requested. A derived ComponentDefinition refers to the template's parts by URI rather than copying them, and a design derived from a variantDerivation is constructed once no matter how many designs use it.
+    class SBOL_DECLSPEC DerivationEnumerator
+    {
+    public:
+        /// @param derivation The CombinatorialDerivation to enumerate. It must belong to a Document.
+        /// @param max_repeats The maximum number of Components derived from a template Component with an unbounded repeat operator
+        DerivationEnumerator(CombinatorialDerivation& derivation, int max_repeats = 2);
+
+        /// @return The number of designs in the library
+        unsigned long long size() { return n_designs; };
+
+        /// @return true if the generator has not reached the end of the library
+        bool hasNext() { return cursor < n_designs; };
+
+        /// Derive the next design in the library, or retrieve it from the Document if it was derived previously
+        /// @return The derived ComponentDefinition, which belongs to the CombinatorialDerivation's Document
+        ComponentDefinition& next();
+
+        /// Return the generator to the first design in the library
+        void reset() { cursor = 0; };
+
+        /// Derive a design, or retrieve it from the Document if it was derived previously. Its Components are listed in template order, linked by SequenceConstraints if the template is ordered, and refer to their template Components through the wasDerivedFrom property.
+        /// @param index The number of the design, from 0 to size() - 1
+        /// @return The derived ComponentDefinition, which belongs to the CombinatorialDerivation's Document
+        ComponentDefinition& derive(unsigned long long index);
+
+        /// Derive a batch of consecutive designs. The ComponentDefinitions are constructed in parallel and then added to the Document.
+        /// @param start The number of the first design in the batch
+        /// @param count The number of designs in the batch
+        /// @param n_threads The number of threads which construct the designs. This should be 1 if the Document's objects have validation rules which are not thread-safe, eg, rules defined in Python.
+        /// @return The derived ComponentDefinitions, in order
+        std::vector<ComponentDefinition*> derive(unsigned long long start, unsigned long long count, int n_threads = 1);
+
+        /// Derive a batch of consecutive designs, if they were not derived previously, and compile their Sequences. Rather than assembling each design from its parts, as ComponentDefinition::compile does, the batch is visited in order as the leaves of a trie over the template's positions. A compiled segment is appended once for each node of the trie and is shared by every design below that node, so the unchanged prefix of consecutive designs is never reassembled and the work of assembly is proportional to the unique material in the batch. Each variant is compiled only once. Unlike ComponentDefinition::compile, the designs are not annotated with SequenceAnnotations.
+        /// @param start The number of the first design in the batch
+        /// @param count The number of designs in the batch
+        /// @return The compiled Sequences, in order. Each is referred to by the sequences property of its design.
+        std::vector<Sequence*> compile(unsigned long long start, unsigned long long count);
+
+        /// Derive every design in the library and compile its Sequence. See DerivationEnumerator::compile(start, count)
+        /// @return The compiled Sequences, in the order of the designs
+        std::vector<Sequence*> compile() { return compile(0, n_designs); };
+
+        /// Look up the parts of a design without deriving it
+        /// @param index The number of the design, from 0 to size() - 1
+        /// @return The URIs of the ComponentDefinitions which the design's Components will refer to, in template order
+        std::vector<std::string> getVariants(unsigned long long index);
+
+        /// @param index The number of the design, from 0 to size() - 1
+        /// @return The URI of the derived ComponentDefinition, whether or not it has been derived yet
+        std::string getURI(unsigned long long index);
+
+    /// @cond
+    private:
+        DerivationEnumerator(CombinatorialDerivation& derivation, int max_repeats, std::vector<std::string>& ancestors);
+        void initialize(int max_repeats, std::vector<std::string>& ancestors);
+        std::vector<unsigned long long> getOptions(unsigned long long index);
+        std::vector<unsigned long long> getChoices(DerivationPosition& position, unsigned long long option);
+        std::string getVariant(DerivationPosition& position, unsigned long long i_variant, bool materialize);
+        ComponentDefinition* construct(unsigned long long index, std::vector<std::vector<std::string>>& structure);
+        std::string compileVariant(std::string uri);
+
+        CombinatorialDerivation* derivation;
+        ComponentDefinition* template_cdef;
+        std::vector<DerivationPosition> positions;
+        bool ordered;
+        unsigned long long n_designs;
+        unsigned long long cursor;
+    /// @endcond
     };
     
 }
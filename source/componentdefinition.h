@@ -183,6 +183,13 @@ namespace sbol
         /// @return Returns a flat list of pointers to all Components in the hierarchy.
         std::vector<ComponentDefinition*> applyToComponentHierarchy(void (*callback_fn)(ComponentDefinition *, void *) = NULL, void * user_data = NULL);
 
+        /// Perform an operation on every distinct ComponentDefinition in a structurally-linked hierarchy of Components. Unlike applyToComponentHierarchy, a ComponentDefinition that is instantiated by several Components, such as a part shared by sub-designs, is visited only once.
+        /// @param callback_fun A pointer to a callback function with signature void callback_fn(ComponentDefinition *, void *).
+        /// @param user_data Arbitrary user data which can be passed in and out of the callback as an argument or return value.
+        /// @param n_threads If greater than 1, the callback is applied concurrently on this many threads after the hierarchy has been traversed. Only use this with callbacks that do not modify the Document or user_data without their own synchronization.
+        /// @return Returns a flat list of pointers to the distinct ComponentDefinitions in the hierarchy, in depth-first order.
+        std::vector<ComponentDefinition*> applyToUniqueComponentHierarchy(void (*callback_fn)(ComponentDefinition *, void *) = NULL, void * user_data = NULL, int n_threads = 1);
+
         /// Get the primary sequence of a design in terms of its sequentially ordered Components
         std::vector<ComponentDefinition*> getPrimaryStructure();
 
@@ -51,6 +51,7 @@ std::map<std::string, std::string> sbol::Config::options {
     {"sbol_typed_uris", "True"},
     {"serialization_format", "sbol"},
     {"validate", "True"},
+    {"validator", "online"},
     {"validator_url", "http://www.async.ece.utah.edu/validate/"},
     {"language", "SBOL2"},
     {"test_equality", "False"},
@@ -67,7 +68,13 @@ std::map<std::string, std::string> sbol::Config::options {
     {"diff_file_name", "comparison file"},
     {"return_file", "False"},
     {"verbose", "False"},
-    {"ca-path", ""}
+    {"ca-path", ""},
+    {"max_parallel_requests", "8"},
+    {"cache_dir", ""},
+    {"cache_max_size", "1024"},
+    {"offline", "False"},
+    {"incremental_pull", "False"},
+    {"compress_submissions", "False"}
 
 };
 
@@ -76,6 +83,7 @@ std::map<std::string, std::vector<std::string>> sbol::Config::valid_options {
     {"sbol_typed_uris", { "True", "False" }},
     {"serialization_format", {"sbol", "rdfxml", "json", "ntriples"}},
     {"validate", { "True", "False" }},
+    {"validator", { "local", "online" }},
     {"language", { "SBOL2", "FASTA", "GenBank" }},
     {"test_equality", { "True", "False" }},
     {"check_uri_compliance", { "True", "False" }},
@@ -85,7 +93,10 @@ std::map<std::string, std::vector<std::string>> sbol::Config::valid_options {
     {"provide_detailed_stack_trace", { "True", "False" }},
     {"insert_type", { "True", "False" }},
     {"return_file", { "True", "False" }},
-    {"verbose", { "True", "False" }}
+    {"verbose", { "True", "False" }},
+    {"offline", { "True", "False" }},
+    {"incremental_pull", { "True", "False" }},
+    {"compress_submissions", { "True", "False" }}
 };
 
 std::map<std::string, std::string> sbol::Config::extension_namespaces {};
@@ -495,7 +506,7 @@ size_t sbol::CurlResponseHeader_CallbackFunc(char *buffer,   size_t size,   size
     {
         std::unordered_map<std::string, std::string>& headers = *(std::unordered_map<std::string, std::string>*)userdata;
         size_t header_length = size * nitems;
-        std::string header = std::string(buffer);
+        std::string header = std::string(buffer, header_length);
         std::size_t delimiter_pos = header.find(':');
         if (delimiter_pos != std::string::npos)
         {
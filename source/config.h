@@ -94,6 +94,7 @@ namespace sbol
         /// | sbol_typed_uris              | Include the SBOL type in SBOL-compliant URIs                             | True or False   |
         /// | output_format                | File format for serialization                                            | True or False   |
         /// | validate                     | Enable validation and conversion requests through the online validator   | True or False   |
+        /// | validator                    | Whether Documents are validated, and converted to FASTA or GenBank,<br>in-process or by the online validator | local or online, set to online by default. The local validator checks only part of the specification |
         /// | validator_url                | The http request endpoint for validation                                 | A valid URL, set to<br>http://www.async.ece.utah.edu/sbol-validator/endpoint.php by default |
         /// | language                     | File format for conversion                                               | SBOL2, SBOL1, FASTA, GenBank |
         /// | test_equality                | Report differences between two files                                     | True or False |
@@ -105,6 +106,12 @@ namespace sbol
         /// | uri_prefix                   | Required for conversion from FASTA and GenBank to SBOL1 or SBOL2,<br>used to generate URIs  | True or False |
         /// | version                      | Adds the version to all URIs and to the document                         | A valid Maven version string |
         /// | return_file                  | Whether or not to return the file contents as a string                   | True or False |
+        /// | max_parallel_requests        | The number of requests a PartShop issues concurrently when pulling<br>many URIs | A positive integer, set to 8 by default |
+        /// | cache_dir                    | A directory in which PartShop responses are cached on disk and<br>revalidated with the server on later pulls | A directory path, empty by default, which disables caching |
+        /// | cache_max_size               | The size at which the least recently used responses are evicted from<br>the cache | A number of megabytes, set to 1024 by default |
+        /// | offline                      | If set to true, pulls are served from the cache without contacting<br>the server | True or False, set to False by default |
+        /// | incremental_pull             | If set to true, a recursive pull retrieves only the dependencies<br>which the Document does not already contain | True or False, set to False by default |
+        /// | compress_submissions         | If set to true, Documents are submitted to a PartShop gzip-compressed    | True or False, set to False by default |
         /// @param option The option key
         /// @param value The option value
         static void setOption(std::string option, std::string value);
@@ -148,6 +148,12 @@
 #define SBOL_ENCODING_SMILES "http://www.opensmiles.org/opensmiles.html"          ///< Option for Sequence::encoding property
 #define SBOL_ORIENTATION_INLINE SBOL_URI "#inline"                        ///< Option for Location::orientation property
 #define SBOL_ORIENTATION_REVERSE_COMPLEMENT SBOL_URI "#reverseComplement" ///< Option for Location::orientation property
+#define SBOL_ENUMERATE SBOL_URI "#enumerate"   ///< Option for CombinatorialDerivation::strategy property
+#define SBOL_SAMPLE SBOL_URI "#sample"         ///< Option for CombinatorialDerivation::strategy property
+#define SBOL_REPEAT_ZERO_OR_ONE SBOL_URI "#zeroOrOne"    ///< Option for VariableComponent::repeat property
+#define SBOL_REPEAT_ONE SBOL_URI "#one"                  ///< Option for VariableComponent::repeat property
+#define SBOL_REPEAT_ZERO_OR_MORE SBOL_URI "#zeroOrMore"  ///< Option for VariableComponent::repeat property
+#define SBOL_REPEAT_ONE_OR_MORE SBOL_URI "#oneOrMore"    ///< Option for VariableComponent::repeat property
 #define SBOL_REFINEMENT_USE_REMOTE SBOL_URI "#useRemote" ///< Option for FunctionalComponent::refinement property
 #define SBOL_REFINEMENT_USE_LOCAL SBOL_URI "#useLocal"   ///< Option for FunctionalComponent::refinement property
 #define SBOL_REFINEMENT_VERIFY_IDENTICAL SBOL_URI "#verifyIdentical" ///< Option for MapsTo::refinement property
@@ -28,6 +28,10 @@
 
 #include <tuple>
 #include <cctype>
+#include <algorithm>
+#include <thread>
+#include <functional>
+#include <exception>
 
 using namespace std;
 using namespace sbol;
@@ -611,6 +615,7 @@ namespace sbol
             {
                 child_obj->doc = parent_doc;
                 parent_doc->SBOLObjects[child_id] = (SBOLObject*)child_obj;
+                parent_doc->markProvenanceStale(child_id);
             }
             this->validate(child_obj);
             return *child_obj;
@@ -749,13 +754,10 @@ namespace sbol
         throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Could not annotate sequences because of invalid base comparison");
     }
 
-    void addQCAnnotations(ComponentDefinition& target, ComponentDefinition& construct)
+    // Annotates the construct with the regions of an alignment, padded with '-' to equal lengths, in which the verified
+    // sequence matches or varies from the target sequence
+    void add_qc_annotations(ComponentDefinition& construct, string target_sequence, string verified_sequence)
     {
-        Sequence& target_s = target.doc->get<Sequence>(target.sequences.get());
-        Sequence& construct_s = construct.doc->get<Sequence>(construct.sequences.get());
-        string target_sequence = target_s.elements.get();
-        string verified_sequence = construct_s.elements.get();
-        
         /* Clip gaps from target and verified sequences */
         string target_clipped = target_sequence;
         string verified_clipped = verified_sequence;
@@ -881,6 +883,13 @@ namespace sbol
         }
     };
 
+    void addQCAnnotations(ComponentDefinition& target, ComponentDefinition& construct)
+    {
+        Sequence& target_s = target.doc->get<Sequence>(target.sequences.get());
+        Sequence& construct_s = construct.doc->get<Sequence>(construct.sequences.get());
+        add_qc_annotations(construct, target_s.elements.get(), construct_s.elements.get());
+    };
+
 
     void Analysis::verifyTarget(Sequence& consensus)
     {
@@ -936,130 +945,170 @@ namespace sbol
         
         ::addQCAnnotations(design_structure, build_structure);
     };
-    
-    
-    float calculateIdentity(SequenceAnnotation& target, vector<SequenceAnnotation*> qc_annotations)
+
+    void Analysis::alignTarget(Sequence& read)
     {
-        int n_identical = 0;
+        if (consensusSequence.size())
+            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot align target. The consensusSequence property for this Analysis has already been set. Perform a new Analysis or remove the Sequence.");
 
-        if (target.locations.size() == 0)
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate identity. SequenceAnnotation " + target.identity.get() + " is invalid for this operation because it has no Range specified");
-        if (target.locations.size() > 1)
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate identity. SequenceAnnotation " + target.identity.get() + " is invalid for this operation because it has more than one Range specified");
-        sbol::Range& r_target = (sbol::Range&)target.locations[0];
-        
-        if (Config::getOption("verbose") == "True")
-            cout << r_target.start.get() << "\t" << r_target.end.get() << "\t";
+        if (!doc)
+            throw SBOLError(SBOL_ERROR_MISSING_DOCUMENT, "Cannot align target. Analysis " + identity.get() + " does not belong to a Document");
 
-        for (auto &p_qc : qc_annotations)
-        {
-            SequenceAnnotation& qc = *p_qc;
-            if (qc.locations.size() == 0)
-                throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate identity. SequenceAnnotation " + qc.identity.get() + " is invalid for this operation because it has no Range specified");
-            if (qc.locations.size() > 1)
-                throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate identity. A SequenceAnnotation " + qc.identity.get() + " is invalid for this operation because it has more than one Range specified");
-            sbol::Range& r_qc = (sbol::Range&)qc.locations[0];
-            
-            if (Config::getOption("verbose") == "True")
-                cout << r_qc.start.get() << "\t" << r_qc.end.get() << "\t";
+        // Retrieve Design by following links back through Analysis
+        if (!rawData.size() || !doc->tests.find(rawData.get()))
+            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot align target because the Analysis is not linked to a Design. The Analysis is not part of a Design-Build-Test-Analysis workflow.");
 
+        Test& test = doc->get<Test>(rawData.get());
+        if (!test.samples.size() || !doc->builds.find(test.samples.get()) )
+            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot align target because the Analysis is not linked to a Design. The Analysis is not part of a Design-Build-Test-Analysis workflow.");
 
-            string qc_classification = qc.roles.get();
-            if (qc_classification.compare(SO_NUCLEOTIDE_MATCH) == 0)
-            {
-                n_identical += r_target.contains(r_qc) + r_target.overlaps(r_qc);
-                if (Config::getOption("verbose") == "True")
-                    cout << "Contains: " << r_target.contains(r_qc) << "\tOverlaps: " <<  r_target.overlaps(r_qc) << "\tIdentical: " << n_identical << "\n\t\t";
-            }
-            else
-                if (Config::getOption("verbose") == "True")
-                    cout << "\n\t\t";
-        }
-        if (Config::getOption("verbose") == "True")
-        {
-            cout << (float)n_identical << "\t" << (float)r_target.length() << endl;
-            cout << "\n";
-        }
-        return (float)n_identical / (float)r_target.length();
-    };
+        Build& build = doc->get<Build>(test.samples.get());
+        if (!build.design.size() || !doc->designs.find(build.design.get()))
+            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot align target because the Analysis is not linked to a Design. The Analysis is not part of a Design-Build-Test-Analysis workflow.");
 
-    float calculateError(SequenceAnnotation& target, vector<SequenceAnnotation*> qc_annotations)
-    {
-        int n_substitution = 0;
-        int n_deletion = 0;
-        int n_insertion = 0;
-
-        if (target.locations.size() == 0)
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate error. SequenceAnnotation " + target.identity.get() + " is invalid for this operation because it has no Range specified");
-        if (target.locations.size() > 1)
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate error. SequenceAnnotation " + target.identity.get() + " is invalid for this operation because it has more than one Range specified");
-        sbol::Range& r_target = (sbol::Range&)target.locations[0];
-    //    cout << r_target.start.get() << "\t" << r_target.end.get() << "\t";
-        
-        for (auto &p_qc : qc_annotations)
+        Design& design = doc->get<Design>(build.design.get());
+        if (!design.structure.size())
+            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot align target, because the Design does not specify a target structure.");
+
+        // The target is the Design's Sequence, or else is compiled from the Design's hierarchy
+        ComponentDefinition& design_structure = design.structure.get();
+        string target_sequence;
+        if (design_structure.sequences.size() && doc->sequences.find(design_structure.sequences.get()))
+            target_sequence = doc->get<Sequence>(design_structure.sequences.get()).elements.get();
+        else if (design_structure.components.size())
+            target_sequence = design_structure.compile();
+        if (target_sequence.empty())
+            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot align target because the Design does not specify a target Sequence and its structure cannot be compiled.");
+
+        SequenceAlignment alignment = align_sequences(target_sequence, read.elements.get());
+        if (alignment.score <= 0)
+            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot align target. The Sequence " + read.identity.get() + " has no significant alignment to the target Sequence.");
+
+        consensusSequence.set(read);
+
+        // Auto-construct Build.structure
+        if (!build.structure.size())
         {
-            SequenceAnnotation& qc = *p_qc;
-            if (qc.locations.size() == 0)
-                throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate error. SequenceAnnotation " + qc.identity.get() + " is invalid for this operation because it has no Range specified");
-            if (qc.locations.size() > 1)
-                throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate error. A SequenceAnnotation " + qc.identity.get() + " is invalid for this operation because it has more than one Range specified");
-            sbol::Range& r_qc = (sbol::Range&)qc.locations[0];
-    //        cout << r_qc.start.get() << "\t" << r_qc.end.get();
-            
-            
-            string qc_classification = qc.roles.get();
-            if (qc_classification.compare(SO_SUBSTITUTION) == 0)
-                n_substitution += r_target.contains(r_qc) + r_target.overlaps(r_qc);
-            else if (qc_classification.compare(SO_DELETION) == 0)
-                n_deletion += r_target.contains(r_qc) + r_target.overlaps(r_qc);
-            else if (qc_classification.compare(SO_INSERTION) == 0)
-                n_insertion += r_target.contains(r_qc) + r_target.overlaps(r_qc);
-            
-    //        else
-    //            cout << "\n\t\t";
+            string build_structure_id;
+            if (Config::getOption("sbol_compliant_uris") == "True")
+                build_structure_id = build.displayId.get();
+            else
+                build_structure_id = build.identity.get();
+            build.structure.create(build_structure_id);
         }
-    //    cout << "\n";
-        return (float)(n_substitution + n_deletion + n_insertion) / (float)(r_target.length() + n_insertion);
+        ComponentDefinition& build_structure = build.structure.get();
+        build_structure.sequence.set(read);
+
+        // Regions of the target outside the local alignment are uncovered by the read
+        string target_aligned = target_sequence.substr(0, alignment.target_start) + alignment.target + target_sequence.substr(alignment.target_end);
+        string read_aligned = string(alignment.target_start, '-') + alignment.query + string(target_sequence.size() - alignment.target_end, '-');
+        add_qc_annotations(build_structure, target_aligned, read_aligned);
     };
+    
+    
+    // The classes of QC annotation added by addQCAnnotations
+    enum QCClass { QC_MATCH, QC_SUBSTITUTION, QC_DELETION, QC_INSERTION, QC_AMBIGUITY, N_QC_CLASSES };
 
-    float calculateAmbiguity(SequenceAnnotation& target, vector<SequenceAnnotation*> qc_annotations)
+    // Indexes the QC annotations of a Build by interval, so the number of bases of each class within a region can be
+    // counted with a binary search rather than a scan of every annotation. Overlapping annotations are counted once per
+    // annotation, as with Range::contains and Range::overlaps.
+    class QCIntervalIndex
     {
-        int n_ambiguous = 0;
-        
-        if (target.locations.size() == 0)
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate ambiguity. SequenceAnnotation " + target.identity.get() + " is invalid for this operation because it has no Range specified");
-        if (target.locations.size() > 1)
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate ambiguity. SequenceAnnotation " + target.identity.get() + " is invalid for this operation because it has more than one Range specified");
-        sbol::Range& r_target = (sbol::Range&)target.locations[0];
-    //    cout << r_target.start.get() << "\t" << r_target.end.get() << "\t";
-        
-        for (auto &p_qc : qc_annotations)
+    public:
+        QCIntervalIndex(vector<SequenceAnnotation*>& qc_annotations)
         {
-            SequenceAnnotation& qc = *p_qc;
-            if (qc.locations.size() == 0)
-                throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate ambiguity. SequenceAnnotation " + qc.identity.get() + " is invalid for this operation because it has no Range specified");
-            if (qc.locations.size() > 1)
-                throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate ambiguity. A SequenceAnnotation " + qc.identity.get() + " is invalid for this operation because it has more than one Range specified");
-            sbol::Range& r_qc = (sbol::Range&)qc.locations[0];
-    //        cout << r_qc.start.get() << "\t" << r_qc.end.get();
-            
-            
-            string qc_classification = qc.roles.get();
-            if (qc_classification.compare(SO_POSSIBLE_ASSEMBLY_ERROR) == 0)
+            // Each annotation adds 1 to the depth of its class at its start and subtracts 1 past its end
+            vector< pair<int, int> > events;  // Position, signed class
+            events.reserve(2 * qc_annotations.size());
+            for (auto & p_qc : qc_annotations)
             {
-                n_ambiguous += r_target.contains(r_qc) + r_target.overlaps(r_qc);
-    //            cout << SO_POSSIBLE_ASSEMBLY_ERROR << "\n\t\t";
+                SequenceAnnotation& qc = *p_qc;
+                if (qc.locations.size() == 0)
+                    throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate QC statistics. SequenceAnnotation " + qc.identity.get() + " is invalid for this operation because it has no Range specified");
+                if (qc.locations.size() > 1)
+                    throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate QC statistics. A SequenceAnnotation " + qc.identity.get() + " is invalid for this operation because it has more than one Range specified");
+                Range* r_qc = dynamic_cast<Range*>(&qc.locations[0]);
+                if (!r_qc)
+                    throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate QC statistics. SequenceAnnotation " + qc.identity.get() + " is invalid for this operation because its location is not a Range");
+
+                string qc_classification = qc.roles.size() ? qc.roles.get() : "";
+                int qc_class;
+                if (qc_classification == SO_NUCLEOTIDE_MATCH)
+                    qc_class = QC_MATCH;
+                else if (qc_classification == SO_SUBSTITUTION)
+                    qc_class = QC_SUBSTITUTION;
+                else if (qc_classification == SO_DELETION)
+                    qc_class = QC_DELETION;
+                else if (qc_classification == SO_INSERTION)
+                    qc_class = QC_INSERTION;
+                else if (qc_classification == SO_POSSIBLE_ASSEMBLY_ERROR)
+                    qc_class = QC_AMBIGUITY;
+                else
+                    continue;
+                int start = r_qc->start.get();
+                int end = r_qc->end.get();
+                if (end < start)
+                    continue;
+                events.push_back(make_pair(start, qc_class + 1));
+                events.push_back(make_pair(end + 1, -(qc_class + 1)));
             }
-    //        else
-    //            cout << "\n\t\t";
-        }
-    //    cout << "\n";
-        return (float)n_ambiguous / (float)r_target.length();
+            sort(events.begin(), events.end());
+
+            // Record the depth of each class between consecutive breakpoints, and the cumulative number of bases before each breakpoint
+            vector<int> depth(N_QC_CLASSES, 0);
+            for (auto & event : events)
+            {
+                if (breakpoints.empty() || breakpoints.back() != event.first)
+                {
+                    vector<long long> bases_before(N_QC_CLASSES, 0);
+                    if (!breakpoints.empty())
+                        for (int i_class = 0; i_class < N_QC_CLASSES; ++i_class)
+                            bases_before[i_class] = cumulative.back()[i_class] + (long long)depths.back()[i_class] * (event.first - breakpoints.back());
+                    breakpoints.push_back(event.first);
+                    cumulative.push_back(bases_before);
+                    depths.push_back(depth);
+                }
+                int qc_class = abs(event.second) - 1;
+                depth[qc_class] += event.second > 0 ? 1 : -1;
+                depths.back()[qc_class] = depth[qc_class];
+            }
+        };
+
+        // Counts the bases of each class from start to end, inclusive
+        vector<long long> count(int start, int end) const
+        {
+            vector<long long> n_bases = basesBefore(end + 1);
+            vector<long long> n_before = basesBefore(start);
+            for (int i_class = 0; i_class < N_QC_CLASSES; ++i_class)
+                n_bases[i_class] -= n_before[i_class];
+            return n_bases;
+        };
+
+    private:
+        // The number of bases of each class at positions less than pos
+        vector<long long> basesBefore(int pos) const
+        {
+            vector<long long> n_bases(N_QC_CLASSES, 0);
+            size_t i_breakpoint = upper_bound(breakpoints.begin(), breakpoints.end(), pos) - breakpoints.begin();
+            if (i_breakpoint == 0)
+                return n_bases;
+            --i_breakpoint;
+            for (int i_class = 0; i_class < N_QC_CLASSES; ++i_class)
+                n_bases[i_class] = cumulative[i_breakpoint][i_class] + (long long)depths[i_breakpoint][i_class] * (pos - breakpoints[i_breakpoint]);
+            return n_bases;
+        };
+
+        vector<int> breakpoints;
+        vector< vector<long long> > cumulative;
+        vector< vector<int> > depths;
     };
 
-    float calculateCoverage(SequenceAnnotation& target, vector<SequenceAnnotation*> qc_annotations)
+    // A region of the target whose QC statistics are reported, and the URI of the ComponentDefinition it is reported for
+    struct QCTarget
     {
-        return calculateIdentity(target, qc_annotations) + calculateError(target, qc_annotations) + calculateAmbiguity(target, qc_annotations);
+        string uri;
+        int start;
+        int end;
     };
 
     void get_sequence_annotation_callback(ComponentDefinition* cdef_node, void * user_data)
@@ -1072,184 +1121,294 @@ namespace sbol
             cumulative_annotations.insert(cumulative_annotations.end(), annotations.begin(), annotations.end());
         }
     };
-    
-    std::unordered_map < std::string, std::tuple < int, int, float > > reportQC(ComponentDefinition& target, ComponentDefinition& construct, float (*qc_method)(SequenceAnnotation&, vector<SequenceAnnotation*>))
-    {
-        std::unordered_map < std::string, std::tuple < int, int, float > > qc_report;  // Maps the URI of the ComponentDefinition to its qc statistic and its start and end coordinates
 
+    // Gathers the regions of a target design which are reported by a QC report. These are its annotated sub-Components, its
+    // annotated features, and the complete target, in the order that their entries are written to the report.
+    vector<QCTarget> get_qc_targets(ComponentDefinition& target)
+    {
+        vector<QCTarget> qc_targets;
         vector<SequenceAnnotation*> target_annotations;
-        vector<SequenceAnnotation*> qc_annotations;
 
         // Recursively gather all sub-Components through their SequenceAnnotation
         target.applyToComponentHierarchy(get_sequence_annotation_callback, &target_annotations);
-        construct.applyToComponentHierarchy(get_sequence_annotation_callback, &qc_annotations);
-        
+
         if (Config::getOption("verbose") == "True")
-        {
-            std::cout << "Generating QC report..." << std::endl;
             std::cout << "Found " << target_annotations.size() << " target annotations" << std::endl;
-            std::cout << "Found " << qc_annotations.size() << " QC annotations" << std::endl;
-        }
-        
+
         for (auto &ann_target : target_annotations)
         {
             ComponentDefinition& parent_cdef = (ComponentDefinition&)*ann_target->parent;
-            if (ann_target->locations.size() > 0)
+            if (ann_target->locations.size() == 0)
+                continue;
+
+            // Skip over SequenceAnnotations that neither have a corresponding Component nor a role
+            string uri;
+            if (ann_target->component.size())
             {
-                sbol::Range& r = (sbol::Range&)ann_target->locations[0];
-                // Skip over SequenceAnnotations that do not have a corresponding Component
-                if (ann_target->component.size())
+                Component& c = parent_cdef.components[ann_target->component.get()];
+                ComponentDefinition& cdef = ann_target->doc->get<ComponentDefinition>(c.definition.get());
+                uri = cdef.identity.get();
+            }
+            else if (ann_target->roles.size() > 0)
+                uri = parent_cdef.identity.get();
+            else
+                continue;
+
+            if (ann_target->locations.size() > 1)
+                throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate QC statistics. SequenceAnnotation " + ann_target->identity.get() + " is invalid for this operation because it has more than one Range specified");
+            Range* r = dynamic_cast<Range*>(&ann_target->locations[0]);
+            if (!r)
+                throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot calculate QC statistics. SequenceAnnotation " + ann_target->identity.get() + " is invalid for this operation because its location is not a Range");
+            qc_targets.push_back({ uri, r->start.get(), r->end.get() });
+        }
+
+        // Calculate cumulative statistics at the highest level of the component hierarchy.
+        Sequence& target_seq = target.doc->get<Sequence>(target.sequences.get());
+        qc_targets.push_back({ target.identity.get(), 1, target_seq.length() });
+        return qc_targets;
+    };
+
+    QCStatistics calculate_qc_statistics(const QCTarget& qc_target, const QCIntervalIndex& qc_index)
+    {
+        vector<long long> n_bases = qc_index.count(qc_target.start, qc_target.end);
+        int length = qc_target.end + 1 - qc_target.start;
+        QCStatistics qc;
+        qc.start = qc_target.start;
+        qc.end = qc_target.end;
+        qc.identity = (float)n_bases[QC_MATCH] / (float)length;
+        qc.error = (float)(n_bases[QC_SUBSTITUTION] + n_bases[QC_DELETION] + n_bases[QC_INSERTION]) / (float)(length + n_bases[QC_INSERTION]);
+        qc.ambiguity = (float)n_bases[QC_AMBIGUITY] / (float)length;
+        qc.coverage = qc.identity + qc.error + qc.ambiguity;
+        return qc;
+    };
+
+    // Partitions the items 0..n_items-1 into contiguous blocks, one block per worker thread, and calls block_fn(i_begin, i_end)
+    // for each block. The first exception thrown by a worker is rethrown once every worker has finished.
+    void for_each_block(size_t n_items, int n_threads, std::function<void(size_t, size_t)> block_fn)
+    {
+        if (n_threads < 1)
+            n_threads = 1;
+        size_t block_size = (n_items + n_threads - 1) / n_threads;
+        vector<thread> workers;
+        vector<exception_ptr> errors(n_threads);
+        for (int i_thread = 0; i_thread < n_threads; ++i_thread)
+        {
+            size_t i_begin = i_thread * block_size;
+            size_t i_end = min(n_items, i_begin + block_size);
+            if (i_begin >= i_end)
+                break;
+            auto run_block = [&block_fn, &errors, i_thread, i_begin, i_end]()
+            {
+                try
                 {
-                    Component& c = parent_cdef.components[ann_target->component.get()];
-                    ComponentDefinition& cdef = ann_target->doc->get<ComponentDefinition>(c.definition.get());
-                    
-                    float qc_statistic = qc_method(*ann_target, qc_annotations);
-                    std::tuple < int, int, float > qc = std::make_tuple(r.start.get(), r.end.get(), qc_statistic);
-                    qc_report[ cdef.identity.get() ] = qc;
-                    
+                    block_fn(i_begin, i_end);
                 }
-                else if(ann_target->roles.size() > 0)
+                catch (...)
                 {
-                    float qc_statistic = qc_method(*ann_target, qc_annotations);
-                    std::tuple < int, int, float > qc = std::make_tuple(r.start.get(), r.end.get(), qc_statistic);
-                    qc_report[ parent_cdef.identity.get() ] = qc;
+                    errors[i_thread] = current_exception();
                 }
-            }
+            };
+            if (n_threads == 1)
+                run_block();
+            else
+                workers.push_back(thread(run_block));
         }
-        
-        // Calculate cumulative statistics at the highest level of the component hierarchy.
-        Sequence& target_seq = target.doc->get<Sequence>(target.sequences.get());
-        SequenceAnnotation target_sa = SequenceAnnotation("temporary");
-        Range& r = target_sa.locations.create<Range>("r");
-        r.start.set(1);
-        r.end.set(target_seq.elements.get().size());
-        float qc_statistic = qc_method(target_sa, qc_annotations);
-        std::tuple < int, int, float > qc = std::make_tuple(r.start.get(), r.end.get(), qc_statistic);
-        qc_report[ target.identity.get() ] = qc;
-        return qc_report;
+        for (auto & worker : workers)
+            worker.join();
+        for (auto & error : errors)
+            if (error)
+                rethrow_exception(error);
     };
-    
-    
-    std::unordered_map < std::string, std::tuple < int, int, float > > Analysis::reportIdentity()
+
+    // Calculates the QC statistics of every target region against the QC annotations of a construct. The regions are
+    // independent once the QC annotations are indexed, so they are partitioned across worker threads.
+    vector<QCStatistics> calculate_qc_report(const vector<QCTarget>& qc_targets, vector<SequenceAnnotation*>& qc_annotations, int n_threads)
     {
-        if (!doc)
-            throw SBOLError(SBOL_ERROR_MISSING_DOCUMENT, "Cannot generate QC report. Analysis " + identity.get() + " does not belong to a Document");
+        QCIntervalIndex qc_index(qc_annotations);
+        vector<QCStatistics> statistics(qc_targets.size());
+        for_each_block(qc_targets.size(), n_threads, [&qc_targets, &qc_index, &statistics](size_t i_begin, size_t i_end)
+        {
+            for (size_t i_target = i_begin; i_target < i_end; ++i_target)
+                statistics[i_target] = calculate_qc_statistics(qc_targets[i_target], qc_index);
+        });
+        return statistics;
+    };
 
-        // Retrieve Design by following links back through Analysis
-        if (!rawData.size() || !doc->tests.find(rawData.get()))
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report because the Analysis is not linked to a Test. The Analysis is not part of a Design-Build-Test-Analysis workflow.");
-        
-        Test& test = doc->get<Test>(rawData.get());
-        if (!test.samples.size() || !doc->builds.find(test.samples.get()) )
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report because the Analysis is not linked to a Build. The Analysis is not part of a Design-Build-Test-Analysis workflow.");
-        
-        Build& build = doc->get<Build>(test.samples.get());
-        if (!build.design.size() || !doc->designs.find(build.design.get()))
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report because the Analysis is not linked to a Design. The Analysis is not part of a Design-Build-Test-Analysis workflow.");
+    std::unordered_map < std::string, QCStatistics > report_qc(vector<QCTarget>& qc_targets, ComponentDefinition& construct, int n_threads)
+    {
+        vector<SequenceAnnotation*> qc_annotations;
+        construct.applyToComponentHierarchy(get_sequence_annotation_callback, &qc_annotations);
+        if (Config::getOption("verbose") == "True")
+        {
+            std::cout << "Generating QC report..." << std::endl;
+            std::cout << "Found " << qc_annotations.size() << " QC annotations" << std::endl;
+        }
+        vector<QCStatistics> statistics = calculate_qc_report(qc_targets, qc_annotations, n_threads);
 
-        Design& design = doc->get<Design>(build.design.get());
-        
-        if (!design.structure.size())
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report, because the structure property of the Design is unspecified.");
-        ComponentDefinition& target = design.structure.get();
-        
-        if (!build.structure.size())
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report, because the structure property of the Build is unspecified.");
-        ComponentDefinition& construct = build.structure.get();
+        // Later regions take precedence when two regions are reported for the same ComponentDefinition
+        std::unordered_map < std::string, QCStatistics > qc_report;  // Maps the URI of the ComponentDefinition to its qc statistics and its start and end coordinates
+        for (size_t i_target = 0; i_target < qc_targets.size(); ++i_target)
+        {
+            qc_report[ qc_targets[i_target].uri ] = statistics[i_target];
+            if (Config::getOption("verbose") == "True")
+            {
+                QCStatistics& qc = statistics[i_target];
+                cout << qc.start << "\t" << qc.end << "\tIdentity: " << qc.identity << "\tError: " << qc.error << "\tAmbiguity: " << qc.ambiguity << "\tCoverage: " << qc.coverage << endl;
+            }
+        }
+        return qc_report;
+    };
 
-        return ::reportQC(target, construct, &::calculateIdentity);
+    // Checks whether a TopLevel object is in the Document. Looking up the URI in the Document's object store first avoids a
+    // linear search of the OwnedObject when the URI is a full identity, which matters when many Analyses are reported.
+    template < class SBOLClass >
+    bool has_top_level(Document& doc, OwnedObject<SBOLClass>& objects, string uri)
+    {
+        auto i_obj = doc.SBOLObjects.find(uri);
+        if (i_obj != doc.SBOLObjects.end() && dynamic_cast<SBOLClass*>(i_obj->second))
+            return true;
+        return objects.find(uri);
     };
-    
-    std::unordered_map < std::string, std::tuple < int, int, float > > Analysis::reportError()
+
+    // Follows the links from an Analysis back through its Test and Build to the Design, and returns the structures of the
+    // Design and Build which are compared by a QC report
+    void get_qc_structures(Analysis& analysis, ComponentDefinition*& target, ComponentDefinition*& construct)
     {
+        Document* doc = analysis.doc;
         if (!doc)
-            throw SBOLError(SBOL_ERROR_MISSING_DOCUMENT, "Cannot generate QC report. Analysis " + identity.get() + " does not belong to a Document");
+            throw SBOLError(SBOL_ERROR_MISSING_DOCUMENT, "Cannot generate QC report. Analysis " + analysis.identity.get() + " does not belong to a Document");
 
         // Retrieve Design by following links back through Analysis
-        if (!rawData.size() || !doc->tests.find(rawData.get()))
+        if (!analysis.rawData.size() || !has_top_level(*doc, doc->tests, analysis.rawData.get()))
             throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report because the Analysis is not linked to a Test. The Analysis is not part of a Design-Build-Test-Analysis workflow.");
-        
-        Test& test = doc->get<Test>(rawData.get());
-        if (!test.samples.size() || !doc->builds.find(test.samples.get()) )
+
+        Test& test = doc->get<Test>(analysis.rawData.get());
+        if (!test.samples.size() || !has_top_level(*doc, doc->builds, test.samples.get()) )
             throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report because the Analysis is not linked to a Build. The Analysis is not part of a Design-Build-Test-Analysis workflow.");
-        
+
         Build& build = doc->get<Build>(test.samples.get());
-        if (!build.design.size() || !doc->designs.find(build.design.get()))
+        if (!build.design.size() || !has_top_level(*doc, doc->designs, build.design.get()))
             throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report because the Analysis is not linked to a Design. The Analysis is not part of a Design-Build-Test-Analysis workflow.");
 
         Design& design = doc->get<Design>(build.design.get());
-        
+
         if (!design.structure.size())
             throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report, because the structure property of the Design is unspecified.");
-        ComponentDefinition& target = design.structure.get();
-        
+        target = &design.structure.get();
+
         if (!build.structure.size())
             throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report, because the structure property of the Build is unspecified.");
-        ComponentDefinition& construct = build.structure.get();
+        construct = &build.structure.get();
+    };
 
-        return ::reportQC(target, construct, &::calculateError);
+    std::unordered_map < std::string, QCStatistics > Analysis::reportQC(int n_threads)
+    {
+        ComponentDefinition* target;
+        ComponentDefinition* construct;
+        get_qc_structures(*this, target, construct);
+        vector<QCTarget> qc_targets = get_qc_targets(*target);
+        return report_qc(qc_targets, *construct, n_threads);
     };
-    
-    std::unordered_map < std::string, std::tuple < int, int, float > > Analysis::reportCoverage()
+
+    QCReportTable Document::reportQC(std::vector<std::string> analysis_uris, int n_threads)
     {
-        if (!doc)
-            throw SBOLError(SBOL_ERROR_MISSING_DOCUMENT, "Cannot generate QC report. Analysis " + identity.get() + " does not belong to a Document");
+        if (analysis_uris.empty())
+            for (auto & analysis : analyses.getAll())
+                analysis_uris.push_back(analysis->identity.get());
+
+        // Resolve the links of every Analysis back to its Design and Build. Builds of the same Design share the Design's
+        // target regions, so the Design's hierarchy is only gathered once.
+        vector<ComponentDefinition*> constructs;
+        vector<vector<QCTarget>*> analysis_targets;
+        unordered_map<ComponentDefinition*, vector<QCTarget>> target_cache;
+        for (auto & analysis_uri : analysis_uris)
+        {
+            Analysis& analysis = get<Analysis>(analysis_uri);
+            ComponentDefinition* target;
+            ComponentDefinition* construct;
+            get_qc_structures(analysis, target, construct);
+            auto i_targets = target_cache.find(target);
+            if (i_targets == target_cache.end())
+                i_targets = target_cache.emplace(target, get_qc_targets(*target)).first;
+            constructs.push_back(construct);
+            analysis_targets.push_back(&i_targets->second);
+        }
 
-        // Retrieve Design by following links back through Analysis
-        if (!rawData.size() || !doc->tests.find(rawData.get()))
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report because the Analysis is not linked to a Test. The Analysis is not part of a Design-Build-Test-Analysis workflow.");
-        
-        Test& test = doc->get<Test>(rawData.get());
-        if (!test.samples.size() || !doc->builds.find(test.samples.get()) )
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report because the Analysis is not linked to a Build. The Analysis is not part of a Design-Build-Test-Analysis workflow.");
-        
-        Build& build = doc->get<Build>(test.samples.get());
-        if (!build.design.size() || !doc->designs.find(build.design.get()))
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report because the Analysis is not linked to a Design. The Analysis is not part of a Design-Build-Test-Analysis workflow.");
+        // The Analyses only read the Document, so they are partitioned across worker threads
+        vector<vector<QCStatistics>> statistics(analysis_uris.size());
+        for_each_block(analysis_uris.size(), n_threads, [&constructs, &analysis_targets, &statistics](size_t i_begin, size_t i_end)
+        {
+            for (size_t i_analysis = i_begin; i_analysis < i_end; ++i_analysis)
+            {
+                vector<SequenceAnnotation*> qc_annotations;
+                constructs[i_analysis]->applyToComponentHierarchy(get_sequence_annotation_callback, &qc_annotations);
+                statistics[i_analysis] = calculate_qc_report(*analysis_targets[i_analysis], qc_annotations, 1);
+            }
+        });
 
-        Design& design = doc->get<Design>(build.design.get());
-        
-        if (!design.structure.size())
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report, because the structure property of the Design is unspecified.");
-        ComponentDefinition& target = design.structure.get();
-        
-        if (!build.structure.size())
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report, because the structure property of the Build is unspecified.");
-        ComponentDefinition& construct = build.structure.get();
+        // Write one row for each ComponentDefinition reported by each Analysis. As in Analysis::reportQC, later regions take
+        // precedence when two regions are reported for the same ComponentDefinition.
+        QCReportTable table;
+        for (size_t i_analysis = 0; i_analysis < analysis_uris.size(); ++i_analysis)
+        {
+            vector<QCTarget>& qc_targets = *analysis_targets[i_analysis];
+            unordered_map<string, size_t> rows;
+            for (size_t i_target = 0; i_target < qc_targets.size(); ++i_target)
+            {
+                size_t i_row = table.size();
+                auto i_existing = rows.find(qc_targets[i_target].uri);
+                if (i_existing == rows.end())
+                {
+                    rows[qc_targets[i_target].uri] = i_row;
+                    table.analysis.push_back(analysis_uris[i_analysis]);
+                    table.definition.push_back(qc_targets[i_target].uri);
+                    table.start.push_back(0);
+                    table.end.push_back(0);
+                    table.identity.push_back(0);
+                    table.error.push_back(0);
+                    table.ambiguity.push_back(0);
+                    table.coverage.push_back(0);
+                }
+                else
+                    i_row = i_existing->second;
+                QCStatistics& qc = statistics[i_analysis][i_target];
+                table.start[i_row] = qc.start;
+                table.end[i_row] = qc.end;
+                table.identity[i_row] = qc.identity;
+                table.error[i_row] = qc.error;
+                table.ambiguity[i_row] = qc.ambiguity;
+                table.coverage[i_row] = qc.coverage;
+            }
+        }
+        return table;
+    };
 
-        return ::reportQC(target, construct, &::calculateCoverage);
+    // Selects one statistic from each entry of a QC report
+    std::unordered_map < std::string, std::tuple < int, int, float > > select_qc_statistic(std::unordered_map < std::string, QCStatistics > qc_report, float QCStatistics::*qc_statistic)
+    {
+        std::unordered_map < std::string, std::tuple < int, int, float > > qc_report_statistic;
+        for (auto & i_entry : qc_report)
+            qc_report_statistic[ i_entry.first ] = std::make_tuple(i_entry.second.start, i_entry.second.end, i_entry.second.*qc_statistic);
+        return qc_report_statistic;
     };
-    
-    std::unordered_map < std::string, std::tuple < int, int, float > > Analysis::reportAmbiguity()
+
+    std::unordered_map < std::string, std::tuple < int, int, float > > Analysis::reportIdentity()
     {
-        if (!doc)
-            throw SBOLError(SBOL_ERROR_MISSING_DOCUMENT, "Cannot generate QC report. Analysis " + identity.get() + " does not belong to a Document");
+        return select_qc_statistic(reportQC(), &QCStatistics::identity);
+    };
 
-        // Retrieve Design by following links back through Analysis
-        if (!rawData.size() || !doc->tests.find(rawData.get()))
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report because the Analysis is not linked to a Test. The Analysis is not part of a Design-Build-Test-Analysis workflow.");
-        
-        Test& test = doc->get<Test>(rawData.get());
-        if (!test.samples.size() || !doc->builds.find(test.samples.get()) )
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report because the Analysis is not linked to a Build. The Analysis is not part of a Design-Build-Test-Analysis workflow.");
-        
-        Build& build = doc->get<Build>(test.samples.get());
-        if (!build.design.size() || !doc->designs.find(build.design.get()))
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report because the Analysis is not linked to a Design. The Analysis is not part of a Design-Build-Test-Analysis workflow.");
+    std::unordered_map < std::string, std::tuple < int, int, float > > Analysis::reportError()
+    {
+        return select_qc_statistic(reportQC(), &QCStatistics::error);
+    };
 
-        Design& design = doc->get<Design>(build.design.get());
-        
-        if (!design.structure.size())
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report, because the structure property of the Design is unspecified.");
-        ComponentDefinition& target = design.structure.get();
-        
-        if (!build.structure.size())
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot generate QC report, because the structure property of the Build is unspecified.");
-        ComponentDefinition& construct = build.structure.get();
+    std::unordered_map < std::string, std::tuple < int, int, float > > Analysis::reportCoverage()
+    {
+        return select_qc_statistic(reportQC(), &QCStatistics::coverage);
+    };
 
-        return ::reportQC(target, construct, &::calculateAmbiguity);
+    std::unordered_map < std::string, std::tuple < int, int, float > > Analysis::reportAmbiguity()
+    {
+        return select_qc_statistic(reportQC(), &QCStatistics::ambiguity);
     };
-    
-    
-    
 };
@@ -246,6 +246,33 @@ namespace sbol
     template<>
     Test& TopLevel::generate<Test>(std::string uri, Agent& agent, Plan& plan, std::vector < Identified* > usages);
 
+    /// QC statistics for a region of a Design's target Sequence, as reported by Analysis::reportQC. Each statistic is a fraction of the region's length.
+    struct SBOL_DECLSPEC QCStatistics
+    {
+        int start;          ///< The first position of the region
+        int end;            ///< The last position of the region, inclusive
+        float identity;     ///< The fraction of bases which were verified to match the target
+        float error;        ///< The fraction of bases with a substitution, deletion or insertion
+        float ambiguity;    ///< The fraction of bases which could not be resolved by sequencing
+        float coverage;     ///< The sum of identity, error and ambiguity
+    };
+
+    /// QC statistics for many Analyses, as reported by Document::reportQC. The table is stored by column, so row i of the table is the i-th element of every column.
+    struct SBOL_DECLSPEC QCReportTable
+    {
+        std::vector<std::string> analysis;      ///< The URI of the Analysis
+        std::vector<std::string> definition;    ///< The URI of the ComponentDefinition whose region is reported
+        std::vector<int> start;                 ///< The first position of the region
+        std::vector<int> end;                   ///< The last position of the region, inclusive
+        std::vector<float> identity;            ///< The fraction of bases which were verified to match the target
+        std::vector<float> error;               ///< The fraction of bases with a substitution, deletion or insertion
+        std::vector<float> ambiguity;           ///< The fraction of bases which could not be resolved by sequencing
+        std::vector<float> coverage;            ///< The sum of identity, error and ambiguity
+
+        /// @return The number of rows
+        size_t size() const { return analysis.size(); };
+    };
+
     class Analysis : public TopLevel
     {
     friend class Document;
@@ -286,7 +313,16 @@ namespace sbol
         
         /// Compare a consensus Sequence to the target Sequence
         void verifyTarget(Sequence& consensus_sequence);
+
+        /// Align a sequencing read to the target Sequence of the Design, and annotate the Build with the regions in which the read matches or varies from the target. Unlike verifyTarget, the read need not be aligned in advance. The best local alignment is found with a vectorized Smith-Waterman search, so the read may cover only part of the target.
+        /// @param sequence The sequencing read, which becomes the consensusSequence of this Analysis and the Sequence of the Build
+        void alignTarget(Sequence& sequence);
         
+        /// Compare the Build's structure to the Design's structure, and calculate the identity, error, ambiguity and coverage of each annotated region of the Design in a single pass. Call verifyTarget first, to annotate the Build with the results of sequencing.
+        /// @param n_threads The number of threads across which the regions are partitioned
+        /// @return Maps the URI of each ComponentDefinition in the Design's hierarchy, and of the Design's structure itself, to the QC statistics of its region
+        std::unordered_map < std::string, QCStatistics > reportQC(int n_threads = 1);
+
         std::unordered_map < std::string, std::tuple < int, int, float > > reportIdentity();
 
         std::unordered_map < std::string, std::tuple < int, int, float > > reportError();
@@ -987,6 +987,17 @@ void sbol::raptor_error_handler(void *user_data, raptor_log_message* message)
 */
 std::string Document::validate()
 {
+    if (Config::getOption("validator") == "local")
+    {
+        if (Config::getOption("validate") != "True")
+            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot validate Document. To enable validation, use Config::setOption(\"validate\").");
+        vector<string> errors = validate_locally(*this);
+        string response = errors.size() ? "Invalid." : "Valid.";
+        for (auto& error : errors)
+            response += " " + error;
+        return response;
+    }
+
 	raptor_world* world = getWorld();
 	raptor_serializer* sbol_serializer;
 	if (Config::getOption("serialization_format") == "sbol" || Config::getOption("serialization_format") == "rdfxml")
@@ -1063,6 +1074,16 @@ void Document::cacheObjects() {
 }
 
 void Document::serialize_rdfxml(std::ostream &os) {
+    serialize_rdfxml_header(os);
+
+    // Add top level SBOL objects
+    for(auto objPair : SBOLObjects)
+        serialize_rdfxml_toplevel(os, *objPair.second);
+
+    serialize_rdfxml_footer(os);
+}
+
+void Document::serialize_rdfxml_header(std::ostream &os) {
     // RDF/XML Header
     os << "<?xml version=\"1.0\" ?>" << std::endl;
 
@@ -1088,43 +1109,42 @@ void Document::serialize_rdfxml(std::ostream &os) {
            << nsPair.second << "\"";
     }
     os << ">" << std::endl;
+}
 
-    // Add top level SBOL objects
-    for(auto objPair : SBOLObjects)
+void Document::serialize_rdfxml_toplevel(std::ostream &os, SBOLObject &obj) {
+    bool topLevel = false;
+    SBOLObject *parent = obj.parent;
+    auto typeURI = obj.getTypeURI();
+
+    // If an object has a parent and is not a hidden property it is
+    // not a top-level object
+    // if((parent != NULL) &&
+    //    (std::find(parent->hidden_properties.begin(),
+    //               parent->hidden_properties.end(),
+    //               typeURI) == hidden_properties.end()))
+    // {
+    //     return;
+    // }
+
+    if(dynamic_cast<TopLevel*>(&obj) == NULL)
     {
-        SBOLObject &obj = *objPair.second;
-        bool topLevel = false;
-        SBOLObject *parent = obj.parent;
-        auto typeURI = obj.getTypeURI();
-
-        // If an object has a parent and is not a hidden property it is
-        // not a top-level object
-        // if((parent != NULL) &&
-        //    (std::find(parent->hidden_properties.begin(),
-        //               parent->hidden_properties.end(),
-        //               typeURI) == hidden_properties.end()))
-        // {
-        //     continue;
-        // }
-
-        if(dynamic_cast<TopLevel*>(&obj) == NULL)
-        {
-        	continue;
-        }
+    	return;
+    }
 
 
-        std::string identity = obj.identity.get();
-        std::string rdfType = referenceNamespace(typeURI);
+    std::string identity = obj.identity.get();
+    std::string rdfType = referenceNamespace(typeURI);
 
-        os << "  <" << rdfType << " rdf:about=\""
-           << identity << "\">" << std::endl;
+    os << "  <" << rdfType << " rdf:about=\""
+       << identity << "\">" << std::endl;
 
-        // Add object properties
-        obj.serialize_rdfxml(os, 2);
+    // Add object properties
+    obj.serialize_rdfxml(os, 2);
 
-        os << "  </" << rdfType << ">" << std::endl;
-    }
+    os << "  </" << rdfType << ">" << std::endl;
+}
 
+void Document::serialize_rdfxml_footer(std::ostream &os) {
     os << "</rdf:RDF>" << std::endl;
 }
 
@@ -1182,6 +1202,8 @@ void Document::clear()
         obj.close();
     }
     SBOLObjects.clear();
+    verification_cache.clear();
+    provenance = ProvenanceIndex();
 //    properties.clear();  // This may cause problems later because the Document object will lose all properties of an SBOLObject
 //    properties[SBOL_IDENTITY].push_back("<>");  // Re-initialize the identity property. The SBOLObject::compare method needs to get the Document's identity
 //    owned_objects.clear();
@@ -1364,6 +1386,7 @@ void Document::append(std::string filename)
 
     // On the final pass, nested annotations not in the SBOL namespace are identified
     parse_annotation_objects();
+    provenance = ProvenanceIndex();  // Objects are assembled piecewise while parsing, so the next query rebuilds the index
 
     // Process libSBOL objects not part of the SBOL core standard
     dress_document();
@@ -1376,15 +1399,78 @@ void Document::append(std::string filename)
     }
 }
 
+// Moves the TopLevels of another Document, such as a scratch Document parsed on a worker thread, into this Document, keeping
+// each in the same store, eg, designs or builds. Objects which this Document already contains are left behind, and are
+// destroyed with the source Document.
+void Document::absorb(Document& source)
+{
+    auto set_document = [this](SBOLObject* obj)
+    {
+        vector<SBOLObject*> subtree = { obj };
+        while (subtree.size())
+        {
+            SBOLObject* child = subtree.back();
+            subtree.pop_back();
+            child->doc = this;
+            for (auto& i_child_store : child->owned_objects)
+                subtree.insert(subtree.end(), i_child_store.second.begin(), i_child_store.second.end());
+        }
+    };
+    for (auto& i_store : source.owned_objects)
+    {
+        vector<SBOLObject*> duplicates;
+        for (auto obj : i_store.second)
+        {
+            string uri = obj->identity.get();
+            if (SBOLObjects.count(uri))
+            {
+                duplicates.push_back(obj);
+                continue;
+            }
+            source.SBOLObjects.erase(uri);
+            source.markProvenanceStale(uri);
+            SBOLObjects[uri] = obj;
+            markProvenanceStale(uri);
+            owned_objects[i_store.first].push_back(obj);
+            obj->parent = this;
+            set_document(obj);
+        }
+        i_store.second = duplicates;
+    }
+    // Move TopLevels which do not belong to a store, such as generic annotation objects
+    for (auto i_obj = source.SBOLObjects.begin(); i_obj != source.SBOLObjects.end(); )
+    {
+        if (SBOLObjects.count(i_obj->first))
+        {
+            ++i_obj;
+            continue;
+        }
+        SBOLObjects[i_obj->first] = i_obj->second;
+        set_document(i_obj->second);
+        markProvenanceStale(i_obj->first);
+        source.markProvenanceStale(i_obj->first);
+        i_obj = source.SBOLObjects.erase(i_obj);
+    }
+    for (auto& ns : source.namespaces)
+        if (!namespaces.count(ns.first))
+            namespaces[ns.first] = ns.second;
+    resource_namespaces.insert(source.resource_namespaces.begin(), source.resource_namespaces.end());
+};
+
 void Document::readString(std::string& sbol)
+{
+    readString(sbol, Config::getOption("serialization_format"));
+}
+
+void Document::readString(std::string& sbol, std::string serialization_format)
 {
     raptor_world_set_log_handler(this->rdf_graph, NULL, raptor_error_handler); // Intercept raptor errors
 
     raptor_parser* rdf_parser;
-    if (Config::getOption("serialization_format") == "sbol")
+    if (serialization_format == "sbol")
     	rdf_parser = raptor_new_parser(this->rdf_graph, "rdfxml");
     else
-    	rdf_parser = raptor_new_parser(this->rdf_graph, Config::getOption("serialization_format").c_str());
+    	rdf_parser = raptor_new_parser(this->rdf_graph, serialization_format.c_str());
 
     raptor_parser_set_namespace_handler(rdf_parser, this, this->namespaceHandler);
 
@@ -1412,6 +1498,7 @@ void Document::readString(std::string& sbol)
 
     // On the final pass, nested annotations not in the SBOL namespace are identified
     parse_annotation_objects();
+    provenance = ProvenanceIndex();  // Objects are assembled piecewise while parsing, so the next query rebuilds the index
 
     // Process libSBOL objects not part of the SBOL core standard
     dress_document();
@@ -1460,6 +1547,7 @@ int Document::countTriples()
 
 void SBOLObject::serialize(raptor_serializer* sbol_serializer, raptor_world *sbol_world)
 {
+    unpack();
 	// Check if there is an RDF graph associated with this SBOLObject.  Only TopLevel objects can be belong to SBOL Documents, so
 	// only TopLevel objects have a valid back-pointer.
 	//
@@ -1608,6 +1696,7 @@ void SBOLObject::serialize(raptor_serializer* sbol_serializer, raptor_world *sbo
 void TopLevel::addToDocument(Document& doc)
 {
     doc.SBOLObjects[this->identity.get()] = this;
+    doc.markProvenanceStale(this->identity.get());
     this->doc = &doc;
     this->parent = &doc;
 };
@@ -1729,11 +1818,11 @@ std::string Document::write(std::string filename)
         fclose(fh);
     }
 
-	// Validate SBOL using online validator
-    if (Config::getOption("validate") == "True" && (Config::getOption("serialization_format") == "sbol" || Config::getOption("serialization_format") == "rdfxml"))
+	// Validate SBOL in-process, or using the online validator, which only accepts RDF/XML
+    if (Config::getOption("validate") == "True" && (Config::getOption("validator") == "local" || Config::getOption("serialization_format") == "sbol" || Config::getOption("serialization_format") == "rdfxml"))
 	    response = validate();
 	else
-	   response = "Validation disabled. To enable use of the online validation tool, use Config::setOption(\"validate\", true)";
+	   response = "Validation disabled. To enable validation, use Config::setOption(\"validate\", true)";
 
 	if (Config::getOption("verbose") == "True")
 	{
@@ -1863,6 +1952,7 @@ void Document::close(std::string uri)
             SBOLObject* obj = SBOLObjects[uri];
             obj->close();
             SBOLObjects.erase(uri);
+            markProvenanceStale(uri);
         }
     }
 };
@@ -1910,6 +2000,7 @@ std::string ReferencedObject::create(std::string uri)
 
 Identified& Identified::copy(Document* target_doc, string ns, string version)
 {
+    unpack();
     // Call constructor for the copy
 	string new_obj_type;
 	if (SBOL_DATA_MODEL_REGISTER.find(this->type) != SBOL_DATA_MODEL_REGISTER.end())
@@ -2066,6 +2157,7 @@ Identified& Identified::copy(Document* target_doc, string ns, string version)
 
 Identified& Identified::simpleCopy(string uri)
 {
+    unpack();
     // Call constructor for the copy
     Identified& new_obj = (Identified&)SBOL_DATA_MODEL_REGISTER[ this->type ]();
 
@@ -44,6 +44,7 @@
 
 #include <raptor2.h>
 #include <unordered_map>
+#include <unordered_set>
 #include <istream>
 #include <algorithm>
 #include <set>
@@ -60,6 +61,29 @@ namespace sbol {
     /// @cond
     // This is the global SBOL register for classes.  It maps an SBOL RDF type (eg, "http://sbolstandard.org/v2#Sequence" to a constructor
     extern std::unordered_map<std::string, sbol::SBOLObject&(*)()> SBOL_DATA_MODEL_REGISTER;
+
+    // A memoized regularity check for a single ComponentDefinition. It remains valid as long as the modification stamps of the ComponentDefinition and its Sequence are unchanged
+    struct VerificationRecord
+    {
+        unsigned long long cdef_stamp;
+        unsigned long long seq_stamp;
+        bool is_regular;
+        std::string msg;
+    };
+
+    // The provenance graph of a Document. Its nodes are URIs, and each edge runs from an object to a source upstream of it: an
+    // object it was derived from, the Activity that generated it, an entity used by an Activity, an Activity that informed
+    // another, or the Agent and Plan associated with an Activity. Edges are counted, since more than one reference may link
+    // the same nodes. The index is built by the first query. From then on, the Document records each TopLevel which is
+    // added, removed or modified, and the next query re-reads the edges of those TopLevels only
+    struct ProvenanceIndex
+    {
+        std::unordered_map<std::string, std::unordered_map<std::string, int>> sources;      // Upstream edges
+        std::unordered_map<std::string, std::unordered_map<std::string, int>> derivatives;  // Downstream edges
+        std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>> edges;  // The edges read from each TopLevel
+        std::unordered_set<std::string> stale;  // The TopLevels whose edges must be re-read
+        bool is_built = false;
+    };
     /// @endcond
 
     
@@ -122,9 +146,16 @@ namespace sbol {
 		std::unordered_map<std::string, sbol::SBOLObject*> SBOLObjects;
         std::map<std::string, sbol::SBOLObject*> objectCache;
         std::set<std::string> resource_namespaces;
+        std::unordered_map<std::string, VerificationRecord> verification_cache;  // Memoizes ComponentDefinition::isRegular, keyed by the identity of each ComponentDefinition checked
+        ProvenanceIndex provenance;
+
+        void indexProvenance();
+        void markProvenanceStale(const std::string& uri) { if (provenance.is_built) provenance.stale.insert(uri); };
+        std::vector<std::string> traverseProvenance(std::string uri, bool upstream, std::string type);
 
         TopLevel& getTopLevel(std::string);
         raptor_world* getWorld();
+        void absorb(Document& source);
         /// @endcond
 
         OwnedObject<Design> designs;
@@ -181,6 +212,11 @@ namespace sbol {
         /// Convert text in SBOL into data objects
         /// @param sbol A string formatted in SBOL
         void readString(std::string& sbol);
+
+        /// @cond
+        /// Convert text in the given serialization format into data objects, regardless of the serialization_format option
+        void readString(std::string& sbol, std::string serialization_format);
+        /// @endcond
         
         /// Convert data objects in this Document into textual SBOL
         std::string writeString();
@@ -209,14 +245,68 @@ namespace sbol {
 
         void serialize_rdfxml(std::ostream &os);
 
-        /// Run validation on this Document via the online validation tool.
+        /// @cond
+        // The parts of the RDF/XML serialization, so that a Document can be serialized one TopLevel at a time
+        void serialize_rdfxml_header(std::ostream &os);
+        void serialize_rdfxml_toplevel(std::ostream &os, SBOLObject &obj);
+        void serialize_rdfxml_footer(std::ostream &os);
+        /// @endcond
+
+        /// Run validation on this Document. By default the Document is serialized and sent to the online validation tool,
+        /// which checks it against every rule of the specification. If the validator option is set to local, it is checked
+        /// in-process instead, against only the rules which the local validator implements, see validate_locally.
         /// @return A string containing a message with the validation results
         std::string validate();
 
-        /// Convert this SBOL Document to GenBank or FASTA.
+        /// Check every object of this Document, without stopping at the first violation. The rules of the local validator
+        /// are run, along with the validation rules registered by each Property on the values it holds, except rules which
+        /// only guard or synchronize the change made by a setter. Objects are partitioned across the worker threads.
+        /// @param n_threads The number of threads which check the objects. This should be 1 if any Property has a rule
+        /// defined in C++ which is not thread-safe. Rules defined in Python are always run on the calling thread.
+        /// @return The violations which were found and the number of rules which were run
+        ValidationReport validateAll(int n_threads = 1);
+
+        /// Convert this SBOL Document to GenBank or FASTA. When the validator option is local, the conversion is done
+        /// in-process by exportToFormat, otherwise the Document is sent to the online validator.
+        /// @param language The format to convert to. If empty, the language option is used
+        /// @param output_path The file to write. If empty, a default name is used
+        /// @return The path of the file written when the conversion is done in-process, or the URL from which the
+        /// validator served the converted file when it is done online. In both cases the file is written to output_path
         std::string convert(std::string language = "", std::string output_path = "");
+
+        /// Read every record of a FASTA or GenBank file into this Document, as a ComponentDefinition with a Sequence for
+        /// each record. The file is read one record at a time. Use a SequenceFileReader to process files which are too
+        /// large to hold in one Document.
+        /// @param input_path The file to read
+        /// @param language FASTA or GenBank. By default, the format is detected from the file
+        void importFromFormat(std::string input_path, std::string language = "");
+
+        /// Write each ComponentDefinition of this Document which has a Sequence to a FASTA or GenBank file, one record at
+        /// a time, without the online validator. Each Sequence which none of those ComponentDefinitions refers to is
+        /// written as a record of its own.
+        /// @param language FASTA or GenBank
+        /// @param output_path The file to write
+        void exportToFormat(std::string language, std::string output_path);
         
         Document& copy(std::string ns = "", Document* doc = NULL, std::string version = "");
+
+        /// Generate QC reports for many Analyses at once. This is equivalent to calling Analysis::reportQC for each Analysis, but the links from each Analysis back to its Design are resolved once, the target regions of a Design are shared by all of its Builds, and the Analyses are processed concurrently.
+        /// @param analyses The URIs of the Analyses to report. By default, every Analysis in the Document is reported.
+        /// @param n_threads The number of threads across which the Analyses are partitioned
+        /// @return A table with one row for each ComponentDefinition reported by each Analysis
+        QCReportTable reportQC(std::vector<std::string> analyses = {}, int n_threads = 1);
+
+        /// Find the full lineage of an object: the objects it was derived from, the Activity that generated it, the entities used by that Activity and its associated Agents and Plans, and so on recursively. The Document maintains an index of provenance relationships in both directions, so the lineage is found in time proportional to its size, rather than by searching every object.
+        /// @param uri The URI of any object, or of a non-SBOL resource referred to by provenance properties
+        /// @param type If specified, only TopLevel objects of this RDF type, eg, SYSBIO_DESIGN, are returned
+        /// @return URIs in order of increasing distance from the object
+        std::vector<std::string> getAncestors(std::string uri, std::string type = "");
+
+        /// Find all objects downstream of an object in the provenance graph: the objects derived from it, the Activities which used it and the objects they generated, and so on recursively. For example, the Builds derived from a Design, or everything generated by Activities associated with an Agent or Plan.
+        /// @param uri The URI of any object, or of a non-SBOL resource referred to by provenance properties
+        /// @param type If specified, only TopLevel objects of this RDF type, eg, SBOL_IMPLEMENTATION for Builds, are returned
+        /// @return URIs in order of increasing distance from the object
+        std::vector<std::string> getDescendants(std::string uri, std::string type = "");
         
         /// Get the total number of objects in the Document, including SBOL core object and custom annotation objects
         int size()
@@ -436,7 +526,10 @@ namespace sbol {
         {
             // If TopLevel add to Document.
             if (dynamic_cast<TopLevel*>(&sbol_obj))
+            {
                 SBOLObjects[sbol_obj.identity.get()] = (SBOLObject*)&sbol_obj;
+                markProvenanceStale(sbol_obj.identity.get());
+            }
             if (owned_objects.find(sbol_obj.type) != owned_objects.end())
             {
                 sbol_obj.parent = this;  // Set back-pointer to parent object
@@ -640,9 +733,15 @@ namespace sbol {
             
             // Check for uniqueness of URI in the Document
             if (parent_doc && parent_doc->find(child_id))
+            {
+                delete child_obj;
                 throw SBOLError(SBOL_ERROR_URI_NOT_UNIQUE, "An object with URI " + child_id + " is already in the Document");
+            }
             if (this->find(child_id))
+            {
+                delete child_obj;
                 throw SBOLError(SBOL_ERROR_URI_NOT_UNIQUE, "An object with URI " + child_id + " is already in the " + this->type + " property");
+            }
             
             // Initialize SBOLCompliant properties
             child_obj->identity.set(child_id);
@@ -655,12 +754,16 @@ namespace sbol {
             child_obj->parent = parent_obj;  // Set back-pointer to parent object
             std::vector< sbol::SBOLObject* >& object_store = this->sbol_owner->owned_objects[this->type];
             object_store.push_back((SBOLObject*)child_obj);
+            this->sbol_owner->markModified();
 
             // The following effectively adds the child object to the Document by setting its back-pointer.  However, the Document itself only maintains a register of TopLevel objects, otherwise the returned object will not be registered
             if (parent_doc)
                 child_obj->doc = parent_doc;
             if (CHECK_TOP_LEVEL && parent_doc)
+            {
                 parent_doc->SBOLObjects[child_id] = (SBOLObject*)child_obj;
+                parent_doc->markProvenanceStale(child_id);
+            }
             
             this->validate(child_obj);
             return *child_obj;
@@ -668,7 +771,10 @@ namespace sbol {
         else
         {
             if (parent_doc && parent_doc->find(uri))
+            {
+                delete child_obj;
                 throw SBOLError(SBOL_ERROR_URI_NOT_UNIQUE, "An object with URI " + uri + " is already in the Document");
+            }
             
             // Construct a new child object
             //SBOLClass* child_obj = new SBOLClass(uri);
@@ -749,12 +855,16 @@ namespace sbol {
             child_obj->parent = parent_obj;  // Set back-pointer to parent object
             std::vector< sbol::SBOLObject* >& object_store = this->sbol_owner->owned_objects[this->type];
             object_store.push_back(child_obj);
+            this->sbol_owner->markModified();
             
             // The following effectively adds the child object to the Document by setting its back-pointer.  However, the Document itself only maintains a register of TopLevel objects, otherwise the returned object will not be registered
             if (parent_doc)
                 child_obj->doc = parent_doc;
             if (CHECK_TOP_LEVEL)
+            {
                 parent_doc->SBOLObjects[child_id] = (SBOLObject*)child_obj;
+                parent_doc->markProvenanceStale(child_id);
+            }
 
             this->validate(child_obj);
             return *child_obj;
@@ -808,6 +918,7 @@ namespace sbol {
         else
             throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot set " + parsePropertyName(this->type) + " property. The property is already set. Call remove before attempting to overwrite the value.");
         sbol_obj.parent = this->sbol_owner;  // Set back-pointer to parent object
+        this->sbol_owner->markModified();
         
         // Update URI for the argument object and all its children, if SBOL-compliance is enabled.
         sbol_obj.update_uri();
@@ -841,6 +952,7 @@ namespace sbol {
                 
                 // Add to parent object
                 object_store.push_back((SBOLObject *)&sbol_obj);
+                this->sbol_owner->markModified();
                 sbol_obj.parent = this->sbol_owner;  // Set back-pointer to parent object
                 
                 // Update URI for the argument object and all its children, if SBOL-compliance is enabled.
@@ -1222,6 +1334,7 @@ namespace sbol {
             SBOLObject* sbol_obj = getSwigClient(py_obj);
             sbol_obj->parent = this->sbol_owner;
             this->sbol_owner->owned_objects[this->type][0] = sbol_obj;
+            this->sbol_owner->markModified();
             this->sbol_owner->PythonObjects[sbol_obj->identity.get()] = py_obj;
         };
         
@@ -1237,6 +1350,7 @@ namespace sbol {
                 {
                     Document& doc = (Document &)*this->sbol_owner;
                     doc.SBOLObjects[sbol_obj->identity.get()] = sbol_obj;
+                    doc.markProvenanceStale(sbol_obj->identity.get());
                 }
                 else
                 {
@@ -1247,6 +1361,7 @@ namespace sbol {
                     {
                         sbol_obj->parent = this->sbol_owner;  // Set back-pointer to parent object
                         object_store.push_back(sbol_obj);
+                        this->sbol_owner->markModified();
                         if (this->sbol_owner->doc)
                         {
                             sbol_obj->doc = this->sbol_owner->doc;
@@ -1410,12 +1525,16 @@ namespace sbol {
                 child_obj->parent = parent_obj;  // Set back-pointer to parent object
                 std::vector< sbol::SBOLObject* >& object_store = this->sbol_owner->owned_objects[this->type];
                 object_store.push_back((SBOLObject*)child_obj);
+                this->sbol_owner->markModified();
                 
                 // The following effectively adds the child object to the Document by setting its back-pointer.  However, the Document itself only maintains a register of TopLevel objects, otherwise the returned object will not be registered
                 if (parent_doc)
                     child_obj->doc = parent_doc;
                 if (CHECK_TOP_LEVEL)
+                {
                     parent_doc->SBOLObjects[child_id] = (SBOLObject*)child_obj;
+                    parent_doc->markProvenanceStale(child_id);
+                }
                 
                 this->sbol_owner->PythonObjects[child_id] = py_obj;
                 return py_obj;
@@ -1438,6 +1557,7 @@ namespace sbol {
                 // Add to this property's object store
                 std::vector< sbol::SBOLObject* >& object_store = this->sbol_owner->owned_objects[this->type];
                 object_store.push_back((SBOLObject*)child_obj);
+                this->sbol_owner->markModified();
                 
 //                this->add(*child_obj);
                 // Set pointer to Document
@@ -1557,10 +1677,14 @@ namespace sbol {
                     if (uri.compare(obj->identity.get()) == 0)
                     {
                         this->sbol_owner->owned_objects[this->type].erase( this->sbol_owner->owned_objects[this->type].begin() + i_obj);
+                        this->sbol_owner->markModified();
 
                         // Erase TopLevel objects from Document
                         if (this->sbol_owner->type == SBOL_DOCUMENT)
+                        {
                             obj->doc->SBOLObjects.erase(uri);
+                            obj->doc->markProvenanceStale(uri);
+                        }
                         
                         // Erase nested, hidden TopLevel objects from Document
                         if (obj->doc && !obj->doc->find(uri))
@@ -1620,11 +1744,13 @@ namespace sbol {
                         if (obj->doc) 
                         {
                             obj->doc->SBOLObjects.erase(obj->identity.get());
+                            obj->doc->markProvenanceStale(obj->identity.get());
                         }
                     }
                     obj->close();
                 }
                 object_store.clear();
+                this->sbol_owner->markModified();
             }
         }
     };
@@ -108,6 +108,13 @@ namespace sbol
         /// @param user_data Arbitrary user data which can be passed in and out of the callback as an argument or return value.
         /// @return Returns a flat list of pointers to all ModuleDefinitions in the hierarchy.
         std::vector<ModuleDefinition*> applyToModuleHierarchy(void (*callback_fn)(ModuleDefinition *, void *) = NULL, void * user_data = NULL);
+
+        /// Perform an operation on every distinct ModuleDefinition in a structurally-linked hierarchy of ModuleDefinitions. Unlike applyToModuleHierarchy, a ModuleDefinition that is instantiated by several Modules is visited only once.
+        /// @param callback_fun A pointer to a callback function with signature void callback_fn(ModuleDefinition *, void *).
+        /// @param user_data Arbitrary user data which can be passed in and out of the callback as an argument or return value.
+        /// @param n_threads If greater than 1, the callback is applied concurrently on this many threads after the hierarchy has been traversed. Only use this with callbacks that do not modify the Document or user_data without their own synchronization.
+        /// @return Returns a flat list of pointers to the distinct ModuleDefinitions in the hierarchy, in depth-first order.
+        std::vector<ModuleDefinition*> applyToUniqueModuleHierarchy(void (*callback_fn)(ModuleDefinition *, void *) = NULL, void * user_data = NULL, int n_threads = 1);
         
         virtual ~ModuleDefinition() {};
 
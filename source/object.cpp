@@ -28,6 +28,7 @@
 #include <string>
 #include <vector>
 #include <functional>
+#include <atomic>
 #include <iostream>
 #include "document.h"
 
@@ -38,9 +39,14 @@
 using namespace std;
 using namespace sbol;
 
+// A global counter, so modification stamps are never reused by different objects. It is atomic because objects may be
+// constructed concurrently, eg, by DerivationEnumerator::derive
+static atomic<unsigned long long> MODIFICATION_COUNTER(0);
+
 
 SBOLObject::~SBOLObject()
 {
+    DeferredValidation::forget(this);
     if (type.compare(SBOL_DOCUMENT) != 0)  // Documents have their own destructor override
     {
         for (auto &i_own : owned_objects)
@@ -89,6 +95,7 @@ PyObject* SBOLObject::cast(PyObject* python_class)
     PyObject* temp_py_object = PyObject_GetAttr(py_obj, PyUnicode_FromString("this"));
     SwigPyObject* swig_py_object = (SwigPyObject*)PyObject_GetAttr(py_obj, PyUnicode_FromString("this"));
     SBOLObject* new_obj = (SBOLObject *)swig_py_object->ptr;
+    unpack();
 
     // Set identity
     new_obj->identity.set(this->identity.get());
@@ -146,6 +153,8 @@ std::string SBOLObject::getClassName(string type)
 
 int SBOLObject::compare(SBOLObject* comparand)
 {
+    unpack();
+    comparand->unpack();
     int IS_EQUAL = 1;
     if (type.compare(comparand->type) != 0)
     {
@@ -416,6 +425,7 @@ SBOLObject* SBOLObject::find_property(string uri)
 
 vector<SBOLObject*> SBOLObject::find_property_value(string uri, string value, vector<SBOLObject*> matches)
 {
+    unpack();
     for (auto i_store = owned_objects.begin(); i_store != owned_objects.end(); ++i_store)
     {
         // Skip hidden and aliased properties
@@ -497,6 +507,7 @@ string SBOLObject::makeQName(string uri)
 
 std::string SBOLObject::getPropertyValue(std::string property_uri)
 {
+    unpack();
     if (properties.find(property_uri) != properties.end())
     {
         std::string property_value = properties[property_uri][0];
@@ -520,6 +531,7 @@ void SBOLObject::setPropertyValue(std::string property_uri, std::string val)
             // ...else treat the value as a literal
             properties[property_uri][0] = "\"" + val + "\"";
         }
+        markModified();
     }
     else throw SBOLError(SBOL_ERROR_NOT_FOUND, property_uri + " not contained in this object.");
 
@@ -539,12 +551,14 @@ void SBOLObject::addPropertyValue(std::string property_uri, std::string val)
             // ...else treat the value as a literal
             properties[property_uri].push_back("\"" + val + "\"");
         }
+        markModified();
     }
     else throw SBOLError(SBOL_ERROR_NOT_FOUND, property_uri + " not contained in this object.");
 };
 
 std::vector < std::string > SBOLObject::getPropertyValues(std::string property_uri)
 {
+    unpack();
     if (properties.find(property_uri) != properties.end())
     {
         std::vector < std::string > property_values = properties[property_uri];
@@ -580,6 +594,27 @@ void SBOLObject::setAnnotation(std::string property_uri, std::string val)
     setPropertyValue(property_uri, val);
 };
 
+void SBOLObject::markModified()
+{
+    modification_stamp = ++MODIFICATION_COUNTER;
+
+    // Once a Document has indexed provenance, it re-reads the TopLevels which are modified. Some TopLevels, such as the
+    // Designs of a DBTL workflow, are nested in others, so every TopLevel which contains this object is re-read
+    if (doc && doc->provenance.is_built)
+        for (SBOLObject* obj = this; obj && obj->type != SBOL_DOCUMENT; obj = obj->parent)
+            if (dynamic_cast<TopLevel*>(obj))
+                doc->markProvenanceStale(obj->identity.get());
+};
+
+unsigned long long SBOLObject::getModificationStamp()
+{
+    unsigned long long stamp = modification_stamp;
+    for (auto & i_store : owned_objects)
+        for (auto & child : i_store.second)
+            stamp = max(stamp, child->getModificationStamp());
+    return stamp;
+};
+
 std::string SBOLObject::getAnnotation(std::string property_uri)
 {
     return getPropertyValue(property_uri);
@@ -786,6 +821,7 @@ void ReferencedObject::set(std::string uri)
         {
             this->sbol_owner->properties[this->type][0] = "<" + uri + ">";
         }
+        this->sbol_owner->markModified();
         validate((void *)&uri);
     }
 };
@@ -802,6 +838,7 @@ void ReferencedObject::add(std::string uri)
             else
                 this->sbol_owner->properties[this->type].push_back("<" + uri + ">");
         }
+        this->sbol_owner->markModified();
         validate((void *)&uri);  //  Call validation rules associated with this Property
     }
 };
@@ -858,9 +895,11 @@ std::string ReferencedObject::operator[] (const int nIndex)
 void ReferencedObject::addReference(const std::string uri)
 {
     this->sbol_owner->properties[this->type].push_back("<" + uri + ">");
+    this->sbol_owner->markModified();
 };
 
 void SBOLObject::serialize_rdfxml(std::ostream &os, size_t indentLevel) {
+    unpack();
     const size_t spaces_per_indent = 2;
 
     std::string indentString = std::string(spaces_per_indent * indentLevel,
@@ -84,6 +84,11 @@ namespace sbol
         
         std::map<sbol::rdf_type, std::vector< std::string > > properties;
         std::map<sbol::rdf_type, std::vector< sbol::SBOLObject* > > owned_objects;
+        ClassPropertyRules* property_rules = NULL;  // The validation rules of this object's class, shared by every object of the class
+#if defined(SBOL_BUILD_PYTHON2) || defined(SBOL_BUILD_PYTHON3)
+        std::map<sbol::rdf_type, std::vector<std::pair<PyObject*, PyObject*>>> python_rules;  // Rules defined in Python, which are passed this object's Property, by type
+#endif
+        unsigned long long modification_stamp = 0;
         /// @endcond
         
         /// The identity property is REQUIRED by all Identified objects and has a data type of URI. A given Identified object’s identity URI MUST be globally unique among all other identity URIs. The identity of a compliant SBOL object MUST begin with a URI prefix that maps to a domain over which the user has control. Namely, the user can guarantee uniqueness of identities within this domain.  For other best practices regarding URIs see Section 11.2 of the [SBOL specification doucment](http://sbolstandard.org/wp-content/uploads/2015/08/SBOLv2.0.1.pdf).
@@ -151,6 +156,15 @@ namespace sbol
         /// @val Either a literal or URI value
         void addPropertyValue(std::string property_uri, std::string val);
 
+        /// Restore property values which are held in a compact representation, such as packed Sequence elements, to the property store. Methods which read the property store directly call this first.
+        virtual void unpack() {};
+
+        /// Record that this object has been modified. Properties call this whenever their values change, so that results cached from this object, such as those of ComponentDefinition::isRegular, are invalidated
+        void markModified();
+
+        /// @return A stamp which increases whenever this object or any of its child objects is modified. Stamps are unique across objects, so an object which is deleted and recreated under the same URI will not reuse a stale stamp
+        unsigned long long getModificationStamp();
+
         /// Set the value for a user-defined annotation property. Synonymous with setPropertyValue
         /// @val If the value is a URI, it should be surrounded by angle brackets, else it will be interpreted as a literal value
         void setAnnotation(std::string property_uri, std::string val);
@@ -191,6 +205,7 @@ namespace sbol
             namespaces({}),
             identity(this, SBOL_IDENTITY, '0', '1', ValidationRules({ sbol_rule_10202 }), uri)
         {
+            markModified();
             if (hasHomespace())
                 identity.set(getHomespace() + "/" + uri);
         };
@@ -201,6 +216,7 @@ namespace sbol
     SBOLClass& SBOLObject::cast()
     {
         SBOLClass& new_obj = *new SBOLClass();
+        unpack();
 
         // Set identity
         new_obj.identity.set(this->identity.get());
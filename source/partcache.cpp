@@ -0,0 +1,430 @@
+/**
+ * @file    partcache.cpp
+ * @brief   On-disk cache of responses from online repositories
+ * @author  Bryan Bartley
+ * @email   bartleyba@sbolstandard.org
+ *
+ * <!--------------------------------------------------------------------------
+ * This file is part of libSBOL.  Please visit http://sbolstandard.org for more
+ * information about SBOL, and the latest version of libSBOL.
+ *
+ *  Copyright 2016 University of Washington, WA, USA
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ------------------------------------------------------------------------->*/
+
+#include "partshop.h"
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+
+#ifdef SBOL_WIN
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+using namespace sbol;
+using namespace std;
+
+#define CACHE_JOURNAL "journal.tsv"
+
+// A stable 64-bit FNV-1a hash, in hexadecimal
+string fnv_hash(const string& text)
+{
+    unsigned long long hash = 14695981039346656037ULL;
+    for (unsigned char c : text)
+    {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    char digest[17];
+    snprintf(digest, sizeof(digest), "%016llx", hash);
+    return digest;
+};
+
+// The name of the file which holds each response
+string cache_file_name(const string& key)
+{
+    return fnv_hash(key) + ".cache";
+};
+
+string sbol::cache_key(const string& url, const unordered_map<string, string>& headers)
+{
+    string login = find_header(headers, "X-authorization");
+    if (login == "")
+        return url;
+    return url + " login:" + fnv_hash(login);
+};
+
+// Looks up a response header by name, ignoring case, and trims the surrounding whitespace from its value
+string sbol::find_header(const unordered_map<string, string>& headers, string name, bool trim)
+{
+    transform(name.begin(), name.end(), name.begin(), ::tolower);
+    for (auto& header : headers)
+    {
+        string header_name = header.first;
+        transform(header_name.begin(), header_name.end(), header_name.begin(), ::tolower);
+        if (header_name != name)
+            continue;
+        if (!trim)
+            return header.second;
+        size_t i_start = header.second.find_first_not_of(" \t\r\n");
+        size_t i_end = header.second.find_last_not_of(" \t\r\n");
+        if (i_start == string::npos)
+            return "";
+        return header.second.substr(i_start, i_end - i_start + 1);
+    }
+    return "";
+};
+
+// Journal fields are separated by tabs, so tabs and line breaks in header values are replaced
+string journal_field(string value)
+{
+    for (auto& c : value)
+        if (c == '\t' || c == '\n' || c == '\r')
+            c = ' ';
+    return value;
+};
+
+// The size of a file, or zero if it cannot be read
+unsigned long long file_size(const string& path)
+{
+    ifstream file(path, ios::binary | ios::ate);
+    return file ? (unsigned long long)file.tellg() : 0;
+};
+
+PartCache::PartCache(string directory, unsigned long long max_size) :
+    directory(directory),
+    max_size(max_size),
+    total_size(0),
+    clock(0),
+    n_journal_records(0),
+    journal_size(0)
+{
+#ifdef SBOL_WIN
+    _mkdir(directory.c_str());
+#else
+    mkdir(directory.c_str(), 0755);
+#endif
+    load();
+};
+
+PartCache::~PartCache()
+{
+    compact();
+};
+
+shared_ptr<PartCache> PartCache::open(string directory, unsigned long long max_size)
+{
+    static std::mutex registry_lock;
+    static map<string, weak_ptr<PartCache>> registry;
+    std::lock_guard<std::mutex> lock(registry_lock);
+    shared_ptr<PartCache> cache = registry[directory].lock();
+    if (!cache)
+    {
+        cache = make_shared<PartCache>(directory, max_size);
+        registry[directory] = cache;
+    }
+    std::lock_guard<std::mutex> cache_lock(cache->lock);
+    if (cache->max_size != max_size)
+    {
+        cache->max_size = max_size;
+        cache->evict();
+    }
+    return cache;
+};
+
+string PartCache::getDirectory()
+{
+    return directory;
+};
+
+// Replays the journal. Each record is a store (S), access (A) or eviction (E), and the order of the records gives the
+// order in which responses were last used
+void PartCache::load()
+{
+    ifstream journal_file(directory + "/" CACHE_JOURNAL);
+    string line;
+    while (getline(journal_file, line))
+    {
+        ++n_journal_records;
+        // Split on tabs, keeping empty fields, since an empty header value is the last field of many records
+        vector<string> fields;
+        size_t i_field = 0;
+        for (size_t i_tab = line.find('\t'); i_tab != string::npos; i_tab = line.find('\t', i_field))
+        {
+            fields.push_back(line.substr(i_field, i_tab - i_field));
+            i_field = i_tab + 1;
+        }
+        fields.push_back(line.substr(i_field));
+        if (fields.size() < 2)
+            continue;
+        string& key = fields[1];
+        if (fields[0] == "S" && fields.size() >= 7)
+        {
+            erase(key);
+            CacheEntry& entry = entries[key];
+            entry.file = fields[2];
+            entry.size = stoull(fields[3]);
+            entry.etag = fields[4];
+            entry.last_modified = fields[5];
+            entry.content_disposition = fields[6];
+            entry.last_access = ++clock;
+            total_size += entry.size;
+        }
+        else if (fields[0] == "A" && entries.count(key))
+            entries[key].last_access = ++clock;
+        else if (fields[0] == "E")
+            erase(key);
+    }
+    journal_file.close();
+    journal_size = file_size(directory + "/" CACHE_JOURNAL);
+    if (n_journal_records > 2 * entries.size() + 100)
+        compact();
+};
+
+// Rewrites the journal with one store record per cached response, in order of last use. Other processes may share the
+// cache directory, and the journal is only rewritten if none of them has appended to it since this process read it,
+// since their records are not in this process's view of the cache
+void PartCache::compact()
+{
+    vector<pair<unsigned long long, const string*>> order;
+    for (auto& i_entry : entries)
+        order.push_back({ i_entry.second.last_access, &i_entry.first });
+    sort(order.begin(), order.end());
+    string journal_path = directory + "/" CACHE_JOURNAL;
+    ofstream journal_file(journal_path + ".tmp");
+    if (!journal_file)
+        return;
+    for (auto& i_order : order)
+    {
+        CacheEntry& entry = entries[*i_order.second];
+        journal_file << "S\t" << *i_order.second << "\t" << entry.file << "\t" << entry.size << "\t" << entry.etag << "\t" << entry.last_modified << "\t" << entry.content_disposition << "\n";
+    }
+    journal_file.close();
+    if (file_size(journal_path) != journal_size)
+    {
+        remove((journal_path + ".tmp").c_str());
+        return;
+    }
+    remove(journal_path.c_str());
+    rename((journal_path + ".tmp").c_str(), journal_path.c_str());
+    n_journal_records = entries.size();
+    journal_size = file_size(journal_path);
+};
+
+void PartCache::journal(string record)
+{
+    FILE* journal_file = fopen((directory + "/" CACHE_JOURNAL).c_str(), "ab");
+    if (!journal_file)
+        return;
+    record += "\n";
+    fputs(record.c_str(), journal_file);
+    fclose(journal_file);
+    ++n_journal_records;
+    journal_size += record.size();
+};
+
+// Forgets a response, without deleting its file
+void PartCache::erase(const string& key)
+{
+    auto i_entry = entries.find(key);
+    if (i_entry == entries.end())
+        return;
+    total_size -= i_entry->second.size;
+    entries.erase(i_entry);
+};
+
+// Deletes the least recently used responses until the cache fits in its size limit
+void PartCache::evict()
+{
+    if (total_size <= max_size)
+        return;
+    vector<pair<unsigned long long, string>> order;
+    for (auto& i_entry : entries)
+        order.push_back({ i_entry.second.last_access, i_entry.first });
+    sort(order.begin(), order.end());
+    for (auto& i_order : order)
+    {
+        if (total_size <= max_size)
+            break;
+        remove((directory + "/" + entries[i_order.second].file).c_str());
+        erase(i_order.second);
+        journal("E\t" + i_order.second);
+    }
+};
+
+bool PartCache::read(const string& key, HTTPResponse& response)
+{
+    auto i_entry = entries.find(key);
+    if (i_entry == entries.end())
+        return false;
+    CacheEntry& entry = i_entry->second;
+    ifstream body_file(directory + "/" + entry.file, ios::binary);
+    string body((istreambuf_iterator<char>(body_file)), istreambuf_iterator<char>());
+    if (!body_file || body.size() != entry.size)
+    {
+        // The file was removed or damaged, eg, by another process evicting it
+        erase(key);
+        journal("E\t" + key);
+        return false;
+    }
+    response.status = 200;
+    response.error = "";
+    response.body.swap(body);
+    response.headers.clear();
+    if (entry.content_disposition != "")
+        response.headers["Content-Disposition"] = entry.content_disposition;
+    entry.last_access = ++clock;
+    journal("A\t" + key);
+    return true;
+};
+
+void PartCache::addValidators(const string& key, unordered_map<string, string>& headers)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    auto i_entry = entries.find(key);
+    if (i_entry == entries.end())
+        return;
+    if (i_entry->second.etag != "")
+        headers["If-None-Match"] = i_entry->second.etag;
+    if (i_entry->second.last_modified != "")
+        headers["If-Modified-Since"] = i_entry->second.last_modified;
+};
+
+bool PartCache::resolve(const string& key, HTTPResponse& response)
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    // The cached response is current, or the server cannot be reached
+    if (response.error != "" || response.status == 304)
+        return read(key, response);
+    if (response.status != 200)
+        return false;
+
+    return store(key, response.headers, response.body.size(), [&](FILE* body_file)
+    {
+        return fwrite(response.body.c_str(), 1, response.body.size(), body_file) == response.body.size();
+    });
+};
+
+// Stores a new response. The body is written to a temporary file first, so a reader never sees a partial response
+bool PartCache::store(const string& key, const unordered_map<string, string>& headers, unsigned long long size, std::function<bool(FILE*)> write)
+{
+    if (size > max_size)
+        return false;
+    CacheEntry entry;
+    entry.file = cache_file_name(key);
+    entry.size = size;
+    entry.etag = journal_field(find_header(headers, "ETag"));
+    entry.last_modified = journal_field(find_header(headers, "Last-Modified"));
+    entry.content_disposition = journal_field(find_header(headers, "Content-Disposition", false));
+    string path = directory + "/" + entry.file;
+    FILE* body_file = fopen((path + ".tmp").c_str(), "wb");
+    if (!body_file)
+        return false;
+    bool written = write(body_file);
+    written = (fclose(body_file) == 0) && written;
+    remove(path.c_str());
+    if (!written || rename((path + ".tmp").c_str(), path.c_str()) != 0)
+    {
+        remove((path + ".tmp").c_str());
+        erase(key);
+        return false;
+    }
+    erase(key);
+    entry.last_access = ++clock;
+    entries[key] = entry;
+    total_size += entry.size;
+    journal("S\t" + key + "\t" + entry.file + "\t" + to_string(entry.size) + "\t" + entry.etag + "\t" + entry.last_modified + "\t" + entry.content_disposition);
+    evict();
+    return true;
+};
+
+bool PartCache::fetch(const string& key, HTTPResponse& response)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return read(key, response);
+};
+
+bool PartCache::storeFile(const string& key, const string& file, const unordered_map<string, string>& headers)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    ifstream source_size(file, ios::binary | ios::ate);
+    FILE* source = fopen(file.c_str(), "rb");
+    if (!source_size || !source)
+    {
+        if (source)
+            fclose(source);
+        return false;
+    }
+    unsigned long long size = source_size.tellg();
+    bool stored = store(key, headers, size, [&](FILE* body_file)
+    {
+        vector<char> buffer(65536);
+        unsigned long long n_copied = 0;
+        size_t n_read;
+        while ((n_read = fread(buffer.data(), 1, buffer.size(), source)) > 0)
+        {
+            if (fwrite(buffer.data(), 1, n_read, body_file) != n_read)
+                return false;
+            n_copied += n_read;
+        }
+        return n_copied == size;
+    });
+    fclose(source);
+    return stored;
+};
+
+bool PartCache::locate(const string& key, string& file, unordered_map<string, string>& headers)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    auto i_entry = entries.find(key);
+    if (i_entry == entries.end())
+        return false;
+    CacheEntry& entry = i_entry->second;
+    ifstream body_file(directory + "/" + entry.file, ios::binary | ios::ate);
+    if (!body_file || (unsigned long long)body_file.tellg() != entry.size)
+    {
+        erase(key);
+        journal("E\t" + key);
+        return false;
+    }
+    file = directory + "/" + entry.file;
+    headers.clear();
+    if (entry.content_disposition != "")
+        headers["Content-Disposition"] = entry.content_disposition;
+    entry.last_access = ++clock;
+    journal("A\t" + key);
+    return true;
+};
+
+PartCache* PartShop::getCache()
+{
+    string directory = Config::getOption("cache_dir");
+    if (directory == "")
+        return NULL;
+    unsigned long long max_size = 0;
+    try
+    {
+        max_size = stoull(Config::getOption("cache_max_size")) * 1024 * 1024;
+    }
+    catch (std::exception&)
+    {
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "The cache_max_size option must be a number of megabytes");
+    }
+    cache = PartCache::open(directory, max_size);
+    return cache.get();
+};
@@ -1,5 +1,17 @@
 #include "partshop.h"
+#include "sequencefile.h"
 #include <algorithm>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <unordered_set>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
 
 // For UNIX like implementation of getch (see login method)
 // this may not be portable to windows, may need conio.h
@@ -68,211 +80,447 @@ void encode_url(string& text)
     // replace(text, ".", UTF8_DOT);
     // replace(text, "(", UTF8_DOT);
     // replace(text, ")", UTF8_DOT);
-    CURL *curl;
-    char * encoded_text = curl_easy_escape(curl, text.c_str(), text.size());
+    char * encoded_text = curl_easy_escape(NULL, text.c_str(), text.size());
     text = string(encoded_text);
+    curl_free(encoded_text);
 };
 
-// Advanced search
-SearchResponse& sbol::PartShop::search(SearchQuery& q)
+HTTPClient::HTTPClient() :
+    connection_count(0),
+    multi(NULL),
+    stopping(false)
 {
-    string url = parseURLDomain(resource);
-    
-    /* Perform HTTP request */
-    string response;
-    CURL *curl;
-    CURLcode res;
-    
-    /* In windows, this will init the winsock stuff */
+    /* In windows, this will init the winsock stuff. Initialization is reference counted by libcurl */
     curl_global_init(CURL_GLOBAL_ALL);
-    
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(headers, "Content-Type: application/x-www-form-urlencoded");
-    headers = curl_slist_append(headers, "Accept: text/plain");
-    headers = curl_slist_append(headers, string("X-authorization: " + key).c_str());
-    
-    /* get a curl handle */
-    curl = curl_easy_init();
-    
-    /* Specify the GET parameters */
-    if(curl)
+
+    share = curl_share_init();
+    curl_share_setopt(share, CURLSHOPT_LOCKFUNC, HTTPClient::lockShare);
+    curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, HTTPClient::unlockShare);
+    curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+};
+
+HTTPClient::~HTTPClient()
+{
+    if (loop_thread.joinable())
     {
-        string parameters;
-        // Specify the type of SBOL object to search for
-        if (q["objectType"].size() == 1)
-            parameters = "objectType=" + parseClassName(q["objectType"].get()) + "&";
-        else
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "SearchQuery is invalid because it does not have an objectType specified");
-        
-        // Get the search criteria, while ignoring special search parameters like objectType, offset, and limit
-        vector<string> search_criteria = q.getProperties();
-        auto i_ignore = std::find(std::begin(search_criteria), std::end(search_criteria), SBOL_IDENTITY);
-        search_criteria.erase(i_ignore);
-        i_ignore = std::find(std::begin(search_criteria), std::end(search_criteria), SBOL_URI "#objectType");
-        search_criteria.erase(i_ignore);
-        i_ignore = std::find(std::begin(search_criteria), std::end(search_criteria), SBOL_URI "#offset");
-        search_criteria.erase(i_ignore);
-        i_ignore = std::find(std::begin(search_criteria), std::end(search_criteria), SBOL_URI "#limit");
-        search_criteria.erase(i_ignore);
-        
-        // Form GET request from the search criteria
-        for (auto & property_uri : search_criteria)
-            for (auto & property_val : q.getPropertyValues(property_uri))
+        {
+            std::lock_guard<std::mutex> guard(loop_lock);
+            stopping = true;
+        }
+        wakeLoop();
+        loop_thread.join();
+        curl_multi_cleanup(multi);
+    }
+    for (auto curl : idle_handles)
+        curl_easy_cleanup(curl);
+    curl_share_cleanup(share);
+    curl_global_cleanup();
+};
+
+void HTTPClient::lockShare(CURL* handle, curl_lock_data data, curl_lock_access access, void* client)
+{
+    ((HTTPClient*)client)->share_locks[data].lock();
+};
+
+void HTTPClient::unlockShare(CURL* handle, curl_lock_data data, void* client)
+{
+    ((HTTPClient*)client)->share_locks[data].unlock();
+};
+
+CURL* HTTPClient::acquire()
+{
+    CURL* curl = NULL;
+    {
+        std::lock_guard<std::mutex> lock(pool_lock);
+        if (idle_handles.size())
+        {
+            curl = idle_handles.back();
+            idle_handles.pop_back();
+        }
+    }
+    if (!curl)
+        curl = curl_easy_init();
+    if (!curl)
+        throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Failed to initialize an HTTP connection");
+    curl_easy_setopt(curl, CURLOPT_SHARE, share);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    if (Config::getOption("ca-path") != "")
+        curl_easy_setopt(curl, CURLOPT_CAINFO, Config::getOption("ca-path").c_str());
+    if (Config::getOption("verbose") == "True")
+        curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
+    return curl;
+};
+
+void HTTPClient::release(CURL* curl)
+{
+    curl_easy_reset(curl);
+    std::lock_guard<std::mutex> lock(pool_lock);
+    idle_handles.push_back(curl);
+};
+
+HTTPResponse HTTPClient::request(std::string url, const unordered_map<string, string>& headers, std::function<void(CURL*)> configure)
+{
+    HTTPResponse response;
+    CURL* curl = acquire();
+
+    struct curl_slist *header_list = NULL;
+    for (auto& header : headers)
+        header_list = curl_slist_append(header_list, (header.first + ": " + header.second).c_str());
+
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, header_list);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlWrite_CallbackFunc_StdString);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response.body);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, CurlResponseHeader_CallbackFunc);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &response.headers);
+    if (configure)
+        configure(curl);
+
+    /* Perform the request, res will get the return code */
+    CURLcode res = curl_easy_perform(curl);
+    long n_connects = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response.status);
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &n_connects);
+    connection_count += n_connects;
+
+    curl_slist_free_all(header_list);
+    release(curl);
+
+    /* Check for errors */
+    if (res != CURLE_OK)
+        throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, string(curl_easy_strerror(res)));
+    return response;
+};
+
+HTTPResponse HTTPClient::get(std::string url, const unordered_map<string, string>& headers)
+{
+    return request(url, headers);
+};
+
+void HTTPClient::requestAll(const vector<string>& urls, const vector<unordered_map<string, string>>& headers, int max_parallel, std::function<void(size_t, HTTPResponse&)> on_response)
+{
+    struct Transfer
+    {
+        size_t index;
+        HTTPResponse response;
+        struct curl_slist *header_list = NULL;
+    };
+
+    CURLM* multi = curl_multi_init();
+    size_t i_next = 0;
+    int n_in_flight = 0;
+
+    // Keeps up to max_parallel transfers in flight
+    auto start_transfers = [&]()
+    {
+        while (i_next < urls.size() && n_in_flight < max_parallel)
+        {
+            Transfer* transfer = new Transfer();
+            transfer->index = i_next;
+            for (auto& header : headers[i_next])
+                transfer->header_list = curl_slist_append(transfer->header_list, (header.first + ": " + header.second).c_str());
+            CURL* curl = acquire();
+            curl_easy_setopt(curl, CURLOPT_URL, urls[i_next].c_str());
+            curl_easy_setopt(curl, CURLOPT_HTTPHEADER, transfer->header_list);
+            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlWrite_CallbackFunc_StdString);
+            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer->response.body);
+            curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, CurlResponseHeader_CallbackFunc);
+            curl_easy_setopt(curl, CURLOPT_HEADERDATA, &transfer->response.headers);
+            curl_easy_setopt(curl, CURLOPT_PRIVATE, transfer);
+            curl_multi_add_handle(multi, curl);
+            ++i_next;
+            ++n_in_flight;
+        }
+    };
+
+    start_transfers();
+    while (n_in_flight)
+    {
+        int n_running = 0;
+        curl_multi_perform(multi, &n_running);
+
+        // Hand off completed transfers, and replace them with new ones
+        CURLMsg* message;
+        int n_messages;
+        while ((message = curl_multi_info_read(multi, &n_messages)))
+        {
+            if (message->msg != CURLMSG_DONE)
+                continue;
+            CURL* curl = message->easy_handle;
+            CURLcode res = message->data.result;
+            Transfer* transfer = NULL;
+            long n_connects = 0;
+            curl_easy_getinfo(curl, CURLINFO_PRIVATE, (char**)&transfer);
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &transfer->response.status);
+            curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &n_connects);
+            connection_count += n_connects;
+            curl_multi_remove_handle(multi, curl);
+            release(curl);
+            --n_in_flight;
+            if (res != CURLE_OK)
+                transfer->response.error = curl_easy_strerror(res);
+            curl_slist_free_all(transfer->header_list);
+            on_response(transfer->index, transfer->response);
+            delete transfer;
+            start_transfers();
+        }
+        if (n_in_flight)
+            curl_multi_wait(multi, NULL, 0, 100, NULL);
+    }
+    curl_multi_cleanup(multi);
+};
+
+// A request queued for the event loop
+struct HTTPClient::AsyncTransfer
+{
+    std::string url;
+    CURL* curl = NULL;
+    struct curl_slist* header_list = NULL;
+    std::function<void(CURL*)> configure;
+    std::function<void(HTTPResponse&)> on_done;
+    HTTPResponse response;
+};
+
+void HTTPClient::requestAsync(std::string url, const unordered_map<string, string>& headers, std::function<void(CURL*)> configure, std::function<void(HTTPResponse&)> on_done)
+{
+    AsyncTransfer* transfer = new AsyncTransfer();
+    transfer->url = url;
+    for (auto& header : headers)
+        transfer->header_list = curl_slist_append(transfer->header_list, (header.first + ": " + header.second).c_str());
+    transfer->configure = configure;
+    transfer->on_done = on_done;
+    {
+        std::lock_guard<std::mutex> guard(loop_lock);
+        if (!stopping)
+        {
+            if (!loop_thread.joinable())
             {
-                if (property_val.length() > 0)
-                {
-                    parameters += "<" + property_uri + ">=";
-                    if (property_val.find("http") == 0)
-                        parameters += "<" + property_val + ">&"; // encode property value as a URI
-                    else
-                        parameters += "'" + property_val + "'&"; // encode property value as a literal
-                }
+                multi = curl_multi_init();
+                loop_thread = std::thread(&HTTPClient::runLoop, this);
             }
-        
-        // Specify index of the first record to retrieve
-        if (q["offset"].size() == 1)
-            parameters += "/?offset=" + q["offset"].get();
-        else
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Invalid offset parameter specified");
-        
-        // Specify how many records to retrieve
-        if (q["limit"].size() == 1)
-            parameters += "&limit=" + q["limit"].get();
-        else
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Invalid limit parameter specified");
-        
-        encode_url(parameters);
-        parameters = url + "/remoteSearch/" + parameters;
-        
-        /* First set the URL that is about to receive our GET. */
-        //curl_easy_setopt(curl, CURLOPT_URL, Config::getOption("validator_url").c_str());
-        curl_easy_setopt(curl, CURLOPT_URL, parameters.c_str());
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-        
-        /* Now specify the callback to read the response into string */
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlWrite_CallbackFunc_StdString);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-        
-        /* Perform the request, res will get the return code */
-        res = curl_easy_perform(curl);
-        /* Check for errors */
-        if(res != CURLE_OK)
-            throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Search request failed with " + string(curl_easy_strerror(res)));
-        
-        /* always cleanup */
-        curl_easy_cleanup(curl);
+            queued.push_back(transfer);
+            transfer = NULL;
+        }
     }
-    curl_slist_free_all(headers);
-    curl_global_cleanup();
-    
-    SearchResponse& search_response = * new SearchResponse();
-    Json::Value json_response;
-    Json::Reader reader;
-    bool parsed = reader.parse( response, json_response );     //parse process
-    if ( parsed )
+    if (transfer)
     {
-        for( Json::ValueIterator i_entry = json_response.begin() ; i_entry != json_response.end(); i_entry++ )
+        // The client is shutting down, which happens if a request is issued by the completion of another
+        curl_slist_free_all(transfer->header_list);
+        transfer->response.error = "The request was abandoned because the HTTP client was shut down";
+        transfer->on_done(transfer->response);
+        delete transfer;
+        return;
+    }
+    wakeLoop();
+};
+
+void HTTPClient::wakeLoop()
+{
+#if LIBCURL_VERSION_NUM >= 0x074400
+    curl_multi_wakeup(multi);
+#else
+    loop_wakeup.notify_one();
+#endif
+};
+
+void HTTPClient::runLoop()
+{
+    unordered_set<AsyncTransfer*> in_flight;
+
+    // Hands a finished transfer to its callback
+    auto finish = [&](AsyncTransfer* transfer)
+    {
+        curl_slist_free_all(transfer->header_list);
+        try
         {
-            Json::Value json_entry = *i_entry;
-            Identified* record = new Identified(SBOL_IDENTIFIED, "dummy", "0");
-            record->identity.set( json_entry.get("uri", response ).asString() );
-            record->displayId.set( json_entry.get("displayId", response ).asString() );
-            record->name.set( json_entry.get("name", response ).asString() );
-            record->description.set( json_entry.get("description", response ).asString() );
-            record->version.set( json_entry.get("version", response ).asString() );
-            search_response.records.push_back(record);
+            transfer->on_done(transfer->response);
+        }
+        catch (...)
+        {
+            // An exception cannot be reported from here, so callbacks are expected to catch their own
+        }
+        delete transfer;
+    };
+
+    while (true)
+    {
+        vector<AsyncTransfer*> added;
+        {
+            std::unique_lock<std::mutex> guard(loop_lock);
+#if LIBCURL_VERSION_NUM < 0x074400
+            // Older versions of libcurl cannot be woken from a wait, so an idle loop waits for requests here instead
+            if (in_flight.empty())
+                loop_wakeup.wait(guard, [this]() { return queued.size() || stopping; });
+#endif
+            if (stopping)
+                break;
+            added.swap(queued);
+        }
+        for (auto transfer : added)
+        {
+            CURL* curl = acquire();
+            transfer->curl = curl;
+            curl_easy_setopt(curl, CURLOPT_URL, transfer->url.c_str());
+            curl_easy_setopt(curl, CURLOPT_HTTPHEADER, transfer->header_list);
+            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlWrite_CallbackFunc_StdString);
+            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer->response.body);
+            curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, CurlResponseHeader_CallbackFunc);
+            curl_easy_setopt(curl, CURLOPT_HEADERDATA, &transfer->response.headers);
+            curl_easy_setopt(curl, CURLOPT_PRIVATE, transfer);
+            if (transfer->configure)
+                transfer->configure(curl);
+            curl_multi_add_handle(multi, curl);
+            in_flight.insert(transfer);
+        }
+
+        int n_running = 0;
+        curl_multi_perform(multi, &n_running);
+        CURLMsg* message;
+        int n_messages;
+        while ((message = curl_multi_info_read(multi, &n_messages)))
+        {
+            if (message->msg != CURLMSG_DONE)
+                continue;
+            CURL* curl = message->easy_handle;
+            CURLcode res = message->data.result;
+            AsyncTransfer* transfer = NULL;
+            long n_connects = 0;
+            curl_easy_getinfo(curl, CURLINFO_PRIVATE, (char**)&transfer);
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &transfer->response.status);
+            curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &n_connects);
+            connection_count += n_connects;
+            curl_multi_remove_handle(multi, curl);
+            release(curl);
+            in_flight.erase(transfer);
+            if (res != CURLE_OK)
+                transfer->response.error = curl_easy_strerror(res);
+            finish(transfer);
         }
+
+        // Sleep until there is network activity or a new request
+#if LIBCURL_VERSION_NUM >= 0x074400
+        curl_multi_poll(multi, NULL, 0, 1000, NULL);
+#else
+        if (in_flight.size())
+            curl_multi_wait(multi, NULL, 0, 10, NULL);
+#endif
+    }
+
+    // Abandon the requests which have not finished
+    vector<AsyncTransfer*> abandoned;
+    {
+        std::lock_guard<std::mutex> guard(loop_lock);
+        abandoned.swap(queued);
+    }
+    for (auto transfer : in_flight)
+    {
+        curl_multi_remove_handle(multi, transfer->curl);
+        release(transfer->curl);
+        abandoned.push_back(transfer);
+    }
+    for (auto transfer : abandoned)
+    {
+        transfer->response.error = "The request was abandoned because the HTTP client was shut down";
+        finish(transfer);
     }
+};
+
+long HTTPClient::getConnectionCount()
+{
+    return connection_count;
+};
+
+// Advanced search
+std::string sbol::PartShop::searchURL(SearchQuery& q, int offset, int limit)
+{
+    string url = parseURLDomain(resource);
+
+    /* Specify the GET parameters */
+    string parameters;
+    // Specify the type of SBOL object to search for
+    if (q["objectType"].size() == 1)
+        parameters = "objectType=" + parseClassName(q["objectType"].get()) + "&";
     else
-        throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Search failed with error message" + response);
-    return search_response;
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "SearchQuery is invalid because it does not have an objectType specified");
+    
+    // Get the search criteria, while ignoring special search parameters like objectType, offset, and limit
+    vector<string> search_criteria = q.getProperties();
+    auto i_ignore = std::find(std::begin(search_criteria), std::end(search_criteria), SBOL_IDENTITY);
+    search_criteria.erase(i_ignore);
+    i_ignore = std::find(std::begin(search_criteria), std::end(search_criteria), SBOL_URI "#objectType");
+    search_criteria.erase(i_ignore);
+    i_ignore = std::find(std::begin(search_criteria), std::end(search_criteria), SBOL_URI "#offset");
+    search_criteria.erase(i_ignore);
+    i_ignore = std::find(std::begin(search_criteria), std::end(search_criteria), SBOL_URI "#limit");
+    search_criteria.erase(i_ignore);
+    
+    // Form GET request from the search criteria
+    for (auto & property_uri : search_criteria)
+        for (auto & property_val : q.getPropertyValues(property_uri))
+        {
+            if (property_val.length() > 0)
+            {
+                parameters += "<" + property_uri + ">=";
+                if (property_val.find("http") == 0)
+                    parameters += "<" + property_val + ">&"; // encode property value as a URI
+                else
+                    parameters += "'" + property_val + "'&"; // encode property value as a literal
+            }
+        }
+    
+    // Specify index of the first record to retrieve, and how many records to retrieve
+    parameters += "/?offset=" + to_string(offset) + "&limit=" + to_string(limit);
+    
+    encode_url(parameters);
+    return url + "/remoteSearch/" + parameters;
+};
+
+SearchResponse& sbol::PartShop::search(SearchQuery& q)
+{
+    if (q["offset"].size() != 1)
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Invalid offset parameter specified");
+    if (q["limit"].size() != 1)
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Invalid limit parameter specified");
+    return searchPage(searchURL(q, q.offset.get(), q.limit.get()));
 };
 
 // Exact search
-SearchResponse& sbol::PartShop::search(std::string search_text, rdf_type object_type, std::string property_uri, int offset, int limit)
+std::string sbol::PartShop::searchURL(std::string search_text, rdf_type object_type, std::string property_uri, int offset, int limit)
 {
     string url = parseURLDomain(resource);
+
+    /* Specify the GET data */
+    // Specify the type of SBOL object to search for
+    string parameters = "objectType=" + parseClassName(object_type) + "&";
     
-    /* Perform HTTP request */
-    string response;
-    CURL *curl;
-    CURLcode res;
+    //        // Specify which property of the SBOL object to look in for the search text
+    //        parameters += parsePropertyName(property_uri) + UTF8_EQUALS;
+    parameters += "<" + property_uri + ">=";
     
-    /* In windows, this will init the winsock stuff */
-    curl_global_init(CURL_GLOBAL_ALL);
+    if (search_text.find("http") == 0)
+        // Encode search text as a URL
+        parameters += "<" + search_text + ">&";
+    else
+        // Encode as a literal
+        parameters += "'" + search_text + "'&";
     
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(headers, "Content-Type: application/x-www-form-urlencoded");
-    headers = curl_slist_append(headers, "Accept: text/plain");
-    headers = curl_slist_append(headers, string("X-authorization: " + key).c_str());
+    encode_url(parameters);
     
-    /* get a curl handle */
-    curl = curl_easy_init();
-    if(curl) {
-        /* Specify the GET data */
-        // Specify the type of SBOL object to search for
-        string parameters = "objectType=" + parseClassName(object_type) + "&";
-        
-        //        // Specify which property of the SBOL object to look in for the search text
-        //        parameters += parsePropertyName(property_uri) + UTF8_EQUALS;
-        parameters += "<" + property_uri + ">=";
-        
-        if (search_text.find("http") == 0)
-            // Encode search text as a URL
-            parameters += "<" + search_text + ">&";
-        else
-            // Encode as a literal
-            parameters += "'" + search_text + "'&";
-        
-        encode_url(parameters);
-        
-        // Specify how many records to retrieve
-        parameters += "/?offset=" + to_string(offset) + "&limit=" + to_string(limit);
-        
-        parameters = url + "/remoteSearch/" + parameters;
-        
-        /* First set the URL that is about to receive our GET. */
-        //curl_easy_setopt(curl, CURLOPT_URL, Config::getOption("validator_url").c_str());
-        curl_easy_setopt(curl, CURLOPT_URL, parameters.c_str());
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-        
-        /* Now specify the callback to read the response into string */
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlWrite_CallbackFunc_StdString);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-        
-        /* Perform the request, res will get the return code */
-        res = curl_easy_perform(curl);
-        /* Check for errors */
-        if(res != CURLE_OK)
-            throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Search failed with: " + string(curl_easy_strerror(res)));
-        
-        /* always cleanup */
-        curl_easy_cleanup(curl);
-    }
-    curl_slist_free_all(headers);
-    curl_global_cleanup();
+    // Specify how many records to retrieve
+    parameters += "/?offset=" + to_string(offset) + "&limit=" + to_string(limit);
     
-    SearchResponse& search_response = * new SearchResponse();
-    Json::Value json_response;
-    Json::Reader reader;
-    bool parsed = reader.parse( response, json_response );     //parse process
-    if ( parsed )
-    {
-        for( Json::ValueIterator i_entry = json_response.begin() ; i_entry != json_response.end(); i_entry++ )
-        {
-            Json::Value json_entry = *i_entry;
-            Identified* record = new Identified(SBOL_IDENTIFIED, "dummy", "0");
-            record->identity.set( json_entry.get("uri", response ).asString() );
-            record->displayId.set( json_entry.get("displayId", response ).asString() );
-            record->name.set( json_entry.get("name", response ).asString() );
-            record->description.set( json_entry.get("description", response ).asString() );
-            record->version.set( json_entry.get("version", response ).asString() );
-            search_response.records.push_back(record);
-        }
-    }
-    else
-        throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Search failed with error message" + response);
-    return search_response;
+    return url + "/remoteSearch/" + parameters;
+};
+
+SearchResponse& sbol::PartShop::search(std::string search_text, rdf_type object_type, std::string property_uri, int offset, int limit)
+{
+    return searchPage(searchURL(search_text, object_type, property_uri, offset, limit));
 };
 
 std::string sbol::PartShop::getKey()
@@ -281,61 +529,43 @@ std::string sbol::PartShop::getKey()
 };
 
 // General search
-SearchResponse& sbol::PartShop::search(std::string search_text, rdf_type object_type, int offset, int limit)
+std::string sbol::PartShop::searchURL(std::string search_text, rdf_type object_type, int offset, int limit)
 {
     string url = parseURLDomain(resource);
+
+    /* Specify the GET data */
+    // Specify the type of SBOL object to search for
+    string parameters = "objectType=" + parseClassName(object_type) + "&";
     
-    /* Perform HTTP request */
-    string response;
-    CURL *curl;
-    CURLcode res;
-    
-    /* In windows, this will init the winsock stuff */
-    curl_global_init(CURL_GLOBAL_ALL);
+    // Specify partial search text. Specify how many records to retrieve
+    parameters = parameters + search_text;
     
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(headers, "Content-Type: application/x-www-form-urlencoded");
-    headers = curl_slist_append(headers, "Accept: text/plain");
-    headers = curl_slist_append(headers, string("X-authorization: " + key).c_str());
+    encode_url(search_text);
     
-    /* get a curl handle */
-    curl = curl_easy_init();
-    if(curl) {
-        /* Specify the GET data */
-        // Specify the type of SBOL object to search for
-        string parameters = "objectType=" + parseClassName(object_type) + "&";
-        
-        // Specify partial search text. Specify how many records to retrieve
-        parameters = parameters + search_text;
-        
-        encode_url(search_text);
-        
-        // Specify how many records to retrieve
-        parameters += "/?offset=" + to_string(offset) + "&limit=" + to_string(limit);
-        
-        parameters = url + "/remoteSearch/" + parameters;
-        
-        /* First set the URL that is about to receive our GET. */
-        //curl_easy_setopt(curl, CURLOPT_URL, Config::getOption("validator_url").c_str());
-        curl_easy_setopt(curl, CURLOPT_URL, parameters.c_str());
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-        
-        /* Now specify the callback to read the response into string */
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlWrite_CallbackFunc_StdString);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-        
-        /* Perform the request, res will get the return code */
-        res = curl_easy_perform(curl);
-        /* Check for errors */
-        if(res != CURLE_OK)
-            throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to validate online failed with " + string(curl_easy_strerror(res)));
-        
-        /* always cleanup */
-        curl_easy_cleanup(curl);
-    }
-    curl_slist_free_all(headers);
-    curl_global_cleanup();
+    // Specify how many records to retrieve
+    parameters += "/?offset=" + to_string(offset) + "&limit=" + to_string(limit);
     
+    return url + "/remoteSearch/" + parameters;
+};
+
+SearchResponse& sbol::PartShop::search(std::string search_text, rdf_type object_type, int offset, int limit)
+{
+    return searchPage(searchURL(search_text, object_type, offset, limit));
+};
+
+// The headers of a search request
+unordered_map<string, string> search_headers(string key)
+{
+    unordered_map<string, string> headers;
+    headers["Content-Type"] = "application/x-www-form-urlencoded";
+    headers["Accept"] = "text/plain";
+    headers["X-authorization"] = key;
+    return headers;
+};
+
+// Decodes the records of a search response
+SearchResponse& parse_search_response(string& response)
+{
     SearchResponse& search_response = * new SearchResponse();
     Json::Value json_response;
     Json::Reader reader;
@@ -355,89 +585,67 @@ SearchResponse& sbol::PartShop::search(std::string search_text, rdf_type object_
         }
     }
     else
+    {
+        delete &search_response;
         throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Search failed with error message" + response);
+    }
     return search_response;
 };
 
+SearchResponse& sbol::PartShop::searchPage(std::string url)
+{
+    /* Perform HTTP request */
+    string response = client->get(url, search_headers(key)).body;
+    return parse_search_response(response);
+};
 
 int sbol::PartShop::searchCount(SearchQuery& q)
 {
     string url = parseURLDomain(resource);
     
-    /* Perform HTTP request */
-    string response;
-    CURL *curl;
-    CURLcode res;
-    
-    /* In windows, this will init the winsock stuff */
-    curl_global_init(CURL_GLOBAL_ALL);
-    
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(headers, "Content-Type: application/x-www-form-urlencoded");
-    headers = curl_slist_append(headers, "Accept: text/plain");
-    headers = curl_slist_append(headers, string("X-authorization: " + key).c_str());
-    
-    /* get a curl handle */
-    curl = curl_easy_init();
-    
+    unordered_map<string, string> headers;
+    headers["Content-Type"] = "application/x-www-form-urlencoded";
+    headers["Accept"] = "text/plain";
+    headers["X-authorization"] = key;
+
     /* Specify the GET parameters */
-    if(curl)
-    {
-        string parameters;
-        // Specify the type of SBOL object to search for
-        if (q["objectType"].size() == 1)
-            parameters = "objectType=" + parseClassName(q["objectType"].get()) + "&";
-        else
-            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "SearchQuery is invalid because it does not have an objectType specified");
-        
-        // Get the search criteria, while ignoring special search parameters like objectType, offset, and limit
-        vector<string> search_criteria = q.getProperties();
-        auto i_ignore = std::find(std::begin(search_criteria), std::end(search_criteria), SBOL_IDENTITY);
-        search_criteria.erase(i_ignore);
-        i_ignore = std::find(std::begin(search_criteria), std::end(search_criteria), SBOL_URI "#objectType");
-        search_criteria.erase(i_ignore);
-        i_ignore = std::find(std::begin(search_criteria), std::end(search_criteria), SBOL_URI "#offset");
-        search_criteria.erase(i_ignore);
-        i_ignore = std::find(std::begin(search_criteria), std::end(search_criteria), SBOL_URI "#limit");
-        search_criteria.erase(i_ignore);
-        
-        // Form GET request from the search criteria
-        for (auto & property_uri : search_criteria)
-            for (auto & property_val : q.getPropertyValues(property_uri))
+    string parameters;
+    // Specify the type of SBOL object to search for
+    if (q["objectType"].size() == 1)
+        parameters = "objectType=" + parseClassName(q["objectType"].get()) + "&";
+    else
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "SearchQuery is invalid because it does not have an objectType specified");
+    
+    // Get the search criteria, while ignoring special search parameters like objectType, offset, and limit
+    vector<string> search_criteria = q.getProperties();
+    auto i_ignore = std::find(std::begin(search_criteria), std::end(search_criteria), SBOL_IDENTITY);
+    search_criteria.erase(i_ignore);
+    i_ignore = std::find(std::begin(search_criteria), std::end(search_criteria), SBOL_URI "#objectType");
+    search_criteria.erase(i_ignore);
+    i_ignore = std::find(std::begin(search_criteria), std::end(search_criteria), SBOL_URI "#offset");
+    search_criteria.erase(i_ignore);
+    i_ignore = std::find(std::begin(search_criteria), std::end(search_criteria), SBOL_URI "#limit");
+    search_criteria.erase(i_ignore);
+    
+    // Form GET request from the search criteria
+    for (auto & property_uri : search_criteria)
+        for (auto & property_val : q.getPropertyValues(property_uri))
+        {
+            if (property_val.length() > 0)
             {
-                if (property_val.length() > 0)
-                {
-                    parameters += "<" + property_uri + ">=";
-                    if (property_val.find("http") == 0)
-                        parameters += "<" + property_val + ">&"; // encode property value as a URI
-                    else
-                        parameters += "'" + property_val + "'&"; // encode property value as a literal
-                }
+                parameters += "<" + property_uri + ">=";
+                if (property_val.find("http") == 0)
+                    parameters += "<" + property_val + ">&"; // encode property value as a URI
+                else
+                    parameters += "'" + property_val + "'&"; // encode property value as a literal
             }
-        
-        encode_url(parameters);
-        parameters = url + "/searchCount/" + parameters;
-        
-        /* First set the URL that is about to receive our GET. */
-        //curl_easy_setopt(curl, CURLOPT_URL, Config::getOption("validator_url").c_str());
-        curl_easy_setopt(curl, CURLOPT_URL, parameters.c_str());
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-        
-        /* Now specify the callback to read the response into string */
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlWrite_CallbackFunc_StdString);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-        
-        /* Perform the request, res will get the return code */
-        res = curl_easy_perform(curl);
-        /* Check for errors */
-        if(res != CURLE_OK)
-            throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to validate online failed with " + string(curl_easy_strerror(res)));
-        
-        /* always cleanup */
-        curl_easy_cleanup(curl);
-    }
-    curl_slist_free_all(headers);
-    curl_global_cleanup();
+        }
+    
+    encode_url(parameters);
+    parameters = url + "/searchCount/" + parameters;
+    
+    /* Perform HTTP request */
+    string response = client->get(parameters, headers).body;
     
     int count;
     try
@@ -455,61 +663,32 @@ int sbol::PartShop::searchCount(std::string search_text, rdf_type object_type, s
 {
     string url = resource;
     
-    /* Perform HTTP request */
-    string response;
-    CURL *curl;
-    CURLcode res;
+    unordered_map<string, string> headers;
+    headers["Content-Type"] = "application/x-www-form-urlencoded";
+    headers["Accept"] = "text/plain";
+    headers["X-authorization"] = key;
+
+    /* Specify the GET data */
+    // Specify the type of SBOL object to search for
+    string parameters = "objectType=" + parseClassName(object_type) + "&";
     
-    /* In windows, this will init the winsock stuff */
-    curl_global_init(CURL_GLOBAL_ALL);
+    //        // Specify which property of the SBOL object to look in for the search text
+    //        parameters += parsePropertyName(property_uri) + UTF8_EQUALS;
+    parameters += "<" + property_uri + ">=";
     
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(headers, "Content-Type: application/x-www-form-urlencoded");
-    headers = curl_slist_append(headers, "Accept: text/plain");
-    headers = curl_slist_append(headers, string("X-authorization: " + key).c_str());
+    if (search_text.find("http") == 0)
+        // Encode search text as a URL
+        parameters += "<" + search_text + ">&";
+    else
+        // Encode as a literal
+        parameters += "'" + search_text + "'&";
     
-    /* get a curl handle */
-    curl = curl_easy_init();
-    if(curl) {
-        /* Specify the GET data */
-        // Specify the type of SBOL object to search for
-        string parameters = "objectType=" + parseClassName(object_type) + "&";
-        
-        //        // Specify which property of the SBOL object to look in for the search text
-        //        parameters += parsePropertyName(property_uri) + UTF8_EQUALS;
-        parameters += "<" + property_uri + ">=";
-        
-        if (search_text.find("http") == 0)
-            // Encode search text as a URL
-            parameters += "<" + search_text + ">&";
-        else
-            // Encode as a literal
-            parameters += "'" + search_text + "'&";
-        
-        encode_url(parameters);
-        
-        parameters = parseURLDomain(url) + "/remoteSearch/" + parameters;
-        
-        /* First set the URL that is about to receive our GET. */
-        //curl_easy_setopt(curl, CURLOPT_URL, Config::getOption("validator_url").c_str());
-        curl_easy_setopt(curl, CURLOPT_URL, parameters.c_str());
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-        
-        /* Now specify the callback to read the response into string */
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlWrite_CallbackFunc_StdString);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-        
-        /* Perform the request, res will get the return code */
-        res = curl_easy_perform(curl);
-        /* Check for errors */
-        if(res != CURLE_OK)
-            throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to validate online failed with " + string(curl_easy_strerror(res)));
-        
-        /* always cleanup */
-        curl_easy_cleanup(curl);
-    }
-    curl_slist_free_all(headers);
-    curl_global_cleanup();
+    encode_url(parameters);
+    
+    parameters = parseURLDomain(url) + "/remoteSearch/" + parameters;
+    
+    /* Perform HTTP request */
+    string response = client->get(parameters, headers).body;
 
     int count;
     try
@@ -527,53 +706,24 @@ int sbol::PartShop::searchCount(std::string search_text, rdf_type object_type)
 {
     string url = parseURLDomain(resource);
     
-    /* Perform HTTP request */
-    string response;
-    CURL *curl;
-    CURLcode res;
+    unordered_map<string, string> headers;
+    headers["Content-Type"] = "application/x-www-form-urlencoded";
+    headers["Accept"] = "text/plain";
+    headers["X-authorization"] = key;
+
+    /* Specify the GET data */
+    // Specify the type of SBOL object to search for
+    string parameters = "objectType=" + parseClassName(object_type) + "&";
     
-    /* In windows, this will init the winsock stuff */
-    curl_global_init(CURL_GLOBAL_ALL);
+    // Specify partial search text. Specify how many records to retrieve
+    parameters = parameters + search_text;
     
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(headers, "Content-Type: application/x-www-form-urlencoded");
-    headers = curl_slist_append(headers, "Accept: text/plain");
-    headers = curl_slist_append(headers, string("X-authorization: " + key).c_str());
+    encode_url(search_text);
     
-    /* get a curl handle */
-    curl = curl_easy_init();
-    if(curl) {
-        /* Specify the GET data */
-        // Specify the type of SBOL object to search for
-        string parameters = "objectType=" + parseClassName(object_type) + "&";
-        
-        // Specify partial search text. Specify how many records to retrieve
-        parameters = parameters + search_text;
-        
-        encode_url(search_text);
-        
-        parameters = url + "/searchCount/" + parameters;
-        
-        /* First set the URL that is about to receive our GET. */
-        //curl_easy_setopt(curl, CURLOPT_URL, Config::getOption("validator_url").c_str());
-        curl_easy_setopt(curl, CURLOPT_URL, parameters.c_str());
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-        
-        /* Now specify the callback to read the response into string */
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlWrite_CallbackFunc_StdString);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-        
-        /* Perform the request, res will get the return code */
-        res = curl_easy_perform(curl);
-        /* Check for errors */
-        if(res != CURLE_OK)
-            throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to validate online failed with " + string(curl_easy_strerror(res)));
-        
-        /* always cleanup */
-        curl_easy_cleanup(curl);
-    }
-    curl_slist_free_all(headers);
-    curl_global_cleanup();
+    parameters = url + "/searchCount/" + parameters;
+    
+    /* Perform HTTP request */
+    string response = client->get(parameters, headers).body;
     
     int count;
     try
@@ -636,63 +786,214 @@ void sbol::PartShop::login(std::string user_id, std::string password)
         }
     }
 
-    /* Perform HTTP request */
-    string response;
-    CURL *curl;
-    CURLcode res;
-    long http_response_code = 0;
+    unordered_map<string, string> headers;
+    headers["Content-Type"] = "application/x-www-form-urlencoded";
 
-    /* In windows, this will init the winsock stuff */
-    curl_global_init(CURL_GLOBAL_ALL);
-    
-    struct curl_slist *headers = NULL;
-    //    headers = curl_slist_append(headers, "Accept: application/json");
-    headers = curl_slist_append(headers, "Content-Type: application/x-www-form-urlencoded");
-    //    headers = curl_slist_append(headers, "charsets: utf-8");
+    /* Now specify the POST data */
+    string parameters = "email=" + user_id + "&" + "password=" + password;
+
+    /* Perform HTTP request */
+    HTTPResponse http_response;
+    try
+    {
+        http_response = client->request(parseURLDomain(resource) + "/remoteLogin", headers, [&](CURL* curl)
+        {
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDS, parameters.c_str());
+        });
+    }
+    catch (SBOLError& e)
+    {
+        throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Login failed due to an HTTP error: " + e.error_message());
+    }
+    string response = http_response.body;
+    long http_response_code = http_response.status;
     
-    /* get a curl handle */
-    curl = curl_easy_init();
-    if(curl) {
-        /* First set the URL that is about to receive our POST. This URL can
-         just as well be a https:// URL if that is what should receive the
-         data. */
-        //curl_easy_setopt(curl, CURLOPT_URL, Config::getOption("validator_url").c_str());
-        curl_easy_setopt(curl, CURLOPT_URL, (parseURLDomain(resource) + "/remoteLogin").c_str());
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    if (http_response_code != 200)
+        throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Login failed due to a " + to_string(http_response_code) + " HTTP error: " + response);
 
-        if (Config::getOption("ca-path") != "")
-            curl_easy_setopt(curl , CURLOPT_CAINFO, Config::getOption("ca-path").c_str());
+    key = response;
+};
 
-        /* Now specify the POST data */
-        string parameters = "email=" + user_id + "&" + "password=" + password;
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, parameters.c_str());
-        
-        /* Now specify the callback to read the response into string */
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlWrite_CallbackFunc_StdString);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-        
-        /* Perform the request, res will get the return code */
-        res = curl_easy_perform(curl);
-        /* Check for errors */
-        if(res != CURLE_OK)
-            throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Login failed due to an HTTP error: " + string(curl_easy_strerror(res)));
+// Generates the body of a submission as libcurl reads it, one batch of TopLevels at a time, so that the serialization of
+// a large Document is never held in memory all at once. The body may be compressed as it is generated
+struct SubmissionStream
+{
+    Document* doc = NULL;
+    string* serialization = NULL;  // A Document which has already been serialized, in a format other than SBOL
+    unordered_map<string, SBOLObject*>::iterator i_obj;
+    int stage = 0;  // Header, TopLevels, footer, then done
+    string buffer;
+    size_t i_buffer = 0;
+    unsigned long long n_bytes = 0;  // The size of the body before compression
+    string error;
+    bool compress = false;
+#ifdef HAVE_ZLIB
+    z_stream zlib_stream;
+#endif
+
+    SubmissionStream(bool compress) :
+        compress(compress)
+    {
+#ifdef HAVE_ZLIB
+        if (compress)
+        {
+            memset(&zlib_stream, 0, sizeof(zlib_stream));
+            deflateInit2(&zlib_stream, Z_BEST_SPEED, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);  // 15 + 16 selects a gzip wrapper
+        }
+#endif
+    };
 
-        curl_easy_getinfo (curl, CURLINFO_RESPONSE_CODE, &http_response_code);
+    ~SubmissionStream()
+    {
+#ifdef HAVE_ZLIB
+        if (compress)
+            deflateEnd(&zlib_stream);
+#endif
+    };
 
+    // Generates the next part of the body. Returns false once the body is complete
+    bool fill()
+    {
+        string chunk;
+        if (stage == 3)
+            return false;
+        if (serialization)
+        {
+            chunk.swap(*serialization);
+            stage = 3;
+        }
+        else
+        {
+            std::ostringstream os;
+            if (stage == 0)
+            {
+                doc->serialize_rdfxml_header(os);
+                i_obj = doc->SBOLObjects.begin();
+                stage = 1;
+            }
+            else if (stage == 1)
+            {
+                // Small TopLevels are serialized in batches
+                while (i_obj != doc->SBOLObjects.end() && os.tellp() < 65536)
+                {
+                    doc->serialize_rdfxml_toplevel(os, *i_obj->second);
+                    ++i_obj;
+                }
+                if (i_obj == doc->SBOLObjects.end())
+                    stage = 2;
+            }
+            else
+            {
+                doc->serialize_rdfxml_footer(os);
+                stage = 3;
+            }
+            chunk = os.str();
+        }
+        n_bytes += chunk.size();
+        i_buffer = 0;
+        if (!compress)
+        {
+            buffer.swap(chunk);
+            return true;
+        }
+#ifdef HAVE_ZLIB
+        buffer.clear();
+        zlib_stream.next_in = (Bytef*)chunk.data();
+        zlib_stream.avail_in = (uInt)chunk.size();
+        char out[65536];
+        int status;
+        do
+        {
+            zlib_stream.next_out = (Bytef*)out;
+            zlib_stream.avail_out = sizeof(out);
+            status = deflate(&zlib_stream, stage == 3 ? Z_FINISH : Z_NO_FLUSH);
+            buffer.append(out, sizeof(out) - zlib_stream.avail_out);
+        } while (zlib_stream.avail_out == 0 || (stage == 3 && status != Z_STREAM_END));
+#endif
+        return true;
+    };
+};
+
+size_t read_submission(char* buffer, size_t size, size_t nitems, void* user_data)
+{
+    SubmissionStream* stream = (SubmissionStream*)user_data;
+    try
+    {
+        // Compression may consume a chunk without producing any output yet
+        while (stream->i_buffer == stream->buffer.size())
+            if (!stream->fill())
+                return 0;
+    }
+    catch (std::exception& e)
+    {
+        stream->error = e.what();
+        return CURL_READFUNC_ABORT;
+    }
+    size_t n_read = std::min(size * nitems, stream->buffer.size() - stream->i_buffer);
+    memcpy(buffer, stream->buffer.data() + stream->i_buffer, n_read);
+    stream->i_buffer += n_read;
+    return n_read;
+};
+
+// The form data of a submission, which must outlive its request
+struct sbol::Submission
+{
+    string url;
+    unordered_map<string, string> headers;
+    struct curl_httppost* post = NULL;
+    struct curl_httppost* last = NULL;
+    SubmissionStream stream;
+    string serialization;
+    int t_start = 0;  // For timing
+
+    Submission(bool compress) :
+        stream(compress)
+    {
+    };
+
+    ~Submission()
+    {
+        curl_formfree(post);
+    };
+
+    // Sets the options of the request on its handle
+    void configure(CURL* curl)
+    {
+        curl_easy_setopt(curl, CURLOPT_HTTPPOST, post);
+        curl_easy_setopt(curl, CURLOPT_READFUNCTION, read_submission);
+    };
 
-        /* always cleanup */
-        curl_easy_cleanup(curl);
-    }
-    curl_slist_free_all(headers);
-    curl_global_cleanup();
-    
-    if (http_response_code != 200)
-        throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Login failed due to a " + to_string(http_response_code) + " HTTP error: " + response);
+    // Interprets the response to the submission
+    std::string complete(HTTPResponse& http_response)
+    {
+        if (http_response.error != "")
+        {
+            if (stream.error != "")
+                throw SBOLError(SBOL_ERROR_SERIALIZATION, "Submission failed. " + stream.error);
+            throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "HTTP post request failed with: " + http_response.error);
+        }
+        if (Config::getOption("verbose") == "True")
+            cout << "Submitted " << stream.n_bytes << " bytes" << endl;
+        string response = http_response.body;
+        long http_response_code = http_response.status;
+        
+        if (Config::getOption("verbose") == "True")
+        {
+            cout << "Submission request returned HTTP response code " << http_response_code << endl;
+            int t_end = getTime();
+            cout << "Submission request took " << t_end - t_start << " seconds" << endl;
+        }
 
-    key = response;
+        if (http_response_code == 200)
+            return response;
+        else if (http_response_code == 401)
+            throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "You must login with valid credentials before submitting");
+        else
+            throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "HTTP post request failed with: " + response);
+    };
 };
 
-std::string sbol::PartShop::submit(Document& doc, std::string collection, int overwrite)
+std::shared_ptr<Submission> sbol::PartShop::prepareSubmission(Document& doc, std::string collection, int overwrite)
 {
     if (collection == "")
     {
@@ -709,6 +1010,15 @@ std::string sbol::PartShop::submit(Document& doc, std::string collection, int ov
             cout << "Submitting Document to existing collection: " << collection << endl;
     }
     
+    // The native SBOL serializer is streamed into the request. Other formats are serialized up front
+    bool compress = Config::getOption("compress_submissions") == "True";
+#ifndef HAVE_ZLIB
+    if (compress)
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot compress submission. libSBOL was built without zlib");
+#endif
+    std::shared_ptr<Submission> submission = std::make_shared<Submission>(compress);
+    submission->url = parseURLDomain(resource) + "/submit";
+
     int t_start;  // For timing
     int t_end;  // For timing
     if (Config::getOption("verbose") == "True")
@@ -719,105 +1029,79 @@ std::string sbol::PartShop::submit(Document& doc, std::string collection, int ov
         addSynBioHubAnnotations(doc);
     }
 
-    /* Perform HTTP request */
-    string response;
-    long http_response_code = 0;
-    CURL *curl;
-    CURLcode res;
-    
-    /* In windows, this will init the winsock stuff */
-    curl_global_init(CURL_GLOBAL_ALL);
-    
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(headers, "Accept: text/plain");
-    headers = curl_slist_append(headers, string("X-authorization: " + key).c_str());
-    //    headers = curl_slist_append(headers, "charsets: utf-8");
-    
-    /* get a curl handle */
-    curl = curl_easy_init();
-    if(curl) {
-        /* First set the URL that is about to receive our POST. This URL can
-         just as well be a https:// URL if that is what should receive the
-         data. */
-        
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-        curl_easy_setopt(curl, CURLOPT_URL, (parseURLDomain(resource) + "/submit").c_str());
+    unordered_map<string, string>& headers = submission->headers;
+    headers["Accept"] = "text/plain";
+    headers["X-authorization"] = key;
 
-        if (Config::getOption("ca-path") != "")
-            curl_easy_setopt(curl , CURLOPT_CAINFO, Config::getOption("ca-path").c_str());
-        
-        /* Now specify the POST data */
-        struct curl_httppost* post = NULL;
-        struct curl_httppost* last = NULL;
-        
-        if (doc.displayId.size())
-            curl_formadd(&post, &last, CURLFORM_COPYNAME, "id", CURLFORM_COPYCONTENTS, doc.displayId.get().c_str(), CURLFORM_END);
-        if (doc.version.size())
-            curl_formadd(&post, &last, CURLFORM_COPYNAME, "version", CURLFORM_COPYCONTENTS, doc.version.get().c_str(), CURLFORM_END);
-        if (doc.name.size())
-            curl_formadd(&post, &last, CURLFORM_COPYNAME, "name", CURLFORM_COPYCONTENTS, doc.name.get().c_str(), CURLFORM_END);
-        if (doc.description.size())
-            curl_formadd(&post, &last, CURLFORM_COPYNAME, "description", CURLFORM_COPYCONTENTS, doc.description.get().c_str(), CURLFORM_END);
-        string citations;
-        for (auto citation : doc.citations.getAll())
-            citations += citation + ",";
-        citations = citations.substr(0, citations.length() - 1);
-        curl_formadd(&post, &last, CURLFORM_COPYNAME, "citations", CURLFORM_COPYCONTENTS, citations.c_str(), CURLFORM_END);  // Comma separated list
-        string keywords;
-        for (auto kw : doc.keywords.getAll())
-            keywords += kw + ",";
-        keywords = keywords.substr(0, keywords.length() - 1);
-        curl_formadd(&post, &last, CURLFORM_COPYNAME, "keywords", CURLFORM_COPYCONTENTS, keywords.c_str(), CURLFORM_END);
-//        curl_formadd(&post, &last, CURLFORM_COPYNAME, "collectionChoices", CURLFORM_COPYCONTENTS, collection.c_str(), CURLFORM_END);
-        curl_formadd(&post, &last, CURLFORM_COPYNAME, "overwrite_merge", CURLFORM_COPYCONTENTS, std::to_string(overwrite).c_str(), CURLFORM_END);
-        curl_formadd(&post, &last, CURLFORM_COPYNAME, "user", CURLFORM_COPYCONTENTS, key.c_str(), CURLFORM_END);
-        curl_formadd(&post, &last, CURLFORM_COPYNAME, "file", CURLFORM_COPYCONTENTS, doc.writeString().c_str(), CURLFORM_CONTENTTYPE, "text/xml", CURLFORM_END);
-
-        if (collection != "")
-            curl_formadd(&post, &last, CURLFORM_COPYNAME, "rootCollections", CURLFORM_COPYCONTENTS, collection.c_str());
-        
-        
-        /* Set the form info */
-        curl_easy_setopt(curl, CURLOPT_HTTPPOST, post);
-        
-        /* Now specify the callback to read the response into string */
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlWrite_CallbackFunc_StdString);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+    /* Now specify the POST data */
+    struct curl_httppost*& post = submission->post;
+    struct curl_httppost*& last = submission->last;
+    
+    if (doc.displayId.size())
+        curl_formadd(&post, &last, CURLFORM_COPYNAME, "id", CURLFORM_COPYCONTENTS, doc.displayId.get().c_str(), CURLFORM_END);
+    if (doc.version.size())
+        curl_formadd(&post, &last, CURLFORM_COPYNAME, "version", CURLFORM_COPYCONTENTS, doc.version.get().c_str(), CURLFORM_END);
+    if (doc.name.size())
+        curl_formadd(&post, &last, CURLFORM_COPYNAME, "name", CURLFORM_COPYCONTENTS, doc.name.get().c_str(), CURLFORM_END);
+    if (doc.description.size())
+        curl_formadd(&post, &last, CURLFORM_COPYNAME, "description", CURLFORM_COPYCONTENTS, doc.description.get().c_str(), CURLFORM_END);
+    string citations;
+    for (auto citation : doc.citations.getAll())
+        citations += citation + ",";
+    citations = citations.substr(0, citations.length() - 1);
+    curl_formadd(&post, &last, CURLFORM_COPYNAME, "citations", CURLFORM_COPYCONTENTS, citations.c_str(), CURLFORM_END);  // Comma separated list
+    string keywords;
+    for (auto kw : doc.keywords.getAll())
+        keywords += kw + ",";
+    keywords = keywords.substr(0, keywords.length() - 1);
+    curl_formadd(&post, &last, CURLFORM_COPYNAME, "keywords", CURLFORM_COPYCONTENTS, keywords.c_str(), CURLFORM_END);
+//    curl_formadd(&post, &last, CURLFORM_COPYNAME, "collectionChoices", CURLFORM_COPYCONTENTS, collection.c_str(), CURLFORM_END);
+    curl_formadd(&post, &last, CURLFORM_COPYNAME, "overwrite_merge", CURLFORM_COPYCONTENTS, std::to_string(overwrite).c_str(), CURLFORM_END);
+    curl_formadd(&post, &last, CURLFORM_COPYNAME, "user", CURLFORM_COPYCONTENTS, key.c_str(), CURLFORM_END);
+
+    SubmissionStream& stream = submission->stream;
+    if (Config::getOption("serialization_format") == "sbol")
+        stream.doc = &doc;
+    else
+    {
+        submission->serialization = doc.writeString();
+        stream.serialization = &submission->serialization;
+    }
+    if (compress)
+        curl_formadd(&post, &last, CURLFORM_COPYNAME, "file", CURLFORM_STREAM, &stream, CURLFORM_FILENAME, "document.xml.gz", CURLFORM_CONTENTTYPE, "application/gzip", CURLFORM_END);
+    else
+        curl_formadd(&post, &last, CURLFORM_COPYNAME, "file", CURLFORM_STREAM, &stream, CURLFORM_CONTENTTYPE, "text/xml", CURLFORM_END);
 
-        if (Config::getOption("verbose") == "True")
-        {
-            t_end = getTime();
-            cout << "Serialization took " << t_end - t_start << " seconds" << endl;
-            t_start = getTime();   
-        }        
-        /* Perform the request, res will get the return code */
-        res = curl_easy_perform(curl);
+    if (collection != "")
+        curl_formadd(&post, &last, CURLFORM_COPYNAME, "rootCollections", CURLFORM_COPYCONTENTS, collection.c_str(), CURLFORM_END);
 
-        curl_easy_getinfo (curl, CURLINFO_RESPONSE_CODE, &http_response_code);
-        
-        /* Check for errors */
-        if(res != CURLE_OK)
-            throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "HTTP post request failed with: " + string(curl_easy_strerror(res)));
-        
-        /* always cleanup */
-        curl_easy_cleanup(curl);
-    }
-    curl_slist_free_all(headers);
-    curl_global_cleanup();
-    
     if (Config::getOption("verbose") == "True")
     {
-        cout << "Submission request returned HTTP response code " << http_response_code << endl;
         t_end = getTime();
-        cout << "Submission request took " << t_end - t_start << " seconds" << endl;
-    }
+        cout << "Serialization took " << t_end - t_start << " seconds" << endl;
+        submission->t_start = getTime();   
+    }        
+    return submission;
+};
 
-    if (http_response_code == 200)
-        return response;
-    else if (http_response_code == 401)
-        throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "You must login with valid credentials before submitting");
-    else
-        throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "HTTP post request failed with: " + response);
+std::string sbol::PartShop::submit(Document& doc, std::string collection, int overwrite)
+{
+    std::shared_ptr<Submission> submission = prepareSubmission(doc, collection, overwrite);
+
+    /* Perform HTTP request */
+    HTTPResponse http_response;
+    try
+    {
+        http_response = client->request(submission->url, submission->headers, [&](CURL* curl)
+        {
+            submission->configure(curl);
+        });
+    }
+    catch (SBOLError& e)
+    {
+        http_response.error = e.error_message();
+    }
+    return submission->complete(http_response);
 };
 
 //std::string sbol::PartShop::submit(std::string filename, std::string collection, int overwrite)
@@ -956,47 +1240,20 @@ std::string PartShop::searchRootCollections()
     std::string get_request;
     get_request = parseURLDomain(resource) + "/rootCollections";
     
+    unordered_map<string, string> headers;
+    headers["Accept"] = "text/plain";
+    headers["X-authorization"] = key;
+
     /* Perform HTTP request */
     std::string response;
-    CURL *curl;
-    CURLcode res;
-    
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(headers, "Accept: text/plain");
-    headers = curl_slist_append(headers, string("X-authorization: " + key).c_str());
-
-    
-    /* In windows, this will init the winsock stuff */
-    curl_global_init(CURL_GLOBAL_ALL);
-        
-    /* get a curl handle */
-    curl = curl_easy_init();
-    if(curl) {
-        /* First set the URL that is about to receive our POST. This URL can
-         just as well be a https:// URL if that is what should receive the
-         data. */
-        //curl_easy_setopt(curl, CURLOPT_URL, Config::getOption("validator_url").c_str());
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-        curl_easy_setopt(curl, CURLOPT_URL, get_request.c_str());
-
-        if (Config::getOption("ca-path") != "")
-            curl_easy_setopt(curl , CURLOPT_CAINFO, Config::getOption("ca-path").c_str());
-
-        /* Now specify the callback to read the response into string */
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlWrite_CallbackFunc_StdString);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-        
-        /* Perform the request, res will get the return code */
-        res = curl_easy_perform(curl);
-        /* Check for errors */
-        if(res != CURLE_OK)
-            throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to retrieve root collections failed with: " + std::string(curl_easy_strerror(res)));
-        
-        /* always cleanup */
-        curl_easy_cleanup(curl);
+    try
+    {
+        response = client->get(get_request, headers).body;
+    }
+    catch (SBOLError& e)
+    {
+        throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to retrieve root collections failed with: " + e.error_message());
     }
-    curl_slist_free_all(headers);
-    curl_global_cleanup();
     
     return response;
 };
@@ -1007,144 +1264,381 @@ std::string PartShop::searchSubCollections(std::string uri)
     std::string get_request;
     get_request = uri + "/subCollections";
     
+    unordered_map<string, string> headers;
+    headers["Accept"] = "text/plain";
+    headers["X-authorization"] = key;
+
     /* Perform HTTP request */
     std::string response;
-    CURL *curl;
-    CURLcode res;
-    
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(headers, "Accept: text/plain");
-    headers = curl_slist_append(headers, string("X-authorization: " + key).c_str());
+    try
+    {
+        response = client->get(get_request, headers).body;
+    }
+    catch (SBOLError& e)
+    {
+        throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to count objects failed with " + e.error_message());
+    }
+    return response;
+};
 
-    /* In windows, this will init the winsock stuff */
-    curl_global_init(CURL_GLOBAL_ALL);
-        
-    /* get a curl handle */
-    curl = curl_easy_init();
-    if(curl) {
-        /* First set the URL that is about to receive our POST. This URL can
-         just as well be a https:// URL if that is what should receive the
-         data. */
-        //curl_easy_setopt(curl, CURLOPT_URL, Config::getOption("validator_url").c_str());
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-        curl_easy_setopt(curl, CURLOPT_URL, get_request.c_str());
 
-        if (Config::getOption("ca-path") != "")
-            curl_easy_setopt(curl , CURLOPT_CAINFO, Config::getOption("ca-path").c_str());
+void PartShop::pull(std::vector<std::string> uris, Document& doc, bool recursive)
+{
+    if (recursive && Config::getOption("incremental_pull") == "True")
+        pullIncremental(uris, doc);
+    else
+        pullAll(uris, doc, recursive);
+};
 
-        /* Now specify the callback to read the response into string */
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlWrite_CallbackFunc_StdString);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-        
-        /* Perform the request, res will get the return code */
-        res = curl_easy_perform(curl);
-        /* Check for errors */
-        if(res != CURLE_OK)
-            throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to count objects failed with " + std::string(curl_easy_strerror(res)));
-        
-        /* always cleanup */
-        curl_easy_cleanup(curl);
+// Adds the identities of an object and its children to a set
+void index_identities(SBOLObject& obj, unordered_set<string>& identities)
+{
+    identities.insert(obj.identity.get());
+    auto i_persistent_identity = obj.properties.find(SBOL_PERSISTENT_IDENTITY);
+    if (i_persistent_identity != obj.properties.end())
+        for (auto& value : i_persistent_identity->second)
+            if (value.size() > 2 && value[0] == '<')
+                identities.insert(value.substr(1, value.size() - 2));
+    for (auto& i_store : obj.owned_objects)
+        for (auto child : i_store.second)
+            index_identities(*child, identities);
+};
+
+// Collects the URIs referred to by the properties of an object and its children
+void get_references(SBOLObject& obj, vector<string>& references)
+{
+    for (auto& i_property : obj.properties)
+    {
+        if (i_property.first == SBOL_IDENTITY || i_property.first == SBOL_PERSISTENT_IDENTITY)
+            continue;
+        for (auto& value : i_property.second)
+            if (value.size() > 2 && value[0] == '<')
+                references.push_back(value.substr(1, value.size() - 2));
     }
-    curl_slist_free_all(headers);
-    curl_global_cleanup();
-    return response;
+    for (auto& i_store : obj.owned_objects)
+        for (auto child : i_store.second)
+            get_references(*child, references);
+};
+
+void PartShop::pullIncremental(std::vector<std::string> uris, Document& doc)
+{
+    // The objects which the Document already holds, including child objects, which may also be referred to
+    unordered_set<string> known;
+    for (auto& i_obj : doc.SBOLObjects)
+        index_identities(*i_obj.second, known);
+
+    // The requested objects are always retrieved, since the caller may want a fresh copy
+    vector<SBOLObject*> added;
+    pullAll(uris, doc, false, NULL, &added);
+    unordered_set<string> requested(uris.begin(), uris.end());
+    string domain = parseURLDomain(resource);
+    while (added.size())
+    {
+        for (auto obj : added)
+            index_identities(*obj, known);
+
+        // Only references to objects in this repository are followed, since it cannot serve any others
+        vector<string> references;
+        for (auto obj : added)
+            get_references(*obj, references);
+        vector<string> frontier;
+        for (auto& uri : references)
+        {
+            if (doc.SBOLObjects.count(uri) || known.count(uri) || requested.count(uri))
+                continue;
+            if (uri.find(resource) == std::string::npos && uri.find(domain) == std::string::npos &&
+                (spoofed_resource == "" || uri.find(spoofed_resource) == std::string::npos))
+                continue;
+            requested.insert(uri);
+            frontier.push_back(uri);
+        }
+        if (Config::getOption("verbose") == "True")
+            std::cout << "Retrieving " << frontier.size() << " referenced objects" << std::endl;
+        added.clear();
+        if (frontier.size())
+        {
+            vector<string> missing;
+            pullAll(frontier, doc, false, &missing, &added);
+            if (Config::getOption("verbose") == "True")
+                for (auto& uri : missing)
+                    std::cout << "Skipping " << uri << ", which was not found" << std::endl;
+        }
+    }
+};
+
+// A queue of responses shared by a pool of parser threads. The threads are released and joined when the pool is destroyed,
+// so an exception thrown while responses are being received does not leave them running
+struct ParserPool
+{
+    std::mutex queue_lock;
+    std::condition_variable queue_ready;
+    std::deque<size_t> queue;
+    bool all_received = false;
+    vector<std::thread> parsers;
+
+    // Waits for the next response to parse. Returns false once all responses have been received and taken
+    bool next(size_t& i_response)
+    {
+        std::unique_lock<std::mutex> lock(queue_lock);
+        queue_ready.wait(lock, [&]() { return queue.size() || all_received; });
+        if (queue.empty())
+            return false;
+        i_response = queue.front();
+        queue.pop_front();
+        return true;
+    };
+
+    void push(size_t i_response)
+    {
+        std::lock_guard<std::mutex> lock(queue_lock);
+        queue.push_back(i_response);
+        queue_ready.notify_one();
+    };
+
+    // Waits for the parsers to finish the responses which have been queued
+    void join()
+    {
+        {
+            std::lock_guard<std::mutex> lock(queue_lock);
+            all_received = true;
+        }
+        queue_ready.notify_all();
+        for (auto& parser : parsers)
+            if (parser.joinable())
+                parser.join();
+    };
+
+    ~ParserPool()
+    {
+        join();
+    };
 };
 
+void PartShop::pullAll(std::vector<std::string> uris, Document& doc, bool recursive, std::vector<std::string>* missing, std::vector<SBOLObject*>* added)
+{
+    int max_parallel = 0;
+    try
+    {
+        max_parallel = stoi(Config::getOption("max_parallel_requests"));
+    }
+    catch (std::exception&)
+    {
+    }
+    if (max_parallel < 1)
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot pull. The max_parallel_requests option must be a positive integer");
+
+    unordered_map<string, string> headers;
+    headers["X-authorization"] = key;
+    headers["Accept"] = "text/plain";
+
+    vector<string> requests;
+    for (auto uri : uris)
+        requests.push_back(pullURL(uri, recursive));
+
+    // Parsing constructs objects through the data model register, which is safe to do concurrently. Extension classes
+    // defined in Python must be constructed while holding the interpreter lock, so in that case responses are parsed
+    // on the calling thread after all have arrived
+    bool parse_concurrently = true;
+#if defined(SBOL_BUILD_PYTHON2) || defined(SBOL_BUILD_PYTHON3)
+    if (Config::PYTHON_DATA_MODEL_REGISTER.size())
+        parse_concurrently = false;
+#endif
+
+    vector<string> responses(uris.size());
+    vector<std::unique_ptr<Document>> parsed(uris.size());
+    vector<std::shared_ptr<SBOLError>> errors(uris.size());
+    vector<bool> not_found(uris.size(), false);
+
+    // Responses are queued for a pool of parser threads as they arrive. The format is given to each parser explicitly, since
+    // the serialization_format option is shared with other threads
+    ParserPool pool;
+    int n_parsers = parse_concurrently ? std::max(1, std::min(max_parallel, (int)std::thread::hardware_concurrency())) : 0;
+    for (int i_parser = 0; i_parser < n_parsers; ++i_parser)
+        pool.parsers.push_back(std::thread([&]()
+        {
+            size_t i_uri;
+            while (pool.next(i_uri))
+            {
+                parsed[i_uri].reset(new Document());
+                try
+                {
+                    parsed[i_uri]->readString(responses[i_uri], "sbol");
+                }
+                catch (SBOLError& e)
+                {
+                    errors[i_uri] = std::make_shared<SBOLError>(e.error_code(), "Unable to parse " + uris[i_uri] + ". " + e.error_message());
+                }
+                catch (std::exception& e)
+                {
+                    errors[i_uri] = std::make_shared<SBOLError>(SBOL_ERROR_PARSE, "Unable to parse " + uris[i_uri] + ". " + e.what());
+                }
+                string().swap(responses[i_uri]);
+            }
+        }));
+
+    PartCache* part_cache = getCache();
+    bool offline = part_cache && Config::getOption("offline") == "True";
+    vector<string> cache_keys;
+    for (auto& request : requests)
+        cache_keys.push_back(cache_key(request, headers));
+    auto receive = [&](size_t i_uri, HTTPResponse& response)
+    {
+        if (part_cache && !offline)
+            part_cache->resolve(cache_keys[i_uri], response);
+        if (Config::getOption("verbose") == "True")
+            std::cout << "Request " << requests[i_uri] << " returned status code " << response.status << std::endl;
+        if (response.error != "")
+            errors[i_uri] = std::make_shared<SBOLError>(SBOL_ERROR_BAD_HTTP_REQUEST, "Unable to pull " + uris[i_uri] + ". " + response.error);
+        else if (response.status == 404 && missing)
+            not_found[i_uri] = true;
+        else if (response.status == 404)
+            errors[i_uri] = std::make_shared<SBOLError>(SBOL_ERROR_NOT_FOUND, "Part not found. Unable to pull " + uris[i_uri]);
+        else if (response.status == 401)
+            errors[i_uri] = std::make_shared<SBOLError>(SBOL_ERROR_HTTP_UNAUTHORIZED, "Please login with valid credentials");
+        else if (response.status != 200 && response.status != 302)
+            errors[i_uri] = std::make_shared<SBOLError>(SBOL_ERROR_BAD_HTTP_REQUEST, response.body);
+        if (errors[i_uri] || not_found[i_uri])
+            return;
+        responses[i_uri].swap(response.body);
+        if (parse_concurrently)
+            pool.push(i_uri);
+    };
+    if (offline)
+    {
+        for (size_t i_uri = 0; i_uri < requests.size(); ++i_uri)
+        {
+            HTTPResponse response;
+            if (part_cache->fetch(cache_keys[i_uri], response))
+                receive(i_uri, response);
+            else if (missing)
+                not_found[i_uri] = true;
+            else
+                errors[i_uri] = std::make_shared<SBOLError>(SBOL_ERROR_NOT_FOUND, "Part not found. Unable to pull " + uris[i_uri] + ". Cannot retrieve " + requests[i_uri] + " while offline, because it is not in the cache");
+        }
+    }
+    else
+    {
+        vector<unordered_map<string, string>> request_headers(requests.size(), headers);
+        if (part_cache)
+            for (size_t i_uri = 0; i_uri < requests.size(); ++i_uri)
+                part_cache->addValidators(cache_keys[i_uri], request_headers[i_uri]);
+        client->requestAll(requests, request_headers, max_parallel, receive);
+    }
+    pool.join();
+
+    // Report the first failure, in the order the URIs were given, without modifying the Document
+    for (auto& error : errors)
+        if (error)
+            throw *error;
+
+    if (missing)
+        for (size_t i_uri = 0; i_uri < uris.size(); ++i_uri)
+            if (not_found[i_uri])
+                missing->push_back(uris[i_uri]);
+
+    if (parse_concurrently)
+    {
+        for (auto& scratch : parsed)
+        {
+            if (!scratch)
+                continue;
+            if (added)
+                for (auto& i_obj : scratch->SBOLObjects)
+                    if (!doc.SBOLObjects.count(i_obj.first))
+                        added->push_back(i_obj.second);
+            doc.absorb(*scratch);
+            scratch.reset();
+        }
+    }
+    else
+    {
+        unordered_set<string> existing;
+        if (added)
+            for (auto& i_obj : doc.SBOLObjects)
+                existing.insert(i_obj.first);
+        for (size_t i_uri = 0; i_uri < uris.size(); ++i_uri)
+            if (!not_found[i_uri])
+                doc.readString(responses[i_uri], "sbol");
+        if (added)
+            for (auto& i_obj : doc.SBOLObjects)
+                if (!existing.count(i_obj.first))
+                    added->push_back(i_obj.second);
+    }
+    doc.resource_namespaces.insert(resource);
+}
 
-void PartShop::pull(std::vector<std::string> uris, Document& doc, bool recursive)
+// Raises an SBOLError for a transport error or an HTTP error code
+void check_http_response(const HTTPResponse& response)
 {
-    for (auto & uri : uris)
-        pull(uri, doc, recursive);
+    if (response.error != "")
+        throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, response.error);
+    if (response.status == 404)
+        throw SBOLError(SBOL_ERROR_NOT_FOUND, "");
+    else if (response.status == 401)
+        throw SBOLError(SBOL_ERROR_HTTP_UNAUTHORIZED, "Please login with valid credentials");
+    else if (response.status == 302)
+        ;  // Do nothing in case of redirect. This occurs sometimes with spoofed resources
+    else if (response.status != 200)
+        throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, response.body);
 }
 
-std::string http_get_request(std::string get_request, unordered_map<string, string>* headers = NULL, unordered_map<string, string>* response_headers = NULL)
+// Issues a GET request through a pool of connections, and raises an SBOLError for HTTP error codes. If a cache is given,
+// the response is revalidated against the cache, or read from it when working offline
+std::string http_get_request(HTTPClient& client, std::string get_request, unordered_map<string, string>* headers = NULL, unordered_map<string, string>* response_headers = NULL, PartCache* cache = NULL)
 {
-    /* Perform HTTP request */
-    std::string response;
-    CURL *curl;
-    CURLcode res;
+    if (Config::getOption("verbose") == "True")
+    {
+        std::cout << "Issuing get request: " << get_request << std::endl;
+    }
 
-    /* In windows, this will init the winsock stuff */
-    curl_global_init(CURL_GLOBAL_ALL);
-    
-    struct curl_slist *header_list = NULL;
+    /* Perform the request */
+    HTTPResponse http_response;
+    unordered_map<string, string> request_headers;
     if (headers)
-        for (auto & header : *headers)
-            header_list = curl_slist_append(header_list, (header.first + ": " + header.second).c_str());
-    
-    //    headers = curl_slist_append(headers, "Accept: application/json");
-    //    headers = curl_slist_append(headers, "Content-Type: application/x-www-form-urlencoded");
-    //    headers = curl_slist_append(headers, "charsets: utf-8");
-    
-    /* get a curl handle */
-    curl = curl_easy_init();
-    if(curl) {
-        /* First set the URL that is about to receive our POST. This URL can
-         just as well be a https:// URL if that is what should receive the
-         data. */
-        //curl_easy_setopt(curl, CURLOPT_URL, Config::getOption("validator_url").c_str());
-        curl_easy_setopt(curl, CURLOPT_URL, get_request.c_str());
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, header_list);
-        if (Config::getOption("ca-path") != "")
-            curl_easy_setopt(curl , CURLOPT_CAINFO, Config::getOption("ca-path").c_str());
-
-        /* Now specify the POST data */
-        //        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, json.c_str());
-        
-        /* Now specify the callback to read the response into string */
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlWrite_CallbackFunc_StdString);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-        
-        /* Now specify the callback to read response headers */
-        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, CurlResponseHeader_CallbackFunc);
-        curl_easy_setopt(curl, CURLOPT_HEADERDATA, response_headers);
-        if (Config::getOption("ca-path") != "")
-            curl_easy_setopt(curl , CURLOPT_CAINFO, Config::getOption("ca-path").c_str());
-
-        if (Config::getOption("verbose") == "True")
+        request_headers = *headers;
+    string key = cache_key(get_request, request_headers);
+    if (cache && Config::getOption("offline") == "True")
+    {
+        if (!cache->fetch(key, http_response))
+            throw SBOLError(SBOL_ERROR_NOT_FOUND, "Cannot retrieve " + get_request + " while offline, because it is not in the cache");
+    }
+    else if (cache)
+    {
+        cache->addValidators(key, request_headers);
+        try
         {
-            std::cout << "Issuing get request: " << get_request << std::endl;
+            http_response = client.get(get_request, request_headers);
         }
-
-        /* Perform the request, res will get the return code */
-        res = curl_easy_perform(curl);
-        
-        /* Check for errors */
-        if(res != CURLE_OK)
-            throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, std::string(curl_easy_strerror(res)));
-
-        long http_response_code = 0;
-        curl_easy_getinfo (curl, CURLINFO_RESPONSE_CODE, &http_response_code);
-        if (Config::getOption("verbose") == "True")
+        catch (SBOLError& e)
         {
-            std::cout << "Received response" << std::endl << response << std::endl;
-            std::cout << "HTTP request returned status code " << http_response_code << std::endl;
+            http_response.error = e.error_message();
         }
-        if (http_response_code == 404)
-            throw SBOLError(SBOL_ERROR_NOT_FOUND, "");
-        else if (http_response_code == 401)
-            throw SBOLError(SBOL_ERROR_HTTP_UNAUTHORIZED, "Please login with valid credentials");
-        else if (http_response_code == 302)
-            ;  // Do nothing in case of redirect. This occurs sometimes with spoofed resources
-        else if (http_response_code != 200)
-            throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, response);
+        if (!cache->resolve(key, http_response) && http_response.error != "")
+            throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, http_response.error);
+    }
+    else
+        http_response = client.get(get_request, request_headers);
+    std::string& response = http_response.body;
+    if (response_headers)
+        *response_headers = http_response.headers;
 
-        /* always cleanup */
-        curl_easy_cleanup(curl);
+    if (Config::getOption("verbose") == "True")
+    {
+        std::cout << "Received response" << std::endl << response << std::endl;
+        std::cout << "HTTP request returned status code " << http_response.status << std::endl;
     }
-    curl_slist_free_all(header_list);
-    curl_global_cleanup();
+    check_http_response(http_response);
     return response;
 }
 
-
-void PartShop::pull(std::string uri, Document& doc, bool recursive)
+std::string http_get_request(std::string get_request, unordered_map<string, string>* headers = NULL, unordered_map<string, string>* response_headers = NULL)
 {
-    std::string response;  // holds the response returned from the http get request
-    unordered_map<string, string> headers;
-    headers["X-authorization"] = key;
-    headers["Accept"] = "text/plain";
+    HTTPClient client;
+    return http_get_request(client, get_request, headers, response_headers);
+}
 
+std::string PartShop::pullURL(std::string uri, bool recursive)
+{
     string query;
     if (uri.find(resource) != std::string::npos)
         query = uri;  // User has specified full URI
@@ -1154,19 +1648,32 @@ void PartShop::pull(std::string uri, Document& doc, bool recursive)
         query = uri.replace(uri.find(spoofed_resource), spoofed_resource.size(), resource);
     else
         query = resource + "/" + uri;  // Assume user has only specified displayId
+    return query + (recursive ? "/sbol" : "/sbolnr");
+};
+
+void PartShop::pull(std::string uri, Document& doc, bool recursive)
+{
+    if (recursive && Config::getOption("incremental_pull") == "True")
+    {
+        pullIncremental({ uri }, doc);
+        return;
+    }
+    std::string response;  // holds the response returned from the http get request
+    unordered_map<string, string> headers;
+    headers["X-authorization"] = key;
+    headers["Accept"] = "text/plain";
+
     try
     {
-        string get_request = query + "/sbol";
-        if (!recursive)
-            get_request += "nr";
+        string get_request = pullURL(uri, recursive);
         if (Config::getOption("verbose") == "True")
             std::cout << "Issuing get request:\n" << get_request << std::endl;
-        response = http_get_request(get_request, &headers);
+        response = http_get_request(*client, get_request, &headers, NULL, getCache());
     }
     catch (SBOLError& e)
     {
         if (e.error_code() == SBOL_ERROR_NOT_FOUND)
-            throw SBOLError(SBOL_ERROR_NOT_FOUND, "Part not found. Unable to pull " + uri);
+            throw SBOLError(SBOL_ERROR_NOT_FOUND, "Part not found. Unable to pull " + uri + (e.error_message() != "" ? ". " + e.error_message() : ""));
     }
 
     Document temp_doc = Document();
@@ -1184,7 +1691,7 @@ void sbol::PartShop::spoof(std::string spoofed_url)
     spoofed_resource = spoofed_url;
 };
 
-std::string sbol::PartShop::sparqlQuery(std::string query)
+std::string sbol::PartShop::sparqlURL(std::string query)
 {
     string endpoint = parseURLDomain(this->resource) + "/sparql?query=";
     string resource;
@@ -1200,7 +1707,12 @@ std::string sbol::PartShop::sparqlQuery(std::string query)
         query = query.insert(p, from_clause);
     }
     encode_url(query);
-    query = endpoint + query;
+    return endpoint + query;
+};
+
+std::string sbol::PartShop::sparqlQuery(std::string query)
+{
+    query = sparqlURL(query);
 
     unordered_map<string, string> headers;
     unordered_map<string, string> header_response;
@@ -1210,11 +1722,132 @@ std::string sbol::PartShop::sparqlQuery(std::string query)
     string response;
     if (Config::getOption("verbose") == "True")
         std::cout << "Issuing SPARQL:\n" << query << std::endl;
-    response = http_get_request(query, &headers);
+    response = http_get_request(*client, query, &headers);
 
     return response;
 };
 
+// Hands a SPARQL response to a decoder as it arrives. The body of an error response is kept for its message instead
+struct SPARQLStream
+{
+    SPARQLDecoder* decoder;
+    CURL* curl;
+    long status = 0;
+    std::string error_body;
+    std::exception_ptr error;
+};
+
+size_t write_sparql(void* data, size_t size, size_t n_items, void* user_data)
+{
+    SPARQLStream* stream = (SPARQLStream*)user_data;
+    size_t n_bytes = size * n_items;
+    if (stream->status == 0)
+        curl_easy_getinfo(stream->curl, CURLINFO_RESPONSE_CODE, &stream->status);
+    if (stream->status != 200)
+    {
+        stream->error_body.append((char*)data, n_bytes);
+        return n_bytes;
+    }
+    try
+    {
+        stream->decoder->decode((char*)data, n_bytes);
+    }
+    catch (...)
+    {
+        // Exceptions must not propagate through libcurl. Returning a short count aborts the transfer
+        stream->error = current_exception();
+        return 0;
+    }
+    return n_bytes;
+};
+
+void sbol::PartShop::sparqlDecode(std::string query, SPARQLDecoder& decoder)
+{
+    query = sparqlURL(query);
+
+    unordered_map<string, string> headers;
+    headers["X-authorization"] = key;
+    headers["Accept"] = "application/json";
+
+    if (Config::getOption("verbose") == "True")
+        std::cout << "Issuing SPARQL:\n" << query << std::endl;
+
+    SPARQLStream stream;
+    stream.decoder = &decoder;
+    HTTPResponse response;
+    try
+    {
+        response = client->request(query, headers, [&](CURL* curl)
+        {
+            stream.curl = curl;
+            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_sparql);
+            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &stream);
+        });
+    }
+    catch (SBOLError& e)
+    {
+        if (stream.error)
+            rethrow_exception(stream.error);
+        throw;
+    }
+
+    if (Config::getOption("verbose") == "True")
+        std::cout << "HTTP request returned status code " << response.status << std::endl;
+    if (response.status == 404)
+        throw SBOLError(SBOL_ERROR_NOT_FOUND, "");
+    else if (response.status == 401)
+        throw SBOLError(SBOL_ERROR_HTTP_UNAUTHORIZED, "Please login with valid credentials");
+    else if (response.status != 200)
+        throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, stream.error_body);
+    decoder.finish();
+};
+
+std::vector<std::string> sbol::PartShop::sparqlQuery(std::string query, void (*row_fn)(const std::vector<std::string>& variables, std::vector<SPARQLTerm>& row, void* user_data), void* user_data)
+{
+    SPARQLDecoder decoder([&](const vector<string>& variables, vector<SPARQLTerm>& row)
+    {
+        row_fn(variables, row, user_data);
+    });
+    sparqlDecode(query, decoder);
+    return decoder.variables;
+};
+
+void sbol::PartShop::sparqlQuery(std::string query, SPARQLResults& results)
+{
+    results = SPARQLResults();
+    size_t n_rows = 0;
+    
+    // Adds columns for variables which have been seen so far, and pads them for the earlier solutions
+    auto add_columns = [&](size_t n_variables)
+    {
+        while (results.values.size() < n_variables)
+        {
+            results.values.emplace_back(n_rows);
+            results.types.emplace_back(n_rows, SPARQL_UNBOUND);
+            results.datatypes.emplace_back(n_rows);
+            results.languages.emplace_back(n_rows);
+        }
+    };
+    SPARQLDecoder decoder([&](const vector<string>& variables, vector<SPARQLTerm>& row)
+    {
+        add_columns(variables.size());
+        for (size_t i_variable = 0; i_variable < row.size(); ++i_variable)
+        {
+            // The decoder clears the terms before the next solution, so their contents can be moved
+            SPARQLTerm& term = row[i_variable];
+            results.values[i_variable].push_back(std::move(term.value));
+            results.types[i_variable].push_back(term.type);
+            results.datatypes[i_variable].push_back(std::move(term.datatype));
+            results.languages[i_variable].push_back(std::move(term.language));
+        }
+        ++n_rows;
+    });
+    sparqlDecode(query, decoder);
+    add_columns(decoder.variables.size());
+    results.variables = decoder.variables;
+    results.boolean = decoder.boolean;
+};
+
 void sbol::PartShop::remove(string uri)
 {
     string query;
@@ -1234,7 +1867,7 @@ void sbol::PartShop::remove(string uri)
     headers["X-authorization"] = key;
     headers["Accept"] = "application/json";
     
-    http_get_request(endpoint, &headers);
+    http_get_request(*client, endpoint, &headers);
 };
 
 string PartShop::getUser()
@@ -1252,7 +1885,21 @@ string PartShop::getSpoofedURL()
     return spoofed_resource;
 }
 
-void PartShop::attachFile(std::string topleveluri, std::string filename)
+// Reports the progress of an upload to a callback given by the user
+struct UploadProgress
+{
+    void (*progress_fn)(long long, long long, void*);
+    void* user_data;
+};
+
+int upload_progress(void* user_data, curl_off_t download_total, curl_off_t downloaded, curl_off_t upload_total, curl_off_t uploaded)
+{
+    UploadProgress* progress = (UploadProgress*)user_data;
+    progress->progress_fn((long long)uploaded, (long long)upload_total, progress->user_data);
+    return 0;
+};
+
+void PartShop::attachFile(std::string topleveluri, std::string filename, void (*progress_fn)(long long, long long, void*), void* user_data)
 {
     if (filename != "" && filename[0] == '~') {
         if (filename[1] != '/'){
@@ -1267,93 +1914,505 @@ void PartShop::attachFile(std::string topleveluri, std::string filename)
     if (!fh)
         throw SBOLError(SBOL_ERROR_FILE_NOT_FOUND, "File " + filename + " not found");
     
+    fclose(fh);
+
+    unordered_map<string, string> headers;
+    headers["Accept"] = "text/plain";
+    headers["X-authorization"] = key;
+
+    /* Now specify the POST data. The file is read in chunks as it is sent, rather than loaded into memory */
+    struct curl_httppost* post = NULL;
+    struct curl_httppost* last = NULL;
+    curl_formadd(&post, &last, CURLFORM_COPYNAME, "file", CURLFORM_FILE, filename.c_str(), CURLFORM_END);
+
     /* Perform HTTP request */
-    string response;
-    long http_response_code = 0;
-    CURL *curl;
-    CURLcode res;
-    
-    /* In windows, this will init the winsock stuff */
-    curl_global_init(CURL_GLOBAL_ALL);
-    
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(headers, "Accept: text/plain");
-    headers = curl_slist_append(headers, string("X-authorization: " + key).c_str());
+    HTTPResponse http_response;
+    UploadProgress progress = { progress_fn, user_data };
+    try
+    {
+        http_response = client->request(topleveluri + "/attach", headers, [&](CURL* curl)
+        {
+            curl_easy_setopt(curl, CURLOPT_HTTPPOST, post);
+            if (progress_fn)
+            {
+                curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, upload_progress);
+                curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &progress);
+                curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+            }
+        });
+    }
+    catch (SBOLError& e)
+    {
+        curl_formfree(post);
+        throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to upload attachment failed with " + e.error_message());
+    }
+    curl_formfree(post);
+    string response = http_response.body;
+    long http_response_code = http_response.status;
     
-    /* get a curl handle */
-    curl = curl_easy_init();
-    if(curl) {
-        /* First set the URL that is about to receive our POST. This URL can
-         just as well be a https:// URL if that is what should receive the
-         data. */
-        
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-        curl_easy_setopt(curl, CURLOPT_URL, string(topleveluri + "/attach").c_str());
-        if (Config::getOption("ca-path") != "")
-            curl_easy_setopt(curl , CURLOPT_CAINFO, Config::getOption("ca-path").c_str());
+    if (Config::getOption("verbose") == "True")
+        std::cout << response << std::endl;
+
+    if (http_response_code == 401)
+        throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "You must login with valid credentials before submitting");
+    if (http_response_code != 200)
+        throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to attach file failed with HTTP " + to_string(http_response_code));
+};
+
+// SHA-1, computed incrementally so that a file is checksummed as it is transferred. SynBioHub records the SHA-1 of each
+// attached file in the hash property of its Attachment
+struct SHA1Digest
+{
+    uint32_t state[5];
+    unsigned char block[64];
+    size_t n_block;
+    unsigned long long length;
+
+    SHA1Digest()
+    {
+        reset();
+    };
+
+    void reset()
+    {
+        state[0] = 0x67452301;
+        state[1] = 0xEFCDAB89;
+        state[2] = 0x98BADCFE;
+        state[3] = 0x10325476;
+        state[4] = 0xC3D2E1F0;
+        n_block = 0;
+        length = 0;
+    };
+
+    static uint32_t rotate(uint32_t x, int n)
+    {
+        return (x << n) | (x >> (32 - n));
+    };
+
+    void transform(const unsigned char* data)
+    {
+        uint32_t w[80];
+        for (int i = 0; i < 16; ++i)
+            w[i] = (uint32_t)data[4 * i] << 24 | (uint32_t)data[4 * i + 1] << 16 | (uint32_t)data[4 * i + 2] << 8 | data[4 * i + 3];
+        for (int i = 16; i < 80; ++i)
+            w[i] = rotate(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+        for (int i = 0; i < 80; ++i)
+        {
+            uint32_t f, k;
+            if (i < 20)
+            {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            }
+            else if (i < 40)
+            {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            }
+            else if (i < 60)
+            {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            }
+            else
+            {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            uint32_t t = rotate(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rotate(b, 30);
+            b = a;
+            a = t;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+    };
+
+    void update(const char* data, size_t size)
+    {
+        length += size;
+        while (size)
+        {
+            size_t n_copy = std::min(size, sizeof(block) - n_block);
+            memcpy(block + n_block, data, n_copy);
+            n_block += n_copy;
+            data += n_copy;
+            size -= n_copy;
+            if (n_block == sizeof(block))
+            {
+                transform(block);
+                n_block = 0;
+            }
+        }
+    };
+
+    // Pads a copy of the state, so more data may still be added
+    std::string hex()
+    {
+        SHA1Digest final_digest = *this;
+        unsigned long long n_bits = length * 8;
+        char padding = (char)0x80;
+        final_digest.update(&padding, 1);
+        padding = 0;
+        while (final_digest.n_block != 56)
+            final_digest.update(&padding, 1);
+        for (int i = 7; i >= 0; --i)
+        {
+            char byte = (char)(n_bits >> (8 * i));
+            final_digest.update(&byte, 1);
+        }
+        char hex_digest[41];
+        for (int i = 0; i < 5; ++i)
+            snprintf(hex_digest + 8 * i, 9, "%08x", final_digest.state[i]);
+        return string(hex_digest);
+    };
+};
+
+// Reads a file in chunks, passing each to a function. Returns false if the file cannot be read
+bool read_file_chunks(const string& path, std::function<bool(const char*, size_t)> consume)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+    vector<char> buffer(65536);
+    size_t n_read;
+    bool consumed = true;
+    while (consumed && (n_read = fread(buffer.data(), 1, buffer.size(), file)) > 0)
+        consumed = consume(buffer.data(), n_read);
+    bool read = consumed && !ferror(file);
+    fclose(file);
+    return read;
+};
+
+// The state of a download which is written to disk as it arrives
+struct DownloadStream
+{
+    CURL* curl = NULL;
+    FILE* file = NULL;
+    string partial_file;  // The file being downloaded to
+    string validator_file;  // Records the ETag or Last-Modified date of a partial download, so it may be resumed
+    unsigned long long offset = 0;  // The number of bytes already downloaded when the request was issued
+    long status = 0;
+    bool started = false;
+    bool is_html = false;
+    string body;  // The body of a response which is not the file, such as an error page
+    unordered_map<string, string> headers;
+    SHA1Digest digest;
+};
+
+size_t write_download(void* contents, size_t size, size_t nmemb, DownloadStream* stream)
+{
+    size_t n_bytes = size * nmemb;
+    if (!stream->started)
+    {
+        stream->started = true;
+        curl_easy_getinfo(stream->curl, CURLINFO_RESPONSE_CODE, &stream->status);
+
+        // SynBioHub answers a request for a missing attachment with a web page
+        string head((char*)contents, std::min(n_bytes, (size_t)64));
+        size_t i_head = head.find_first_not_of(" \t\r\n");
+        stream->is_html = i_head != string::npos && head.compare(i_head, 15, "<!DOCTYPE html>") == 0;
+
+        if (stream->status == 200 && !stream->is_html)
+        {
+            // The server sent the whole file, because this is a new download, or because the file has changed or the server
+            // does not support ranges
+            if (stream->offset)
+            {
+                fclose(stream->file);
+                stream->file = fopen(stream->partial_file.c_str(), "wb");
+                stream->offset = 0;
+                stream->digest.reset();
+            }
+            string validator = find_header(stream->headers, "ETag");
+            if (validator == "" || validator.compare(0, 2, "W/") == 0)
+                validator = find_header(stream->headers, "Last-Modified");
+            if (validator != "")
+            {
+                ofstream validator_file(stream->validator_file);
+                validator_file << validator;
+            }
+            else
+                remove(stream->validator_file.c_str());
+        }
+    }
+    if ((stream->status != 200 && stream->status != 206) || stream->is_html)
+    {
+        stream->body.append((char*)contents, n_bytes);
+        return n_bytes;
+    }
+    if (!stream->file || fwrite(contents, 1, n_bytes, stream->file) != n_bytes)
+        return 0;  // Abort the transfer, eg, if the disk is full
+    stream->digest.update((char*)contents, n_bytes);
+    return n_bytes;
+};
+
+// Copies a file in chunks, computing its checksum
+bool copy_download(const string& source, const string& target, string& checksum)
+{
+    FILE* target_file = fopen(target.c_str(), "wb");
+    if (!target_file)
+        return false;
+    SHA1Digest digest;
+    bool copied = read_file_chunks(source, [&](const char* data, size_t size)
+    {
+        digest.update(data, size);
+        return fwrite(data, 1, size, target_file) == size;
+    });
+    copied = (fclose(target_file) == 0) && copied;
+    checksum = digest.hex();
+    return copied;
+};
+
+// Reduces a file name to its last path segment, so it cannot name a file outside the target directory
+// @return The name, or an empty string if it names no file
+string attachment_basename(string name)
+{
+    while (name != "" && (name.back() == '/' || name.back() == '\\'))
+        name.pop_back();
+    size_t i_slash = name.find_last_of("/\\");
+    if (i_slash != string::npos)
+        name = name.substr(i_slash + 1);
+    if (name == "." || name == ".." || name.find('\0') != string::npos)
+        return "";
+    return name;
+};
+
+// Extracts the file name from a Content-Disposition header, eg, attachment; filename="data.csv". The name is chosen by
+// the server, so only its last path segment is used. If that is empty, the name is taken from the attachment URI
+string parse_attachment_filename(const string& content_disposition, const string& attachment_uri)
+{
+    string filename;
+    size_t i_name = content_disposition.find("filename=");
+    if (i_name != string::npos)
+    {
+        i_name += 9;
+        if (i_name < content_disposition.size() && content_disposition[i_name] == '"')
+            filename = content_disposition.substr(i_name + 1, content_disposition.find('"', i_name + 1) - i_name - 1);
+        else
+            filename = content_disposition.substr(i_name, content_disposition.find_first_of("; \r\n", i_name) - i_name);
+    }
+    filename = attachment_basename(filename);
+    if (filename == "")
+        filename = attachment_basename(attachment_uri.substr(0, attachment_uri.find_first_of("?#")));
+    if (filename == "")
+        filename = "attachment";
+    return filename;
+};
+
+// The state of an attachment download. A download which cannot be resumed is begun again, so it may take more than one request
+struct sbol::AttachmentDownload
+{
+    string attachment_uri;
+    string path;
+    string hash;
+    string url;
+    string key;  // The key of the response in the cache
+    unordered_map<string, string> base_headers;
+    unordered_map<string, string> headers;  // The headers of the next request
+    std::shared_ptr<PartCache> part_cache;
+    DownloadStream stream;
+    string filename;
+    string checksum;
+
+    // Copies a cached response to the target path
+    bool useCached()
+    {
+        string cached_file;
+        unordered_map<string, string> cached_headers;
+        if (!part_cache || !part_cache->locate(key, cached_file, cached_headers))
+            return false;
+        filename = parse_attachment_filename(find_header(cached_headers, "Content-Disposition"), attachment_uri);
+        if (!copy_download(cached_file, path + "/" + filename, checksum))
+            throw SBOLError(SBOL_ERROR_FILE_NOT_FOUND, "Cannot download attachment. The target path " + path + "/" + filename + " is invalid.");
+        return true;
+    };
 
-        /* Now specify the POST data */
-        struct curl_httppost* post = NULL;
-        struct curl_httppost* last = NULL;
+    // Prepares the next request
+    // @return False if no request is needed, because the attachment was read from the cache
+    bool begin()
+    {
+        if (part_cache && Config::getOption("offline") == "True")
+        {
+            if (!useCached())
+                throw SBOLError(SBOL_ERROR_NOT_FOUND, "Unable to download. Attachment " + attachment_uri + " is not in the cache, and cannot be retrieved while offline.");
+            return false;
+        }
 
-        curl_formadd(&post, &last, CURLFORM_COPYNAME, "file", CURLFORM_FILE, filename.c_str(), CURLFORM_END);
-        
-        /* Set the form info */
-        curl_easy_setopt(curl, CURLOPT_HTTPPOST, post);
-        
-        /* Now specify the callback to read the response into string */
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlWrite_CallbackFunc_StdString);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-        
-        /* Perform the request, res will get the return code */
-        res = curl_easy_perform(curl);
-        /* Check for errors */
-        if(res != CURLE_OK)
-        throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to upload attachment failed with " + string(curl_easy_strerror(res)));
-        
-        curl_easy_getinfo (curl, CURLINFO_RESPONSE_CODE, &http_response_code);
+        // A partial download is named after the URL it comes from, so an interrupted download can be found and resumed
+        SHA1Digest url_digest;
+        url_digest.update(url.c_str(), url.size());
+        stream = DownloadStream();
+        stream.partial_file = path + "/.sbol-download-" + url_digest.hex();
+        stream.validator_file = stream.partial_file + ".validator";
+        headers = base_headers;
+
+        // Resume a partial download, provided it can be checked that the file has not changed since
+        string validator;
+        ifstream validator_file(stream.validator_file);
+        getline(validator_file, validator);
+        validator_file.close();
+        if (validator != "" && read_file_chunks(stream.partial_file, [&](const char* data, size_t size)
+            {
+                stream.digest.update(data, size);
+                return true;
+            }))
+        {
+            stream.offset = stream.digest.length;
+            stream.file = fopen(stream.partial_file.c_str(), "ab");
+        }
+        else
+        {
+            stream.digest.reset();
+            stream.file = fopen(stream.partial_file.c_str(), "wb");
+        }
+        if (!stream.file)
+            throw SBOLError(SBOL_ERROR_FILE_NOT_FOUND, "Cannot download attachment. The target path " + path + " is invalid.");
+        if (stream.offset)
+        {
+            headers["Range"] = "bytes=" + to_string(stream.offset) + "-";
+            headers["If-Range"] = validator;
+        }
+        else if (part_cache)
+            part_cache->addValidators(key, headers);
+        if (Config::getOption("verbose") == "True")
+            std::cout << "Issuing get request: " << url << (stream.offset ? " from byte " + to_string(stream.offset) : "") << std::endl;
+        return true;
+    };
 
-        /* always cleanup */
-        curl_easy_cleanup(curl);
-    }
-    curl_slist_free_all(headers);
-    curl_global_cleanup();
-    
-    if (Config::getOption("verbose") == "True")
-        std::cout << response << std::endl;
+    // Sets the options of the request on its handle
+    void configure(CURL* curl)
+    {
+        stream.curl = curl;
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_download);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &stream);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &stream.headers);
+    };
 
-    if (http_response_code == 401)
-        throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "You must login with valid credentials before submitting");
-    if (http_response_code != 200)
-        throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to attach file failed with HTTP " + to_string(http_response_code));
+    // Completes a request
+    // @param status The status code of the response
+    // @param error A transport error, if the request did not complete
+    // @return True if the download must be begun again
+    bool finish(long status, string error)
+    {
+        if (!stream.started)
+            stream.status = status;  // The response had no body
+        if (stream.file)
+            fclose(stream.file);
+        stream.file = NULL;
+        if (Config::getOption("verbose") == "True")
+            std::cout << "HTTP request returned status code " << stream.status << std::endl;
+
+        if (error != "")
+        {
+            // The partial download is kept so it can be resumed, and a cached copy is used meanwhile if there is one
+            if (!useCached())
+                throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Download of attachment " + attachment_uri + " was interrupted. Download it again to resume. " + error);
+        }
+        else if (stream.status == 304)
+        {
+            std::remove(stream.partial_file.c_str());
+            if (!useCached())
+                throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Unable to download attachment " + attachment_uri + ". The server reported that the cached copy is current, but it is not in the cache.");
+        }
+        else if (stream.status == 416 && stream.offset)
+        {
+            // The partial download cannot be resumed, so start again
+            std::remove(stream.partial_file.c_str());
+            std::remove(stream.validator_file.c_str());
+            return true;
+        }
+        else
+        {
+            if ((stream.status != 200 && stream.status != 206) || stream.is_html)
+            {
+                std::remove(stream.partial_file.c_str());
+                std::remove(stream.validator_file.c_str());
+            }
+            if (stream.status == 404 || stream.is_html)
+                throw SBOLError(SBOL_ERROR_NOT_FOUND, "Unable to download. Attachment " + attachment_uri + " not found.");
+            if (stream.status == 401)
+                throw SBOLError(SBOL_ERROR_HTTP_UNAUTHORIZED, "Please login with valid credentials");
+            if (stream.status != 200 && stream.status != 206)
+                throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Unable to download attachment " + attachment_uri + ". HTTP " + to_string(stream.status) + " " + stream.body);
+            string content_disposition = find_header(stream.headers, "Content-Disposition");
+            if (content_disposition == "")
+            {
+                std::remove(stream.partial_file.c_str());
+                std::remove(stream.validator_file.c_str());
+                throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Unable to download attachment " + attachment_uri + ". The server response did not name the file.");
+            }
+            filename = parse_attachment_filename(content_disposition, attachment_uri);
+            string target = path + "/" + filename;
+            std::remove(target.c_str());
+            if (rename(stream.partial_file.c_str(), target.c_str()) != 0)
+                throw SBOLError(SBOL_ERROR_FILE_NOT_FOUND, "Cannot download attachment. The target path " + target + " is invalid.");
+            std::remove(stream.validator_file.c_str());
+            checksum = stream.digest.hex();
+            if (part_cache)
+                part_cache->storeFile(key, target, stream.headers);
+        }
+        return false;
+    };
+
+    // Checks the downloaded file against the expected checksum
+    // @return The checksum of the file
+    string verify()
+    {
+        if (hash != "" && hash != checksum)
+        {
+            std::remove((path + "/" + filename).c_str());
+            throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Download of attachment " + attachment_uri + " is corrupt. Its SHA-1 checksum is " + checksum + " but " + hash + " was expected.");
+        }
+        return checksum;
+    };
 };
 
-void PartShop::downloadAttachment(string attachment_uri, string path)
+std::shared_ptr<AttachmentDownload> PartShop::prepareDownload(string attachment_uri, string path, string hash)
 {
     if (parseURLDomain(attachment_uri) != resource)
         throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot download attachment. The URI does not match the domain for this PartShop.");
-    string url = attachment_uri + "/download";
-    unordered_map<string, string> headers;
-    unordered_map<string, string> header_response;
-
-    headers["X-authorization"] = key;
-    headers["Accept"] = "text/plain";
-    string response = http_get_request(url, &headers, &header_response);
-    if (response.find("<!DOCTYPE html>") != std::string::npos)
-        throw SBOLError(SBOL_ERROR_NOT_FOUND, "Unable to download. Attachment " + attachment_uri + " not found.");
-    if (header_response.find("Content-Disposition") == header_response.end())
-        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "You must login with valid credentials before submitting");
-
-    std::string filename = header_response["Content-Disposition"];
-    filename.erase(0, 23); // remove the substring: attachment; filename="
-    filename.erase(filename.end() - 2, filename.end()); // remove the terminating "
-
-    FILE* fh = fopen((path + "/" + filename).c_str(), "wb");
-    if (!fh)
-        throw SBOLError(SBOL_ERROR_FILE_NOT_FOUND, "Cannot download attachment. The target path " + path + filename + " is invalid.");
+    std::shared_ptr<AttachmentDownload> download = std::make_shared<AttachmentDownload>();
+    download->attachment_uri = attachment_uri;
+    download->path = path;
+    download->hash = hash;
+    download->url = attachment_uri + "/download";
+    download->base_headers["X-authorization"] = key;
+    download->base_headers["Accept"] = "text/plain";
+    download->key = cache_key(download->url, download->base_headers);
+    if (getCache())
+        download->part_cache = cache;
+    return download;
+};
 
-    fputs(response.c_str(), fh);
-    fclose(fh);
+string PartShop::downloadAttachment(string attachment_uri, string path, string hash)
+{
+    std::shared_ptr<AttachmentDownload> download = prepareDownload(attachment_uri, path, hash);
+    while (download->begin())
+    {
+        long status = 0;
+        string error;
+        try
+        {
+            status = client->request(download->url, download->headers, [&](CURL* curl)
+            {
+                download->configure(curl);
+            }).status;
+        }
+        catch (SBOLError& e)
+        {
+            error = e.error_message();
+        }
+        if (!download->finish(status, error))
+            break;
+    }
+    return download->verify();
 }
 
 void PartShop::addSynBioHubAnnotations(Document& doc)
@@ -1370,33 +2429,21 @@ void PartShop::addSynBioHubAnnotations(Document& doc)
     }
 }
 
-bool sbol::PartShop::exists(std::string uri)
+std::string sbol::PartShop::metadataURL(std::string uri)
 {
-    unordered_map<string, string> headers;
-    headers["X-authorization"] = key;
-    headers["Accept"] = "text/plain";
-
     string query;
-    string response;
-
     if (uri.find(resource) != std::string::npos)
         query = uri;  // User has specified full URI
     else if (uri.find(parseURLDomain(resource)) != std::string::npos)
         query = uri;  // User has specified full URI
     else if (spoofed_resource != "" && uri.find(spoofed_resource) != std::string::npos)
         query = uri.replace(uri.find(spoofed_resource), spoofed_resource.size(), resource);
-    try
-    {
-        string get_request = query + "/metadata";
-        if (Config::getOption("verbose") == "True")
-            std::cout << "Issuing get request:\n" << get_request << std::endl;
-        response = http_get_request(get_request, &headers);
-    }   
-    catch (SBOLError& e)
-    {
-        throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Search request failed with response: " + e.error_message());
-    }
+    return query + "/metadata";
+};
 
+// Interprets the metadata returned for an object, which is empty if the object does not exist
+bool parse_exists_response(const string& response)
+{
     Json::Value json_response;
     Json::Reader reader;
     bool parsed = reader.parse(response, json_response);
@@ -1408,8 +2455,250 @@ bool sbol::PartShop::exists(std::string uri)
         return true;
 };
 
+bool sbol::PartShop::exists(std::string uri)
+{
+    unordered_map<string, string> headers;
+    headers["X-authorization"] = key;
+    headers["Accept"] = "text/plain";
+
+    string response;
+    try
+    {
+        string get_request = metadataURL(uri);
+        if (Config::getOption("verbose") == "True")
+            std::cout << "Issuing get request:\n" << get_request << std::endl;
+        response = http_get_request(*client, get_request, &headers);
+    }   
+    catch (SBOLError& e)
+    {
+        throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Search request failed with response: " + e.error_message());
+    }
+    return parse_exists_response(response);
+};
+
+std::future<void> sbol::PartShop::pullAsync(std::string uri, Document& doc, bool recursive)
+{
+    auto promise = std::make_shared<std::promise<void>>();
+    try
+    {
+        unordered_map<string, string> headers;
+        headers["X-authorization"] = key;
+        headers["Accept"] = "text/plain";
+        string get_request = pullURL(uri, recursive);
+        string key = cache_key(get_request, headers);
+        string resource = this->resource;
+        std::shared_ptr<PartCache> part_cache;
+        if (getCache())
+            part_cache = cache;
+        bool offline = part_cache && Config::getOption("offline") == "True";
+        bool verbose = Config::getOption("verbose") == "True";
+        Document* target = &doc;
+
+        // Parses the response into the Document. The PartShop may be gone by then, so only copies of its members are used
+        auto complete = [promise, uri, get_request, key, resource, part_cache, offline, verbose, target](HTTPResponse& response)
+        {
+            try
+            {
+                if (part_cache && !offline)
+                    part_cache->resolve(key, response);
+                if (verbose)
+                    std::cout << "Request " << get_request << " returned status code " << response.status << std::endl;
+                if (response.error != "")
+                    throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Unable to pull " + uri + ". " + response.error);
+                if (response.status == 404)
+                    throw SBOLError(SBOL_ERROR_NOT_FOUND, "Part not found. Unable to pull " + uri);
+                check_http_response(response);
+                target->readString(response.body, "sbol");
+                target->resource_namespaces.insert(resource);
+                promise->set_value();
+            }
+            catch (...)
+            {
+                promise->set_exception(std::current_exception());
+            }
+        };
+        if (offline)
+        {
+            HTTPResponse response;
+            if (!part_cache->fetch(key, response))
+                throw SBOLError(SBOL_ERROR_NOT_FOUND, "Part not found. Unable to pull " + uri + ". Cannot retrieve " + get_request + " while offline, because it is not in the cache");
+            complete(response);
+        }
+        else
+        {
+            if (part_cache)
+                part_cache->addValidators(key, headers);
+            if (verbose)
+                std::cout << "Issuing get request:\n" << get_request << std::endl;
+            client->requestAsync(get_request, headers, nullptr, complete);
+        }
+    }
+    catch (...)
+    {
+        promise->set_exception(std::current_exception());
+    }
+    return promise->get_future();
+};
+
+std::future<SearchResponse&> sbol::PartShop::searchPageAsync(std::string url)
+{
+    auto promise = std::make_shared<std::promise<SearchResponse&>>();
+    client->requestAsync(url, search_headers(key), nullptr, [promise](HTTPResponse& response)
+    {
+        try
+        {
+            check_http_response(response);
+            promise->set_value(parse_search_response(response.body));
+        }
+        catch (...)
+        {
+            promise->set_exception(std::current_exception());
+        }
+    });
+    return promise->get_future();
+};
+
+std::future<SearchResponse&> sbol::PartShop::searchAsync(std::string search_text, rdf_type object_type, std::string property_uri, int offset, int limit)
+{
+    return searchPageAsync(searchURL(search_text, object_type, property_uri, offset, limit));
+};
+
+std::future<SearchResponse&> sbol::PartShop::searchAsync(std::string search_text, rdf_type object_type, int offset, int limit)
+{
+    return searchPageAsync(searchURL(search_text, object_type, offset, limit));
+};
+
+std::future<SearchResponse&> sbol::PartShop::searchAsync(SearchQuery& q)
+{
+    if (q["offset"].size() != 1)
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Invalid offset parameter specified");
+    if (q["limit"].size() != 1)
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Invalid limit parameter specified");
+    return searchPageAsync(searchURL(q, q.offset.get(), q.limit.get()));
+};
+
+std::future<std::string> sbol::PartShop::submitAsync(Document& doc, std::string collection, int overwrite)
+{
+    auto promise = std::make_shared<std::promise<std::string>>();
+    try
+    {
+        std::shared_ptr<Submission> submission = prepareSubmission(doc, collection, overwrite);
+        client->requestAsync(submission->url, submission->headers, [submission](CURL* curl)
+        {
+            submission->configure(curl);
+        },
+        [promise, submission](HTTPResponse& response)
+        {
+            try
+            {
+                promise->set_value(submission->complete(response));
+            }
+            catch (...)
+            {
+                promise->set_exception(std::current_exception());
+            }
+        });
+    }
+    catch (...)
+    {
+        promise->set_exception(std::current_exception());
+    }
+    return promise->get_future();
+};
+
+std::future<bool> sbol::PartShop::existsAsync(std::string uri)
+{
+    auto promise = std::make_shared<std::promise<bool>>();
+    unordered_map<string, string> headers;
+    headers["X-authorization"] = key;
+    headers["Accept"] = "text/plain";
+    string get_request = metadataURL(uri);
+    if (Config::getOption("verbose") == "True")
+        std::cout << "Issuing get request:\n" << get_request << std::endl;
+    client->requestAsync(get_request, headers, nullptr, [promise](HTTPResponse& response)
+    {
+        try
+        {
+            try
+            {
+                check_http_response(response);
+            }
+            catch (SBOLError& e)
+            {
+                throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Search request failed with response: " + e.error_message());
+            }
+            promise->set_value(parse_exists_response(response.body));
+        }
+        catch (...)
+        {
+            promise->set_exception(std::current_exception());
+        }
+    });
+    return promise->get_future();
+};
+
+// Issues the next request of an attachment download on the event loop, and begins it again from its completion if the
+// partial download cannot be resumed
+void download_async(HTTPClient* client, std::shared_ptr<AttachmentDownload> download, std::shared_ptr<std::promise<string>> promise)
+{
+    try
+    {
+        if (!download->begin())
+        {
+            promise->set_value(download->verify());
+            return;
+        }
+        client->requestAsync(download->url, download->headers, [download](CURL* curl)
+        {
+            download->configure(curl);
+        },
+        [client, download, promise](HTTPResponse& response)
+        {
+            try
+            {
+                if (download->finish(response.status, response.error))
+                    download_async(client, download, promise);
+                else
+                    promise->set_value(download->verify());
+            }
+            catch (...)
+            {
+                promise->set_exception(std::current_exception());
+            }
+        });
+    }
+    catch (...)
+    {
+        promise->set_exception(std::current_exception());
+    }
+};
+
+std::future<std::string> sbol::PartShop::downloadAttachmentAsync(std::string attachment_uri, std::string path, std::string hash)
+{
+    auto promise = std::make_shared<std::promise<std::string>>();
+    try
+    {
+        download_async(client.get(), prepareDownload(attachment_uri, path, hash), promise);
+    }
+    catch (...)
+    {
+        promise->set_exception(std::current_exception());
+    }
+    return promise->get_future();
+};
+
 std::string Document::convert(string language, string output_path)
 {
+    // FASTA and GenBank are written in-process, unless the online validator is preferred
+    string native_language = sequence_file_language(language != "" ? language : Config::getOption("language"));
+    if (Config::getOption("validator") == "local" && native_language != "")
+    {
+        if (output_path == "")
+            output_path = native_language == "FASTA" ? "output.fasta" : "output.gb";
+        exportToFormat(native_language, output_path);
+        return output_path;
+    }
+
     string original_language = Config::getOption("language");
     string original_return_file = Config::getOption("return_file");
     if (language != "")
@@ -1550,6 +2839,136 @@ string SearchResponse::__str__()
     return output;
 };
 
+SearchResults::SearchResults(PartShop& shop, SearchQuery& q, int prefetch) :
+    part_shop(shop),
+    offset(q.offset.get()),
+    page_size(q.limit.get()),
+    prefetch(prefetch)
+{
+    // Copy the search criteria, so the query is not needed once the results have been constructed
+    shared_ptr<SearchQuery> query = make_shared<SearchQuery>();
+    query->properties = q.properties;
+    PartShop* shop_ptr = &part_shop;
+    page_url = [shop_ptr, query](int page_offset)
+    {
+        return shop_ptr->searchURL(*query, page_offset, query->limit.get());
+    };
+    start();
+};
+
+SearchResults::SearchResults(PartShop& shop, std::string search_text, rdf_type object_type, std::string property_uri, int offset, int page_size, int prefetch) :
+    part_shop(shop),
+    offset(offset),
+    page_size(page_size),
+    prefetch(prefetch)
+{
+    PartShop* shop_ptr = &part_shop;
+    page_url = [shop_ptr, search_text, object_type, property_uri, page_size](int page_offset)
+    {
+        return shop_ptr->searchURL(search_text, object_type, property_uri, page_offset, page_size);
+    };
+    start();
+};
+
+SearchResults::SearchResults(PartShop& shop, std::string search_text, rdf_type object_type, int offset, int page_size, int prefetch) :
+    part_shop(shop),
+    offset(offset),
+    page_size(page_size),
+    prefetch(prefetch)
+{
+    PartShop* shop_ptr = &part_shop;
+    page_url = [shop_ptr, search_text, object_type, page_size](int page_offset)
+    {
+        return shop_ptr->searchURL(search_text, object_type, page_offset, page_size);
+    };
+    start();
+};
+
+void SearchResults::start()
+{
+    if (page_size < 1)
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Invalid limit parameter specified");
+    if (prefetch < 1)
+        prefetch = 1;
+    i_record = 0;
+    done = false;
+    stopping = false;
+    worker = std::thread(&SearchResults::fetchPages, this);
+};
+
+SearchResults::~SearchResults()
+{
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    changed.notify_all();
+    // A request which is already under way is allowed to finish
+    worker.join();
+    for (auto& fetched : pages)
+        delete fetched;
+};
+
+// Runs on the worker thread. Requests pages in order, staying at most prefetch pages ahead of the reader
+void SearchResults::fetchPages()
+{
+    int page_offset = offset;
+    while (true)
+    {
+        {
+            unique_lock<mutex> guard(lock);
+            changed.wait(guard, [this]() { return stopping || (int)pages.size() < prefetch; });
+            if (stopping)
+                return;
+        }
+        SearchResponse* fetched = NULL;
+        try
+        {
+            fetched = &part_shop.searchPage(page_url(page_offset));
+        }
+        catch (...)
+        {
+            lock_guard<mutex> guard(lock);
+            error = current_exception();
+            done = true;
+            changed.notify_all();
+            return;
+        }
+        page_offset += page_size;
+
+        lock_guard<mutex> guard(lock);
+        pages.push_back(fetched);
+        // A short page is the last one
+        if (fetched->size() < page_size)
+            done = true;
+        changed.notify_all();
+        if (done)
+            return;
+    }
+};
+
+Identified* SearchResults::next()
+{
+    while (!page || i_record >= page->size())
+    {
+        unique_lock<mutex> guard(lock);
+        // Release the page that has been read before waiting for the next one
+        page.reset();
+        changed.wait(guard, [this]() { return !pages.empty() || done; });
+        if (pages.empty())
+        {
+            if (error)
+                rethrow_exception(error);
+            return NULL;
+        }
+        page.reset(pages.front());
+        pages.pop_front();
+        i_record = 0;
+        changed.notify_all();
+    }
+    return page->records[i_record++];
+};
+
 string SearchQuery::__str__()
 {
     Json::Value json;
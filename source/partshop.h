@@ -35,6 +35,16 @@
 #include <iostream>
 #include <algorithm>
 #include <json/json.h>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <future>
+#include <atomic>
+#include <functional>
+#include <unordered_map>
 
 namespace sbol
 {
@@ -154,6 +164,265 @@ namespace sbol
     };
     
     
+    /// @cond
+    /// The status, body and headers returned by an HTTP request
+    struct HTTPResponse
+    {
+        long status = 0;
+        std::string body;
+        std::unordered_map<std::string, std::string> headers;
+        std::string error;  // Describes a transport error, if the request did not complete
+    };
+
+    /// A pool of reusable curl handles. Handles share a connection cache, DNS cache and TLS session cache, so
+    /// consecutive requests to the same host reuse one keep-alive connection instead of repeating the TCP and
+    /// TLS handshakes
+    class SBOL_DECLSPEC HTTPClient
+    {
+    private:
+        CURLSH* share;
+        std::mutex share_locks[CURL_LOCK_DATA_LAST];
+        std::mutex pool_lock;
+        std::vector<CURL*> idle_handles;
+        std::atomic<long> connection_count;
+
+        // Asynchronous requests are driven by a single event loop thread, which is started by the first of them
+        struct AsyncTransfer;
+        CURLM* multi;
+        std::thread loop_thread;
+        std::mutex loop_lock;
+        std::condition_variable loop_wakeup;
+        std::vector<AsyncTransfer*> queued;  // Requests waiting to be added to the multi handle by the event loop
+        bool stopping;
+
+        void runLoop();
+        void wakeLoop();
+
+        static void lockShare(CURL* handle, curl_lock_data data, curl_lock_access access, void* client);
+        static void unlockShare(CURL* handle, curl_lock_data data, void* client);
+
+    public:
+        HTTPClient();
+        ~HTTPClient();
+        HTTPClient(const HTTPClient&) = delete;
+        HTTPClient& operator=(const HTTPClient&) = delete;
+
+        /// Take a handle from the pool, or create one if all are busy. The handle is attached to the shared caches
+        CURL* acquire();
+
+        /// Reset a handle's options and return it to the pool. Its connection stays open in the shared cache
+        void release(CURL* curl);
+
+        /// Perform a request on a pooled handle
+        /// @param url The request URL
+        /// @param headers Request headers
+        /// @param configure An optional callback which sets further options on the handle, eg, POST data
+        /// @return The response. HTTP error codes are returned, not thrown; transport errors throw SBOLError
+        HTTPResponse request(std::string url, const std::unordered_map<std::string, std::string>& headers, std::function<void(CURL*)> configure = nullptr);
+
+        HTTPResponse get(std::string url, const std::unordered_map<std::string, std::string>& headers = {});
+
+        /// Perform GET requests concurrently on pooled handles, driven by a curl multi handle on the calling thread
+        /// @param urls The request URLs
+        /// @param headers The headers for each request
+        /// @param max_parallel The maximum number of requests in flight at once
+        /// @param on_response Called on the calling thread with the index of each URL and its response, in order of completion.
+        /// Transport errors are reported in the response rather than thrown
+        void requestAll(const std::vector<std::string>& urls, const std::vector<std::unordered_map<std::string, std::string>>& headers, int max_parallel, std::function<void(size_t, HTTPResponse&)> on_response);
+
+        /// Queue a request for the event loop thread, which drives every asynchronous request of this client through one curl
+        /// multi handle, so that any number of them may be in flight at once
+        /// @param configure An optional callback which sets further options on the handle. It is called on the event loop thread
+        /// @param on_done Called on the event loop thread with the response. Transport errors are reported in the response rather
+        /// than thrown. It should return promptly, since other transfers wait for it. If the client is destroyed first, the request
+        /// is abandoned and on_done reports an error.
+        void requestAsync(std::string url, const std::unordered_map<std::string, std::string>& headers, std::function<void(CURL*)> configure, std::function<void(HTTPResponse&)> on_done);
+
+        /// The number of new connections opened by this client, for diagnosing connection reuse
+        long getConnectionCount();
+    };
+    /// A response stored in a PartCache
+    struct CacheEntry
+    {
+        std::string file;  // The file holding the response body, relative to the cache directory
+        unsigned long long size = 0;
+        unsigned long long last_access = 0;
+        std::string etag;
+        std::string last_modified;
+        std::string content_disposition;
+    };
+
+    /// A size-bounded cache of raw HTTP responses in a directory on disk, keyed by request URL and login. Each body is kept in its own
+    /// file, and an append-only journal records stores, accesses and evictions, so the cache can be shared by successive
+    /// processes, eg, CI builds. When the cache grows past its size limit, the least recently used responses are evicted
+    class SBOL_DECLSPEC PartCache
+    {
+    private:
+        std::string directory;
+        unsigned long long max_size;
+        unsigned long long total_size;
+        unsigned long long clock;
+        unsigned long long n_journal_records;
+        unsigned long long journal_size;  // The size of the journal as this process last read or wrote it
+        std::unordered_map<std::string, CacheEntry> entries;
+        std::mutex lock;
+
+        void load();
+        void compact();
+        void journal(std::string record);
+        void erase(const std::string& key);
+        void evict();
+        bool read(const std::string& key, HTTPResponse& response);
+        bool store(const std::string& key, const std::unordered_map<std::string, std::string>& headers, unsigned long long size, std::function<bool(FILE*)> write);
+
+    public:
+        PartCache(std::string directory, unsigned long long max_size);
+        ~PartCache();
+
+        /// Get the cache for a directory, which is shared by every PartShop using that directory
+        /// @param directory The cache directory, which is created if it does not exist
+        /// @param max_size The maximum total size of cached responses, in bytes
+        static std::shared_ptr<PartCache> open(std::string directory, unsigned long long max_size);
+
+        std::string getDirectory();
+
+        /// Add conditional request headers, so the server may answer that a cached response is still current
+        void addValidators(const std::string& key, std::unordered_map<std::string, std::string>& headers);
+
+        /// Reconcile a response with the cache. A successful response is stored. If the server reports that the cached
+        /// response is current, or cannot be reached, the cached response is substituted
+        /// @return True if the response was stored or substituted
+        bool resolve(const std::string& key, HTTPResponse& response);
+
+        /// Read a cached response without contacting the server
+        /// @return False if the response is not cached
+        bool fetch(const std::string& key, HTTPResponse& response);
+
+        /// Store a downloaded file as the response to a request, without reading it into memory
+        /// @return True if the file was stored
+        bool storeFile(const std::string& key, const std::string& file, const std::unordered_map<std::string, std::string>& headers);
+
+        /// Find the file which holds a cached response, so it can be copied without reading it into memory
+        /// @param file Set to the path of the cached response
+        /// @param headers Set to the response headers which were stored with it
+        /// @return False if the response is not cached
+        bool locate(const std::string& key, std::string& file, std::unordered_map<std::string, std::string>& headers);
+    };
+
+    /// Look up a response header by name, ignoring case
+    /// @param trim Whether to remove the whitespace surrounding the value
+    std::string find_header(const std::unordered_map<std::string, std::string>& headers, std::string name, bool trim = true);
+
+    /// The key under which the response to a request is cached. Responses to requests made with a login are kept apart
+    /// from anonymous responses and from those of other logins. Only a hash of the login key is written to the cache
+    std::string cache_key(const std::string& url, const std::unordered_map<std::string, std::string>& headers);
+    /// @endcond
+
+    /// The kinds of RDF term which may be bound to a variable in the results of a SPARQL query
+    enum SPARQLTermType
+    {
+        SPARQL_UNBOUND,  ///< The variable has no value in this solution
+        SPARQL_URI,
+        SPARQL_LITERAL,
+        SPARQL_BNODE
+    };
+
+    /// A value bound to a variable in one solution of a SPARQL query
+    struct SPARQLTerm
+    {
+        SPARQLTermType type = SPARQL_UNBOUND;
+        std::string value;
+        std::string datatype;  ///< The datatype URI of a typed literal
+        std::string language;  ///< The language tag of a literal
+    };
+
+    /// The solutions of a SPARQL query, stored by column. Each variable has one column, and each solution is one row.
+    class SBOL_DECLSPEC SPARQLResults
+    {
+    public:
+        /// The variables of the query, in the order given in the results
+        std::vector<std::string> variables;
+
+        /// values[i_variable][i_row] is the value bound to a variable in a solution, or an empty string where it is unbound
+        std::vector< std::vector<std::string> > values;
+
+        /// The kind of term bound in each cell, arranged like values
+        std::vector< std::vector<SPARQLTermType> > types;
+
+        /// The datatype URI of each typed literal, arranged like values
+        std::vector< std::vector<std::string> > datatypes;
+
+        /// The language tag of each literal, arranged like values
+        std::vector< std::vector<std::string> > languages;
+
+        /// The answer to an ASK query
+        bool boolean = false;
+
+        /// @return The number of solutions
+        int size();
+
+        /// @return The index of a variable's column
+        int column(std::string variable);
+
+        /// @return The value bound to a variable in one solution
+        std::string get(std::string variable, int i_row);
+    };
+
+    /// @cond
+    /// Decodes SPARQL query results in the JSON format incrementally, so that each solution is handed over as soon as its bytes
+    /// have arrived and the response is never held in memory whole
+    class SBOL_DECLSPEC SPARQLDecoder
+    {
+    public:
+        /// @param on_row Called with the variables and the terms bound to them in each solution. The terms are reused for the next solution.
+        SPARQLDecoder(std::function<void(const std::vector<std::string>&, std::vector<SPARQLTerm>&)> on_row);
+
+        /// Decode the next part of a response. Throws SBOLError if the response is not well-formed JSON
+        void decode(const char* data, size_t size);
+
+        /// Check that the whole response has been decoded
+        void finish();
+
+        std::vector<std::string> variables;
+        bool boolean;
+
+    private:
+        enum LexState { VALUE, KEY, COLON, AFTER_VALUE, STRING, ESCAPE, UNICODE, LITERAL };
+        enum Role { ROOT, HEAD, VARS, RESULTS, BINDINGS, BINDING, TERM, OTHER };
+
+        struct Frame
+        {
+            Role role;
+            bool is_object;
+            std::string key;  // The key of the member being decoded, in an object
+        };
+
+        std::function<void(const std::vector<std::string>&, std::vector<SPARQLTerm>&)> on_row;
+        std::vector<Frame> frames;
+        std::vector<SPARQLTerm> row;
+        int i_term;  // The column of the term being decoded
+        LexState state;
+        bool string_is_key;
+        bool started;
+        std::string token;
+        unsigned int code_unit;
+        unsigned int high_surrogate;
+        int n_hex_digits;
+
+        void openContainer(bool is_object);
+        void closeContainer(char bracket);
+        void endString();
+        void endLiteral();
+        void endValue();
+        int variableIndex(const std::string& variable);
+    };
+    /// @endcond
+
+    /// @cond
+    struct Submission;
+    struct AttachmentDownload;
+    /// @endcond
+
     /// A class which provides an API front-end for online bioparts repositories
     class SBOL_DECLSPEC PartShop
     {
@@ -162,6 +431,51 @@ namespace sbol
         std::string spoofed_resource;
         std::string key;
         std::string user;
+        std::shared_ptr<HTTPClient> client;  // Connection pool, shared by copies of this PartShop
+        std::shared_ptr<PartCache> cache;
+
+        /// @return The response cache configured by the "cache_dir" option, or NULL if caching is disabled
+        PartCache* getCache();
+
+        /// Retrieves objects concurrently and adds them to a Document once every request has succeeded
+        /// @param missing If given, URIs which are not found are added to it instead of raising an error
+        /// @param added If given, the TopLevels added to the Document are appended to it
+        void pullAll(std::vector<std::string> uris, Document& doc, bool recursive, std::vector<std::string>* missing = NULL, std::vector<SBOLObject*>* added = NULL);
+
+        /// Retrieves objects with their dependencies by following references from the non-recursive form of each object, so
+        /// that only the objects which the Document does not already contain are downloaded and parsed
+        void pullIncremental(std::vector<std::string> uris, Document& doc);
+
+        /// Forms the request URL for retrieving an object, which may be given by its full URI or by its displayId
+        std::string pullURL(std::string uri, bool recursive);
+
+        /// Forms the request URL for the metadata of an object
+        std::string metadataURL(std::string uri);
+
+        /// Validates a Document for submission, and prepares the form data which is uploaded
+        std::shared_ptr<Submission> prepareSubmission(Document& doc, std::string collection, int overwrite);
+
+        /// Validates the arguments of an attachment download, and prepares its state
+        std::shared_ptr<AttachmentDownload> prepareDownload(std::string attachment_uri, std::string path, std::string hash);
+
+        /// Requests one page of search results on the event loop
+        std::future<SearchResponse&> searchPageAsync(std::string url);
+
+        /// Forms the request URL for one page of an ADVANCED, EXACT or GENERAL search
+        std::string searchURL(SearchQuery& q, int offset, int limit);
+        std::string searchURL(std::string search_text, rdf_type object_type, std::string property_uri, int offset, int limit);
+        std::string searchURL(std::string search_text, rdf_type object_type, int offset, int limit);
+
+        /// Forms the request URL for a SPARQL query, restricted to the user's graph
+        std::string sparqlURL(std::string query);
+
+        /// Issues a SPARQL query and feeds the response to a decoder as it arrives
+        void sparqlDecode(std::string query, SPARQLDecoder& decoder);
+
+        /// Requests one page of search results and decodes its records
+        SearchResponse& searchPage(std::string url);
+
+        friend class SearchResults;
 
     public:
         /// Construct an interface to an instance of SynBioHub or other parts repository
@@ -169,7 +483,8 @@ namespace sbol
         PartShop(std::string url, std::string spoofed_url = "") :
             resource(url),
             key(""),
-            spoofed_resource(spoofed_url)
+            spoofed_resource(spoofed_url),
+            client(std::make_shared<HTTPClient>())
             {
                 if (url.size() && url.back() == '/')
                     throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "PartShop initialization failed. The resource URL should not contain a terminal backslash");
@@ -184,17 +499,40 @@ namespace sbol
         /// Issue a SPARQL query
         std::string sparqlQuery(std::string query);
 
+        /// Issue a SPARQL query, and decode its results while they are downloaded. Each solution is handed to a callback as soon
+        /// as it arrives, so queries with very many solutions can be processed without holding the response in memory.
+        /// @param row_fn Called with the query variables and the terms bound to them in each solution. The terms are in the same
+        /// order as the variables, and are overwritten by the next solution, so copy any which are needed later.
+        /// @param user_data Arbitrary data passed to the callback
+        /// @return The variables of the query, or for an ASK query, an empty list (see the boolean member of SPARQLResults)
+        std::vector<std::string> sparqlQuery(std::string query, void (*row_fn)(const std::vector<std::string>& variables, std::vector<SPARQLTerm>& row, void* user_data), void* user_data = NULL);
+
+        /// Issue a SPARQL query, and decode its results into a table while they are downloaded
+        /// @param results The table to fill. Its columns are replaced.
+        void sparqlQuery(std::string query, SPARQLResults& results);
+
         /// Specify the URL of a resource that is simulated or spoofed by this PartShop
         void spoof(std::string spoofed_url);
 
         void remove(std::string uri);
         
-        /// Retrieve an object from an online resource
+        /// Retrieve an object from an online resource. If the "cache_dir" option is set, responses are cached on disk and
+        /// revalidated with the server on later pulls. A cached response is used if the server cannot be reached, and if the
+        /// "offline" option is set, the server is not contacted at all. The "cache_max_size" option limits the size of the
+        /// cache in megabytes.
+        ///
+        /// If the "incremental_pull" option is set, a recursive pull retrieves the object without its dependencies, then
+        /// retrieves only those referenced objects which the Document does not already contain, level by level. Each level
+        /// is retrieved concurrently. References to objects which the repository does not hold are skipped.
         /// @param uri The identity of the SBOL object you want to retrieve
         /// @param doc A document to add the data to
         void pull(std::string uri, Document& doc, bool recursive = true);
 
-        /// Retrieve an object from an online resource
+        /// Retrieve objects from an online resource. Requests are issued concurrently, up to the limit set by the
+        /// "max_parallel_requests" option, and responses are parsed on worker threads as they arrive. The objects are added to the
+        /// Document together once every request has succeeded, so a failed request leaves the Document unchanged. Objects which the
+        /// Document already contains are not replaced. Responses are cached, and dependencies may be retrieved incrementally, in
+        /// the same way as for a single pull.
         /// @param uris A vector of URIs for multiple SBOL objects you want to retrieve
         /// @param doc A document to add the data to
         void pull(std::vector<std::string> uris, Document& doc, bool recursive = true );
@@ -245,7 +583,9 @@ namespace sbol
         /// @return An integer count.
         int searchCount(SearchQuery& q);
         
-        /// Submit an SBOL Document to SynBioHub
+        /// Submit an SBOL Document to SynBioHub. The Document is serialized a batch of objects at a time while it is uploaded,
+        /// so large Documents are never held in memory as a single string. Set the "compress_submissions" option to "True"
+        /// to gzip the upload (requires libSBOL built with zlib).
         /// @param doc The Document to submit
         /// @param collection The URI of an SBOL Collection to which the Document contents will be uploaded
         /// @param overwrite An integer code: 0(default) - do not overwrite, 1 - overwrite, 2 - merge
@@ -272,24 +612,175 @@ namespace sbol
 
         std::string getSpoofedURL();        
 
-        /// Upload and attach a file to a TopLevel object in a PartShop.
+        /// Upload and attach a file to a TopLevel object in a PartShop. The file is read from disk as it is sent.
         /// @param top_level_uri The identity of the object to which the file will be attached
         /// @param file_name A path to the file attachment
-        void attachFile(std::string topleveluri, std::string filename);
+        /// @param progress_fn An optional callback, which is called periodically with the number of bytes sent, the total number of bytes to send, and the user data
+        /// @param user_data Arbitrary data passed to the callback
+        void attachFile(std::string topleveluri, std::string filename, void (*progress_fn)(long long, long long, void*) = NULL, void* user_data = NULL);
 
-        /// Download a file attached to a TopLevel object in an online repository.
+        /// Download a file attached to a TopLevel object in an online repository. The file is written to disk as it arrives,
+        /// so files of any size may be downloaded. If a download is interrupted, calling this method again resumes it from
+        /// where it stopped, provided the server supports range requests and the file has not changed. Downloads are cached
+        /// in the same way as pulls.
         /// @param attachment_uri The full URI of the attached object
-        /// @param path The target path to which the file will be downloaded
-        void downloadAttachment(std::string attachment_uri, std::string path = ".");
+        /// @param path The target directory to which the file will be downloaded. The file is named by the server, but only the last segment of that name is used, so the file is always written to this directory
+        /// @param hash If given, the expected SHA-1 checksum of the file, as recorded in the hash property of an Attachment. A download which does not match is deleted.
+        /// @return The SHA-1 checksum of the downloaded file, as a hexadecimal string
+        std::string downloadAttachment(std::string attachment_uri, std::string path = ".", std::string hash = "");
       
         void addSynBioHubAnnotations(Document& doc); 
 
         bool exists(std::string uri); 
+
+        /// Retrieve an object without blocking. The requests of every asynchronous method of a PartShop, and its copies, are
+        /// driven by a single event loop thread, so that hundreds of them may be in flight at once. Responses are parsed on
+        /// that thread, so pulls into the same Document never run concurrently, but the Document must not be used until the
+        /// future is ready. Objects are always retrieved with their dependencies in one request, regardless of the
+        /// incremental_pull option. Requests still pending when the last copy of the PartShop is destroyed are abandoned, and
+        /// their futures hold an SBOLError.
+        /// @param uri The identity of the object, or its displayId
+        /// @param doc The Document to which the object is added
+        /// @param recursive Whether the object's dependencies are retrieved too
+        /// @return A future which becomes ready once the object has been added, or which holds the SBOLError that prevented it
+        std::future<void> pullAsync(std::string uri, Document& doc, bool recursive = true);
+
+        /// Perform an EXACT search without blocking. See search.
+        /// @return A future holding the SearchResponse, which the caller owns
+        std::future<SearchResponse&> searchAsync(std::string search_text, std::string object_type, std::string property_uri, int offset = 0, int limit = 25);
+
+        /// Perform a GENERAL search without blocking. See search.
+        /// @return A future holding the SearchResponse, which the caller owns
+        std::future<SearchResponse&> searchAsync(std::string search_text, std::string object_type = SBOL_COMPONENT_DEFINITION, int offset = 0, int limit = 25);
+
+        /// Perform an ADVANCED search without blocking. See search.
+        /// @return A future holding the SearchResponse, which the caller owns
+        std::future<SearchResponse&> searchAsync(SearchQuery& q);
+
+        /// Submit a Document without blocking. The Document is serialized while it is uploaded, so it must not be modified
+        /// until the future is ready. See submit.
+        /// @return A future holding the response of the repository
+        std::future<std::string> submitAsync(Document& doc, std::string collection = "", int overwrite = 0);
+
+        /// Check whether an object exists without blocking. See exists.
+        std::future<bool> existsAsync(std::string uri);
+
+        /// Download an attachment without blocking. See downloadAttachment.
+        /// @return A future holding the SHA-1 checksum of the downloaded file
+        std::future<std::string> downloadAttachmentAsync(std::string attachment_uri, std::string path = ".", std::string hash = "");
     };
 
 //    /// Returns a Document including all objects referenced from this object
 //    template <> sbol::Document& sbol::PartShop::pull<sbol::Document>(std::string uri);
 
+    /// SearchResults pages through every record matching a search, so that large collections can be scanned with a single
+    /// loop instead of repeated calls to PartShop::search. The next pages are requested on a background thread while the
+    /// current one is being read, and each page is released as soon as its last record has been read.
+    /// @code
+    /// SearchResults results(part_shop, "GFP");
+    /// for (auto& record : results)
+    ///     std::cout << record.identity.get() << std::endl;
+    /// @endcode
+    class SBOL_DECLSPEC SearchResults
+    {
+    private:
+        PartShop part_shop;
+        std::function<std::string(int)> page_url;  // Forms the request URL for the page starting at the given offset
+        int offset;
+        int page_size;
+        int prefetch;
+        std::unique_ptr<SearchResponse> page;  // The page being read
+        int i_record;
+        std::deque<SearchResponse*> pages;  // Pages which have arrived but have not been read yet
+        bool done;  // Set once the last page has arrived, or a request has failed
+        bool stopping;
+        std::exception_ptr error;
+        std::mutex lock;
+        std::condition_variable changed;
+        std::thread worker;
+
+        void start();
+        void fetchPages();
+
+    public:
+        /// Page through the results of an ADVANCED search. The offset and limit of the SearchQuery give the first record and the page size.
+        /// @param shop The PartShop to search
+        /// @param q A SearchQuery. It is copied, so it may be changed or destroyed while the results are read
+        /// @param prefetch The number of pages to request ahead of the page being read
+        SearchResults(PartShop& shop, SearchQuery& q, int prefetch = 1);
+
+        /// Page through the results of an EXACT search. See PartShop::search for the search criteria.
+        /// @param page_size The number of records requested at a time
+        /// @param prefetch The number of pages to request ahead of the page being read
+        SearchResults(PartShop& shop, std::string search_text, rdf_type object_type, std::string property_uri, int offset = 0, int page_size = 25, int prefetch = 1);
+
+        /// Page through the results of a GENERAL search. See PartShop::search for the search criteria.
+        /// @param page_size The number of records requested at a time
+        /// @param prefetch The number of pages to request ahead of the page being read
+        SearchResults(PartShop& shop, std::string search_text, rdf_type object_type = SBOL_COMPONENT_DEFINITION, int offset = 0, int page_size = 25, int prefetch = 1);
+
+        SearchResults(const SearchResults&) = delete;
+        SearchResults& operator=(const SearchResults&) = delete;
+
+        ~SearchResults();
+
+        /// Advance to the next search record, waiting for its page to arrive if necessary. If a page request failed, its error is raised here.
+        /// @return The next record, or NULL after the last one. A record remains valid until the records of the following page are read.
+        Identified* next();
+
+        /// Reads the records of a SearchResults in order. Incrementing the iterator may wait for the next page to arrive.
+        class iterator
+        {
+        private:
+            SearchResults* results;
+            Identified* record;
+
+        public:
+            iterator(SearchResults* results = NULL, Identified* record = NULL) :
+                results(results),
+                record(record)
+            {
+            };
+
+            Identified& operator*()
+            {
+                return *record;
+            };
+
+            Identified* operator->()
+            {
+                return record;
+            };
+
+            iterator& operator++()
+            {
+                record = results->next();
+                return *this;
+            };
+
+            bool operator==(const iterator& other) const
+            {
+                return record == other.record;
+            };
+
+            bool operator!=(const iterator& other) const
+            {
+                return record != other.record;
+            };
+        };
+
+        /// Reads the first record that has not been read yet
+        iterator begin()
+        {
+            return iterator(this, next());
+        };
+
+        iterator end()
+        {
+            return iterator(this, NULL);
+        };
+    };
+
     template < class SBOLClass > int PartShop::count()
     {
         // Form get request
@@ -300,42 +791,14 @@ namespace sbol
         
         /* Perform HTTP request */
         std::string response;
-        CURL *curl;
-        CURLcode res;
-        
-        /* In windows, this will init the winsock stuff */
-        curl_global_init(CURL_GLOBAL_ALL);
-        
-        struct curl_slist *headers = NULL;
-        //    headers = curl_slist_append(headers, "Accept: application/json");
-        //    headers = curl_slist_append(headers, "Content-Type: application/x-www-form-urlencoded");
-        //    headers = curl_slist_append(headers, "charsets: utf-8");
-        
-        /* get a curl handle */
-        curl = curl_easy_init();
-        if(curl) {
-            /* First set the URL that is about to receive our POST. This URL can
-             just as well be a https:// URL if that is what should receive the
-             data. */
-            //curl_easy_setopt(curl, CURLOPT_URL, Config::getOption("validator_url").c_str());
-            curl_easy_setopt(curl, CURLOPT_URL, get_request.c_str());
-            //        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-            
-            /* Now specify the callback to read the response into string */
-            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlWrite_CallbackFunc_StdString);
-            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-            
-            /* Perform the request, res will get the return code */
-            res = curl_easy_perform(curl);
-            /* Check for errors */
-            if(res != CURLE_OK)
-                throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to count objects failed with " + std::string(curl_easy_strerror(res)));
-            
-            /* always cleanup */
-            curl_easy_cleanup(curl);
+        try
+        {
+            response = client->get(get_request).body;
+        }
+        catch (SBOLError& e)
+        {
+            throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to count objects failed with " + e.error_message());
         }
-        curl_slist_free_all(headers);
-        curl_global_cleanup();
         
         return stoi(response);
     };
@@ -349,45 +812,14 @@ namespace sbol
         
         /* Perform HTTP request */
         std::string response;
-        CURL *curl;
-        CURLcode res;
-        
-        /* In windows, this will init the winsock stuff */
-        curl_global_init(CURL_GLOBAL_ALL);
-        
-        struct curl_slist *headers = NULL;
-        //    headers = curl_slist_append(headers, "Accept: application/json");
-        //    headers = curl_slist_append(headers, "Content-Type: application/x-www-form-urlencoded");
-        //    headers = curl_slist_append(headers, "charsets: utf-8");
-        
-        /* get a curl handle */
-        curl = curl_easy_init();
-        if(curl) {
-            /* First set the URL that is about to receive our POST. This URL can
-             just as well be a https:// URL if that is what should receive the
-             data. */
-            //curl_easy_setopt(curl, CURLOPT_URL, Config::getOption("validator_url").c_str());
-            curl_easy_setopt(curl, CURLOPT_URL, get_request.c_str());
-            //        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-            
-            /* Now specify the POST data */
-            //        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, json.c_str());
-            
-            /* Now specify the callback to read the response into string */
-            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlWrite_CallbackFunc_StdString);
-            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-            
-            /* Perform the request, res will get the return code */
-            res = curl_easy_perform(curl);
-            /* Check for errors */
-            if(res != CURLE_OK)
-                throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to access PartShop failed with " + std::string(curl_easy_strerror(res)));
-            
-            /* always cleanup */
-            curl_easy_cleanup(curl);
+        try
+        {
+            response = client->get(get_request).body;
+        }
+        catch (SBOLError& e)
+        {
+            throw SBOLError(SBOL_ERROR_BAD_HTTP_REQUEST, "Attempt to access PartShop failed with " + e.error_message());
         }
-        curl_slist_free_all(headers);
-        curl_global_cleanup();
         
         doc.readString(response);
 
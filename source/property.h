@@ -58,6 +58,37 @@ namespace sbol
 	// All SBOLProperties have a pointer back to the object which the property belongs to.  This requires forward declaration of the SBOLObject class
 	class SBOLObject;
 
+    /// @cond
+    // How the values of a Property are passed to its validation rules
+    enum PropertyValueKind { TEXT_VALUE, INT_VALUE, FLOAT_VALUE, OBJECT_VALUE };
+
+    inline PropertyValueKind property_value_kind(std::string*) { return TEXT_VALUE; };
+    inline PropertyValueKind property_value_kind(int*) { return INT_VALUE; };
+    inline PropertyValueKind property_value_kind(double*) { return FLOAT_VALUE; };
+    template <class SBOLClass> PropertyValueKind property_value_kind(SBOLClass*) { return OBJECT_VALUE; };
+
+    // The validation rules of a Property, which are registered so that values already in the store can be checked against
+    // them by Document::validateAll
+    struct PropertyRules
+    {
+        PropertyValueKind kind;
+        ValidationRules rules;
+    };
+
+    // The rules of the Properties of a class, by property URI
+    typedef std::map<rdf_type, PropertyRules> ClassPropertyRules;
+
+    // Adds the rules of a Property to a registry which holds one set of rules per class, keyed by the RDF type of the
+    // class and the URI of the Property, rather than a copy in every object. Properties which share a URI share rules.
+    // Once a thread has registered the rules of a Property, it registers them again without taking a lock
+    // @param class_rules The rules of the owner's class, which are looked up by owner_type if this is NULL
+    void register_property_rules(ClassPropertyRules*& class_rules, const rdf_type& owner_type, const rdf_type& property, PropertyValueKind kind, const ValidationRules& rules);
+
+    // A copy of the rules of a Property, taken under the lock of the registry
+    // @return False if no rules are registered for the Property
+    bool find_property_rules(const ClassPropertyRules* class_rules, const rdf_type& property, PropertyRules& property_rules);
+    /// @endcond
+
     /// Member properties of all SBOL objects are defined using a Property object.  The Property class provides a generic interface for accessing SBOL objects.  At a low level, the Property class converts SBOL data structures into RDF triples.
     /// @tparam The SBOL specification currently supports string, URI, and integer literal values.
     /// @ingroup extension_layer
@@ -158,15 +189,22 @@ namespace sbol
         
         std::vector<std::string>::iterator python_iter;
         
+        /// Add a rule which is checked whenever this Property is set. The rule is also registered for the owner's class, so
+        /// Document::validateAll and DeferredValidation check it on this Property in every object of that class, whereas a
+        /// setter checks it only on this object. Add rules in the constructor of a class, so that every object has them
         void addValidationRule(ValidationRule rule)
         {
             validationRules.push_back(rule);
+            if (sbol_owner)
+                registerRules(ValidationRules({ rule }));
         };
         
 #if defined(SBOL_BUILD_PYTHON2) || defined(SBOL_BUILD_PYTHON3)
         void addValidationRule(PyObject* property_object, PyObject* validation_fx)
         {
             pythonValidationRules.push_back(std::make_pair(validation_fx, property_object));
+            if (sbol_owner)
+                sbol_owner->python_rules[type].push_back(std::make_pair(validation_fx, property_object));
         };
         
         bool __contains__(std::string value)
@@ -179,6 +217,12 @@ namespace sbol
 #endif
 
     protected:
+        // Adds rules of this Property to the rules of its owner's class
+        void registerRules(const ValidationRules& rules)
+        {
+            register_property_rules(this->sbol_owner->property_rules, this->sbol_owner->type, this->type, property_value_kind((LiteralType*)NULL), rules);
+        };
+
         bool isHidden()
         {
             if (std::find(this->sbol_owner->hidden_properties.begin(), this->sbol_owner->hidden_properties.end(), this->type) != this->sbol_owner->hidden_properties.end())
@@ -202,6 +246,8 @@ namespace sbol
             std::vector<std::string> property_store;
             property_store.push_back("\"\"");
             this->sbol_owner->properties.insert({ type_uri, property_store });
+            if (validationRules.size())
+                registerRules(validationRules);
         }
     }
 
@@ -266,7 +312,7 @@ namespace sbol
             {
                 this->sbol_owner->properties[this->type][0] = "\"" + new_value + "\"";
             }
-            
+            this->sbol_owner->markModified();
         }
         validate((void *)&new_value);
     };
@@ -279,6 +325,7 @@ namespace sbol
         {
             // TODO:  need to convert new_value to string
             this->sbol_owner->properties[type][0] = "\"" + std::to_string(new_value) + "\"";
+            this->sbol_owner->markModified();
         }
         validate((void *)&new_value);  //  Call validation rules associated with this Property
     };
@@ -291,6 +338,7 @@ namespace sbol
         {
             // TODO:  need to convert new_value to string
             this->sbol_owner->properties[type][0] = "\"" + std::to_string(new_value) + "\"";
+            this->sbol_owner->markModified();
         }
         validate((void *)&new_value);  //  Call validation rules associated with this Property
     };
@@ -317,6 +365,7 @@ namespace sbol
         {
             this->sbol_owner->properties[this->type].push_back("\"\"");
         }
+        this->sbol_owner->markModified();
     }
     
     template <class LiteralType>
@@ -349,16 +398,35 @@ namespace sbol
         // Validate the argument, if one is specified. The setters do this
         if (arg)
         {
+            // While validation is deferred, the rules which check values are run on the final values when the deferral
+            // ends, so only the change is recorded
+            bool deferred = false;
+            if (sbol_owner && DeferredValidation::active())
+            {
+                bool deferrable = false;
+#if defined(SBOL_BUILD_PYTHON2) || defined(SBOL_BUILD_PYTHON3)
+                deferrable = pythonValidationRules.size() > 0;
+#endif
+                if (property_value_kind((LiteralType*)NULL) != OBJECT_VALUE)
+                    for (auto rule : validationRules)
+                        deferrable = deferrable || checks_stored_values(rule);
+                deferred = deferrable && DeferredValidation::active()->record(sbol_owner, type);
+            }
+
             // Validate the argument, if one is specified. The setters do this
             for (ValidationRules::iterator i_rule = validationRules.begin(); i_rule != validationRules.end(); ++i_rule)
             {
                 ValidationRule& validate_fx = *i_rule;
+                if (deferred && property_value_kind((LiteralType*)NULL) != OBJECT_VALUE && checks_stored_values(validate_fx))
+                    continue;
                 validate_fx(sbol_owner, arg);
             }
             
 #if defined(SBOL_BUILD_PYTHON2) || defined(SBOL_BUILD_PYTHON3)
             for (auto & rule : pythonValidationRules)
             {
+                if (deferred)
+                    break;
                 PyObject* validate_fx = rule.first;
                 PyObject* property_to_validate = rule.second;
                 PyObject* py_tuple = PyTuple_New(1);
@@ -405,6 +473,7 @@ namespace sbol
                 else
                     this->sbol_owner->properties[this->type].push_back("\"" + new_value + "\"");
             }
+            this->sbol_owner->markModified();
             validate((void *)&new_value);  //  Call validation rules associated with this Property
         }
     };
@@ -421,7 +490,10 @@ namespace sbol
                 if (this->sbol_owner->properties[this->type].size() == 1)
                     this->clear();  // If this is the only value in the property, then clearing it will properly re-initialize the property
                 else
+                {
                     this->sbol_owner->properties[this->type].erase( this->sbol_owner->properties[this->type].begin() + index);
+                    this->sbol_owner->markModified();
+                }
             }
         }
     };
@@ -439,6 +511,7 @@ namespace sbol
             if (size() == 0)
                 values->clear();  // Remove "<>" or "" which indicates an empty SBOL property
             values->insert(values->end(), targets->begin(), targets->end());
+            this->sbol_owner->markModified();
     };
 
     
@@ -0,0 +1,183 @@
+/**
+ * @file    provenance.cpp
+ * @brief   Index of provenance relationships between objects in a Document
+ * @author  Bryan Bartley
+ * @email   bartleyba@sbolstandard.org
+ *
+ * <!--------------------------------------------------------------------------
+ * This file is part of libSBOL.  Please visit http://sbolstandard.org for more
+ * information about SBOL, and the latest version of libSBOL.
+ *
+ *  Copyright 2016 University of Washington, WA, USA
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ------------------------------------------------------------------------->*/
+
+#include "document.h"
+
+#include <unordered_set>
+
+using namespace sbol;
+using namespace std;
+
+// Reads the URIs held by a property directly from the property store, without the angle brackets which delimit them
+vector<string> get_uris(SBOLObject& obj, const string& property_uri)
+{
+    vector<string> uris;
+    auto i_property = obj.properties.find(property_uri);
+    if (i_property == obj.properties.end())
+        return uris;
+    for (auto& value : i_property->second)
+        if (value.size() > 2 && value[0] == '<')
+            uris.push_back(value.substr(1, value.size() - 2));
+    return uris;
+};
+
+// Reads the provenance edges held by an object and its children. Usages and Associations are qualifications of the
+// Activity which owns them, so their references become edges from that Activity
+void get_provenance_edges(SBOLObject& obj, vector<pair<string, string>>& edges)
+{
+    string uri = obj.identity.get();
+    for (auto& source : get_uris(obj, SBOL_WAS_DERIVED_FROM))
+        edges.push_back({ uri, source });
+    for (auto& activity : get_uris(obj, PROVO_WAS_GENERATED_BY))
+        edges.push_back({ uri, activity });
+    for (auto& activity : get_uris(obj, PROVO_WAS_INFORMED_BY))
+        edges.push_back({ uri, activity });
+    if (obj.parent && obj.type == PROVO_USAGE)
+        for (auto& entity : get_uris(obj, PROVO_ENTITY))
+            edges.push_back({ obj.parent->identity.get(), entity });
+    if (obj.parent && obj.type == PROVO_ASSOCIATION)
+    {
+        for (auto& agent : get_uris(obj, PROVO_AGENT_PROPERTY))
+            edges.push_back({ obj.parent->identity.get(), agent });
+        for (auto& plan : get_uris(obj, PROVO_HAD_PLAN))
+            edges.push_back({ obj.parent->identity.get(), plan });
+    }
+    for (auto& i_store : obj.owned_objects)
+        for (auto& child : i_store.second)
+            get_provenance_edges(*child, edges);
+};
+
+void remove_provenance_edge(unordered_map<string, unordered_map<string, int>>& graph, const string& from, const string& to)
+{
+    auto i_node = graph.find(from);
+    if (i_node == graph.end())
+        return;
+    auto i_edge = i_node->second.find(to);
+    if (i_edge != i_node->second.end() && --i_edge->second == 0)
+        i_node->second.erase(i_edge);
+    if (i_node->second.empty())
+        graph.erase(i_node);
+};
+
+// Removes the edges which were read from a TopLevel when it was last indexed
+void remove_provenance_edges(ProvenanceIndex& index, const string& uri)
+{
+    auto i_edges = index.edges.find(uri);
+    if (i_edges == index.edges.end())
+        return;
+    for (auto& edge : i_edges->second)
+    {
+        remove_provenance_edge(index.sources, edge.first, edge.second);
+        remove_provenance_edge(index.derivatives, edge.second, edge.first);
+    }
+    index.edges.erase(i_edges);
+};
+
+// Reads the edges held by a TopLevel into the index
+void add_provenance_edges(ProvenanceIndex& index, const string& uri, SBOLObject& top_level)
+{
+    vector<pair<string, string>>& edges = index.edges[uri];
+    get_provenance_edges(top_level, edges);
+    for (auto& edge : edges)
+    {
+        ++index.sources[edge.first][edge.second];
+        ++index.derivatives[edge.second][edge.first];
+    }
+};
+
+void Document::indexProvenance()
+{
+    if (!provenance.is_built)
+    {
+        for (auto& i_obj : SBOLObjects)
+            add_provenance_edges(provenance, i_obj.first, *i_obj.second);
+        provenance.is_built = true;
+        return;
+    }
+
+    // Re-read the TopLevels which have been added, removed or modified since the last query
+    for (auto& uri : provenance.stale)
+    {
+        remove_provenance_edges(provenance, uri);
+        auto i_obj = SBOLObjects.find(uri);
+        if (i_obj != SBOLObjects.end())
+            add_provenance_edges(provenance, uri, *i_obj->second);
+    }
+    provenance.stale.clear();
+};
+
+// Breadth-first search of the provenance graph, upstream or downstream of an object
+vector<string> Document::traverseProvenance(string uri, bool upstream, string type)
+{
+    indexProvenance();
+    unordered_map<string, unordered_map<string, int>>& graph = upstream ? provenance.sources : provenance.derivatives;
+    vector<string> visited = { uri };
+    unordered_set<string> is_visited = { uri };
+    vector<string> lineage;
+    for (size_t i_node = 0; i_node < visited.size(); ++i_node)
+    {
+        auto i_edges = graph.find(visited[i_node]);
+        if (i_edges == graph.end())
+            continue;
+        for (auto& edge : i_edges->second)
+        {
+            if (!is_visited.insert(edge.first).second)
+                continue;
+            visited.push_back(edge.first);
+            if (type != "")
+            {
+                auto i_obj = SBOLObjects.find(edge.first);
+                if (i_obj == SBOLObjects.end() || i_obj->second->type != type)
+                    continue;
+            }
+            lineage.push_back(edge.first);
+        }
+    }
+    return lineage;
+};
+
+vector<string> Document::getAncestors(string uri, string type)
+{
+    return traverseProvenance(uri, true, type);
+};
+
+vector<string> Document::getDescendants(string uri, string type)
+{
+    return traverseProvenance(uri, false, type);
+};
+
+vector<string> TopLevel::getAncestors(string type)
+{
+    if (!doc)
+        throw SBOLError(SBOL_ERROR_MISSING_DOCUMENT, "Cannot find ancestors of " + identity.get() + " because it does not belong to a Document");
+    return doc->getAncestors(identity.get(), type);
+};
+
+vector<string> TopLevel::getDescendants(string type)
+{
+    if (!doc)
+        throw SBOLError(SBOL_ERROR_MISSING_DOCUMENT, "Cannot find descendants of " + identity.get() + " because it does not belong to a Document");
+    return doc->getDescendants(identity.get(), type);
+};
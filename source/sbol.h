@@ -31,5 +31,6 @@
 
 // Import utility classes
 #include "partshop.h"
+#include "sequencefile.h"
 
 #endif
\ No newline at end of file
@@ -0,0 +1,484 @@
+/**
+ * @file    sequence.cpp
+ * @brief   Packed storage and views of Sequence elements
+ * @author  Bryan Bartley
+ * @email   bartleyba@sbolstandard.org
+ *
+ * <!--------------------------------------------------------------------------
+ * This file is part of libSBOL.  Please visit http://sbolstandard.org for more
+ * information about SBOL, and the latest version of libSBOL.
+ *
+ *  Copyright 2016 University of Washington, WA, USA
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ------------------------------------------------------------------------->*/
+
+#include "document.h"
+
+#include <algorithm>
+
+// SSE2 is part of the x86-64 baseline. AVX2 kernels are compiled with a target attribute on GCC and Clang and selected at
+// run time, or compiled in directly when the compiler targets AVX2 (eg, MSVC with /arch:AVX2)
+#if defined(__SSE2__) || defined(_M_X64)
+#define SBOL_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SBOL_SIMD_AVX2
+#define SBOL_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(__AVX2__)
+#define SBOL_SIMD_AVX2
+#define SBOL_TARGET_AVX2
+#include <immintrin.h>
+#endif
+
+using namespace sbol;
+using namespace std;
+
+// Classifies each character as a 2-bit base code (0-3), another IUPAC nucleotide symbol (AMBIGUOUS), or an invalid character (INVALID)
+const uint8_t AMBIGUOUS = 4;
+const uint8_t INVALID = 5;
+
+struct NucleotideCodes
+{
+    uint8_t codes[256];
+    NucleotideCodes()
+    {
+        fill(codes, codes + 256, INVALID);
+        const string bases = "acgt";
+        for (int i_base = 0; i_base < 4; ++i_base)
+        {
+            codes[(unsigned char)bases[i_base]] = i_base;
+            codes[(unsigned char)toupper(bases[i_base])] = i_base;
+        }
+        for (char symbol : string("uryswkmbdhvn-."))
+        {
+            codes[(unsigned char)symbol] = AMBIGUOUS;
+            codes[(unsigned char)toupper(symbol)] = AMBIGUOUS;
+        }
+    };
+};
+
+static const NucleotideCodes NUCLEOTIDE_CODES;
+
+// Finds the run, if any, which contains pos
+const PackedNucleotides::Run* find_run(const vector<PackedNucleotides::Run>& runs, size_t pos)
+{
+    auto i_run = upper_bound(runs.begin(), runs.end(), pos, [](size_t pos, const PackedNucleotides::Run& run) { return pos < run.start; });
+    if (i_run == runs.begin())
+        return NULL;
+    --i_run;
+    if (pos < i_run->start + i_run->length)
+        return &*i_run;
+    return NULL;
+};
+
+// Extends the last run if it is contiguous with pos and has the same symbol, otherwise starts a new run
+void extend_runs(vector<PackedNucleotides::Run>& runs, size_t pos, char symbol)
+{
+    if (runs.size() && runs.back().start + runs.back().length == pos && runs.back().symbol == symbol)
+        ++runs.back().length;
+    else
+        runs.push_back({ pos, 1, symbol });
+};
+
+PackedNucleotides::PackedNucleotides(const std::string& nucleotides) :
+    words((nucleotides.size() + 31) / 32, 0),
+    length(nucleotides.size())
+{
+    for (size_t i = 0; i < length; ++i)
+    {
+        char symbol = nucleotides[i];
+        uint8_t code = NUCLEOTIDE_CODES.codes[(unsigned char)symbol];
+        if (code == INVALID)
+            throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot pack nucleotides. Invalid IUPAC symbol '" + string(1, symbol) + "' at position " + to_string(i + 1));
+        if (code == AMBIGUOUS)
+        {
+            // Ambiguity codes are restored verbatim, so they do not interrupt a run of upper-case bases
+            extend_runs(ambiguities, i, symbol);
+            if (isupper(symbol) && uppercase.size() && uppercase.back().start + uppercase.back().length == i)
+                ++uppercase.back().length;
+            continue;
+        }
+        words[i / 32] |= (uint64_t)code << (2 * (i % 32));
+        if (isupper(symbol))
+            extend_runs(uppercase, i, 'U');
+    }
+    ambiguities.shrink_to_fit();
+    uppercase.shrink_to_fit();
+};
+
+char PackedNucleotides::at(size_t pos) const
+{
+    if (pos >= length)
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Position " + to_string(pos) + " is out of range");
+    const Run* ambiguity = find_run(ambiguities, pos);
+    if (ambiguity)
+        return ambiguity->symbol;
+    char base = "acgt"[code(pos)];
+    if (find_run(uppercase, pos))
+        return toupper(base);
+    return base;
+};
+
+std::string PackedNucleotides::substr(size_t pos, size_t len) const
+{
+    if (pos > length)
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Position " + to_string(pos) + " is out of range");
+    len = min(len, length - pos);
+    string nucleotides(len, 'a');
+    for (size_t i = 0; i < len; ++i)
+        nucleotides[i] = "acgt"[code(pos + i)];
+
+    // Restore case and ambiguity codes for runs which overlap the region
+    for (const vector<Run>* runs : { &uppercase, &ambiguities })
+    {
+        auto i_run = upper_bound(runs->begin(), runs->end(), pos, [](size_t pos, const Run& run) { return pos < run.start; });
+        if (i_run != runs->begin())
+            --i_run;
+        for (; i_run != runs->end() && i_run->start < pos + len; ++i_run)
+        {
+            size_t run_start = max(i_run->start, pos);
+            size_t run_end = min(i_run->start + i_run->length, pos + len);
+            for (size_t i = run_start; i < run_end; ++i)
+            {
+                if (runs == &uppercase)
+                    nucleotides[i - pos] = toupper(nucleotides[i - pos]);
+                else
+                    nucleotides[i - pos] = i_run->symbol;
+            }
+        }
+    }
+    return nucleotides;
+};
+
+size_t PackedNucleotides::bytes() const
+{
+    return sizeof(*this) + words.capacity() * sizeof(uint64_t) + (ambiguities.capacity() + uppercase.capacity()) * sizeof(Run);
+};
+
+SequenceView SequenceView::subview(size_t pos, size_t len) const
+{
+    if (pos > length || len > length - pos)
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Region of length " + to_string(len) + " at position " + to_string(pos) + " is out of range");
+    if (packed)
+        return SequenceView(*packed, offset + pos, len);
+    return SequenceView(*text, offset + pos, len);
+};
+
+void ElementsProperty::pack()
+{
+    if (is_packed)
+        return;
+    string& value = sbol_owner->properties[type][0];
+    packed = PackedNucleotides(value.substr(1, value.length() - 2));  // Strip quotes
+    string("\"\"").swap(value);  // Release the memory held by the string
+    is_packed = true;
+};
+
+void ElementsProperty::unpack()
+{
+    if (!is_packed)
+        return;
+    sbol_owner->properties[type][0] = "\"" + packed.str() + "\"";
+    discard();
+};
+
+void Sequence::pack()
+{
+    if (encoding.get() != SBOL_ENCODING_IUPAC)
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot pack Sequence " + identity.get() + ". Only Sequences with an IUPAC DNA encoding can be packed.");
+    elements.pack();
+};
+
+void Sequence::unpack()
+{
+    elements.unpack();
+};
+
+bool Sequence::isPacked()
+{
+    return elements.is_packed;
+};
+
+SequenceView Sequence::view()
+{
+    if (elements.is_packed)
+        return SequenceView(elements.packed, 0, elements.packed.size());
+    string& value = properties[SBOL_ELEMENTS][0];
+    return SequenceView(value, 1, value.length() - 2);  // Skip the quotes around the literal
+};
+
+std::string Sequence::subsequence(int start, int end)
+{
+    if (start < 1 || end < start - 1)
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Invalid region " + to_string(start) + ".." + to_string(end) + " of Sequence " + identity.get());
+    return view().subview(start - 1, end - start + 1).str();
+};
+
+/* <!--- Sequence kernels ---> */
+
+// Maps each character to its complement. IUPAC ambiguity codes map to the code for the complementary set of bases, and case is preserved. Other characters map to themselves.
+struct ComplementTable
+{
+    char complements[256];
+    ComplementTable()
+    {
+        for (int i = 0; i < 256; ++i)
+            complements[i] = (char)i;
+        const string symbols    = "acgturyswkmbdhvn";
+        const string complement = "tgcaayrswmkvhdbn";
+        for (size_t i = 0; i < symbols.size(); ++i)
+        {
+            complements[(unsigned char)symbols[i]] = complement[i];
+            complements[(unsigned char)toupper(symbols[i])] = toupper(complement[i]);
+        }
+    };
+};
+
+static const ComplementTable COMPLEMENT_TABLE;
+
+int popcount(uint32_t mask)
+{
+#ifdef __GNUC__
+    return __builtin_popcount(mask);
+#else
+    int count = 0;
+    for (; mask; mask &= mask - 1)
+        ++count;
+    return count;
+#endif
+};
+
+int count_trailing_zeros(uint32_t mask)
+{
+#ifdef __GNUC__
+    return __builtin_ctz(mask);
+#else
+    int count = 0;
+    for (; !(mask & 1); mask >>= 1)
+        ++count;
+    return count;
+#endif
+};
+
+#ifdef SBOL_SIMD_AVX2
+bool has_avx2()
+{
+#ifdef __GNUC__
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return true;
+#endif
+};
+
+// Complements 32 characters at once. The low 5 bits of a letter index the alphabet (a = 1), so two 16-entry shuffles
+// look up the complementary letter, and the case bit is carried over. Non-letters are passed through unchanged.
+SBOL_TARGET_AVX2 __m256i complement_avx2(__m256i x)
+{
+    const __m256i table_lo = _mm256_setr_epi8(0, 't', 'v', 'g', 'h', 'e', 'f', 'c', 'd', 'i', 'j', 'm', 'l', 'k', 'n', 'o',
+                                              0, 't', 'v', 'g', 'h', 'e', 'f', 'c', 'd', 'i', 'j', 'm', 'l', 'k', 'n', 'o');
+    const __m256i table_hi = _mm256_setr_epi8('p', 'q', 'y', 's', 'a', 'a', 'b', 'w', 'x', 'r', 'z', 0, 0, 0, 0, 0,
+                                              'p', 'q', 'y', 's', 'a', 'a', 'b', 'w', 'x', 'r', 'z', 0, 0, 0, 0, 0);
+    __m256i lower = _mm256_or_si256(x, _mm256_set1_epi8(0x20));
+    __m256i is_letter = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+    __m256i index = _mm256_and_si256(x, _mm256_set1_epi8(0x1F));
+    __m256i is_hi = _mm256_cmpgt_epi8(index, _mm256_set1_epi8(15));
+    __m256i complement = _mm256_blendv_epi8(_mm256_shuffle_epi8(table_lo, index), _mm256_shuffle_epi8(table_hi, _mm256_sub_epi8(index, _mm256_set1_epi8(16))), is_hi);
+    complement = _mm256_or_si256(_mm256_andnot_si256(_mm256_set1_epi8(0x20), complement), _mm256_and_si256(x, _mm256_set1_epi8(0x20)));  // Restore case
+    return _mm256_blendv_epi8(x, complement, is_letter);
+};
+
+SBOL_TARGET_AVX2 size_t reverse_complement_avx2(const char* nucleotides, size_t length, char* out)
+{
+    const __m256i reverse = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                                             15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(nucleotides + length - i - 32));
+        x = complement_avx2(x);
+        x = _mm256_shuffle_epi8(x, reverse);         // Reverse bytes within each 128-bit lane...
+        x = _mm256_permute2x128_si256(x, x, 1);      // ...then swap the lanes
+        _mm256_storeu_si256((__m256i*)(out + i), x);
+    }
+    return i;
+};
+
+// Flags characters that are not IUPAC nucleotide symbols. The low 5 bits of a letter index a table of valid letters, as in
+// complement_avx2. The gap symbols '-' and '.' are compared separately.
+SBOL_TARGET_AVX2 uint32_t invalid_mask_avx2(__m256i x)
+{
+    const __m256i valid_lo = _mm256_setr_epi8(0, -1, -1, -1, -1, 0, 0, -1, -1, 0, 0, -1, 0, -1, -1, 0,
+                                              0, -1, -1, -1, -1, 0, 0, -1, -1, 0, 0, -1, 0, -1, -1, 0);
+    const __m256i valid_hi = _mm256_setr_epi8(0, 0, -1, -1, -1, -1, -1, -1, 0, -1, 0, 0, 0, 0, 0, 0,
+                                              0, 0, -1, -1, -1, -1, -1, -1, 0, -1, 0, 0, 0, 0, 0, 0);
+    __m256i lower = _mm256_or_si256(x, _mm256_set1_epi8(0x20));
+    __m256i is_letter = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+    __m256i index = _mm256_and_si256(x, _mm256_set1_epi8(0x1F));
+    __m256i is_hi = _mm256_cmpgt_epi8(index, _mm256_set1_epi8(15));
+    __m256i valid = _mm256_blendv_epi8(_mm256_shuffle_epi8(valid_lo, index), _mm256_shuffle_epi8(valid_hi, _mm256_sub_epi8(index, _mm256_set1_epi8(16))), is_hi);
+    valid = _mm256_and_si256(valid, is_letter);
+    valid = _mm256_or_si256(valid, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('-')));
+    valid = _mm256_or_si256(valid, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('.')));
+    return ~(uint32_t)_mm256_movemask_epi8(valid);
+};
+
+SBOL_TARGET_AVX2 size_t find_invalid_nucleotide_avx2(const char* nucleotides, size_t length, size_t& i)
+{
+    for (; i + 32 <= length; i += 32)
+    {
+        uint32_t invalid = invalid_mask_avx2(_mm256_loadu_si256((const __m256i*)(nucleotides + i)));
+        if (invalid)
+            return i + count_trailing_zeros(invalid);
+    }
+    return string::npos;
+};
+
+SBOL_TARGET_AVX2 size_t count_gc_avx2(const char* nucleotides, size_t length, size_t& i)
+{
+    size_t count = 0;
+    for (; i + 32 <= length; i += 32)
+    {
+        __m256i lower = _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(nucleotides + i)), _mm256_set1_epi8(0x20));
+        __m256i gc = _mm256_or_si256(_mm256_cmpeq_epi8(lower, _mm256_set1_epi8('g')), _mm256_cmpeq_epi8(lower, _mm256_set1_epi8('c')));
+        gc = _mm256_or_si256(gc, _mm256_cmpeq_epi8(lower, _mm256_set1_epi8('s')));
+        count += popcount((uint32_t)_mm256_movemask_epi8(gc));
+    }
+    return count;
+};
+#endif
+
+#ifdef SBOL_SIMD_SSE2
+size_t count_gc_sse2(const char* nucleotides, size_t length, size_t& i)
+{
+    size_t count = 0;
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i lower = _mm_or_si128(_mm_loadu_si128((const __m128i*)(nucleotides + i)), _mm_set1_epi8(0x20));
+        __m128i gc = _mm_or_si128(_mm_cmpeq_epi8(lower, _mm_set1_epi8('g')), _mm_cmpeq_epi8(lower, _mm_set1_epi8('c')));
+        gc = _mm_or_si128(gc, _mm_cmpeq_epi8(lower, _mm_set1_epi8('s')));
+        count += popcount(_mm_movemask_epi8(gc));
+    }
+    return count;
+};
+
+size_t find_invalid_nucleotide_sse2(const char* nucleotides, size_t length, size_t& i)
+{
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i*)(nucleotides + i));
+        __m128i lower = _mm_or_si128(x, _mm_set1_epi8(0x20));
+        __m128i valid = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+        for (char letter : { 'e', 'f', 'i', 'j', 'l', 'o', 'p', 'q', 'x', 'z' })
+            valid = _mm_andnot_si128(_mm_cmpeq_epi8(lower, _mm_set1_epi8(letter)), valid);
+        valid = _mm_or_si128(valid, _mm_cmpeq_epi8(x, _mm_set1_epi8('-')));
+        valid = _mm_or_si128(valid, _mm_cmpeq_epi8(x, _mm_set1_epi8('.')));
+        uint32_t invalid = ~_mm_movemask_epi8(valid) & 0xFFFF;
+        if (invalid)
+            return i + count_trailing_zeros(invalid);
+    }
+    return string::npos;
+};
+#endif
+
+std::string sbol::reverse_complement(const std::string& nucleotides, bool vectorize)
+{
+    size_t length = nucleotides.size();
+    string reverse_complement(length, ' ');
+    size_t i = 0;
+#ifdef SBOL_SIMD_AVX2
+    if (vectorize && has_avx2())
+        i = reverse_complement_avx2(nucleotides.data(), length, &reverse_complement[0]);
+#endif
+    for (; i < length; ++i)
+        reverse_complement[i] = COMPLEMENT_TABLE.complements[(unsigned char)nucleotides[length - i - 1]];
+    return reverse_complement;
+};
+
+size_t sbol::count_gc(const char* nucleotides, size_t length, bool vectorize)
+{
+    size_t count = 0;
+    size_t i = 0;
+    if (vectorize)
+    {
+#if defined(SBOL_SIMD_AVX2)
+        if (has_avx2())
+            count += count_gc_avx2(nucleotides, length, i);
+#endif
+#if defined(SBOL_SIMD_SSE2)
+        count += count_gc_sse2(nucleotides, length, i);
+#endif
+    }
+    for (; i < length; ++i)
+    {
+        char base = nucleotides[i] | 0x20;
+        if (base == 'g' || base == 'c' || base == 's')
+            ++count;
+    }
+    return count;
+};
+
+size_t sbol::find_invalid_nucleotide(const char* nucleotides, size_t length, bool vectorize)
+{
+    size_t i = 0;
+    if (vectorize)
+    {
+        size_t invalid = string::npos;
+#if defined(SBOL_SIMD_AVX2)
+        if (has_avx2())
+            invalid = find_invalid_nucleotide_avx2(nucleotides, length, i);
+#endif
+#if defined(SBOL_SIMD_SSE2)
+        if (invalid == string::npos)
+            invalid = find_invalid_nucleotide_sse2(nucleotides, length, i);
+#endif
+        if (invalid != string::npos)
+            return invalid;
+    }
+    for (; i < length; ++i)
+        if (NUCLEOTIDE_CODES.codes[(unsigned char)nucleotides[i]] == INVALID)
+            return i;
+    return string::npos;
+};
+
+std::string Sequence::reverseComplement()
+{
+    return reverse_complement(view().str());
+};
+
+double Sequence::gcContent()
+{
+    // Packed elements are scanned in blocks, so they need not be unpacked
+    SequenceView elements_view = view();
+    if (elements_view.size() == 0)
+        return 0;
+    const size_t block_size = 1 << 16;
+    size_t count = 0;
+    for (size_t pos = 0; pos < elements_view.size(); pos += block_size)
+    {
+        string block = elements_view.subview(pos, min(block_size, elements_view.size() - pos)).str();
+        count += count_gc(block.data(), block.size());
+    }
+    return (double)count / elements_view.size();
+};
+
+bool Sequence::isValidIUPAC()
+{
+    if (elements.is_packed)
+        return true;  // Invalid symbols are rejected when packing
+    string& value = properties[SBOL_ELEMENTS][0];
+    return find_invalid_nucleotide(value.data() + 1, value.length() - 2) == string::npos;  // Skip the quotes around the literal
+};
@@ -29,9 +29,137 @@
 #include "toplevel.h"
 
 #include <string>
+#include <vector>
+#include <cstdint>
 
 namespace sbol
 {
+    /// A compact representation of an IUPAC nucleotide sequence. Unambiguous bases (a, c, g, t) are packed 2 bits per base. Ambiguity codes (eg, n, r, y) and other IUPAC symbols are kept in a separate list of runs, as are runs of upper-case bases, so the original string is restored exactly when unpacked. Genomic sequences, which are mostly unambiguous and consistently cased, therefore occupy about a quarter of the memory of their string representation.
+    class SBOL_DECLSPEC PackedNucleotides
+    {
+    public:
+        PackedNucleotides() : length(0) {};
+
+        /// Pack a nucleotide sequence. Throws SBOL_ERROR_INVALID_ARGUMENT if a character is not an IUPAC nucleotide symbol
+        /// @param nucleotides A string of IUPAC nucleotide symbols
+        PackedNucleotides(const std::string& nucleotides);
+
+        /// @return The number of nucleotides
+        size_t size() const { return length; };
+
+        /// @return The nucleotide at the given 0-based position
+        char at(size_t pos) const;
+
+        /// Unpack a region of the sequence
+        /// @param pos The 0-based position of the first nucleotide
+        /// @param len The number of nucleotides to unpack. By default, unpacks to the end of the sequence
+        /// @return A string of IUPAC nucleotide symbols
+        std::string substr(size_t pos, size_t len = std::string::npos) const;
+
+        /// @return The complete sequence as a string
+        std::string str() const { return substr(0); };
+
+        /// @return The approximate number of bytes used to store the packed sequence
+        size_t bytes() const;
+
+        /// @cond
+        // The 2-bit code of the base at the given position. Ambiguous positions hold an arbitrary code; check ambiguities for those
+        uint8_t code(size_t pos) const { return (words[pos / 32] >> (2 * (pos % 32))) & 3; };
+
+        // A run of identical characters which cannot be represented by a 2-bit code, or a run of upper-case bases
+        struct Run { size_t start; size_t length; char symbol; };
+        std::vector<uint64_t> words;
+        std::vector<Run> ambiguities;
+        std::vector<Run> uppercase;
+        /// @endcond
+
+    private:
+        size_t length;
+    };
+
+    /// A read-only view of a region of a Sequence's elements, which does not copy the elements. A view is valid until the Sequence is modified, packed, or unpacked.
+    class SBOL_DECLSPEC SequenceView
+    {
+    public:
+        SequenceView(const PackedNucleotides& packed, size_t offset, size_t length) : packed(&packed), text(NULL), offset(offset), length(length) {};
+        SequenceView(const std::string& text, size_t offset, size_t length) : packed(NULL), text(&text), offset(offset), length(length) {};
+
+        /// @return The number of nucleotides in the view
+        size_t size() const { return length; };
+
+        /// @return The nucleotide at the given 0-based position in the view
+        char operator[](size_t pos) const { return packed ? packed->at(offset + pos) : (*text)[offset + pos]; };
+
+        /// @return A view of a region within this view. This does not copy any elements.
+        /// @param pos The 0-based position of the first nucleotide
+        /// @param len The number of nucleotides
+        SequenceView subview(size_t pos, size_t len) const;
+
+        /// @return The nucleotides in the view as a string
+        std::string str() const { return packed ? packed->substr(offset, length) : text->substr(offset, length); };
+
+    private:
+        const PackedNucleotides* packed;
+        const std::string* text;
+        size_t offset;
+        size_t length;
+    };
+
+    /// @cond
+    // Sequence kernels, which use SSE2 or AVX2 instructions where the processor supports them unless vectorize is false
+    SBOL_DECLSPEC std::string reverse_complement(const std::string& nucleotides, bool vectorize = true);
+    SBOL_DECLSPEC size_t count_gc(const char* nucleotides, size_t length, bool vectorize = true);  // Counts g, c and s (g or c), in either case
+    SBOL_DECLSPEC size_t find_invalid_nucleotide(const char* nucleotides, size_t length, bool vectorize = true);  // Returns std::string::npos if all characters are IUPAC nucleotide symbols
+    /// @endcond
+
+    /// The best local alignment of a query sequence to a target sequence, as found by align_sequences
+    struct SBOL_DECLSPEC SequenceAlignment
+    {
+        int score;                  ///< The alignment score. This is 0 if the sequences do not align.
+        size_t target_start;        ///< The 0-based position of the first aligned base of the target
+        size_t target_end;          ///< The 0-based position after the last aligned base of the target
+        size_t query_start;         ///< The 0-based position of the first aligned base of the query
+        size_t query_end;           ///< The 0-based position after the last aligned base of the query
+        std::string target;         ///< The aligned region of the target, with a '-' opposite each base inserted in the query
+        std::string query;          ///< The aligned region of the query, with a '-' opposite each base deleted from the target
+    };
+
+    /// Align a query nucleotide sequence, eg, a sequencing read of a Build, to a target sequence, eg, the compiled sequence of its Design. The best local (Smith-Waterman) alignment is located with striped SSE2 or AVX2 kernels where the processor supports them, then traced within a band around its diagonal. Matches score 2, mismatches -3, and a gap of k bases -5 - 2(k - 1). Ambiguous bases, such as n, score 0.
+    /// @param target The target sequence
+    /// @param query The query sequence
+    /// @param vectorize If false, the alignment is located with the scalar kernel
+    /// @return The alignment
+    SBOL_DECLSPEC SequenceAlignment align_sequences(const std::string& target, const std::string& query, bool vectorize = true);
+
+    /// @cond
+    // The elements property of a Sequence, which may hold its value in a PackedNucleotides rather than the property store. The value is unpacked lazily, the first time it is accessed as a string
+    class SBOL_DECLSPEC ElementsProperty : public TextProperty
+    {
+    public:
+        ElementsProperty(void *property_owner, rdf_type type_uri, char lower_bound, char upper_bound, ValidationRules validation_rules, std::string initial_value) :
+            TextProperty(property_owner, type_uri, lower_bound, upper_bound, validation_rules, initial_value),
+            is_packed(false)
+            {
+            };
+
+        std::string get() override { unpack(); return TextProperty::get(); };
+        std::vector<std::string> getAll() override { unpack(); return TextProperty::getAll(); };
+        using TextProperty::set;
+        void set(std::string new_value) override { discard(); TextProperty::set(new_value); };
+        void clear() override { discard(); TextProperty::clear(); };
+        void remove(int index = 0) override { discard(); TextProperty::remove(index); };
+        bool find(std::string query) override { unpack(); return TextProperty::find(query); };
+        int size() { return is_packed ? 1 : TextProperty::size(); };
+
+        void pack();
+        void unpack();
+        void discard() { packed = PackedNucleotides(); is_packed = false; };
+
+        PackedNucleotides packed;
+        bool is_packed;
+    };
+    /// @endcond
+
     /// The primary structure (eg, nucleotide or amino acid sequence) of a ComponentDefinition object
 	class SBOL_DECLSPEC Sequence : public TopLevel
 	{
@@ -53,7 +181,7 @@ namespace sbol
             };
         
         /// The elements property is a REQUIRED String of characters that represents the constituents of a biological or chemical molecule. For example, these characters could represent the nucleotide bases of a molecule of DNA, the amino acid residues of a protein, or the atoms and chemical bonds of a small molecule.
-		TextProperty elements;
+		ElementsProperty elements;
         
         /// The encoding property is REQUIRED and has a data type of URI. This property MUST indicate how the elements property of a Sequence MUST be formed and interpreted. For example, the elements property of a Sequence with an IUPAC DNA encoding property MUST contain characters that represent nucleotide bases, such as a, t, c, and g. The elements property of a Sequence with a Simplified Molecular-Input Line-Entry System (SMILES) encoding, on the other hand, MUST contain characters that represent atoms and chemical bonds, such as C, N, O, and =.
         /// It is RECOMMENDED that the encoding property contains a URI from the table below. The terms in the table are organized by the type of ComponentDefinition that typically refer to a Sequence with such an encoding.  When the encoding of a Sequence is well described by one of the URIs in the table, it MUST contain that URI.
@@ -73,6 +201,33 @@ namespace sbol
         
         /// @return The length of the primary sequence in the elements property
         int length();
+
+        /// Store the elements in a packed representation of 2 bits per base, releasing the string. The elements are transparently unpacked the first time they are accessed as a string, eg, by elements.get() or when the Document is written. Use view or subsequence to read packed elements without unpacking them. Only Sequences with an IUPAC DNA encoding can be packed.
+        void pack();
+
+        /// Restore packed elements to their string representation
+        void unpack() override;
+
+        /// @return true if the elements are currently held in a packed representation
+        bool isPacked();
+
+        /// @return A view of the elements, which does not copy or unpack them
+        SequenceView view();
+
+        /// Extract a region of the elements, without unpacking the rest of the Sequence.
+        /// @param start The first position of the region. As with Range, the first position in the Sequence is 1
+        /// @param end The last position of the region, inclusive
+        /// @return The elements of the region
+        std::string subsequence(int start, int end);
+
+        /// @return The reverse complement of the elements. IUPAC ambiguity codes are complemented too, eg, r (a or g) becomes y (c or t), and case is preserved.
+        std::string reverseComplement();
+
+        /// @return The fraction of the elements which are g, c, or s (g or c), between 0 and 1
+        double gcContent();
+
+        /// @return true if every character in the elements is an IUPAC nucleotide symbol, including ambiguity codes and the gap symbols - and .
+        bool isValidIUPAC();
         
         /// @param clone_id A URI for the build, or displayId if working in SBOLCompliant mode.
         ComponentDefinition& synthesize(std::string clone_id);
@@ -0,0 +1,637 @@
+/**
+ * @file    sequencefile.cpp
+ * @brief   Streaming conversion between SBOL and the FASTA and GenBank file formats
+ * @author  Bryan Bartley
+ * @email   bartleyba@sbolstandard.org
+ *
+ * <!--------------------------------------------------------------------------
+ * This file is part of libSBOL.  Please visit http://sbolstandard.org for more
+ * information about SBOL, and the latest version of libSBOL.
+ *
+ *  Copyright 2016 University of Washington, WA, USA
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ------------------------------------------------------------------------->*/
+
+#include "sbol.h"
+#include "sequencefile.h"
+
+#include <cctype>
+#include <cstring>
+#include <ctime>
+#include <algorithm>
+#include <unordered_set>
+
+using namespace sbol;
+using namespace std;
+
+// GenBank feature keys and the Sequence Ontology terms which are the roles of the SequenceAnnotations for them. Features
+// with other keys are annotated as regions
+const vector<pair<string, string>> FEATURE_ROLES = {
+    { "CDS", SO_CDS },
+    { "gene", SO_GENE },
+    { "promoter", SO_PROMOTER },
+    { "RBS", SO_RBS },
+    { "terminator", SO_TERMINATOR },
+    { "misc_feature", SO_MISC }
+};
+
+// The qualifiers of a GenBank feature which name it, in order of preference
+const vector<string> NAME_QUALIFIERS = { "label", "gene", "product", "locus_tag", "note" };
+
+// The number of elements on each line of a FASTA record, and of the ORIGIN section of a GenBank record
+const size_t FASTA_LINE_LENGTH = 80;
+const size_t GENBANK_LINE_LENGTH = 60;
+
+std::string sbol::sequence_file_language(std::string language)
+{
+    transform(language.begin(), language.end(), language.begin(), [](unsigned char c) { return (char)tolower(c); });
+    if (language == "fasta" || language == "fa")
+        return "FASTA";
+    if (language == "genbank" || language == "gb" || language == "gbk")
+        return "GenBank";
+    return "";
+};
+
+string trim(const string& text)
+{
+    size_t i_begin = text.find_first_not_of(" \t");
+    if (i_begin == string::npos)
+        return "";
+    return text.substr(i_begin, text.find_last_not_of(" \t") - i_begin + 1);
+};
+
+// A displayId for a record's identifier, with characters that are not allowed replaced by underscores
+string record_display_id(string id)
+{
+    for (auto& c : id)
+        if (is_not_alphanumeric_or_underscore(c))
+            c = '_';
+    if (id == "" || isdigit((unsigned char)id[0]))
+        id = "_" + id;
+    return id;
+};
+
+// Creates an object in a Document, appending a number to the displayId if another object already has it
+template <class SBOLClass>
+SBOLClass& create_unique(OwnedObject<SBOLClass>& store, string display_id)
+{
+    for (int i_copy = 1; ; ++i_copy)
+    {
+        try
+        {
+            return store.create(i_copy == 1 ? display_id : display_id + "_" + to_string(i_copy));
+        }
+        catch (SBOLError& e)
+        {
+            if (e.error_code() != SBOL_ERROR_URI_NOT_UNIQUE)
+                throw;
+        }
+    }
+};
+
+// Adds a ComponentDefinition for a record, with a Sequence for its elements, to a Document
+ComponentDefinition& create_record(Document& doc, string id, string description, string& elements, bool is_protein)
+{
+    // Nucleotides are stored in lower case, following the convention for the IUPAC encoding
+    if (!is_protein)
+        transform(elements.begin(), elements.end(), elements.begin(), [](unsigned char c) { return (char)tolower(c); });
+    ComponentDefinition& cd = create_unique(doc.componentDefinitions, record_display_id(id));
+    Sequence& seq = create_unique(doc.sequences, cd.displayId.get() + "_sequence");
+    seq.elements.set(elements);
+    seq.encoding.set(is_protein ? SBOL_ENCODING_IUPAC_PROTEIN : SBOL_ENCODING_IUPAC);
+    cd.types.set(is_protein ? BIOPAX_PROTEIN : BIOPAX_DNA);
+    cd.sequences.set(seq.identity.get());
+    if (description != "")
+        cd.description.set(description);
+    return cd;
+};
+
+// Whether a FASTA record holds amino acids, which is assumed if it has letters which do not stand for nucleotides
+bool is_protein_sequence(const string& elements)
+{
+    for (char c : elements)
+        if (!strchr("acgtunrykmswbdhvACGTUNRYKMSWBDHV-.", c))
+            return true;
+    return false;
+};
+
+SequenceFileReader::SequenceFileReader(std::string path, std::string language) :
+    file(path.c_str(), ios::in | ios::binary),
+    path(path),
+    language(sequence_file_language(language)),
+    has_line(false),
+    n_records(0)
+{
+    if (!file.is_open())
+        throw SBOLError(SBOL_ERROR_FILE_NOT_FOUND, "Cannot read " + path + ". The file could not be opened");
+    if (language != "" && this->language == "")
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot read " + language + " files. Only FASTA and GenBank are supported");
+    if (this->language != "")
+        return;
+
+    // Detect the format from the first line which is not blank
+    while (readLine())
+    {
+        if (trim(line) == "")
+            continue;
+        has_line = true;
+        if (line[0] == '>' || line[0] == ';')
+            this->language = "FASTA";
+        else if (line.compare(0, 5, "LOCUS") == 0)
+            this->language = "GenBank";
+        else
+            throw SBOLError(SBOL_ERROR_PARSE, "Cannot read " + path + ". It is neither a FASTA nor a GenBank file");
+        return;
+    }
+    this->language = "FASTA";  // An empty file has no records in either format
+};
+
+bool SequenceFileReader::readLine()
+{
+    if (!getline(file, line))
+        return false;
+    if (line.size() && line.back() == '\r')
+        line.pop_back();
+    return true;
+};
+
+ComponentDefinition* SequenceFileReader::next(Document& doc)
+{
+    ComponentDefinition* cd = language == "FASTA" ? nextFASTA(doc) : nextGenBank(doc);
+    if (cd)
+        ++n_records;
+    return cd;
+};
+
+ComponentDefinition* SequenceFileReader::nextFASTA(Document& doc)
+{
+    // Find the header of the next record, skipping blank lines and comments
+    bool has_header = false;
+    while (has_line || readLine())
+    {
+        has_line = false;
+        if (trim(line) == "" || line[0] == ';')
+            continue;
+        if (line[0] != '>')
+            throw SBOLError(SBOL_ERROR_PARSE, "Cannot read " + path + ". Expected the header of FASTA record " + to_string(n_records + 1) + ", but found " + line.substr(0, 40));
+        has_header = true;
+        break;
+    }
+    if (!has_header)
+        return NULL;
+    string header = trim(line.substr(1));
+    size_t i_space = header.find_first_of(" \t");
+    string id = header.substr(0, i_space);
+    string description = i_space == string::npos ? "" : trim(header.substr(i_space));
+
+    // The elements continue until the next header
+    string elements;
+    while (readLine())
+    {
+        if (line.size() && line[0] == '>')
+        {
+            has_line = true;
+            break;
+        }
+        if (line.size() && line[0] == ';')
+            continue;
+        for (char c : line)
+            if (!isspace((unsigned char)c))
+                elements += c;
+    }
+    return &create_record(doc, id, description, elements, is_protein_sequence(elements));
+};
+
+// A segment of a feature's location, with 1-based inclusive coordinates
+struct LocationSegment
+{
+    int start;
+    int end;
+    bool reverse;
+};
+
+// Parses a GenBank location, such as complement(join(1..10,20..>30)), into its segments. Partial bounds are read as
+// exact, and references to other records are skipped
+void parse_location(string location, bool reverse, vector<LocationSegment>& segments)
+{
+    location.erase(remove_if(location.begin(), location.end(), [](unsigned char c) { return isspace(c) != 0; }), location.end());
+    size_t i_open = location.find('(');
+    if (i_open != string::npos && location.back() == ')')
+    {
+        string op = location.substr(0, i_open);
+        string operands = location.substr(i_open + 1, location.size() - i_open - 2);
+        if (op == "complement")
+        {
+            parse_location(operands, !reverse, segments);
+            return;
+        }
+        if (op != "join" && op != "order")
+            throw SBOLError(SBOL_ERROR_PARSE, "Unsupported location operator " + op);
+
+        // Split the operands at the commas which are not nested in parentheses
+        int depth = 0;
+        size_t i_operand = 0;
+        for (size_t i_char = 0; i_char <= operands.size(); ++i_char)
+        {
+            if (i_char == operands.size() || (operands[i_char] == ',' && depth == 0))
+            {
+                parse_location(operands.substr(i_operand, i_char - i_operand), reverse, segments);
+                i_operand = i_char + 1;
+            }
+            else if (operands[i_char] == '(')
+                ++depth;
+            else if (operands[i_char] == ')')
+                --depth;
+        }
+        return;
+    }
+    if (location.find(':') != string::npos)
+        return;
+    location.erase(remove_if(location.begin(), location.end(), [](char c) { return c == '<' || c == '>'; }), location.end());
+    size_t i_range = location.find("..");
+    size_t i_site = location.find('^');
+    LocationSegment segment;
+    segment.reverse = reverse;
+    if (i_range != string::npos)
+    {
+        segment.start = stoi(location.substr(0, i_range));
+        segment.end = stoi(location.substr(i_range + 2));
+    }
+    else if (i_site != string::npos)
+    {
+        segment.start = stoi(location.substr(0, i_site));
+        segment.end = stoi(location.substr(i_site + 1));
+    }
+    else
+        segment.start = segment.end = stoi(location);
+    segments.push_back(segment);
+};
+
+// A feature of a GenBank record, as it is read
+struct GenBankFeature
+{
+    string key;
+    string location;
+    vector<pair<string, string>> qualifiers;
+};
+
+ComponentDefinition* SequenceFileReader::nextGenBank(Document& doc)
+{
+    // Find the LOCUS line which begins the next record
+    bool has_locus = false;
+    while (has_line || readLine())
+    {
+        has_line = false;
+        if (trim(line) == "")
+            continue;
+        if (line.compare(0, 5, "LOCUS") != 0)
+            throw SBOLError(SBOL_ERROR_PARSE, "Cannot read " + path + ". Expected the LOCUS line of GenBank record " + to_string(n_records + 1) + ", but found " + line.substr(0, 40));
+        has_locus = true;
+        break;
+    }
+    if (!has_locus)
+        return NULL;
+    vector<string> locus;
+    size_t i_token = 0;
+    while ((i_token = line.find_first_not_of(' ', i_token)) != string::npos)
+    {
+        size_t i_end = line.find(' ', i_token);
+        locus.push_back(line.substr(i_token, i_end - i_token));
+        i_token = i_end;
+    }
+    string id = locus.size() > 1 ? locus[1] : "";
+    bool is_protein = find(locus.begin(), locus.end(), "aa") != locus.end();
+    bool is_circular = find(locus.begin(), locus.end(), "circular") != locus.end();
+
+    // Read the sections of the record. Each begins with its keyword in the first column, and continues on indented lines
+    string section;
+    string description;
+    string elements;
+    vector<GenBankFeature> features;
+    bool is_complete = false;
+    while (readLine())
+    {
+        if (line.compare(0, 2, "//") == 0)
+        {
+            is_complete = true;
+            break;
+        }
+        if (line.size() && line[0] != ' ')
+        {
+            size_t i_space = line.find(' ');
+            section = line.substr(0, i_space);
+            if (section == "DEFINITION")
+                description = trim(line.substr(section.size()));
+            continue;
+        }
+        if (section == "DEFINITION")
+            description += " " + trim(line);
+        else if (section == "ORIGIN")
+        {
+            for (char c : line)
+                if (isalpha((unsigned char)c))
+                    elements += c;
+        }
+        else if (section == "FEATURES" && line.size() > 5)
+        {
+            if (line[5] != ' ')
+            {
+                // A new feature, with its key in column 6 and its location in column 22
+                GenBankFeature feature;
+                size_t i_space = line.find(' ', 5);
+                feature.key = line.substr(5, i_space - 5);
+                feature.location = i_space == string::npos ? "" : trim(line.substr(i_space));
+                features.push_back(feature);
+                continue;
+            }
+            if (features.empty())
+                continue;
+            GenBankFeature& feature = features.back();
+            string text = trim(line);
+            if (text.size() && text[0] == '/')
+            {
+                size_t i_equals = text.find('=');
+                string qualifier = text.substr(1, i_equals == string::npos ? string::npos : i_equals - 1);
+                string value = i_equals == string::npos ? "" : text.substr(i_equals + 1);
+                feature.qualifiers.push_back({ qualifier, value });
+            }
+            else if (feature.qualifiers.empty())
+                feature.location += text;
+            else
+                feature.qualifiers.back().second += (feature.qualifiers.back().first == "translation" ? "" : " ") + text;
+        }
+    }
+    if (!is_complete)
+        throw SBOLError(SBOL_ERROR_PARSE, "Cannot read " + path + ". GenBank record " + id + " is not terminated by //");
+
+    ComponentDefinition& cd = create_record(doc, id, description == "." ? "" : description, elements, is_protein);
+    if (!is_protein)
+        cd.types.add(is_circular ? SO_CIRCULAR : SO_LINEAR);
+
+    // Each feature, except the source feature which describes the whole record, becomes a SequenceAnnotation
+    int i_annotation = 0;
+    for (auto& feature : features)
+    {
+        if (feature.key == "source")
+            continue;
+        vector<LocationSegment> segments;
+        try
+        {
+            parse_location(feature.location, false, segments);
+        }
+        catch (std::exception&)
+        {
+            throw SBOLError(SBOL_ERROR_PARSE, "Cannot read " + path + ". The location " + feature.location + " of a " + feature.key + " feature in GenBank record " + id + " is invalid");
+        }
+        if (segments.empty())
+            continue;
+        SequenceAnnotation& annotation = cd.sequenceAnnotations.create("annotation" + to_string(i_annotation++));
+        string role = SO_MISC;
+        for (auto& feature_role : FEATURE_ROLES)
+            if (feature.key == feature_role.first)
+                role = feature_role.second;
+        annotation.roles.set(role);
+        for (auto& name_qualifier : NAME_QUALIFIERS)
+        {
+            auto i_qualifier = find_if(feature.qualifiers.begin(), feature.qualifiers.end(), [&name_qualifier](const pair<string, string>& qualifier) { return qualifier.first == name_qualifier; });
+            if (i_qualifier == feature.qualifiers.end())
+                continue;
+            string name = i_qualifier->second;
+            if (name.size() >= 2 && name[0] == '"' && name.back() == '"')
+                name = name.substr(1, name.size() - 2);
+            annotation.name.set(name);
+            break;
+        }
+        for (size_t i_segment = 0; i_segment < segments.size(); ++i_segment)
+        {
+            Range& range = annotation.locations.create<Range>("range" + to_string(i_segment));
+            range.start.set(segments[i_segment].start);
+            range.end.set(segments[i_segment].end);
+            range.orientation.set(segments[i_segment].reverse ? SBOL_ORIENTATION_REVERSE_COMPLEMENT : SBOL_ORIENTATION_INLINE);
+        }
+    }
+    return &cd;
+};
+
+SequenceFileWriter::SequenceFileWriter(std::string path, std::string language) :
+    file(path.c_str(), ios::out | ios::binary | ios::trunc),
+    path(path),
+    language(sequence_file_language(language)),
+    n_records(0)
+{
+    if (this->language == "")
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Cannot write " + language + " files. Only FASTA and GenBank are supported");
+    if (!file.is_open())
+        throw SBOLError(SBOL_ERROR_FILE_NOT_FOUND, "Cannot write " + path + ". The file could not be opened");
+};
+
+// Finds a Sequence which a ComponentDefinition refers to in its Document. The exact identity is looked up first, then the
+// reference is resolved as Document::find and Document::get resolve it, which accepts a persistentIdentity
+Sequence* find_sequence(ComponentDefinition& cd, const string& uri)
+{
+    if (!cd.doc || uri == "")
+        return NULL;
+    Document& doc = *cd.doc;
+    auto i_seq = doc.SBOLObjects.find(uri);
+    if (i_seq != doc.SBOLObjects.end())
+        return dynamic_cast<Sequence*>(i_seq->second);
+    if (Sequence* seq = dynamic_cast<Sequence*>(doc.find(uri)))
+        return seq;
+    try
+    {
+        return dynamic_cast<Sequence*>(&doc.get<Sequence>(uri));
+    }
+    catch (SBOLError&)
+    {
+        return NULL;
+    }
+};
+
+void SequenceFileWriter::write(ComponentDefinition& cd)
+{
+    Sequence* seq = cd.sequences.size() ? find_sequence(cd, cd.sequences.get()) : NULL;
+    if (!seq)
+        throw SBOLError(SBOL_ERROR_NOT_FOUND, "Cannot write " + cd.identity.get() + " to " + path + ". Its Sequence is not in the Document");
+    writeRecord(cd, *seq, &cd);
+};
+
+void SequenceFileWriter::write(Sequence& seq)
+{
+    writeRecord(seq, seq, NULL);
+};
+
+void SequenceFileWriter::writeRecord(Identified& record, Sequence& seq, ComponentDefinition* cd)
+{
+    if (language == "FASTA")
+        writeFASTA(record, seq);
+    else
+        writeGenBank(record, seq, cd);
+    if (!file)
+        throw SBOLError(SBOL_ERROR_SERIALIZATION, "Cannot write " + path + ". Writing failed after " + to_string(n_records) + " records");
+    ++n_records;
+};
+
+void SequenceFileWriter::close()
+{
+    if (!file.is_open())
+        return;
+    file.close();
+    if (file.fail())
+        throw SBOLError(SBOL_ERROR_SERIALIZATION, "Cannot write " + path + ". The file could not be closed");
+};
+
+void SequenceFileWriter::writeFASTA(Identified& record, Sequence& seq)
+{
+    string description = record.description.size() ? record.description.get() : "";
+    file << '>' << record.displayId.get() << (description == "" ? "" : " " + description) << '\n';
+    SequenceView elements = seq.view();
+    for (size_t i_line = 0; i_line < elements.size(); i_line += FASTA_LINE_LENGTH)
+        file << elements.subview(i_line, min(FASTA_LINE_LENGTH, elements.size() - i_line)).str() << '\n';
+};
+
+// Writes text after a 21 column indent, wrapping it at commas or spaces to fit in 80 columns
+void write_feature_text(ofstream& file, string text)
+{
+    const size_t width = 58;
+    while (text.size() > width)
+    {
+        size_t i_break = text.find_last_of(", ", width - 1);
+        i_break = (i_break == string::npos || i_break == 0) ? width : i_break + 1;
+        file << text.substr(0, i_break) << '\n' << string(21, ' ');
+        text = trim(text.substr(i_break));
+    }
+    file << text << '\n';
+};
+
+void SequenceFileWriter::writeGenBank(Identified& record, Sequence& seq, ComponentDefinition* cd)
+{
+    SequenceView elements = seq.view();
+    bool is_protein = seq.encoding.get() == SBOL_ENCODING_IUPAC_PROTEIN;
+    bool is_circular = cd && cd->types.find(SO_CIRCULAR);
+
+    // The date of the record is the date it was written
+    const char* months[] = { "JAN", "FEB", "MAR", "APR", "MAY", "JUN", "JUL", "AUG", "SEP", "OCT", "NOV", "DEC" };
+    time_t now = time(NULL);
+    tm* date = gmtime(&now);
+    char locus[128];
+    snprintf(locus, sizeof(locus), " %11lu %s    %-6s  %-8s UNK %02d-%s-%04d", (unsigned long)elements.size(), is_protein ? "aa" : "bp", is_protein ? "" : "DNA", is_circular ? "circular" : "linear", date->tm_mday, months[date->tm_mon], date->tm_year + 1900);
+
+    string display_id = record.displayId.get();
+    string description = record.description.size() ? record.description.get() : ".";
+    file << "LOCUS       " << display_id << string(display_id.size() < 16 ? 16 - display_id.size() : 0, ' ') << locus << '\n';
+    file << "DEFINITION  ";
+    while (description.size() > 68)
+    {
+        size_t i_break = description.find_last_of(' ', 67);
+        i_break = (i_break == string::npos || i_break == 0) ? 68 : i_break + 1;
+        file << description.substr(0, i_break) << '\n' << string(12, ' ');
+        description = trim(description.substr(i_break));
+    }
+    file << description << '\n';
+    file << "ACCESSION   " << display_id << '\n';
+    file << "VERSION     " << display_id << '\n';
+    file << "FEATURES             Location/Qualifiers\n";
+
+    // A Sequence alone has no features
+    if (cd)
+        writeFeatures(*cd);
+
+    // The elements are numbered in lines of 60, in blocks of 10
+    file << "ORIGIN\n";
+    char position[24];
+    for (size_t i_line = 0; i_line < elements.size(); i_line += GENBANK_LINE_LENGTH)
+    {
+        snprintf(position, sizeof(position), "%9lu", (unsigned long)i_line + 1);
+        file << position;
+        string line = elements.subview(i_line, min(GENBANK_LINE_LENGTH, elements.size() - i_line)).str();
+        for (size_t i_block = 0; i_block < line.size(); i_block += 10)
+            file << ' ' << line.substr(i_block, 10);
+        file << '\n';
+    }
+    file << "//\n";
+};
+
+// Writes a feature for each SequenceAnnotation located by Ranges, keyed by its role
+void SequenceFileWriter::writeFeatures(ComponentDefinition& cd)
+{
+    for (auto& annotation : cd.sequenceAnnotations)
+    {
+        vector<string> segments;
+        bool is_reverse = true;
+        for (auto& location : annotation.locations)
+        {
+            if (location.type != SBOL_RANGE)
+                continue;
+            Range& range = (Range&)location;
+            int start = range.start.get();
+            int end = range.end.get();
+            segments.push_back(start == end ? to_string(start) : to_string(start) + ".." + to_string(end));
+            if (range.orientation.get() != SBOL_ORIENTATION_REVERSE_COMPLEMENT)
+                is_reverse = false;
+        }
+        if (segments.empty())
+            continue;
+        string location = segments[0];
+        if (segments.size() > 1)
+        {
+            location = "join(" + segments[0];
+            for (size_t i_segment = 1; i_segment < segments.size(); ++i_segment)
+                location += "," + segments[i_segment];
+            location += ")";
+        }
+        if (is_reverse)
+            location = "complement(" + location + ")";
+        string key = "misc_feature";
+        for (auto& feature_role : FEATURE_ROLES)
+            if (annotation.roles.find(feature_role.second))
+                key = feature_role.first;
+        file << "     " << key << string(key.size() < 16 ? 16 - key.size() : 1, ' ');
+        write_feature_text(file, location);
+        string label = annotation.name.size() ? annotation.name.get() : annotation.displayId.get();
+        if (label.find_first_of(" \t\"") != string::npos)
+        {
+            label.erase(remove(label.begin(), label.end(), '"'), label.end());
+            label = "\"" + label + "\"";
+        }
+        file << string(21, ' ');
+        write_feature_text(file, "/label=" + label);
+    }
+};
+
+void Document::importFromFormat(std::string input_path, std::string language)
+{
+    SequenceFileReader reader(input_path, language);
+    while (reader.next(*this))
+        ;
+};
+
+void Document::exportToFormat(std::string language, std::string output_path)
+{
+    SequenceFileWriter writer(output_path, language);
+    unordered_set<Sequence*> written;
+    for (auto& cd : componentDefinitions)
+    {
+        if (!cd.sequences.size() || !find_sequence(cd, cd.sequences.get()))
+            continue;
+        writer.write(cd);
+        for (auto uri : cd.sequences)
+            written.insert(find_sequence(cd, uri));
+    }
+
+    // Sequences which no ComponentDefinition was written with get records of their own
+    for (auto& seq : sequences)
+        if (!written.count(&seq))
+            writer.write(seq);
+    writer.close();
+};
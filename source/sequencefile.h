@@ -0,0 +1,116 @@
+/**
+ * @file    sequencefile.h
+ * @brief   Streaming conversion between SBOL and the FASTA and GenBank file formats
+ * @author  Bryan Bartley
+ * @email   bartleyba@sbolstandard.org
+ *
+ * <!--------------------------------------------------------------------------
+ * This file is part of libSBOL.  Please visit http://sbolstandard.org for more
+ * information about SBOL, and the latest version of libSBOL.
+ *
+ *  Copyright 2016 University of Washington, WA, USA
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ------------------------------------------------------------------------->*/
+
+#ifndef SEQUENCE_FILE_INCLUDED
+#define SEQUENCE_FILE_INCLUDED
+
+#include "document.h"
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+namespace sbol
+{
+    /// Reads the records of a FASTA or GenBank file one at a time, converting each into a ComponentDefinition and its
+    /// Sequence. Only the record being read is held in memory, so files larger than memory can be converted by reading
+    /// records into a Document, writing or processing them, and then starting a new Document.
+    ///
+    /// A record's identifier becomes the displayId of its ComponentDefinition, with characters which are not allowed in a
+    /// displayId replaced by underscores, and its description becomes the description. The features of a GenBank record
+    /// become SequenceAnnotations, with a Range for each segment of the feature's location. The roles of common features,
+    /// such as CDS and promoter, are given by Sequence Ontology terms.
+    class SBOL_DECLSPEC SequenceFileReader
+    {
+    public:
+        /// @param path The file to read
+        /// @param language FASTA or GenBank. By default, the format is detected from the first line of the file
+        SequenceFileReader(std::string path, std::string language = "");
+
+        /// Read the next record and add it to a Document. If the Document already contains an object with the record's
+        /// displayId, a number is appended to make it unique.
+        /// @return The ComponentDefinition for the record, or NULL if there are no more records
+        ComponentDefinition* next(Document& doc);
+
+        /// @return The format of the file, FASTA or GenBank
+        std::string getLanguage() { return language; };
+
+        /// @return The number of records read so far
+        size_t size() { return n_records; };
+
+    private:
+        std::ifstream file;
+        std::string path;
+        std::string language;
+        std::string line;  // The line after the end of the last record read, if it has been read
+        bool has_line;
+        size_t n_records;
+
+        bool readLine();
+        ComponentDefinition* nextFASTA(Document& doc);
+        ComponentDefinition* nextGenBank(Document& doc);
+    };
+
+    /// Writes ComponentDefinitions and Sequences to a FASTA or GenBank file one record at a time, as they are written. A
+    /// record's elements are written from the ComponentDefinition's Sequence, which must be in its Document, without
+    /// unpacking them if they are packed. GenBank records include a feature for each SequenceAnnotation located by Ranges.
+    class SBOL_DECLSPEC SequenceFileWriter
+    {
+    public:
+        /// @param path The file to write, which is replaced
+        /// @param language FASTA or GenBank
+        SequenceFileWriter(std::string path, std::string language);
+
+        /// Append a record for a ComponentDefinition
+        void write(ComponentDefinition& cd);
+
+        /// Append a record for a Sequence alone, named by its displayId and described by its description
+        void write(Sequence& seq);
+
+        /// Finish writing the file. This is done when the writer is destroyed, but errors are only reported by close.
+        void close();
+
+        /// @return The number of records written so far
+        size_t size() { return n_records; };
+
+    private:
+        std::ofstream file;
+        std::string path;
+        std::string language;
+        size_t n_records;
+
+        void writeRecord(Identified& record, Sequence& seq, ComponentDefinition* cd);
+        void writeFASTA(Identified& record, Sequence& seq);
+        void writeGenBank(Identified& record, Sequence& seq, ComponentDefinition* cd);
+        void writeFeatures(ComponentDefinition& cd);
+    };
+
+    /// @cond
+    // Normalizes the name of a sequence file format to FASTA or GenBank, or returns an empty string if it is neither
+    std::string sequence_file_language(std::string language);
+    /// @endcond
+}
+
+#endif
@@ -0,0 +1,344 @@
+/**
+ * @file    sparql.cpp
+ * @brief   Incremental decoding of SPARQL query results
+ * @author  Bryan Bartley
+ * @email   bartleyba@sbolstandard.org
+ *
+ * <!--------------------------------------------------------------------------
+ * This file is part of libSBOL.  Please visit http://sbolstandard.org for more
+ * information about SBOL, and the latest version of libSBOL.
+ *
+ *  Copyright 2016 University of Washington, WA, USA
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ------------------------------------------------------------------------->*/
+
+#include "partshop.h"
+
+#include <cctype>
+
+using namespace sbol;
+using namespace std;
+
+int SPARQLResults::size()
+{
+    if (values.size() == 0)
+        return 0;
+    return (int)values[0].size();
+};
+
+int SPARQLResults::column(std::string variable)
+{
+    for (size_t i_variable = 0; i_variable < variables.size(); ++i_variable)
+        if (variables[i_variable] == variable)
+            return (int)i_variable;
+    throw SBOLError(SBOL_ERROR_NOT_FOUND, "The SPARQL results do not contain the variable " + variable);
+};
+
+std::string SPARQLResults::get(std::string variable, int i_row)
+{
+    if (i_row < 0 || i_row >= size())
+        throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Index out of range");
+    return values[column(variable)][i_row];
+};
+
+SPARQLDecoder::SPARQLDecoder(std::function<void(const std::vector<std::string>&, std::vector<SPARQLTerm>&)> on_row) :
+    boolean(false),
+    on_row(on_row),
+    i_term(-1),
+    state(VALUE),
+    string_is_key(false),
+    started(false),
+    code_unit(0),
+    high_surrogate(0),
+    n_hex_digits(0)
+{
+};
+
+// Appends a Unicode code point to a string in UTF-8
+void append_utf8(std::string& text, unsigned int code_point)
+{
+    if (code_point < 0x80)
+        text += (char)code_point;
+    else if (code_point < 0x800)
+    {
+        text += (char)(0xC0 | (code_point >> 6));
+        text += (char)(0x80 | (code_point & 0x3F));
+    }
+    else if (code_point < 0x10000)
+    {
+        text += (char)(0xE0 | (code_point >> 12));
+        text += (char)(0x80 | ((code_point >> 6) & 0x3F));
+        text += (char)(0x80 | (code_point & 0x3F));
+    }
+    else
+    {
+        text += (char)(0xF0 | (code_point >> 18));
+        text += (char)(0x80 | ((code_point >> 12) & 0x3F));
+        text += (char)(0x80 | ((code_point >> 6) & 0x3F));
+        text += (char)(0x80 | (code_point & 0x3F));
+    }
+};
+
+void SPARQLDecoder::decode(const char* data, size_t size)
+{
+    const char* c = data;
+    const char* end = data + size;
+    while (c < end)
+    {
+        switch (state)
+        {
+        case STRING:
+        {
+            // Copy runs of unescaped characters at once
+            const char* run = c;
+            while (c < end && *c != '"' && *c != '\\')
+                ++c;
+            token.append(run, c - run);
+            if (c == end)
+                return;
+            if (*c++ == '"')
+                endString();
+            else
+                state = ESCAPE;
+            break;
+        }
+        case ESCAPE:
+            switch (*c)
+            {
+            case '"':  token += '"'; break;
+            case '\\': token += '\\'; break;
+            case '/':  token += '/'; break;
+            case 'b':  token += '\b'; break;
+            case 'f':  token += '\f'; break;
+            case 'n':  token += '\n'; break;
+            case 'r':  token += '\r'; break;
+            case 't':  token += '\t'; break;
+            case 'u':
+                code_unit = 0;
+                n_hex_digits = 0;
+                break;
+            default:
+                throw SBOLError(SBOL_ERROR_PARSE, string("Invalid escape sequence \\") + *c + " in SPARQL results");
+            }
+            state = (*c == 'u') ? UNICODE : STRING;
+            ++c;
+            break;
+        case UNICODE:
+        {
+            char digit = *c++;
+            code_unit <<= 4;
+            if (digit >= '0' && digit <= '9')
+                code_unit |= digit - '0';
+            else if (digit >= 'a' && digit <= 'f')
+                code_unit |= digit - 'a' + 10;
+            else if (digit >= 'A' && digit <= 'F')
+                code_unit |= digit - 'A' + 10;
+            else
+                throw SBOLError(SBOL_ERROR_PARSE, "Invalid unicode escape sequence in SPARQL results");
+            if (++n_hex_digits < 4)
+                break;
+            state = STRING;
+            // Characters outside the basic multilingual plane are escaped as a pair of UTF-16 surrogates
+            if (code_unit >= 0xD800 && code_unit <= 0xDBFF)
+                high_surrogate = code_unit;
+            else if (code_unit >= 0xDC00 && code_unit <= 0xDFFF && high_surrogate)
+            {
+                append_utf8(token, 0x10000 + ((high_surrogate - 0xD800) << 10) + (code_unit - 0xDC00));
+                high_surrogate = 0;
+            }
+            else
+                append_utf8(token, code_unit);
+            break;
+        }
+        case LITERAL:
+            if (isalnum((unsigned char)*c) || *c == '-' || *c == '+' || *c == '.')
+                token += *c++;
+            else
+                endLiteral();  // The delimiter is decoded in the next state
+            break;
+        default:
+        {
+            char next = *c++;
+            if (next == ' ' || next == '\n' || next == '\r' || next == '\t')
+                break;
+            if (state == VALUE)
+            {
+                if (next == '{' || next == '[')
+                    openContainer(next == '{');
+                else if (frames.empty())
+                    throw SBOLError(SBOL_ERROR_PARSE, "SPARQL results must be a JSON object");
+                else if (next == '"')
+                {
+                    token.clear();
+                    string_is_key = false;
+                    state = STRING;
+                }
+                else if (next == ']')
+                    closeContainer(next);  // An empty array
+                else if (isalnum((unsigned char)next) || next == '-')
+                {
+                    token.assign(1, next);
+                    state = LITERAL;
+                }
+                else
+                    throw SBOLError(SBOL_ERROR_PARSE, string("Unexpected character ") + next + " in SPARQL results");
+            }
+            else if (state == KEY && next == '"')
+            {
+                token.clear();
+                string_is_key = true;
+                state = STRING;
+            }
+            else if (state == KEY && next == '}')
+                closeContainer(next);  // An empty object
+            else if (state == COLON && next == ':')
+                state = VALUE;
+            else if (state == AFTER_VALUE && !frames.empty() && next == ',')
+                state = frames.back().is_object ? KEY : VALUE;
+            else if (state == AFTER_VALUE && !frames.empty() && (next == '}' || next == ']'))
+                closeContainer(next);
+            else
+                throw SBOLError(SBOL_ERROR_PARSE, string("Unexpected character ") + next + " in SPARQL results");
+        }
+        }
+    }
+};
+
+void SPARQLDecoder::finish()
+{
+    if (state == LITERAL)
+        endLiteral();
+    if (!started || !frames.empty() || state != AFTER_VALUE)
+        throw SBOLError(SBOL_ERROR_PARSE, "The SPARQL results ended unexpectedly");
+};
+
+int SPARQLDecoder::variableIndex(const std::string& variable)
+{
+    for (size_t i_variable = 0; i_variable < variables.size(); ++i_variable)
+        if (variables[i_variable] == variable)
+            return (int)i_variable;
+    // Variables are usually listed in the head, but a solution may also introduce one
+    variables.push_back(variable);
+    row.resize(variables.size());
+    return (int)variables.size() - 1;
+};
+
+void SPARQLDecoder::openContainer(bool is_object)
+{
+    Role role = OTHER;
+    if (frames.empty())
+    {
+        if (started || !is_object)
+            throw SBOLError(SBOL_ERROR_PARSE, "SPARQL results must be a single JSON object");
+        role = ROOT;
+        started = true;
+    }
+    else
+    {
+        Frame& parent = frames.back();
+        const string& key = parent.key;
+        if (parent.role == ROOT && is_object && key == "head")
+            role = HEAD;
+        else if (parent.role == ROOT && is_object && key == "results")
+            role = RESULTS;
+        else if (parent.role == HEAD && !is_object && key == "vars")
+            role = VARS;
+        else if (parent.role == RESULTS && !is_object && key == "bindings")
+            role = BINDINGS;
+        else if (parent.role == BINDINGS && is_object)
+        {
+            // A new solution. Every variable is unbound until a term is decoded for it
+            role = BINDING;
+            row.resize(variables.size());
+            for (auto& term : row)
+            {
+                term.type = SPARQL_UNBOUND;
+                term.value.clear();
+                term.datatype.clear();
+                term.language.clear();
+            }
+        }
+        else if (parent.role == BINDING && is_object)
+        {
+            role = TERM;
+            i_term = variableIndex(key);
+        }
+    }
+    Frame frame;
+    frame.role = role;
+    frame.is_object = is_object;
+    frames.push_back(frame);
+    state = is_object ? KEY : VALUE;
+};
+
+void SPARQLDecoder::closeContainer(char bracket)
+{
+    if (frames.empty() || frames.back().is_object != (bracket == '}'))
+        throw SBOLError(SBOL_ERROR_PARSE, string("Unexpected character ") + bracket + " in SPARQL results");
+    Role role = frames.back().role;
+    frames.pop_back();
+    if (role == BINDING)
+        on_row(variables, row);
+    else if (role == TERM)
+        i_term = -1;
+    endValue();
+};
+
+void SPARQLDecoder::endString()
+{
+    high_surrogate = 0;
+    if (string_is_key)
+    {
+        frames.back().key.swap(token);
+        state = COLON;
+        return;
+    }
+    Frame& frame = frames.back();
+    if (frame.role == VARS)
+        variableIndex(token);
+    else if (frame.role == TERM)
+    {
+        SPARQLTerm& term = row[i_term];
+        if (frame.key == "value")
+            term.value.swap(token);  // The token takes over the old buffer, to be reused
+        else if (frame.key == "type")
+        {
+            if (token == "uri")
+                term.type = SPARQL_URI;
+            else if (token == "literal" || token == "typed-literal")
+                term.type = SPARQL_LITERAL;
+            else if (token == "bnode")
+                term.type = SPARQL_BNODE;
+        }
+        else if (frame.key == "datatype")
+            term.datatype.swap(token);
+        else if (frame.key == "xml:lang")
+            term.language.swap(token);
+    }
+    endValue();
+};
+
+void SPARQLDecoder::endLiteral()
+{
+    if (isalpha((unsigned char)token[0]) && token != "true" && token != "false" && token != "null")
+        throw SBOLError(SBOL_ERROR_PARSE, "Unexpected value " + token + " in SPARQL results");
+    if (frames.back().role == ROOT && frames.back().key == "boolean")
+        boolean = (token == "true");
+    endValue();
+};
+
+void SPARQLDecoder::endValue()
+{
+    state = AFTER_VALUE;
+};
@@ -97,6 +97,14 @@ namespace sbol
 
         void initialize(std::string uri);
 
+        /// Find the full provenance lineage of this object. See Document::getAncestors
+        /// @param type If specified, only TopLevel objects of this RDF type are returned
+        std::vector<std::string> getAncestors(std::string type = "");
+
+        /// Find all objects downstream of this object in the provenance graph. For an Activity, these are the objects it generated and their descendants. For an Agent or Plan, they are the Activities associated with it and everything those Activities generated. See Document::getDescendants
+        /// @param type If specified, only TopLevel objects of this RDF type are returned
+        std::vector<std::string> getDescendants(std::string type = "");
+
     };
     
 
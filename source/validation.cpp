@@ -25,6 +25,10 @@
 
 #include "sbol.h"
 #include <iostream>
+#include <unordered_set>
+#include <thread>
+#include <exception>
+#include <mutex>
 
 #ifndef SBOL_BUILD_MANYLINUX
 #include <regex>
@@ -63,7 +67,7 @@ void sbol::sbolRule10101(void *sbol_obj, void *arg)
         string ns = *i_ns;
         if(ns.compare(SBOL_URI "#") == 0) FOUND_NS = 1;
     }
-    if (!FOUND_NS) SBOLError(SBOL_ERROR_MISSING_NAMESPACE, "Missing namespace " SBOL_URI "#");
+    if (!FOUND_NS) throw SBOLError(SBOL_ERROR_MISSING_NAMESPACE, "Missing namespace " SBOL_URI "#");
 }
 
 /* An SBOL document MUST declare the use of the following XML namespace: http://www.w3.org/1999/02/22-rdf-syntax-ns#.*/
@@ -77,7 +81,7 @@ void sbol::sbolRule10102(void *sbol_obj, void *arg)
         string ns = *i_ns;
         if(ns.compare(RDF_URI) == 0) FOUND_NS = 1;
     }
-    if (!FOUND_NS) SBOLError(SBOL_ERROR_MISSING_NAMESPACE, "Missing namespace " RDF_URI);
+    if (!FOUND_NS) throw SBOLError(SBOL_ERROR_MISSING_NAMESPACE, "Missing namespace " RDF_URI);
 }
 
 /* The identity property of an Identified object MUST be globally unique. */
@@ -134,16 +138,16 @@ void sbol::libsbol_rule_1(void *sbol_obj, void *arg)
 void sbol::libsbol_rule_2(void *sbol_obj, void *arg)
 {
 #ifndef SBOL_BUILD_MANYLINUX
-		const char *c_date_time = (const char *)arg;
-		string date_time = string(c_date_time);
+		string date_time = *(string*)arg;
         if (date_time.compare("") != 0)
         {
             bool DATETIME_MATCH_1 = false;
             bool DATETIME_MATCH_2 = false;
             bool DATETIME_MATCH_3 = false;
-            std::regex date_time_1("([0-9]{4})-([0-9]{2})-([0-9]{2})([A-Z])?");
-            std::regex date_time_2("([0-9]{4})-([0-9]{2})-([0-9]{2})T([0-9]{2}):([0-9]{2}):([0-9]{2})([.][0-9]+)?[A-Z]?");
-            std::regex date_time_3("([0-9]{4})-([0-9]{2})-([0-9]{2})T([0-9]{2}):([0-9]{2}):([0-9]{2})([.][0-9]+)?[A-Z]?([\\+|-]([0-9]{2}):([0-9]{2}))?");
+            // Compiled once, as the rule is run for every timestamp that is set or validated
+            static const std::regex date_time_1("([0-9]{4})-([0-9]{2})-([0-9]{2})([A-Z])?");
+            static const std::regex date_time_2("([0-9]{4})-([0-9]{2})-([0-9]{2})T([0-9]{2}):([0-9]{2}):([0-9]{2})([.][0-9]+)?[A-Z]?");
+            static const std::regex date_time_3("([0-9]{4})-([0-9]{2})-([0-9]{2})T([0-9]{2}):([0-9]{2}):([0-9]{2})([.][0-9]+)?[A-Z]?([\\+|-]([0-9]{2}):([0-9]{2}))?");
             if (std::regex_match(date_time.begin(), date_time.end(), date_time_1))
                 DATETIME_MATCH_1 = true;
             if (std::regex_match(date_time.begin(), date_time.end(), date_time_2))
@@ -538,3 +542,578 @@ void sbol::libsbol_rule_24(void *sbol_obj, void *arg)
             asc.agent.set(activity.agent.get().identity.get());
     }
 };
+
+/* The local validator */
+
+void ValidationContext::report(std::string rule, std::string uri, std::string message)
+{
+    diagnostics.push_back({ rule, uri, message });
+};
+
+// The first value of a property, without the quotes of a literal or the brackets of a URI
+string property_value(SBOLObject& obj, rdf_type property)
+{
+    auto i_property = obj.properties.find(property);
+    if (i_property == obj.properties.end() || i_property->second.empty())
+        return "";
+    string value = i_property->second[0];
+    if (value.size() >= 2 && (value[0] == '"' || value[0] == '<'))
+        return value.substr(1, value.size() - 2);
+    return value;
+};
+
+// Runs one of the rules which throw an SBOLError on violation, and reports the violation instead
+void report_thrown(ValidationContext& context, std::string rule, std::string uri, ValidationRule check, void* sbol_obj, void* arg)
+{
+    try
+    {
+        check(sbol_obj, arg);
+    }
+    catch (SBOLError& e)
+    {
+        context.report(rule, uri, e.error_message());
+    }
+};
+
+void sbol::sbol_check_10101(void *sbol_obj, void *arg)
+{
+    report_thrown(*(ValidationContext*)arg, "sbol-10101", "", sbolRule10101, sbol_obj, NULL);
+};
+
+void sbol::sbol_check_10102(void *sbol_obj, void *arg)
+{
+    report_thrown(*(ValidationContext*)arg, "sbol-10102", "", sbolRule10102, sbol_obj, NULL);
+};
+
+/* The identity property of an Identified object MUST be globally unique. Objects are indexed by identity, so only
+child objects may share one */
+void sbol::sbol_check_10202(void *sbol_obj, void *arg)
+{
+    ValidationContext& context = *(ValidationContext*)arg;
+    unordered_set<string> identities;
+    for (auto obj : context.objects)
+    {
+        string uri = obj->identity.get();
+        if (uri != "" && !identities.insert(uri).second)
+            context.report("sbol-10202", uri, "The identity of an object must be unique within the Document");
+    }
+};
+
+/* ComponentInstance objects MUST NOT form a cyclical chain of references via their definition properties and the
+ComponentDefinition objects that contain them */
+void sbol::sbol_check_10603(void *sbol_obj, void *arg)
+{
+    ValidationContext& context = *(ValidationContext*)arg;
+    Document& doc = *context.doc;
+
+    // Search the definitions of the subcomponents depth first, marking those on the current path
+    enum Visit { UNVISITED, ON_PATH, DONE };
+    unordered_map<string, Visit> visits;
+    for (auto& i_obj : doc.SBOLObjects)
+    {
+        if (i_obj.second->type != SBOL_COMPONENT_DEFINITION || visits[i_obj.first] != UNVISITED)
+            continue;
+        vector<pair<SBOLObject*, size_t>> path = { { i_obj.second, 0 } };
+        visits[i_obj.first] = ON_PATH;
+        while (!path.empty())
+        {
+            SBOLObject* cd = path.back().first;
+            auto i_components = cd->owned_objects.find(SBOL_COMPONENTS);
+            if (i_components == cd->owned_objects.end() || path.back().second == i_components->second.size())
+            {
+                visits[cd->identity.get()] = DONE;
+                path.pop_back();
+                continue;
+            }
+            string definition = property_value(*i_components->second[path.back().second++], SBOL_DEFINITION);
+            auto i_definition = doc.SBOLObjects.find(definition);
+            if (i_definition == doc.SBOLObjects.end() || i_definition->second->type != SBOL_COMPONENT_DEFINITION)
+                continue;
+            Visit& visit = visits[definition];
+            if (visit == ON_PATH)
+                context.report("sbol-10603", cd->identity.get(), "ComponentDefinitions must not contain themselves through the definitions of their Components. The definition " + definition + " closes a cycle");
+            else if (visit == UNVISITED)
+            {
+                visit = ON_PATH;
+                path.push_back({ i_definition->second, 0 });
+            }
+        }
+    }
+};
+
+/* The identity property of an Identified object is REQUIRED and MUST contain a URI */
+void sbol::sbol_check_10201(void *sbol_obj, void *arg)
+{
+    SBOLObject& obj = *(SBOLObject*)sbol_obj;
+    string uri = obj.identity.get();
+    if (uri.find(':') == string::npos)
+        ((ValidationContext*)arg)->report("sbol-10201", uri, "The identity of an object must be a URI");
+};
+
+void sbol::sbol_check_10204(void *sbol_obj, void *arg)
+{
+    SBOLObject& obj = *(SBOLObject*)sbol_obj;
+    string display_id = property_value(obj, SBOL_DISPLAY_ID);
+    if (display_id != "")
+        report_thrown(*(ValidationContext*)arg, "sbol-10204", obj.identity.get(), sbol_rule_10204, sbol_obj, &display_id);
+};
+
+/* The version property of an Identified object is OPTIONAL and MAY contain a String that MUST be composed of only
+alphanumeric characters, underscores, hyphens, or periods and MUST begin with a digit */
+void sbol::sbol_check_10206(void *sbol_obj, void *arg)
+{
+    SBOLObject& obj = *(SBOLObject*)sbol_obj;
+    string version = property_value(obj, SBOL_VERSION);
+    if (version == "")
+        return;
+    bool valid = version[0] >= '0' && version[0] <= '9';
+    for (auto c : version)
+        if (is_not_alphanumeric_or_underscore(c) && c != '-' && c != '.')
+            valid = false;
+    if (!valid)
+        ((ValidationContext*)arg)->report("sbol-10206", obj.identity.get(), "Version " + version + " is invalid. Versions must begin with a digit, and contain only alphanumeric characters, underscores, hyphens or periods");
+};
+
+/* The encoding property of a Sequence is REQUIRED and MUST contain a URI */
+void sbol::sbol_check_10403(void *sbol_obj, void *arg)
+{
+    SBOLObject& obj = *(SBOLObject*)sbol_obj;
+    if (obj.type == SBOL_SEQUENCE && property_value(obj, SBOL_ENCODING) == "")
+        ((ValidationContext*)arg)->report("sbol-10403", obj.identity.get(), "A Sequence must specify its encoding");
+};
+
+/* The type property of a ComponentDefinition is REQUIRED and MUST contain a non-empty set of URIs */
+void sbol::sbol_check_10502(void *sbol_obj, void *arg)
+{
+    SBOLObject& obj = *(SBOLObject*)sbol_obj;
+    if (obj.type == SBOL_COMPONENT_DEFINITION && property_value(obj, SBOL_TYPES) == "")
+        ((ValidationContext*)arg)->report("sbol-10502", obj.identity.get(), "A ComponentDefinition must specify at least one type");
+};
+
+/* The definition property of a ComponentInstance is REQUIRED and MUST contain a URI. When the Document is checked for
+completeness, the ComponentDefinition which it refers to must be in the Document too */
+void sbol::sbol_check_10602(void *sbol_obj, void *arg)
+{
+    SBOLObject& obj = *(SBOLObject*)sbol_obj;
+    if (obj.type != SBOL_COMPONENT && obj.type != SBOL_FUNCTIONAL_COMPONENT)
+        return;
+    ValidationContext& context = *(ValidationContext*)arg;
+    string definition = property_value(obj, SBOL_DEFINITION);
+    if (definition == "")
+        context.report("sbol-10602", obj.identity.get(), "A " + parseClassName(obj.type) + " must specify its definition");
+    else if (context.check_completeness && context.doc->SBOLObjects.find(definition) == context.doc->SBOLObjects.end())
+        context.report("sbol-10604", obj.identity.get(), "The definition " + definition + " is not in the Document");
+};
+
+// The rules of the local validator, in the order in which they are reported
+ValidationRules document_rules = { sbol_check_10101, sbol_check_10102, sbol_check_10202, sbol_check_10603 };
+ValidationRules object_rules = { sbol_check_10201, sbol_check_10204, sbol_check_10206, sbol_check_10403, sbol_check_10502, sbol_check_10602 };
+
+void collect_objects(SBOLObject& obj, vector<SBOLObject*>& objects)
+{
+    objects.push_back(&obj);
+    for (auto& i_store : obj.owned_objects)
+        for (auto child : i_store.second)
+            collect_objects(*child, objects);
+};
+
+std::vector<std::string> sbol::validate_locally(Document& doc)
+{
+    ValidationContext context(doc);
+    for (auto& i_obj : doc.SBOLObjects)
+        collect_objects(*i_obj.second, context.objects);
+    for (auto rule : document_rules)
+        rule(&doc, &context);
+    for (auto obj : context.objects)
+        for (auto rule : object_rules)
+            rule(obj, &context);
+    vector<string> errors;
+    for (auto& diagnostic : context.diagnostics)
+        errors.push_back(diagnostic.rule + ": " + diagnostic.message + (diagnostic.uri == "" ? "" : " (" + diagnostic.uri + ")"));
+    return errors;
+};
+
+/* Rules which guard or synchronize the change made by a setter are not run on stored values. The rules for sbol-10202
+and sbol-10204 are covered by the local validator, which checks uniqueness against the other objects rather than the
+Document's index */
+bool sbol::checks_stored_values(ValidationRule rule)
+{
+    return rule != sbol_rule_10202 && rule != sbol_rule_10204 && rule != libsbol_rule_1 && rule != libsbol_rule_19 &&
+        rule != libsbol_rule_20 && rule != libsbol_rule_21;
+};
+
+// The identifier of the rule cited by an error message, eg, sbol-10204, else the default
+string cited_rule(const string& message, const string& default_rule)
+{
+    for (size_t i_cite = message.find("sbol-"); i_cite != string::npos; i_cite = message.find("sbol-", i_cite + 1))
+    {
+        size_t i_end = i_cite + 5;
+        while (i_end < message.size() && isdigit((unsigned char)message[i_end]))
+            ++i_end;
+        if (i_end > i_cite + 5)
+            return message.substr(i_cite, i_end - i_cite);
+    }
+    return default_rule;
+};
+
+// The rules of each class, by the RDF type of the class when its first Property registered rules. The rules of a class
+// are never removed, so objects may keep a pointer to them
+struct PropertyRuleRegistry
+{
+    std::mutex lock;
+    unordered_map<rdf_type, ClassPropertyRules> classes;
+};
+
+PropertyRuleRegistry& property_rule_registry()
+{
+    static PropertyRuleRegistry registry;
+    return registry;
+};
+
+// The registrations which the calling thread has already made. Registered rules are never removed, so a thread which
+// constructs another object of a known class finds its rules here without taking the registry's lock
+struct KnownPropertyRules
+{
+    unordered_map<rdf_type, ClassPropertyRules*> classes;  // By the RDF type of the class
+    unordered_map<const ClassPropertyRules*, unordered_map<rdf_type, vector<ValidationRules>>> registered;  // By class, then by property
+};
+
+void sbol::register_property_rules(ClassPropertyRules*& class_rules, const rdf_type& owner_type, const rdf_type& property, PropertyValueKind kind, const ValidationRules& rules)
+{
+    static thread_local KnownPropertyRules known;
+    if (!class_rules)
+    {
+        auto i_class = known.classes.find(owner_type);
+        if (i_class != known.classes.end())
+            class_rules = i_class->second;
+    }
+    if (class_rules)
+    {
+        auto i_class = known.registered.find(class_rules);
+        if (i_class != known.registered.end())
+        {
+            auto i_property = i_class->second.find(property);
+            if (i_property != i_class->second.end() && std::find(i_property->second.begin(), i_property->second.end(), rules) != i_property->second.end())
+                return;
+        }
+    }
+
+    PropertyRuleRegistry& registry = property_rule_registry();
+    {
+        lock_guard<std::mutex> lock(registry.lock);
+        if (!class_rules)
+            class_rules = &registry.classes[owner_type];
+        auto i_rules = class_rules->find(property);
+        if (i_rules == class_rules->end())
+        {
+            i_rules = class_rules->insert({ property, PropertyRules() }).first;
+            i_rules->second.kind = kind;
+        }
+        ValidationRules& registered = i_rules->second.rules;
+        for (auto rule : rules)
+            if (std::find(registered.begin(), registered.end(), rule) == registered.end())
+                registered.push_back(rule);
+    }
+    known.classes.insert({ owner_type, class_rules });
+    known.registered[class_rules][property].push_back(rules);
+};
+
+bool sbol::find_property_rules(const ClassPropertyRules* class_rules, const rdf_type& property, PropertyRules& property_rules)
+{
+    if (!class_rules)
+        return false;
+    PropertyRuleRegistry& registry = property_rule_registry();
+    lock_guard<std::mutex> lock(registry.lock);
+    auto i_rules = class_rules->find(property);
+    if (i_rules == class_rules->end())
+        return false;
+    property_rules = i_rules->second;
+    return true;
+};
+
+// Copies the rules of the class of each object, so that they can be read without the lock of the registry
+unordered_map<const ClassPropertyRules*, ClassPropertyRules> copy_class_rules(const vector<SBOLObject*>& objects)
+{
+    unordered_map<const ClassPropertyRules*, ClassPropertyRules> copies;
+    PropertyRuleRegistry& registry = property_rule_registry();
+    lock_guard<std::mutex> lock(registry.lock);
+    for (auto obj : objects)
+        if (obj->property_rules && !copies.count(obj->property_rules))
+            copies[obj->property_rules] = *obj->property_rules;
+    return copies;
+};
+
+// Runs the rules registered by a Property on each of its stored values, and returns the number of rules run. Violations
+// are reported to the context, or thrown if there is none
+size_t check_stored_values(SBOLObject& obj, const rdf_type& property, const PropertyRules& property_rules, ValidationContext* context)
+{
+    size_t n_checks = 0;
+    auto i_store = obj.properties.find(property);
+    if (property_rules.kind == OBJECT_VALUE || i_store == obj.properties.end())
+        return n_checks;
+    string uri = property_value(obj, SBOL_IDENTITY);
+    for (auto& stored_value : i_store->second)
+    {
+        string text_value = stored_value.size() >= 2 ? stored_value.substr(1, stored_value.size() - 2) : "";
+        if (text_value == "")
+            continue;
+        int int_value = 0;
+        double float_value = 0;
+        void* arg = &text_value;
+        try
+        {
+            if (property_rules.kind == INT_VALUE)
+            {
+                int_value = stoi(text_value);
+                arg = &int_value;
+            }
+            else if (property_rules.kind == FLOAT_VALUE)
+            {
+                float_value = stod(text_value);
+                arg = &float_value;
+            }
+        }
+        catch (std::exception&)
+        {
+            if (!context)
+                throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "The value " + text_value + " of " + property + " is not a number");
+            context->report(property, uri, "The value " + text_value + " is not a number");
+            continue;
+        }
+        for (auto rule : property_rules.rules)
+        {
+            if (!checks_stored_values(rule))
+                continue;
+            ++n_checks;
+            if (!context)
+            {
+                rule(&obj, arg);
+                continue;
+            }
+            try
+            {
+                rule(&obj, arg);
+            }
+            catch (SBOLError& e)
+            {
+                context->report(cited_rule(e.error_message(), property), uri, e.error_message());
+            }
+        }
+    }
+    return n_checks;
+};
+
+#if defined(SBOL_BUILD_PYTHON2) || defined(SBOL_BUILD_PYTHON3)
+// Runs the rules defined in Python for a Property, which are passed the Property, as when a value is set. Returns the
+// number of rules run. Violations are reported to the context, or thrown if there is none
+size_t check_python_rules(SBOLObject& obj, const rdf_type& property, const vector<pair<PyObject*, PyObject*>>& python_rules, ValidationContext* context)
+{
+    for (auto& rule : python_rules)
+    {
+        PyObject* py_tuple = PyTuple_New(1);
+        Py_INCREF(rule.second);
+        PyTuple_SetItem(py_tuple, 0, rule.second);
+        PyObject* result = PyObject_CallObject(rule.first, py_tuple);
+        Py_DECREF(py_tuple);
+        Py_XDECREF(result);
+        if (PyErr_Occurred() != NULL)
+        {
+            PyErr_Clear();
+            if (!context)
+                throw SBOLError(SBOL_ERROR_INVALID_ARGUMENT, "Validation failed.");
+            context->report(property, property_value(obj, SBOL_IDENTITY), "Validation failed.");
+        }
+    }
+    return python_rules.size();
+};
+#endif
+
+ValidationReport Document::validateAll(int n_threads)
+{
+    ValidationReport report;
+    ValidationContext context(*this);
+    for (auto& i_obj : SBOLObjects)
+        collect_objects(*i_obj.second, context.objects);
+    for (auto rule : document_rules)
+        rule(this, &context);
+    report.checks = document_rules.size();
+    report.diagnostics.swap(context.diagnostics);
+
+    // Each worker checks a contiguous block of objects and reports to its own context, so the diagnostics are merged in
+    // the order of the objects however many workers there are
+    if (n_threads < 1)
+        n_threads = 1;
+    vector<SBOLObject*>& objects = context.objects;
+    unordered_map<const ClassPropertyRules*, ClassPropertyRules> class_rules = copy_class_rules(objects);
+    size_t block_size = (objects.size() + n_threads - 1) / n_threads;
+    vector<ValidationContext> block_contexts(n_threads, ValidationContext(*this));
+    vector<size_t> block_checks(n_threads, 0);
+    vector<exception_ptr> errors(n_threads);
+    vector<thread> workers;
+    for (int i_thread = 0; i_thread < n_threads; ++i_thread)
+    {
+        size_t i_begin = i_thread * block_size;
+        size_t i_end = min(objects.size(), i_begin + block_size);
+        if (i_begin >= i_end)
+            break;
+        auto check_block = [&objects, &class_rules, &block_contexts, &block_checks, &errors, i_thread, i_begin, i_end]()
+        {
+            try
+            {
+                ValidationContext& block_context = block_contexts[i_thread];
+                for (size_t i_obj = i_begin; i_obj < i_end; ++i_obj)
+                {
+                    for (auto rule : object_rules)
+                        rule(objects[i_obj], &block_context);
+                    block_checks[i_thread] += object_rules.size();
+                    if (!objects[i_obj]->property_rules)
+                        continue;
+                    for (auto& i_rules : class_rules.at(objects[i_obj]->property_rules))
+                        block_checks[i_thread] += check_stored_values(*objects[i_obj], i_rules.first, i_rules.second, &block_context);
+                }
+            }
+            catch (...)
+            {
+                errors[i_thread] = current_exception();
+            }
+        };
+        if (n_threads == 1)
+            check_block();
+        else
+            workers.push_back(thread(check_block));
+    }
+    for (auto& worker : workers)
+        worker.join();
+    for (auto& error : errors)
+        if (error)
+            rethrow_exception(error);
+    for (int i_thread = 0; i_thread < n_threads; ++i_thread)
+    {
+        auto& diagnostics = block_contexts[i_thread].diagnostics;
+        report.diagnostics.insert(report.diagnostics.end(), diagnostics.begin(), diagnostics.end());
+        report.checks += block_checks[i_thread];
+    }
+
+#if defined(SBOL_BUILD_PYTHON2) || defined(SBOL_BUILD_PYTHON3)
+    // Rules defined in Python are run afterwards on the calling thread, which holds the interpreter lock
+    for (auto obj : objects)
+        for (auto& i_rules : obj->python_rules)
+            report.checks += check_python_rules(*obj, i_rules.first, i_rules.second, &context);
+    report.diagnostics.insert(report.diagnostics.end(), context.diagnostics.begin(), context.diagnostics.end());
+#endif
+    return report;
+};
+
+// The innermost deferral on the current thread. Deferrals on a thread are linked from inner to outer
+DeferredValidation*& innermost_deferral()
+{
+    static thread_local DeferredValidation* deferral = NULL;
+    return deferral;
+};
+
+DeferredValidation::DeferredValidation(Document& doc) :
+    doc(&doc),
+    outer(innermost_deferral()),
+    closed(false)
+{
+    innermost_deferral() = this;
+};
+
+DeferredValidation::~DeferredValidation() noexcept(false)
+{
+    if (std::uncaught_exception())
+        discard();
+    else
+        close();
+};
+
+DeferredValidation* DeferredValidation::active()
+{
+    return innermost_deferral();
+};
+
+bool DeferredValidation::record(SBOLObject* owner, const std::string& property)
+{
+    if (owner->doc && owner->doc != doc)
+        return outer && outer->record(owner, property);
+    auto i_obj = changed_properties.find(owner);
+    if (i_obj == changed_properties.end())
+    {
+        changed_objects.push_back(owner);
+        changed_properties[owner].push_back(property);
+    }
+    else if (std::find(i_obj->second.begin(), i_obj->second.end(), property) == i_obj->second.end())
+        i_obj->second.push_back(property);
+    return true;
+};
+
+void DeferredValidation::forget(SBOLObject* owner)
+{
+    for (DeferredValidation* deferral = innermost_deferral(); deferral; deferral = deferral->outer)
+        deferral->changed_properties.erase(owner);
+};
+
+size_t DeferredValidation::size()
+{
+    size_t n_properties = 0;
+    for (auto& i_obj : changed_properties)
+        n_properties += i_obj.second.size();
+    return n_properties;
+};
+
+void DeferredValidation::flush()
+{
+    // The changes are taken before the rules run, so that any values the rules set are recorded for the next flush
+    vector<SBOLObject*> objects;
+    unordered_map<SBOLObject*, vector<string>> properties;
+    objects.swap(changed_objects);
+    properties.swap(changed_properties);
+    for (auto obj : objects)
+    {
+        // Objects which were destroyed were forgotten. An object created at the same address is checked once
+        auto i_obj = properties.find(obj);
+        if (i_obj == properties.end())
+            continue;
+        for (auto& property : i_obj->second)
+        {
+            PropertyRules property_rules;
+            if (find_property_rules(obj->property_rules, property, property_rules))
+                check_stored_values(*obj, property, property_rules, NULL);
+#if defined(SBOL_BUILD_PYTHON2) || defined(SBOL_BUILD_PYTHON3)
+            auto i_python_rules = obj->python_rules.find(property);
+            if (i_python_rules != obj->python_rules.end())
+                check_python_rules(*obj, property, i_python_rules->second, NULL);
+#endif
+        }
+        properties.erase(i_obj);
+    }
+};
+
+void DeferredValidation::close()
+{
+    if (closed)
+        return;
+    deactivate();
+    flush();
+};
+
+void DeferredValidation::discard()
+{
+    deactivate();
+    changed_objects.clear();
+    changed_properties.clear();
+};
+
+void DeferredValidation::deactivate()
+{
+    if (closed)
+        return;
+    closed = true;
+
+    // Deferrals closed out of order, as from Python, are unlinked wherever they are in the chain
+    DeferredValidation** link = &innermost_deferral();
+    while (*link && *link != this)
+        link = &(*link)->outer;
+    if (*link)
+        *link = outer;
+};
@@ -27,6 +27,8 @@
 #define VALIDATION_RULE_INCLUDED
 
 #include <vector>
+#include <string>
+#include <unordered_map>
 #include "config.h"
 
 typedef void(*ValidationRule)(void *, void *);  // This defines the signature for validation rules.  The first argument is an SBOLObject, and the second argument is arbitrary data passed through to the handler function for validation
@@ -103,6 +105,125 @@ namespace sbol
     SBOL_DECLSPEC void libsbol_rule_24(void *sbol_obj, void *arg);
 
 
+/* The local validator checks a Document against these rules of the SBOL 2.0 specification on the object model, without
+serializing it. Each rule reports its violations to the ValidationContext passed as its second argument */
+
+    class Document;
+    class SBOLObject;
+
+    /// A violation of a validation rule, as reported by Document::validateAll
+    struct SBOL_DECLSPEC ValidationDiagnostic
+    {
+        std::string rule;       ///< The identifier of the rule, eg, sbol-10204. Rules of a Property which do not name one are identified by the URI of the Property
+        std::string uri;        ///< The identity of the object which violates the rule, or an empty string if the rule applies to the whole Document
+        std::string message;    ///< A description of the violation
+    };
+
+    /// The result of Document::validateAll
+    struct SBOL_DECLSPEC ValidationReport
+    {
+        std::vector<ValidationDiagnostic> diagnostics;  ///< Every violation found, in the order of the objects of the Document
+        size_t checks = 0;                              ///< The number of times a rule was run on an object or property value
+
+        /// @return True if no violations were found
+        bool valid() const { return diagnostics.empty(); };
+    };
+
+    /// Defers the validation rules of Properties while it is in scope, to speed the construction of large Documents. Rather
+    /// than checking each value as it is set, the rules of each Property which was changed are run once when the scope
+    /// ends, against its final values, so a Property which is set repeatedly is checked only once. Rules which guard or
+    /// synchronize a change, such as those which keep the sequence and sequences of a ComponentDefinition in step, still
+    /// run when the value is set. Deferral applies to the objects of the Document, and to new objects which are not yet in
+    /// any Document, when they are changed on the thread which began the deferral.
+    class SBOL_DECLSPEC DeferredValidation
+    {
+    public:
+        /// Begin deferring validation. Deferrals may be nested, in which case each runs the rules it deferred
+        /// @param doc The Document under construction
+        DeferredValidation(Document& doc);
+
+        /// End the deferral, as close does. If the scope is left by an exception, the deferred rules are discarded instead
+        ~DeferredValidation() noexcept(false);
+
+        /// Run the rules deferred so far. Deferral continues afterwards.
+        /// @throw SBOLError for the first violation found, as the setter would have. The remaining rules are not run
+        void flush();
+
+        /// End the deferral and run the deferred rules. Values set afterwards are validated immediately.
+        /// @throw SBOLError for the first violation found, as the setter would have
+        void close();
+
+        /// End the deferral without running the deferred rules
+        void discard();
+
+        /// @return The number of changed Properties whose rules have not yet been run
+        size_t size();
+
+        /// @cond
+        // The innermost deferral on this thread, or NULL
+        static DeferredValidation* active();
+        // Marks a Property as changed, if its owner is covered by this deferral or one it is nested in
+        bool record(SBOLObject* owner, const std::string& property);
+        // Discards the changes recorded for an object which is being destroyed
+        static void forget(SBOLObject* owner);
+        /// @endcond
+
+    private:
+        Document* doc;
+        DeferredValidation* outer;
+        bool closed;
+        std::vector<SBOLObject*> changed_objects;  // In the order in which they were first changed
+        std::unordered_map<SBOLObject*, std::vector<std::string>> changed_properties;
+
+        void deactivate();  // Stops recording changes
+        DeferredValidation(const DeferredValidation&) = delete;
+        DeferredValidation& operator=(const DeferredValidation&) = delete;
+    };
+
+    /// @cond
+    // The state of a local validation, which is shared by its rules
+    class SBOL_DECLSPEC ValidationContext
+    {
+    public:
+        Document* doc;
+        std::vector<SBOLObject*> objects;  // Every object of the Document, including child objects
+        std::vector<ValidationDiagnostic> diagnostics;
+        bool check_completeness;  // Whether referenced objects must be in the Document
+
+        ValidationContext(Document& doc) :
+            doc(&doc),
+            check_completeness(Config::getOption("check_completeness") == "True")
+        {
+        };
+
+        // Records a violation of a rule by an object
+        void report(std::string rule, std::string uri, std::string message);
+    };
+
+    // Rules applied once to a Document, which is their first argument
+    SBOL_DECLSPEC void sbol_check_10101(void *sbol_obj, void *arg);
+    SBOL_DECLSPEC void sbol_check_10102(void *sbol_obj, void *arg);
+    SBOL_DECLSPEC void sbol_check_10202(void *sbol_obj, void *arg);
+    SBOL_DECLSPEC void sbol_check_10603(void *sbol_obj, void *arg);
+
+    // Rules applied to each object of a Document, which is their first argument
+    SBOL_DECLSPEC void sbol_check_10201(void *sbol_obj, void *arg);
+    SBOL_DECLSPEC void sbol_check_10204(void *sbol_obj, void *arg);
+    SBOL_DECLSPEC void sbol_check_10206(void *sbol_obj, void *arg);
+    SBOL_DECLSPEC void sbol_check_10403(void *sbol_obj, void *arg);
+    SBOL_DECLSPEC void sbol_check_10502(void *sbol_obj, void *arg);
+    SBOL_DECLSPEC void sbol_check_10602(void *sbol_obj, void *arg);
+
+    // Whether a rule of a Property checks each value, rather than guarding or synchronizing the change made by a setter.
+    // Document::validateAll runs these rules on the values already in the store
+    bool checks_stored_values(ValidationRule rule);
+    /// @endcond
+
+    /// Check a Document against the rules of the SBOL specification which the local validator implements. Unlike the
+    /// online validator, no request is made and the Document is not serialized.
+    /// @return A description of each violation, beginning with the identifier of its rule, eg, sbol-10204
+    SBOL_DECLSPEC std::vector<std::string> validate_locally(Document& doc);
+
     bool is_alphanumeric_or_underscore(char c);
     
     bool is_not_alphanumeric_or_underscore(char c);
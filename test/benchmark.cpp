@@ -0,0 +1,1018 @@
+#define RAPTOR_STATIC
+
+#include "sbol.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <future>
+#include <unordered_map>
+#include <sstream>
+#include <memory>
+
+#ifndef _WIN32
+#include "mock_server.h"
+#include "mock_synbiohub.h"
+#include <sys/resource.h>
+#include <fstream>
+#include <algorithm>
+#endif
+
+using namespace std;
+using namespace sbol;
+
+
+// Returns a pseudo-random nucleotide sequence, reproducible between runs
+string random_sequence(int length, unsigned int seed = 1)
+{
+    const char nucleotides[] = "acgt";
+    string sequence(length, 'a');
+    for (int i = 0; i < length; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        sequence[i] = nucleotides[(seed >> 16) & 3];
+    }
+    return sequence;
+}
+
+double elapsed_ms(chrono::steady_clock::time_point t_start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - t_start).count();
+}
+
+void report(string benchmark, int size, double ms)
+{
+    cout << benchmark << "\t" << size << "\t" << ms << " ms" << endl;
+}
+
+// Disassembles a flat ComponentDefinition with the given number of annotated features. Every fifth feature encloses the
+// next two, and the features are separated by unannotated gaps, so the benchmark exercises nesting and gap filling.
+void benchmark_disassemble(int n_features)
+{
+    Document doc;
+    const int feature_length = 20;
+    const int gap_length = 5;
+    ComponentDefinition& cd = doc.componentDefinitions.create("flat");
+    Sequence& seq = doc.sequences.create("flat_seq");
+    seq.elements.set(random_sequence(n_features * (feature_length + gap_length)));
+    cd.sequences.set(seq);
+
+    int start = 1;
+    for (int i_feature = 1; i_feature <= n_features; ++i_feature)
+    {
+        SequenceAnnotation& ann = cd.sequenceAnnotations.create("annotation" + to_string(i_feature));
+        ann.name.set("feature " + to_string(i_feature));
+        Range& r = ann.locations.create<Range>("range" + to_string(i_feature));
+        if (i_feature % 5 == 1 && i_feature + 2 <= n_features)
+        {
+            // An enclosing feature spanning the next two
+            r.start.set(start);
+            r.end.set(start + 2 * (feature_length + gap_length) - 1);
+            continue;
+        }
+        r.start.set(start);
+        r.end.set(start + feature_length - 1);
+        start += feature_length + gap_length;
+    }
+
+    auto t_start = chrono::steady_clock::now();
+    cd.disassemble();
+    report("disassemble", n_features, elapsed_ms(t_start));
+}
+
+// Builds a layered hierarchy in which every ComponentDefinition in a layer instantiates every ComponentDefinition in the
+// layer below, so the number of Component instances grows exponentially with depth while the number of definitions does
+// not. Compares traversal of every instance with traversal of the distinct definitions.
+void benchmark_hierarchy(int n_layers)
+{
+    Document doc;
+    const int width = 3;
+    vector<ComponentDefinition*> layer;
+    for (int i_layer = n_layers; i_layer >= 0; --i_layer)
+    {
+        vector<ComponentDefinition*> next_layer;
+        int n_cdefs = i_layer == 0 ? 1 : width;
+        for (int i_cdef = 0; i_cdef < n_cdefs; ++i_cdef)
+        {
+            ComponentDefinition& cd = doc.componentDefinitions.create("cd_" + to_string(i_layer) + "_" + to_string(i_cdef));
+            for (int i_sub = 0; i_sub < (int)layer.size(); ++i_sub)
+            {
+                Component& c = cd.components.create("component" + to_string(i_sub));
+                c.definition.set(layer[i_sub]->identity.get());
+            }
+            next_layer.push_back(&cd);
+        }
+        layer = next_layer;
+    }
+    ComponentDefinition& root = *layer[0];
+
+    auto t_start = chrono::steady_clock::now();
+    int n_instances = root.applyToComponentHierarchy().size();
+    report("hierarchy (" + to_string(n_instances) + " instances)", n_layers, elapsed_ms(t_start));
+
+    t_start = chrono::steady_clock::now();
+    int n_unique = root.applyToUniqueComponentHierarchy().size();
+    report("unique hierarchy (" + to_string(n_unique) + " definitions)", n_layers, elapsed_ms(t_start));
+}
+
+// Checks the regularity of a library of designs which share the same parts. The first pass populates the Document's
+// verification cache; the second pass should reuse it, and the third re-checks only the design that was edited.
+void benchmark_regularity(int n_designs)
+{
+    Document doc;
+    const int n_parts = 10;
+    const int part_length = 50;
+    vector<ComponentDefinition*> parts;
+    for (int i_part = 0; i_part < n_parts; ++i_part)
+    {
+        ComponentDefinition& part = doc.componentDefinitions.create("part" + to_string(i_part));
+        Sequence& seq = doc.sequences.create("part" + to_string(i_part) + "_seq");
+        seq.elements.set(random_sequence(part_length, i_part + 1));
+        part.sequences.set(seq);
+        parts.push_back(&part);
+    }
+    vector<ComponentDefinition*> designs;
+    for (int i_design = 0; i_design < n_designs; ++i_design)
+    {
+        ComponentDefinition& design = doc.componentDefinitions.create("design" + to_string(i_design));
+        Sequence& seq = doc.sequences.create("design" + to_string(i_design) + "_seq");
+        seq.elements.set(random_sequence(n_parts * part_length, i_design + 1));
+        design.sequences.set(seq);
+        for (int i_part = 0; i_part < n_parts; ++i_part)
+        {
+            Component& c = design.components.create("component" + to_string(i_part));
+            c.definition.set(parts[i_part]->identity.get());
+            SequenceAnnotation& ann = design.sequenceAnnotations.create("annotation" + to_string(i_part));
+            Range& r = ann.locations.create<Range>("range" + to_string(i_part));
+            r.start.set(i_part * part_length + 1);
+            r.end.set((i_part + 1) * part_length);
+        }
+        designs.push_back(&design);
+    }
+
+    for (string pass : { "cold", "warm" })
+    {
+        auto t_start = chrono::steady_clock::now();
+        for (auto & design : designs)
+            design->isRegular();
+        report("isRegular (" + pass + ")", n_designs, elapsed_ms(t_start));
+    }
+
+    designs[0]->sequenceAnnotations[0].name.set("edited");
+    auto t_start = chrono::steady_clock::now();
+    for (auto & design : designs)
+        design->isRegular();
+    report("isRegular (after edit)", n_designs, elapsed_ms(t_start));
+}
+
+// Compares the memory footprint of packed and unpacked Sequence elements, and the cost of extracting many short regions
+// with Sequence::subsequence versus copying the elements string with elements.get()
+void benchmark_packing(int length)
+{
+    Document doc;
+    Sequence& seq = doc.sequences.create("genome");
+    seq.elements.set(random_sequence(length));
+    const int n_regions = 1000;
+    const int region_length = 1000;
+
+    auto t_start = chrono::steady_clock::now();
+    for (int i_region = 0; i_region < n_regions; ++i_region)
+    {
+        int start = (i_region * 7919) % (length - region_length) + 1;
+        seq.elements.get().substr(start - 1, region_length);
+    }
+    report("subsequence (string, " + to_string(length + 2) + " bytes)", length, elapsed_ms(t_start));
+
+    t_start = chrono::steady_clock::now();
+    seq.pack();
+    report("pack (" + to_string(seq.elements.packed.bytes()) + " bytes)", length, elapsed_ms(t_start));
+
+    t_start = chrono::steady_clock::now();
+    for (int i_region = 0; i_region < n_regions; ++i_region)
+    {
+        int start = (i_region * 7919) % (length - region_length) + 1;
+        seq.subsequence(start, start + region_length - 1);
+    }
+    report("subsequence (packed)", length, elapsed_ms(t_start));
+}
+
+// Compares the vectorized sequence kernels with their scalar fallbacks
+void benchmark_kernels(int length)
+{
+    string nucleotides = random_sequence(length);
+    const int n_repeats = 10;
+    for (bool vectorize : { false, true })
+    {
+        string label = vectorize ? " (vectorized)" : " (scalar)";
+
+        auto t_start = chrono::steady_clock::now();
+        for (int i = 0; i < n_repeats; ++i)
+            reverse_complement(nucleotides, vectorize);
+        report("reverse complement" + label, length, elapsed_ms(t_start) / n_repeats);
+
+        t_start = chrono::steady_clock::now();
+        for (int i = 0; i < n_repeats; ++i)
+            count_gc(nucleotides.data(), nucleotides.size(), vectorize);
+        report("GC content" + label, length, elapsed_ms(t_start) / n_repeats);
+
+        t_start = chrono::steady_clock::now();
+        for (int i = 0; i < n_repeats; ++i)
+            find_invalid_nucleotide(nucleotides.data(), nucleotides.size(), vectorize);
+        report("IUPAC validation" + label, length, elapsed_ms(t_start) / n_repeats);
+    }
+}
+
+// Compiles a library of 4 variable positions with 10 variants each, flanked by a fixed prefix and suffix. Compares
+// ComponentDefinition::compile, which assembles each design from its parts, with the prefix-sharing library compile.
+// The per-design compile is slow, so it is run on a sample of the library.
+void benchmark_library(int part_length)
+{
+    Document doc;
+    const int n_positions = 4;
+    const int n_variants = 10;
+    const int flank_length = 2000;
+    const int n_sampled = 10;
+    ComponentDefinition& library_template = doc.componentDefinitions.create("library_template");
+    vector<ComponentDefinition*> parts;
+    for (string flank : { "prefix", "suffix" })
+    {
+        ComponentDefinition& part = doc.componentDefinitions.create(flank);
+        Sequence& seq = doc.sequences.create(flank + "_seq");
+        seq.elements.set(random_sequence(flank_length, parts.size() + 1));
+        part.sequences.set(seq);
+        parts.push_back(&part);
+    }
+    for (int i_position = 0; i_position < n_positions; ++i_position)
+        parts.insert(parts.end() - 1, &doc.componentDefinitions.create("position" + to_string(i_position)));
+    library_template.assemblePrimaryStructure(parts);
+
+    CombinatorialDerivation& derivation = doc.combinatorialderivations.create("library");
+    derivation.masterTemplate.set(library_template.identity.get());
+    for (int i_position = 0; i_position < n_positions; ++i_position)
+    {
+        VariableComponent& var = derivation.variableComponents.create("variable" + to_string(i_position));
+        var.variable.set(library_template.components[i_position + 1].identity.get());
+        for (int i_variant = 0; i_variant < n_variants; ++i_variant)
+        {
+            string id = "variant" + to_string(i_position) + "_" + to_string(i_variant);
+            ComponentDefinition& variant = doc.componentDefinitions.create(id);
+            Sequence& seq = doc.sequences.create(id + "_seq");
+            seq.elements.set(random_sequence(part_length, 10 * i_position + i_variant + 3));
+            variant.sequences.set(seq);
+            var.variants.add(variant.identity.get());
+        }
+    }
+
+    DerivationEnumerator library = derivation.enumerate();
+    auto t_start = chrono::steady_clock::now();
+    library.derive(0, library.size());
+    report("derive (" + to_string(library.size()) + " designs)", part_length, elapsed_ms(t_start));
+
+    t_start = chrono::steady_clock::now();
+    for (int i_design = 0; i_design < n_sampled; ++i_design)
+        library.derive(i_design).compile();
+    report("compile (per design, " + to_string(n_sampled) + " designs)", part_length, elapsed_ms(t_start));
+
+    t_start = chrono::steady_clock::now();
+    library.compile(n_sampled, library.size() - n_sampled);
+    report("compile (library, " + to_string(library.size() - n_sampled) + " designs)", part_length, elapsed_ms(t_start));
+}
+
+// Generates a QC report for a Build of a design with the given number of parts. The consensus sequence has a sequencing
+// error every 50 bases, so the Build is annotated with many short QC annotations.
+void benchmark_qc(int n_parts)
+{
+    Document doc;
+    const int part_length = 100;
+    vector<ComponentDefinition*> parts;
+    for (int i_part = 0; i_part < n_parts; ++i_part)
+    {
+        ComponentDefinition& part = doc.componentDefinitions.create("part" + to_string(i_part));
+        Sequence& seq = doc.sequences.create("part" + to_string(i_part) + "_seq");
+        seq.elements.set(random_sequence(part_length, i_part + 1));
+        part.sequences.set(seq);
+        parts.push_back(&part);
+    }
+    ComponentDefinition& target = doc.componentDefinitions.create("target");
+    target.assemblePrimaryStructure(parts);
+    string consensus_elements = target.compile();
+    for (size_t i_base = 25; i_base < consensus_elements.size(); i_base += 50)
+        consensus_elements[i_base] = (i_base / 50) % 2 ? 'n' : '-';
+
+    Design& design = doc.designs.create("design");
+    design.structure.set(target);
+    Build& build = doc.builds.create("build");
+    build.design.set(design);
+    Test& test = doc.tests.create("test");
+    test.samples.set(build);
+    Analysis& analysis = doc.analyses.create("analysis");
+    analysis.rawData.set(test);
+    Sequence& consensus = doc.sequences.create("consensus");
+    consensus.elements.set(consensus_elements);
+    analysis.verifyTarget(consensus);
+
+    for (int n_threads : { 1, 4 })
+    {
+        auto t_start = chrono::steady_clock::now();
+        analysis.reportQC(n_threads);
+        report("reportQC (" + to_string(n_threads) + " threads)", n_parts, elapsed_ms(t_start));
+    }
+}
+
+// Generates QC reports for a plate of Builds of the same 20-part design, each sequenced with a different error. Compares
+// the four per-Analysis reports with a single batch report for the Document.
+void benchmark_batch_qc(int n_analyses)
+{
+    Document doc;
+    const int n_parts = 20;
+    const int part_length = 100;
+    vector<ComponentDefinition*> parts;
+    for (int i_part = 0; i_part < n_parts; ++i_part)
+    {
+        ComponentDefinition& part = doc.componentDefinitions.create("part" + to_string(i_part));
+        Sequence& seq = doc.sequences.create("part" + to_string(i_part) + "_seq");
+        seq.elements.set(random_sequence(part_length, i_part + 1));
+        part.sequences.set(seq);
+        parts.push_back(&part);
+    }
+    ComponentDefinition& target = doc.componentDefinitions.create("target");
+    target.assemblePrimaryStructure(parts);
+    string target_elements = target.compile();
+    Design& design = doc.designs.create("design");
+    design.structure.set(target);
+
+    vector<Analysis*> analyses;
+    for (int i_analysis = 0; i_analysis < n_analyses; ++i_analysis)
+    {
+        string id = to_string(i_analysis);
+        Build& build = doc.builds.create("build" + id);
+        build.design.set(design);
+        Test& test = doc.tests.create("test" + id);
+        test.samples.set(build);
+        Analysis& analysis = doc.analyses.create("analysis" + id);
+        analysis.rawData.set(test);
+        Sequence& consensus = doc.sequences.create("consensus" + id);
+        string consensus_elements = target_elements;
+        consensus_elements[(i_analysis * 7919) % consensus_elements.size()] = 'n';
+        consensus.elements.set(consensus_elements);
+        analysis.verifyTarget(consensus);
+        analyses.push_back(&analysis);
+    }
+
+    auto t_start = chrono::steady_clock::now();
+    for (auto & analysis : analyses)
+    {
+        analysis->reportIdentity();
+        analysis->reportError();
+        analysis->reportCoverage();
+        analysis->reportAmbiguity();
+    }
+    report("QC reports (per Analysis)", n_analyses, elapsed_ms(t_start));
+
+    for (int n_threads : { 1, 4 })
+    {
+        t_start = chrono::steady_clock::now();
+        doc.reportQC({}, n_threads);
+        report("QC report (batch, " + to_string(n_threads) + " threads)", n_analyses, elapsed_ms(t_start));
+    }
+}
+
+// Aligns a simulated sequencing read to a plasmid of the given length. The read is the plasmid with a substitution every
+// 100 bases, an indel every 1000 bases and an unresolved base every 500 bases, so the alignment is close to the diagonal
+// as it is for a Build and its Design. Compares the striped kernels with the scalar Smith-Waterman.
+void benchmark_align(int length)
+{
+    const char nucleotides[] = "acgt";
+    string plasmid = random_sequence(length);
+    string read;
+    for (int i = 0; i < length; ++i)
+    {
+        if (i % 2000 == 1000)
+            continue;  // Deletion
+        if (i % 2000 == 0 && i > 0)
+            read += nucleotides[i % 4];  // Insertion
+        if (i % 500 == 250)
+            read += 'n';
+        else if (i % 100 == 50)
+            read += plasmid[i] == 'a' ? 'c' : 'a';
+        else
+            read += plasmid[i];
+    }
+    for (bool vectorize : { false, true })
+    {
+        auto t_start = chrono::steady_clock::now();
+        align_sequences(plasmid, read, vectorize);
+        report(string("alignment") + (vectorize ? " (vectorized)" : " (scalar)"), length, elapsed_ms(t_start));
+    }
+}
+
+// Generates a Design and many Builds from it, each Build derived from the previous one with an Activity and Usage, then
+// queries lineage. The first query indexes the Document, later queries follow only the lineage, and a query after an edit
+// re-reads only the modified Build.
+void benchmark_lineage(int n_builds)
+{
+    Document doc;
+    Design& design = doc.designs.create("design");
+    vector<TopLevel*> builds = { &design.generate<Build>("build0") };
+    for (int i = 1; i < n_builds; ++i)
+        builds.push_back(&builds.back()->generate<Build>("build" + to_string(i)));
+
+    auto t_start = chrono::steady_clock::now();
+    builds.back()->getAncestors(SYSBIO_DESIGN);
+    report("lineage (cold)", n_builds, elapsed_ms(t_start));
+
+    const int n_queries = 100;
+    t_start = chrono::steady_clock::now();
+    for (int i = 0; i < n_queries; ++i)
+        builds[n_builds / 2]->getDescendants(SBOL_IMPLEMENTATION);
+    report("lineage (warm)", n_builds, elapsed_ms(t_start) / n_queries);
+
+    builds[n_builds / 2]->description.set("edited");
+    t_start = chrono::steady_clock::now();
+    builds[n_builds - 2]->getDescendants();
+    report("lineage (after edit)", n_builds, elapsed_ms(t_start));
+}
+
+// Checks a Document of parts with Document::validateAll, serially and then across every core, and reports the rate at
+// which rules are run. Each part is a ComponentDefinition, its Sequence and the Activity which produced it, whose
+// timestamp is checked by a rule of its DateTimeProperty
+void benchmark_validate(int n_parts)
+{
+    Document doc;
+    for (int i = 0; i < n_parts; ++i)
+    {
+        ComponentDefinition& cd = doc.componentDefinitions.create("part" + to_string(i));
+        Sequence& seq = doc.sequences.create("part" + to_string(i) + "_seq");
+        seq.elements.set(random_sequence(100, i));
+        cd.sequences.set(seq.identity.get());
+        Activity& activity = doc.activities.create("part" + to_string(i) + "_activity");
+        activity.startedAtTime.set("2019-03-16T20:12:00Z");
+        cd.wasGeneratedBy.set(activity.identity.get());
+    }
+
+    int n_cores = max(1, (int)thread::hardware_concurrency());
+    for (int n_threads : { 1, n_cores })
+    {
+        auto t_start = chrono::steady_clock::now();
+        ValidationReport validation = doc.validateAll(n_threads);
+        double ms = elapsed_ms(t_start);
+        report("validate (" + to_string(n_threads) + " threads)", n_parts, ms);
+        cout << "validate (" + to_string(n_threads) + " threads)\t" << n_parts << "\t" << validation.checks / ms * 1000 << " rules/s" << endl;
+    }
+}
+
+// Revises the timestamps of a Document's Activities repeatedly, as an editor or importer might, with each value validated
+// as it is set and then with validation deferred until the revisions are done
+void benchmark_deferred(int n_activities)
+{
+    Document doc;
+    vector<Activity*> activities;
+    for (int i = 0; i < n_activities; ++i)
+        activities.push_back(&doc.activities.create("activity" + to_string(i)));
+
+    const int n_revisions = 50;
+    for (bool defer : { false, true })
+    {
+        auto t_start = chrono::steady_clock::now();
+        {
+            unique_ptr<DeferredValidation> deferral(defer ? new DeferredValidation(doc) : NULL);
+            for (auto activity : activities)
+                for (int i = 0; i < n_revisions; ++i)
+                    activity->endedAtTime.set("2019-03-16T20:" + to_string(10 + i) + ":00Z");
+        }
+        report(defer ? "deferred validation" : "immediate validation", n_activities, elapsed_ms(t_start));
+    }
+}
+
+#ifndef _WIN32
+// Pulls a part repeatedly from a local server. A single PartShop reuses one keep-alive connection, while a new PartShop
+// for every pull opens a new connection each time, as libSBOL did before PartShops pooled their connections.
+void benchmark_pull(int n_pulls)
+{
+    Document served;
+    ComponentDefinition& cd = served.componentDefinitions.create("cd");
+    Sequence& seq = served.sequences.create("cd_seq");
+    seq.elements.set(random_sequence(1000));
+    cd.sequences.set(seq.identity.get());
+    string sbol = served.writeString();
+    MockServer server([&](const MockRequest& request)
+    {
+        MockResponse response;
+        response.content_type = "application/rdf+xml";
+        response.body = sbol;
+        return response;
+    });
+
+    PartShop shop(server.url());
+    auto t_start = chrono::steady_clock::now();
+    for (int i_pull = 0; i_pull < n_pulls; ++i_pull)
+    {
+        Document doc;
+        shop.pull(server.url() + "/cd", doc);
+    }
+    report("pull (pooled)", n_pulls, elapsed_ms(t_start));
+    long n_pooled_connections = server.connectionCount();
+
+    t_start = chrono::steady_clock::now();
+    for (int i_pull = 0; i_pull < n_pulls; ++i_pull)
+    {
+        PartShop new_shop(server.url());
+        Document doc;
+        new_shop.pull(server.url() + "/cd", doc);
+    }
+    report("pull (new connection per pull)", n_pulls, elapsed_ms(t_start));
+    cout << "connections opened: " << n_pooled_connections << " pooled, " << server.connectionCount() - n_pooled_connections << " unpooled" << endl;
+}
+
+// Pulls distinct parts from a local server which holds each response for 2 ms, approximating the round trip to a remote
+// repository. Parts are pulled one at a time, then all at once with concurrent requests.
+void benchmark_pull_concurrent(int n_parts)
+{
+    unordered_map<string, string> parts;
+    vector<string> uris;
+    for (int i_part = 0; i_part < n_parts; ++i_part)
+    {
+        Document part_doc;
+        string display_id = "cd" + to_string(i_part);
+        ComponentDefinition& cd = part_doc.componentDefinitions.create(display_id);
+        Sequence& seq = part_doc.sequences.create(display_id + "_seq");
+        seq.elements.set(random_sequence(1000, i_part));
+        cd.sequences.set(seq.identity.get());
+        parts["/" + display_id + "/sbol"] = part_doc.writeString();
+    }
+    MockServer server([&](const MockRequest& request)
+    {
+        this_thread::sleep_for(chrono::milliseconds(2));
+        MockResponse response;
+        response.content_type = "application/rdf+xml";
+        response.body = parts[request.path];
+        return response;
+    });
+    for (int i_part = 0; i_part < n_parts; ++i_part)
+        uris.push_back(server.url() + "/cd" + to_string(i_part));
+
+    PartShop shop(server.url());
+    Document serial_doc;
+    auto t_start = chrono::steady_clock::now();
+    for (auto& uri : uris)
+        shop.pull(uri, serial_doc);
+    report("pull many (serial)", n_parts, elapsed_ms(t_start));
+
+    Document concurrent_doc;
+    t_start = chrono::steady_clock::now();
+    shop.pull(uris, concurrent_doc);
+    report("pull many (concurrent)", n_parts, elapsed_ms(t_start));
+}
+
+// Checks for and pulls distinct parts from a local server which holds each response for 20 ms, one at a time and then all
+// at once through the asynchronous methods, whose requests share one event loop thread
+void benchmark_async(int n_parts)
+{
+    unordered_map<string, string> parts;
+    vector<string> uris;
+    for (int i_part = 0; i_part < n_parts; ++i_part)
+    {
+        Document part_doc;
+        string display_id = "cd" + to_string(i_part);
+        ComponentDefinition& cd = part_doc.componentDefinitions.create(display_id);
+        Sequence& seq = part_doc.sequences.create(display_id + "_seq");
+        seq.elements.set(random_sequence(1000, i_part));
+        cd.sequences.set(seq.identity.get());
+        parts["/" + display_id + "/sbol"] = part_doc.writeString();
+        parts["/" + display_id + "/metadata"] = "[{\"displayId\":\"" + display_id + "\"}]";
+    }
+    MockServer server([&](const MockRequest& request)
+    {
+        this_thread::sleep_for(chrono::milliseconds(20));
+        MockResponse response;
+        response.content_type = "text/plain";
+        response.body = parts[request.path];
+        return response;
+    });
+    for (int i_part = 0; i_part < n_parts; ++i_part)
+        uris.push_back(server.url() + "/cd" + to_string(i_part));
+
+    PartShop shop(server.url());
+    auto t_start = chrono::steady_clock::now();
+    for (auto& uri : uris)
+        shop.exists(uri);
+    report("exists (serial)", n_parts, elapsed_ms(t_start));
+
+    t_start = chrono::steady_clock::now();
+    vector<future<bool>> found;
+    for (auto& uri : uris)
+        found.push_back(shop.existsAsync(uri));
+    for (auto& f : found)
+        f.get();
+    report("exists (async)", n_parts, elapsed_ms(t_start));
+
+    Document serial_doc;
+    t_start = chrono::steady_clock::now();
+    for (auto& uri : uris)
+        shop.pull(uri, serial_doc);
+    report("pull (serial)", n_parts, elapsed_ms(t_start));
+
+    Document async_doc;
+    t_start = chrono::steady_clock::now();
+    vector<future<void>> pulled;
+    for (auto& uri : uris)
+        pulled.push_back(shop.pullAsync(uri, async_doc));
+    for (auto& f : pulled)
+        f.get();
+    report("pull (async)", n_parts, elapsed_ms(t_start));
+}
+
+// Reports the throughput of a series of operations, and the percentiles of their latencies
+void report_latencies(string benchmark, vector<double> latencies_ms)
+{
+    double total_ms = 0;
+    for (double ms : latencies_ms)
+        total_ms += ms;
+    sort(latencies_ms.begin(), latencies_ms.end());
+    auto percentile = [&](double p) { return latencies_ms[min(latencies_ms.size() - 1, (size_t)(p * latencies_ms.size()))]; };
+    cout << benchmark << "\t" << latencies_ms.size() << "\t" << latencies_ms.size() * 1000 / total_ms << " ops/s\tp50 " << percentile(0.5) << " ms\tp90 " << percentile(0.9) << " ms\tp99 " << percentile(0.99) << " ms" << endl;
+}
+
+// Exercises PartShop against a stand-in SynBioHub, which serves a corpus of SBOL files with a 10 ms latency and a bandwidth
+// of 10 MB/s. The corpus is the given directory, or else a generated one with a part and its sequence in each file.
+// Parts are pulled, searched for and submitted one at a time, then pulled all at once through the asynchronous API.
+void benchmark_synbiohub(int n_parts, string corpus_path)
+{
+    if (corpus_path == "")
+    {
+        char directory[] = "/tmp/sbol_corpus_XXXXXX";
+        corpus_path = mkdtemp(directory);
+        for (int i_part = 0; i_part < n_parts; ++i_part)
+        {
+            Document part_doc;
+            string display_id = "part" + to_string(i_part);
+            ComponentDefinition& cd = part_doc.componentDefinitions.create(display_id);
+            cd.name.set("Part " + to_string(i_part));
+            Sequence& seq = part_doc.sequences.create(display_id + "_seq");
+            seq.elements.set(random_sequence(1000, i_part));
+            cd.sequences.set(seq.identity.get());
+            ofstream file(corpus_path + "/" + display_id + ".xml");
+            part_doc.serialize_rdfxml(file);
+        }
+    }
+    auto t_start = chrono::steady_clock::now();
+    MockSynBioHub hub(corpus_path);
+    report("synbiohub load corpus", hub.size(), elapsed_ms(t_start));
+    hub.setLatency(10);
+    hub.setBandwidth(10000000);
+    vector<string> urls = hub.urls();
+    if (urls.size() > (size_t)n_parts)
+        urls.resize(n_parts);
+    if (urls.empty())
+        return;
+
+    PartShop shop(hub.url());
+    vector<double> latencies;
+    for (auto& url : urls)
+    {
+        Document doc;
+        t_start = chrono::steady_clock::now();
+        shop.pull(url, doc);
+        latencies.push_back(elapsed_ms(t_start));
+    }
+    report_latencies("synbiohub pull", latencies);
+
+    latencies.clear();
+    for (int i_search = 0; i_search < (int)urls.size(); ++i_search)
+    {
+        t_start = chrono::steady_clock::now();
+        SearchResponse& records = shop.search("part" + to_string(i_search), SBOL_COMPONENT_DEFINITION, 0, 10);
+        latencies.push_back(elapsed_ms(t_start));
+        delete &records;
+    }
+    report_latencies("synbiohub search", latencies);
+
+    latencies.clear();
+    for (int i_submit = 0; i_submit < (int)urls.size() / 10; ++i_submit)
+    {
+        Document doc;
+        doc.displayId.set("submission" + to_string(i_submit));
+        doc.name.set("submission");
+        doc.description.set("submission");
+        for (int i_part = 0; i_part < 10; ++i_part)
+            doc.componentDefinitions.create("submitted" + to_string(i_submit) + "_" + to_string(i_part));
+        t_start = chrono::steady_clock::now();
+        shop.submit(doc);
+        latencies.push_back(elapsed_ms(t_start));
+    }
+    report_latencies("synbiohub submit", latencies);
+
+    Document async_doc;
+    t_start = chrono::steady_clock::now();
+    vector<future<void>> pulled;
+    for (auto& url : urls)
+        pulled.push_back(shop.pullAsync(url, async_doc));
+    for (auto& f : pulled)
+        f.get();
+    double ms = elapsed_ms(t_start);
+    cout << "synbiohub pull (async)\t" << urls.size() << "\t" << urls.size() * 1000 / ms << " ops/s" << endl;
+}
+
+// The peak resident memory of this process so far, in megabytes
+long peak_rss_mb()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / (1024 * 1024);
+#else
+    return usage.ru_maxrss / 1024;
+#endif
+}
+
+// Submits a Document whose serialization is about the given size to a local server, which counts the upload without
+// keeping it. The growth in peak memory during the streamed submission is compared with that of serializing the Document
+// to a string and copying it into a request, as libSBOL did before submissions were streamed.
+void benchmark_submit(int megabytes)
+{
+    Document doc;
+    doc.displayId.set("submission");
+    doc.name.set("submission");
+    doc.description.set("submission");
+    string elements = random_sequence(1 << 20);
+    for (int i_seq = 0; i_seq < megabytes; ++i_seq)
+        doc.sequences.create("seq" + to_string(i_seq)).elements.set(elements);
+    string().swap(elements);
+
+    MockServer server([&](const MockRequest& request)
+    {
+        MockResponse response;
+        response.body = "Successfully uploaded";
+        return response;
+    });
+    server.keepBodies(false);
+    PartShop shop(server.url());
+
+    long rss_start = peak_rss_mb();
+    auto t_start = chrono::steady_clock::now();
+    shop.submit(doc);
+    report("submit (streamed)", megabytes, elapsed_ms(t_start));
+    long rss_streamed = peak_rss_mb();
+    cout << "uploaded " << server.bodyBytes() / (1 << 20) << " MB, peak memory grew by " << rss_streamed - rss_start << " MB" << endl;
+
+    try
+    {
+        Config::setOption("compress_submissions", true);
+        long long uploaded = server.bodyBytes();
+        t_start = chrono::steady_clock::now();
+        shop.submit(doc);
+        report("submit (streamed, gzip)", megabytes, elapsed_ms(t_start));
+        cout << "uploaded " << (server.bodyBytes() - uploaded) / (1 << 20) << " MB, peak memory grew by " << peak_rss_mb() - rss_streamed << " MB" << endl;
+    }
+    catch (SBOLError& e)
+    {
+        cout << e.what() << endl;
+    }
+    Config::setOption("compress_submissions", false);
+
+    rss_streamed = peak_rss_mb();
+    t_start = chrono::steady_clock::now();
+    {
+        std::ostringstream os;
+        doc.serialize_rdfxml(os);
+        string serialization = os.str();
+        string request_body = serialization;
+    }
+    report("serialize to string and copy", megabytes, elapsed_ms(t_start));
+    cout << "peak memory grew by " << peak_rss_mb() - rss_streamed << " MB" << endl;
+}
+
+// Writes a multi-record GenBank file, then converts it to FASTA and back to GenBank one batch of records at a time. Each
+// batch is read into a new Document, so peak memory depends on the size of a batch rather than the size of the file.
+void benchmark_sequence_files(int n_records)
+{
+    const int record_length = 10000;
+    const int batch_size = 100;
+    char directory[] = "/tmp/sbol_sequence_files_XXXXXX";
+    string path = mkdtemp(directory);
+    string genbank_path = path + "/records.gb";
+    string fasta_path = path + "/records.fasta";
+    string copy_path = path + "/copy.gb";
+
+    {
+        ofstream genbank(genbank_path);
+        for (int i_record = 0; i_record < n_records; ++i_record)
+        {
+            string elements = random_sequence(record_length, i_record + 1);
+            genbank << "LOCUS       record" << i_record << "    " << record_length << " bp    DNA     linear   UNK 01-JAN-2020\n";
+            genbank << "DEFINITION  Record " << i_record << ".\nFEATURES             Location/Qualifiers\n";
+            genbank << "     promoter        1..100\n                     /label=promoter" << i_record << "\n";
+            genbank << "     CDS             join(200..1000,1100..2000)\n                     /gene=\"gene" << i_record << "\"\n";
+            genbank << "     terminator      complement(3000..3100)\n";
+            genbank << "ORIGIN\n";
+            for (int i_line = 0; i_line < record_length; i_line += 60)
+            {
+                genbank << i_line + 1;
+                for (int i_block = i_line; i_block < i_line + 60 && i_block < record_length; i_block += 10)
+                    genbank << ' ' << elements.substr(i_block, 10);
+                genbank << '\n';
+            }
+            genbank << "//\n";
+        }
+    }
+    ifstream input(genbank_path, ios::binary | ios::ate);
+    double megabytes = input.tellg() / double(1 << 20);
+
+    long rss_start = peak_rss_mb();
+    auto t_start = chrono::steady_clock::now();
+    SequenceFileReader reader(genbank_path);
+    SequenceFileWriter writer(fasta_path, "FASTA");
+    while (true)
+    {
+        Document batch;
+        int n_read = 0;
+        while (n_read < batch_size && reader.next(batch))
+            ++n_read;
+        if (n_read == 0)
+            break;
+        for (auto& cd : batch.componentDefinitions)
+            writer.write(cd);
+    }
+    writer.close();
+    double ms = elapsed_ms(t_start);
+    report("GenBank to FASTA", n_records, ms);
+    cout << megabytes / ms * 1000 << " MB/s, peak memory grew by " << peak_rss_mb() - rss_start << " MB" << endl;
+
+    rss_start = peak_rss_mb();
+    t_start = chrono::steady_clock::now();
+    SequenceFileReader fasta_reader(fasta_path);
+    SequenceFileWriter genbank_writer(copy_path, "GenBank");
+    while (true)
+    {
+        Document batch;
+        int n_read = 0;
+        while (n_read < batch_size && fasta_reader.next(batch))
+            ++n_read;
+        if (n_read == 0)
+            break;
+        for (auto& cd : batch.componentDefinitions)
+            genbank_writer.write(cd);
+    }
+    genbank_writer.close();
+    report("FASTA to GenBank", n_records, elapsed_ms(t_start));
+    cout << "peak memory grew by " << peak_rss_mb() - rss_start << " MB" << endl;
+
+    for (auto& file : { genbank_path, fasta_path, copy_path })
+        remove(file.c_str());
+    rmdir(path.c_str());
+}
+
+// Counts the solutions handed over by a streaming SPARQL query
+void count_solution(const vector<string>& variables, vector<SPARQLTerm>& row, void* n_rows)
+{
+    ++*(int*)n_rows;
+}
+
+// Decodes SPARQL results with the given number of solutions, served by a local server, as they arrive and into a table.
+// These are compared with retrieving the response as a string and parsing it with JsonCpp. The query is issued once before
+// measuring, so that the memory used by the server to send the response is not attributed to the decoders.
+void benchmark_sparql(int n_rows)
+{
+    string body = "{\"head\":{\"vars\":[\"part\",\"name\",\"length\"]},\"results\":{\"bindings\":[";
+    for (int i_row = 0; i_row < n_rows; ++i_row)
+    {
+        if (i_row)
+            body += ",";
+        body += "{\"part\":{\"type\":\"uri\",\"value\":\"https://synbiohub.org/public/igem/BBa_" + to_string(i_row) + "/1\"},";
+        body += "\"name\":{\"type\":\"literal\",\"value\":\"part " + to_string(i_row) + "\"},";
+        body += "\"length\":{\"type\":\"literal\",\"datatype\":\"http://www.w3.org/2001/XMLSchema#integer\",\"value\":\"" + to_string(i_row % 5000) + "\"}}";
+    }
+    body += "]}}";
+
+    MockServer server([&](const MockRequest& request)
+    {
+        MockResponse response;
+        response.content_type = "application/json";
+        response.body = body;
+        return response;
+    });
+    PartShop shop(server.url());
+    string query = "SELECT ?part ?name ?length WHERE { ?part sbol:name ?name }";
+
+    int n_solutions = 0;
+    shop.sparqlQuery(query, count_solution, &n_solutions);
+
+    long rss_start = peak_rss_mb();
+    n_solutions = 0;
+    auto t_start = chrono::steady_clock::now();
+    shop.sparqlQuery(query, count_solution, &n_solutions);
+    report("sparql (streamed rows)", n_solutions, elapsed_ms(t_start));
+    long rss_streamed = peak_rss_mb();
+    cout << "peak memory grew by " << rss_streamed - rss_start << " MB" << endl;
+
+    {
+        SPARQLResults results;
+        t_start = chrono::steady_clock::now();
+        shop.sparqlQuery(query, results);
+        report("sparql (streamed table)", results.size(), elapsed_ms(t_start));
+    }
+    long rss_table = peak_rss_mb();
+    cout << "peak memory grew by " << rss_table - rss_streamed << " MB" << endl;
+
+    {
+        t_start = chrono::steady_clock::now();
+        string response = shop.sparqlQuery(query);
+        Json::Value json_response;
+        Json::Reader reader;
+        reader.parse(response, json_response);
+        report("sparql (string and JsonCpp)", json_response["results"]["bindings"].size(), elapsed_ms(t_start));
+    }
+    cout << "peak memory grew by " << peak_rss_mb() - rss_table << " MB" << endl;
+}
+#endif
+
+int main(int argc, char* argv[])
+{
+    Config::setOption("validate", false);
+    string benchmark = "";
+    if (argc > 1)
+        benchmark = argv[1];
+
+    if (benchmark == "" || benchmark == "disassemble")
+        for (int size : { 10, 50, 100, 200 })
+            benchmark_disassemble(size);
+
+    if (benchmark == "" || benchmark == "hierarchy")
+        for (int size : { 4, 6, 8, 10 })
+            benchmark_hierarchy(size);
+
+    if (benchmark == "" || benchmark == "regularity")
+        for (int size : { 10, 50, 100 })
+            benchmark_regularity(size);
+
+    if (benchmark == "" || benchmark == "packing")
+        for (int size : { 100000, 1000000 })
+            benchmark_packing(size);
+
+    if (benchmark == "" || benchmark == "kernels")
+        for (int size : { 1000000, 10000000 })
+            benchmark_kernels(size);
+
+    if (benchmark == "" || benchmark == "library")
+        for (int size : { 100, 1000 })
+            benchmark_library(size);
+
+    if (benchmark == "" || benchmark == "qc")
+        for (int size : { 100, 1000 })
+            benchmark_qc(size);
+
+    if (benchmark == "" || benchmark == "batch_qc")
+        for (int size : { 100, 1000 })
+            benchmark_batch_qc(size);
+
+    if (benchmark == "" || benchmark == "align")
+        for (int size : { 5000, 10000 })
+            benchmark_align(size);
+
+    if (benchmark == "" || benchmark == "lineage")
+        for (int size : { 1000, 3000 })
+            benchmark_lineage(size);
+
+    if (benchmark == "" || benchmark == "validate")
+        for (int size : { 1000, 2000 })
+            benchmark_validate(size);
+
+    if (benchmark == "" || benchmark == "deferred")
+        for (int size : { 300, 1000 })
+            benchmark_deferred(size);
+
+#ifndef _WIN32
+    if (benchmark == "" || benchmark == "pull")
+        for (int size : { 1000 })
+            benchmark_pull(size);
+
+    if (benchmark == "" || benchmark == "pull_many")
+        for (int size : { 100, 1000 })
+            benchmark_pull_concurrent(size);
+
+    if (benchmark == "" || benchmark == "async")
+        for (int size : { 100, 300 })
+            benchmark_async(size);
+
+    if (benchmark == "synbiohub")
+        for (int size : { 500 })
+            benchmark_synbiohub(size, argc > 2 ? argv[2] : "");
+
+    if (benchmark == "submit")
+        for (int size : { 500 })
+            benchmark_submit(size);
+
+    if (benchmark == "sparql")
+        for (int size : { 1000000 })
+            benchmark_sparql(size);
+
+    if (benchmark == "sequence_files")
+        for (int size : { 10000 })
+            benchmark_sequence_files(size);
+#endif
+
+    return 0;
+}
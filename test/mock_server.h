@@ -0,0 +1,326 @@
+/**
+ * @file    mock_server.h
+ * @brief   A minimal HTTP/1.1 server on the loopback interface, for exercising PartShop without a network
+ * @author  Bryan Bartley
+ * @email   bartleyba@sbolstandard.org
+ *
+ * <!--------------------------------------------------------------------------
+ * This file is part of libSBOL.  Please visit http://sbolstandard.org for more
+ * information about SBOL, and the latest version of libSBOL.
+ *
+ *  Copyright 2016 University of Washington, WA, USA
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ------------------------------------------------------------------------->*/
+
+#ifndef MOCK_SERVER_INCLUDED
+#define MOCK_SERVER_INCLUDED
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <chrono>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+struct MockRequest
+{
+    std::string method;
+    std::string path;
+    std::unordered_map<std::string, std::string> headers;  // Header names are lower case
+    std::string body;
+};
+
+struct MockResponse
+{
+    int status = 200;
+    std::string content_type = "text/plain";
+    std::unordered_map<std::string, std::string> headers;
+    std::string body;
+};
+
+// Serves requests on 127.0.0.1, at an ephemeral port unless one is given. Each connection is kept alive and served by
+// its own thread until the client closes it, so the number of accepted connections shows whether a client reuses its
+// connections. A latency and bandwidth may be injected to approximate a remote server.
+class MockServer
+{
+public:
+    typedef std::function<MockResponse(const MockRequest&)> Handler;
+
+    MockServer(Handler handler, int listen_port = 0) :
+        handler(handler),
+        n_connections(0),
+        n_requests(0),
+        n_body_bytes(0),
+        keep_bodies(true),
+        latency_ms(0),
+        bandwidth(0),
+        running(true)
+    {
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(listen_port);
+        bind(listener, (sockaddr*)&address, sizeof(address));
+        listen(listener, 128);
+        socklen_t length = sizeof(address);
+        getsockname(listener, (sockaddr*)&address, &length);
+        port = ntohs(address.sin_port);
+        acceptor = std::thread(&MockServer::acceptConnections, this);
+    };
+
+    ~MockServer()
+    {
+        running = false;
+        shutdown(listener, SHUT_RDWR);
+        close(listener);
+        acceptor.join();
+        {
+            std::lock_guard<std::mutex> lock(connection_lock);
+            for (int connection : connections)
+                shutdown(connection, SHUT_RDWR);
+        }
+        for (auto& worker : workers)
+            worker.join();
+        for (int connection : connections)
+            close(connection);
+    };
+
+    // The base URL of the server, without a terminal slash
+    std::string url()
+    {
+        return "http://127.0.0.1:" + std::to_string(port);
+    };
+
+    long connectionCount()
+    {
+        return n_connections;
+    };
+
+    long requestCount()
+    {
+        return n_requests;
+    };
+
+    // The total size of the request bodies received
+    long long bodyBytes()
+    {
+        return n_body_bytes;
+    };
+
+    // Whether request bodies are passed to the handler. Large uploads may be counted without being kept in memory
+    void keepBodies(bool keep)
+    {
+        keep_bodies = keep;
+    };
+
+    // Delays the response to every request by the given number of milliseconds
+    void setLatency(int milliseconds)
+    {
+        latency_ms = milliseconds;
+    };
+
+    // Limits each connection to the given number of bytes per second in each direction. Zero removes the limit
+    void setBandwidth(long long bytes_per_second)
+    {
+        bandwidth = bytes_per_second;
+    };
+
+private:
+    Handler handler;
+    int listener;
+    int port;
+    std::atomic<long> n_connections;
+    std::atomic<long> n_requests;
+    std::atomic<long long> n_body_bytes;
+    std::atomic<bool> keep_bodies;
+    std::atomic<int> latency_ms;
+    std::atomic<long long> bandwidth;
+    std::atomic<bool> running;
+    std::thread acceptor;
+    std::vector<std::thread> workers;
+    std::vector<int> connections;
+    std::mutex connection_lock;
+
+    void acceptConnections()
+    {
+        while (running)
+        {
+            int connection = accept(listener, NULL, NULL);
+            if (connection < 0)
+                break;
+            int no_delay = 1;
+            setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+            ++n_connections;
+            std::lock_guard<std::mutex> lock(connection_lock);
+            connections.push_back(connection);
+            workers.push_back(std::thread(&MockServer::serve, this, connection));
+        }
+    };
+
+    // Waits until the given number of bytes may be transferred within the bandwidth. Each direction of a connection has
+    // its own clock, as it would on a full-duplex link
+    // @param next_free The time at which the link is next free, in the direction of the transfer
+    void pace(std::chrono::steady_clock::time_point& next_free, size_t n_bytes)
+    {
+        long long bytes_per_second = bandwidth;
+        if (bytes_per_second <= 0)
+            return;
+        next_free = std::max(next_free, std::chrono::steady_clock::now()) + std::chrono::microseconds(n_bytes * 1000000 / bytes_per_second);
+        std::this_thread::sleep_until(next_free);
+    };
+
+    bool receive(int connection, std::string& buffer)
+    {
+        char chunk[65536];
+        static thread_local std::chrono::steady_clock::time_point next_free;  // Each connection is served by its own thread
+        ssize_t n_read = recv(connection, chunk, sizeof(chunk), 0);
+        if (n_read <= 0)
+            return false;
+        pace(next_free, n_read);
+        buffer.append(chunk, n_read);
+        return true;
+    };
+
+    // Sends a reply in chunks, so that a limited bandwidth is spread over the transfer
+    bool transmit(int connection, const std::string& reply)
+    {
+        if (bandwidth <= 0)
+            return send(connection, reply.c_str(), reply.size(), MSG_NOSIGNAL) >= 0;
+        static thread_local std::chrono::steady_clock::time_point next_free;  // Each connection is served by its own thread
+        const size_t chunk_size = 16384;
+        for (size_t i_sent = 0; i_sent < reply.size(); i_sent += chunk_size)
+        {
+            size_t n_bytes = std::min(chunk_size, reply.size() - i_sent);
+            pace(next_free, n_bytes);
+            if (send(connection, reply.c_str() + i_sent, n_bytes, MSG_NOSIGNAL) < 0)
+                return false;
+        }
+        return true;
+    };
+
+    // Reads requests from a connection until the client closes it. The socket is closed when the server is destroyed
+    void serve(int connection)
+    {
+        std::string buffer;
+        while (true)
+        {
+            // Read the request head
+            size_t head_end;
+            while ((head_end = buffer.find("\r\n\r\n")) == std::string::npos)
+                if (!receive(connection, buffer))
+                    return;
+            MockRequest request;
+            std::string head = buffer.substr(0, head_end);
+            size_t line_end = head.find("\r\n");
+            std::string request_line = head.substr(0, line_end);
+            size_t i_path = request_line.find(' ');
+            size_t i_version = request_line.rfind(' ');
+            request.method = request_line.substr(0, i_path);
+            request.path = request_line.substr(i_path + 1, i_version - i_path - 1);
+            while (line_end != std::string::npos && line_end < head.size())
+            {
+                size_t next_end = head.find("\r\n", line_end + 2);
+                std::string line = head.substr(line_end + 2, next_end == std::string::npos ? std::string::npos : next_end - line_end - 2);
+                size_t i_colon = line.find(':');
+                if (i_colon != std::string::npos)
+                {
+                    std::string name = line.substr(0, i_colon);
+                    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+                    size_t i_value = line.find_first_not_of(' ', i_colon + 1);
+                    request.headers[name] = i_value == std::string::npos ? "" : line.substr(i_value);
+                }
+                line_end = next_end;
+            }
+            buffer.erase(0, head_end + 4);
+
+            // Read the request body
+            size_t content_length = 0;
+            if (request.headers.count("content-length"))
+                content_length = std::stoul(request.headers["content-length"]);
+            if (request.headers.count("expect"))
+            {
+                std::string proceed = "HTTP/1.1 100 Continue\r\n\r\n";
+                send(connection, proceed.c_str(), proceed.size(), MSG_NOSIGNAL);
+            }
+            if (request.headers.count("transfer-encoding") && request.headers["transfer-encoding"] == "chunked")
+            {
+                // Each chunk is preceded by its size in hexadecimal, and a chunk of size zero ends the body
+                while (true)
+                {
+                    size_t size_end;
+                    while ((size_end = buffer.find("\r\n")) == std::string::npos)
+                        if (!receive(connection, buffer))
+                            return;
+                    size_t chunk_size = std::stoul(buffer.substr(0, size_end), NULL, 16);
+                    buffer.erase(0, size_end + 2);
+                    if (chunk_size == 0)
+                    {
+                        size_t trailer_end;
+                        while ((trailer_end = buffer.find("\r\n")) == std::string::npos)
+                            if (!receive(connection, buffer))
+                                return;
+                        buffer.erase(0, trailer_end + 2);
+                        break;
+                    }
+                    while (buffer.size() < chunk_size + 2)
+                        if (!receive(connection, buffer))
+                            return;
+                    if (keep_bodies)
+                        request.body.append(buffer, 0, chunk_size);
+                    n_body_bytes += chunk_size;
+                    buffer.erase(0, chunk_size + 2);
+                }
+            }
+            else
+            {
+                while (buffer.size() < content_length)
+                    if (!receive(connection, buffer))
+                        return;
+                if (keep_bodies)
+                    request.body = buffer.substr(0, content_length);
+                n_body_bytes += content_length;
+                buffer.erase(0, content_length);
+            }
+            ++n_requests;
+
+            if (latency_ms > 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(latency_ms));
+            MockResponse response = handler(request);
+            std::string reply = "HTTP/1.1 " + std::to_string(response.status) + " " + (response.status < 400 ? "OK" : "Error") + "\r\n";
+            reply += "Content-Type: " + response.content_type + "\r\n";
+            reply += "Content-Length: " + std::to_string(response.body.size()) + "\r\n";
+            for (auto& header : response.headers)
+                reply += header.first + ": " + header.second + "\r\n";
+            reply += "\r\n" + response.body;
+            if (!transmit(connection, reply))
+                return;
+        }
+    };
+};
+
+#endif
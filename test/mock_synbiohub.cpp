@@ -0,0 +1,43 @@
+#define RAPTOR_STATIC
+
+#include "sbol.h"
+#include "mock_synbiohub.h"
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+
+using namespace std;
+using namespace sbol;
+
+
+// Serves a directory of SBOL files as a SynBioHub repository until interrupted, so that PartShop clients, including the
+// Python tests, can be run without a network
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        cerr << "Usage: " << argv[0] << " corpus_directory [port] [latency_ms] [bandwidth_bytes_per_second]" << endl;
+        return 1;
+    }
+    Config::setOption("validate", false);
+    int port = argc > 2 ? atoi(argv[2]) : 0;
+    try
+    {
+        MockSynBioHub hub(argv[1], port);
+        if (argc > 3)
+            hub.setLatency(atoi(argv[3]));
+        if (argc > 4)
+            hub.setBandwidth(atoll(argv[4]));
+        cout << "Serving " << hub.size() << " objects at " << hub.url() << endl;
+        if (hub.unreadableCount())
+            cout << hub.unreadableCount() << " files could not be read" << endl;
+        pause();
+    }
+    catch (SBOLError& e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
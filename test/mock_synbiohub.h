@@ -0,0 +1,538 @@
+/**
+ * @file    mock_synbiohub.h
+ * @brief   A stand-in for a SynBioHub repository, serving an SBOL corpus from disk through the endpoints used by PartShop
+ * @author  Bryan Bartley
+ * @email   bartleyba@sbolstandard.org
+ *
+ * <!--------------------------------------------------------------------------
+ * This file is part of libSBOL.  Please visit http://sbolstandard.org for more
+ * information about SBOL, and the latest version of libSBOL.
+ *
+ *  Copyright 2016 University of Washington, WA, USA
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, *
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * ------------------------------------------------------------------------->*/
+
+#ifndef MOCK_SYNBIOHUB_INCLUDED
+#define MOCK_SYNBIOHUB_INCLUDED
+
+#include "sbol.h"
+#include "mock_server.h"
+
+#include <map>
+#include <set>
+#include <memory>
+#include <sstream>
+#include <cctype>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+// Serves the SBOL files of a directory through the SynBioHub endpoints used by PartShop:
+//   GET  /remoteSearch/<criteria>/?offset=&limit=  The records of matching objects, as JSON
+//   GET  /searchCount/<criteria>                   The number of matching objects
+//   GET  <object>/sbol                             The object, with the objects in its file which it refers to
+//   GET  <object>/sbolnr                           The object alone
+//   GET  <object>/metadata                         The record of the object, or [] if there is none
+//   GET  /sparql?query=                            The subject, displayId, name and type of every object. The query is not
+//                                                  evaluated, apart from its LIMIT and OFFSET
+//   POST /submit                                   Adds the objects of the submitted file to the corpus. Compressed
+//                                                  submissions are accepted without being indexed
+//   POST <object>/attach                           Stores the uploaded file, which is then served by <object>/download
+// Objects are found by the path of their URI, whatever its host, so an object may be pulled through the served URLs, or
+// by its URI from a PartShop which spoofs the host of the corpus.
+class MockSynBioHub
+{
+public:
+    MockSynBioHub(std::string corpus_path, int port = 0) :
+        n_submissions(0),
+        server([this](const MockRequest& request) { return handle(request); }, port)
+    {
+        DIR* directory = opendir(corpus_path.c_str());
+        if (!directory)
+            throw sbol::SBOLError(sbol::SBOL_ERROR_FILE_NOT_FOUND, "Corpus directory " + corpus_path + " not found");
+        std::vector<std::string> filenames;
+        while (dirent* entry = readdir(directory))
+        {
+            std::string path = corpus_path + "/" + entry->d_name;
+            struct stat info;
+            if (entry->d_name[0] != '.' && stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode))
+                filenames.push_back(path);
+        }
+        closedir(directory);
+        std::sort(filenames.begin(), filenames.end());
+
+        std::lock_guard<std::mutex> lock(corpus_lock);
+        for (auto& filename : filenames)
+        {
+            std::unique_ptr<sbol::Document> doc(new sbol::Document());
+            try
+            {
+                doc->read(filename);
+            }
+            catch (sbol::SBOLError&)
+            {
+                n_unreadable++;
+                continue;
+            }
+            index(std::move(doc));
+        }
+    };
+
+    // The base URL of the server, without a terminal slash
+    std::string url()
+    {
+        return server.url();
+    };
+
+    // The URLs from which the objects of the corpus are served, in the order in which they were loaded
+    std::vector<std::string> urls()
+    {
+        std::lock_guard<std::mutex> lock(corpus_lock);
+        std::vector<std::string> served;
+        for (auto& path : paths)
+            served.push_back(server.url() + path);
+        return served;
+    };
+
+    // The number of objects in the corpus
+    size_t size()
+    {
+        std::lock_guard<std::mutex> lock(corpus_lock);
+        return paths.size();
+    };
+
+    // The number of corpus files which could not be read
+    int unreadableCount()
+    {
+        return n_unreadable;
+    };
+
+    int submissionCount()
+    {
+        return n_submissions;
+    };
+
+    long requestCount()
+    {
+        return server.requestCount();
+    };
+
+    void setLatency(int milliseconds)
+    {
+        server.setLatency(milliseconds);
+    };
+
+    void setBandwidth(long long bytes_per_second)
+    {
+        server.setBandwidth(bytes_per_second);
+    };
+
+private:
+    struct Entry
+    {
+        sbol::Document* doc;
+        sbol::SBOLObject* obj;
+        std::string sbol;  // Serializations, made when the object is first requested
+        std::string sbolnr;
+    };
+
+    std::vector<std::unique_ptr<sbol::Document>> documents;
+    std::map<std::string, Entry> objects;  // The objects of the corpus, by the path of their URI
+    std::vector<std::string> paths;
+    std::map<std::string, std::pair<std::string, std::string>> attachments;  // The name and content of each upload, by object path
+    std::mutex corpus_lock;
+    int n_unreadable = 0;
+    std::atomic<int> n_submissions;
+    MockServer server;  // Declared last, so that it stops serving before the corpus is destroyed
+
+    static std::string uriPath(const std::string& uri)
+    {
+        size_t i_scheme = uri.find("://");
+        size_t i_path = uri.find('/', i_scheme == std::string::npos ? 0 : i_scheme + 3);
+        return i_path == std::string::npos ? "/" : uri.substr(i_path);
+    };
+
+    static std::string decode(const std::string& text)
+    {
+        std::string decoded;
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            if (text[i] == '%' && i + 2 < text.size() && isxdigit(text[i + 1]) && isxdigit(text[i + 2]))
+            {
+                decoded += (char)std::stoi(text.substr(i + 1, 2), NULL, 16);
+                i += 2;
+            }
+            else if (text[i] == '+')
+                decoded += ' ';
+            else
+                decoded += text[i];
+        }
+        return decoded;
+    };
+
+    static std::string lower(std::string text)
+    {
+        std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+        return text;
+    };
+
+    // The first value of a literal property, without its quotes
+    static std::string literal(sbol::SBOLObject& obj, std::string property_uri)
+    {
+        auto i_property = obj.properties.find(property_uri);
+        if (i_property == obj.properties.end() || i_property->second.empty())
+            return "";
+        std::string value = i_property->second[0];
+        if (value.size() >= 2 && (value[0] == '"' || value[0] == '<'))
+            return value.substr(1, value.size() - 2);
+        return value;
+    };
+
+    // Adds the TopLevel objects of a Document to the corpus, replacing any with the same path
+    void index(std::unique_ptr<sbol::Document> doc)
+    {
+        for (auto& i_obj : doc->SBOLObjects)
+        {
+            std::string path = uriPath(i_obj.first);
+            if (!objects.count(path))
+                paths.push_back(path);
+            objects[path] = { doc.get(), i_obj.second, "", "" };
+        }
+        documents.push_back(std::move(doc));
+    };
+
+    static void getReferences(sbol::SBOLObject& obj, std::vector<std::string>& references)
+    {
+        for (auto& i_property : obj.properties)
+            for (auto& value : i_property.second)
+                if (value.size() > 2 && value[0] == '<')
+                    references.push_back(value.substr(1, value.size() - 2));
+        for (auto& i_store : obj.owned_objects)
+            for (auto child : i_store.second)
+                getReferences(*child, references);
+    };
+
+    // The objects of the corpus are not modified once loaded, so they are serialized without holding the corpus lock
+    static std::string serialize(const Entry& entry, bool recursive)
+    {
+        // Gather the objects of the same file which the object refers to, directly or indirectly
+        std::vector<sbol::SBOLObject*> closure = { entry.obj };
+        std::set<std::string> visited = { entry.obj->identity.get() };
+        for (size_t i_obj = 0; recursive && i_obj < closure.size(); ++i_obj)
+        {
+            std::vector<std::string> references;
+            getReferences(*closure[i_obj], references);
+            for (auto& uri : references)
+            {
+                auto i_reference = entry.doc->SBOLObjects.find(uri);
+                if (i_reference != entry.doc->SBOLObjects.end() && visited.insert(uri).second)
+                    closure.push_back(i_reference->second);
+            }
+        }
+        std::ostringstream os;
+        entry.doc->serialize_rdfxml_header(os);
+        for (auto obj : closure)
+            entry.doc->serialize_rdfxml_toplevel(os, *obj);
+        entry.doc->serialize_rdfxml_footer(os);
+        return os.str();
+    };
+
+    // The serialization of an object, made when it is first requested
+    // @return False if the corpus has no such object
+    bool serialization(const std::string& path, bool recursive, std::string& serialized)
+    {
+        Entry entry;
+        {
+            std::lock_guard<std::mutex> lock(corpus_lock);
+            auto i_object = objects.find(path);
+            if (i_object == objects.end())
+                return false;
+            entry = i_object->second;
+        }
+        serialized = recursive ? entry.sbol : entry.sbolnr;
+        if (serialized != "")
+            return true;
+        serialized = serialize(entry, recursive);
+
+        // Keep the serialization, unless the object was replaced meanwhile
+        std::lock_guard<std::mutex> lock(corpus_lock);
+        auto i_object = objects.find(path);
+        if (i_object != objects.end() && i_object->second.obj == entry.obj)
+            (recursive ? i_object->second.sbol : i_object->second.sbolnr) = serialized;
+        return true;
+    };
+
+    // The objects of the corpus, in the order in which they were loaded
+    std::vector<sbol::SBOLObject*> corpus()
+    {
+        std::lock_guard<std::mutex> lock(corpus_lock);
+        std::vector<sbol::SBOLObject*> loaded;
+        for (auto& path : paths)
+            loaded.push_back(objects[path].obj);
+        return loaded;
+    };
+
+    // Writes JSON without the newline which Json::FastWriter appends, as SynBioHub does
+    static std::string json(const Json::Value& value)
+    {
+        std::string text = Json::FastWriter().write(value);
+        if (text.size() && text.back() == '\n')
+            text.pop_back();
+        return text;
+    };
+
+    static Json::Value record(sbol::SBOLObject& obj)
+    {
+        Json::Value record;
+        record["uri"] = obj.identity.get();
+        record["displayId"] = literal(obj, SBOL_DISPLAY_ID);
+        record["name"] = literal(obj, SBOL_NAME);
+        record["description"] = literal(obj, SBOL_DESCRIPTION);
+        record["version"] = literal(obj, SBOL_VERSION);
+        return record;
+    };
+
+    // Finds the objects which match the criteria of a search, in the order in which they were loaded
+    std::vector<sbol::SBOLObject*> search(const std::string& criteria)
+    {
+        std::string object_type;
+        std::string text;
+        std::vector<std::pair<std::string, std::string>> constraints;
+        std::istringstream tokens(criteria);
+        std::string token;
+        while (std::getline(tokens, token, '&'))
+        {
+            size_t i_assignment = token.find(">=");
+            if (token.find("objectType=") == 0)
+                object_type = token.substr(11);
+            else if (token.size() > 0 && token[0] == '<' && i_assignment != std::string::npos)
+            {
+                // An exact criterion, whose value is a quoted literal or a URI in angle brackets
+                std::string value = token.substr(i_assignment + 2);
+                if (value.size() >= 2 && value[0] == '\'')
+                    value = "\"" + value.substr(1, value.size() - 2) + "\"";
+                constraints.push_back({ token.substr(1, i_assignment - 1), value });
+            }
+            else
+                text += token;
+        }
+        text = lower(text);
+
+        std::vector<sbol::SBOLObject*> matches;
+        for (auto loaded : corpus())
+        {
+            sbol::SBOLObject& obj = *loaded;
+            if (object_type != "" && sbol::parseClassName(obj.type) != object_type)
+                continue;
+            bool match = true;
+            for (auto& constraint : constraints)
+            {
+                auto i_property = obj.properties.find(constraint.first);
+                if (i_property == obj.properties.end() || std::find(i_property->second.begin(), i_property->second.end(), constraint.second) == i_property->second.end())
+                    match = false;
+            }
+            if (match && text != "")
+                match = lower(literal(obj, SBOL_DISPLAY_ID)).find(text) != std::string::npos ||
+                    lower(literal(obj, SBOL_NAME)).find(text) != std::string::npos ||
+                    lower(literal(obj, SBOL_DESCRIPTION)).find(text) != std::string::npos;
+            if (match)
+                matches.push_back(&obj);
+        }
+        return matches;
+    };
+
+    static int parameter(const std::string& query, std::string name, int default_value)
+    {
+        size_t i_name = query.find(name + "=");
+        if (i_name == std::string::npos)
+            return default_value;
+        return std::atoi(query.c_str() + i_name + name.size() + 1);
+    };
+
+    // The value of a SPARQL solution modifier, such as LIMIT 10
+    static int modifier(const std::string& query, std::string keyword, int default_value)
+    {
+        size_t i_keyword = lower(query).find(keyword);
+        if (i_keyword == std::string::npos)
+            return default_value;
+        return std::atoi(query.c_str() + i_keyword + keyword.size());
+    };
+
+    // The content and filename of the part of a multipart/form-data body named "file"
+    static std::string filePart(const MockRequest& request, std::string* filename = NULL)
+    {
+        size_t i_part = request.body.find("name=\"file\"");
+        if (i_part == std::string::npos)
+            return "";
+        size_t i_start = request.body.find("\r\n\r\n", i_part);
+        if (i_start == std::string::npos)
+            return "";
+        if (filename)
+        {
+            size_t i_filename = request.body.find("filename=\"", i_part);
+            if (i_filename != std::string::npos && i_filename < i_start)
+            {
+                i_filename += 10;
+                *filename = request.body.substr(i_filename, request.body.find('"', i_filename) - i_filename);
+            }
+        }
+        i_start += 4;
+        size_t i_end = request.body.find("\r\n--", i_start);
+        return request.body.substr(i_start, i_end == std::string::npos ? std::string::npos : i_end - i_start);
+    };
+
+    MockResponse handle(const MockRequest& request)
+    {
+        MockResponse response;
+        std::string path = request.path;
+
+        if (path.find("/remoteSearch/") == 0 || path.find("/searchCount/") == 0)
+        {
+            bool count = path.find("/searchCount/") == 0;
+            std::string criteria = path.substr(path.find('/', 1) + 1);
+            std::string query;
+            size_t i_query = criteria.find("/?");
+            if (i_query != std::string::npos)
+            {
+                query = criteria.substr(i_query + 2);
+                criteria = criteria.substr(0, i_query);
+            }
+            std::vector<sbol::SBOLObject*> matches = search(decode(criteria));
+            if (count)
+            {
+                response.body = std::to_string(matches.size());
+                return response;
+            }
+            int offset = parameter(query, "offset", 0);
+            int limit = parameter(query, "limit", 50);
+            Json::Value records(Json::arrayValue);
+            for (int i_match = offset; i_match >= 0 && i_match < (int)matches.size() && i_match < offset + limit; ++i_match)
+                records.append(record(*matches[i_match]));
+            response.content_type = "application/json";
+            response.body = json(records);
+            return response;
+        }
+        if (path.find("/sparql?") == 0)
+        {
+            std::string query = decode(path.substr(path.find("query=") + 6));
+            std::vector<sbol::SBOLObject*> loaded = corpus();
+            int offset = modifier(query, "offset", 0);
+            int limit = modifier(query, "limit", (int)loaded.size());
+            Json::Value results;
+            for (std::string variable : { "subject", "displayId", "name", "type" })
+                results["head"]["vars"].append(variable);
+            results["results"]["bindings"] = Json::Value(Json::arrayValue);
+            for (int i_obj = offset; i_obj >= 0 && i_obj < (int)loaded.size() && i_obj < offset + limit; ++i_obj)
+            {
+                sbol::SBOLObject& obj = *loaded[i_obj];
+                Json::Value binding;
+                binding["subject"]["type"] = "uri";
+                binding["subject"]["value"] = obj.identity.get();
+                binding["displayId"]["type"] = "literal";
+                binding["displayId"]["value"] = literal(obj, SBOL_DISPLAY_ID);
+                binding["name"]["type"] = "literal";
+                binding["name"]["value"] = literal(obj, SBOL_NAME);
+                binding["type"]["type"] = "uri";
+                binding["type"]["value"] = obj.type;
+                results["results"]["bindings"].append(binding);
+            }
+            response.content_type = "application/sparql-results+json";
+            response.body = json(results);
+            return response;
+        }
+        if (request.method == "POST" && path == "/submit")
+        {
+            std::string sbol = filePart(request);
+            ++n_submissions;
+            if (sbol.size() > 0 && sbol[0] == '<')
+            {
+                std::unique_ptr<sbol::Document> doc(new sbol::Document());
+                try
+                {
+                    doc->readString(sbol, "sbol");
+                }
+                catch (sbol::SBOLError& e)
+                {
+                    response.status = 400;
+                    response.body = e.what();
+                    return response;
+                }
+                std::lock_guard<std::mutex> lock(corpus_lock);
+                index(std::move(doc));
+            }
+            response.body = "Successfully uploaded";
+            return response;
+        }
+
+        size_t i_endpoint = path.rfind('/');
+        std::string endpoint = path.substr(i_endpoint + 1);
+        std::string object_path = path.substr(0, i_endpoint);
+        if (request.method == "POST" && endpoint == "attach")
+        {
+            std::string filename = "attachment";
+            std::string content = filePart(request, &filename);
+            std::lock_guard<std::mutex> lock(corpus_lock);
+            attachments[object_path] = { filename, content };
+            response.body = "Successfully uploaded";
+            return response;
+        }
+        if (endpoint == "download")
+        {
+            std::pair<std::string, std::string> attachment;
+            bool found = false;
+            {
+                std::lock_guard<std::mutex> lock(corpus_lock);
+                auto i_attachment = attachments.find(object_path);
+                if (i_attachment != attachments.end())
+                {
+                    attachment = i_attachment->second;
+                    found = true;
+                }
+            }
+            if (found)
+            {
+                response.content_type = "application/octet-stream";
+                response.headers["Content-Disposition"] = "attachment; filename=\"" + attachment.first + "\"";
+                response.body = attachment.second;
+                return response;
+            }
+        }
+        if (endpoint == "metadata")
+        {
+            sbol::SBOLObject* obj = NULL;
+            {
+                std::lock_guard<std::mutex> lock(corpus_lock);
+                auto i_object = objects.find(object_path);
+                if (i_object != objects.end())
+                    obj = i_object->second.obj;
+            }
+            Json::Value records(Json::arrayValue);
+            if (obj)
+                records.append(record(*obj));
+            response.content_type = "application/json";
+            response.body = json(records);
+            return response;
+        }
+        if ((endpoint == "sbol" || endpoint == "sbolnr") && serialization(object_path, endpoint == "sbol", response.body))
+        {
+            response.content_type = "application/rdf+xml";
+            return response;
+        }
+        response.status = 404;
+        response.body = "Not found";
+        return response;
+    };
+};
+
+#endif
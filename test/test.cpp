@@ -12,6 +12,13 @@
 #include <vector>
 #include <algorithm>
 
+#ifndef _WIN32
+#include "mock_server.h"
+#include <future>
+#include <atomic>
+#include <cstdlib>
+#endif
+
 using namespace std;
 using namespace sbol;
 
@@ -68,6 +75,129 @@ bool roundtrip(string path, string filename)
     }
 }
 
+#ifndef _WIN32
+// Checks that a future reports an SBOLError within the given time, rather than a value or another exception
+template <class T>
+bool reports_sbol_error(string request, future<T>& f, int timeout_ms)
+{
+    if (f.wait_for(chrono::milliseconds(timeout_ms)) != future_status::ready)
+    {
+        cerr << request << " did not complete" << endl;
+        return false;
+    }
+    try
+    {
+        f.get();
+    }
+    catch (SBOLError& e)
+    {
+        return true;
+    }
+    catch (const std::exception& e)
+    {
+        cerr << request << " failed without an SBOLError: " << e.what() << endl;
+        return false;
+    }
+    cerr << request << " succeeded" << endl;
+    return false;
+}
+
+// Removes a directory of downloads, including the partial downloads which are kept when a download is interrupted
+void remove_downloads(string path)
+{
+    DIR* downloads = opendir(path.c_str());
+    for (struct dirent* file = readdir(downloads); file; file = readdir(downloads))
+        if (string(file->d_name) != "." && string(file->d_name) != "..")
+            remove((path + "/" + file->d_name).c_str());
+    closedir(downloads);
+    rmdir(path.c_str());
+}
+
+// A Document which may be submitted as a new collection
+Document& submittable_document()
+{
+    Document& doc = *new Document();
+    doc.displayId.set("collection");
+    doc.name.set("collection");
+    doc.description.set("A collection");
+    doc.componentDefinitions.create("cd");
+    return doc;
+}
+
+// Each asynchronous PartShop request reports an HTTP error status from its future as an SBOLError
+bool async_errors(int status)
+{
+    char path[] = "async_XXXXXX";
+    mkdtemp(path);
+    MockServer server([status](const MockRequest& request)
+    {
+        MockResponse response;
+        response.status = status;
+        response.body = "[]";  // A valid search response and metadata, so only the status reports the error
+        return response;
+    });
+    PartShop shop(server.url());
+    Document& pulled = *new Document();
+    Document& submitted = submittable_document();
+    future<void> pull = shop.pullAsync(server.url() + "/cd", pulled);
+    future<SearchResponse&> search = shop.searchAsync("cd");
+    future<string> submit = shop.submitAsync(submitted);
+    future<bool> exists = shop.existsAsync(server.url() + "/cd");
+    future<string> download = shop.downloadAttachmentAsync(server.url() + "/attachment", path);
+    bool passed = reports_sbol_error("pullAsync", pull, 10000);
+    passed = reports_sbol_error("searchAsync", search, 10000) && passed;
+    passed = reports_sbol_error("submitAsync", submit, 10000) && passed;
+    passed = reports_sbol_error("existsAsync", exists, 10000) && passed;
+    passed = reports_sbol_error("downloadAttachmentAsync", download, 10000) && passed;
+    remove_downloads(path);
+    std::cout << (passed ? "PASS" : "FAIL") << std::endl;
+    return passed;
+}
+
+// Requests which are pending when the last copy of a PartShop is destroyed are abandoned, and their futures report an
+// SBOLError. A copy of the PartShop keeps them pending
+bool async_abandoned()
+{
+    char path[] = "async_XXXXXX";
+    mkdtemp(path);
+    atomic<bool> released(false);
+    MockServer server([&released](const MockRequest& request)
+    {
+        for (int i_wait = 0; i_wait < 1000 && !released; ++i_wait)
+            this_thread::sleep_for(chrono::milliseconds(10));
+        MockResponse response;
+        response.status = 404;
+        return response;
+    });
+    Document& pulled = *new Document();
+    Document& submitted = submittable_document();
+    PartShop* shop = new PartShop(server.url());
+    future<void> pull = shop->pullAsync(server.url() + "/cd", pulled);
+    future<SearchResponse&> search = shop->searchAsync("cd");
+    future<string> submit = shop->submitAsync(submitted);
+    future<bool> exists = shop->existsAsync(server.url() + "/cd");
+    future<string> download = shop->downloadAttachmentAsync(server.url() + "/attachment", path);
+    PartShop* copy = new PartShop(*shop);
+    delete shop;
+    bool passed = true;
+    if (pull.wait_for(chrono::milliseconds(100)) == future_status::ready)
+    {
+        cerr << "Requests were abandoned while a copy of the PartShop remained" << endl;
+        passed = false;
+    }
+    delete copy;
+    passed = reports_sbol_error("pullAsync", pull, 0) && passed;
+    passed = reports_sbol_error("searchAsync", search, 0) && passed;
+    passed = reports_sbol_error("submitAsync", submit, 0) && passed;
+    passed = reports_sbol_error("existsAsync", exists, 0) && passed;
+    passed = reports_sbol_error("downloadAttachmentAsync", download, 0) && passed;
+    released = true;
+    remove_downloads(path);
+    std::cout << (passed ? "PASS" : "FAIL") << std::endl;
+    return passed;
+}
+#endif
+
 int main(int argc, char* argv[])
 { 
     Config::setOption("validate", false);
@@ -85,6 +215,27 @@ int main(int argc, char* argv[])
     }
     else
     {
+#ifndef _WIN32
+        // The asynchronous PartShop requests are run against a server on the loopback interface
+        for (int status : { 404, 401 })
+        {
+            std::cout << "================" << std::endl;
+            std::cout << "TEST CASE async requests returning " << status << std::endl;
+            std::cout << "================" << std::endl;
+            if (async_errors(status))
+                passed++;
+            else
+                failed++;
+        }
+        std::cout << "================" << std::endl;
+        std::cout << "TEST CASE async requests abandoned" << std::endl;
+        std::cout << "================" << std::endl;
+        if (async_abandoned())
+            passed++;
+        else
+            failed++;
+#endif
+
         DIR* valid = opendir(path.c_str());
         struct dirent * file = readdir(valid);
         int test_case = 0;
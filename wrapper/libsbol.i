@@ -35,6 +35,7 @@
     #include "implementation.h"
     #include "experiment.h"
     #include "dbtl.h"
+    #include "sequencefile.h"
     #include "sbol.h"
 
     #include <vector>
@@ -196,6 +197,18 @@
 }
 
 // Hide these methods in the Python API
+%ignore sbol::ValidationContext;
+%ignore sbol::ValidationDiagnostic;
+%ignore sbol::PropertyRules;
+%ignore sbol::SBOLObject::property_rules;
+%ignore sbol::SBOLObject::python_rules;
+%ignore sbol::ClassPropertyRules;
+%ignore sbol::register_property_rules;
+%ignore sbol::find_property_rules;
+%ignore sbol::checks_stored_values;
+%ignore sbol::DeferredValidation::active;
+%ignore sbol::DeferredValidation::record;
+%ignore sbol::DeferredValidation::forget;
 %ignore sbol::SBOLObject::close;
 %ignore sbol::SBOLObject::properties;
 %ignore sbol::SBOLObject::list_properties;
@@ -214,11 +227,30 @@
 %ignore sbol::ReferencedObject::end;
 %ignore sbol::ReferencedObject::size;
 %ignore sbol::Document::parse_objects;
+%ignore sbol::Document::readString(std::string& sbol, std::string serialization_format);
 %ignore sbol::Document::parse_properties;
 %ignore sbol::Document::namespaceHandler;
 %ignore sbol::Document::flatten();
 %ignore sbol::Document::parse_objects;
 %ignore sbol::Document::close;
+%ignore sbol::Document::provenance;
+%ignore sbol::ProvenanceIndex;
+%ignore sbol::HTTPClient;
+%ignore sbol::HTTPResponse;
+%ignore sbol::PartCache;
+%ignore sbol::CacheEntry;
+%ignore sbol::find_header;
+%ignore sbol::SearchResults::next;
+%ignore sbol::SPARQLDecoder;
+%ignore sbol::SPARQLResults::values;
+%ignore sbol::SPARQLResults::types;
+%ignore sbol::SPARQLResults::datatypes;
+%ignore sbol::SPARQLResults::languages;
+%ignore sbol::PartShop::sparqlQuery(std::string query, void (*row_fn)(const std::vector<std::string>& variables, std::vector<SPARQLTerm>& row, void* user_data), void* user_data);
+%ignore sbol::PartShop::sparqlQuery(std::string query, void (*row_fn)(const std::vector<std::string>& variables, std::vector<SPARQLTerm>& row, void* user_data));
+%ignore sbol::SearchResults::iterator;
+%ignore sbol::SearchResults::begin;
+%ignore sbol::SearchResults::end;
 %ignore sbol::ComponentDefinition::assemble(std::vector<std::string> list_of_uris, Document& doc);  // Use variant signature defined in this interface file
 %ignore sbol::ComponentDefinition::assemble(std::vector<std::string> list_of_uris);  // Use variant signature defined in this interface file
 %ignore sbol::ComponentDefinition::linearize(std::vector<std::string> list_of_uris);  // Use variant signature defined in this interface file
@@ -226,6 +258,13 @@
 %ignore sbol::ComponentDefinition::assemblePrimaryStructure(std::vector<ComponentDefinition*> primary_structure, Document& doc);
 %ignore sbol::ComponentDefinition::assemblePrimaryStructure(std::vector<std::string> primary_structure);
 %ignore sbol::TopLevel::addToDocument;
+%ignore sbol::PackedNucleotides::Run;
+%ignore sbol::PackedNucleotides::code;
+%ignore sbol::PackedNucleotides::words;
+%ignore sbol::PackedNucleotides::ambiguities;
+%ignore sbol::PackedNucleotides::uppercase;
+%ignore sbol::ElementsProperty::packed;
+%ignore sbol::DerivationPosition;
 
 // Instantiate STL templates
 %include "std_string.i"
@@ -280,6 +319,75 @@
     
 }
 
+// Typemap the hash table returned by Analysis::reportQC. Each entry maps to a dictionary of its QC statistics
+%typemap(out) std::unordered_map < std::string, sbol::QCStatistics > {
+    PyObject* dict = PyDict_New();
+    for(auto & i_elem : $1)
+    {
+        sbol::QCStatistics& qc = i_elem.second;
+        PyObject* py_vals = Py_BuildValue("{s:i,s:i,s:f,s:f,s:f,s:f}", "start", qc.start, "end", qc.end, "identity", qc.identity, "error", qc.error, "ambiguity", qc.ambiguity, "coverage", qc.coverage);
+        PyDict_SetItemString(dict, i_elem.first.c_str(), py_vals);
+        Py_DECREF(py_vals);
+    }
+    $result  = dict;
+    $1.clear();
+}
+
+// Typemap the report returned by Document::validateAll into a list of (rule, uri, message) tuples
+%typemap(out) sbol::ValidationReport {
+    PyObject* diagnostics = PyList_New(0);
+    for (auto & diagnostic : $1.diagnostics)
+    {
+        PyObject* py_diagnostic = Py_BuildValue("(sss)", diagnostic.rule.c_str(), diagnostic.uri.c_str(), diagnostic.message.c_str());
+        PyList_Append(diagnostics, py_diagnostic);
+        Py_DECREF(py_diagnostic);
+    }
+    $result  = diagnostics;
+}
+
+// Typemap the table returned by Document::reportQC into a dictionary of columns
+%typemap(out) sbol::QCReportTable {
+    PyObject* dict = PyDict_New();
+    PyObject* analysis = PyList_New(0);
+    PyObject* definition = PyList_New(0);
+    PyObject* start = PyList_New(0);
+    PyObject* end = PyList_New(0);
+    PyObject* identity = PyList_New(0);
+    PyObject* error = PyList_New(0);
+    PyObject* ambiguity = PyList_New(0);
+    PyObject* coverage = PyList_New(0);
+    for (size_t i_row = 0; i_row < $1.size(); ++i_row)
+    {
+        PyObject* vals = Py_BuildValue("(ssiiffff)", $1.analysis[i_row].c_str(), $1.definition[i_row].c_str(), $1.start[i_row], $1.end[i_row], $1.identity[i_row], $1.error[i_row], $1.ambiguity[i_row], $1.coverage[i_row]);
+        PyList_Append(analysis, PyTuple_GetItem(vals, 0));
+        PyList_Append(definition, PyTuple_GetItem(vals, 1));
+        PyList_Append(start, PyTuple_GetItem(vals, 2));
+        PyList_Append(end, PyTuple_GetItem(vals, 3));
+        PyList_Append(identity, PyTuple_GetItem(vals, 4));
+        PyList_Append(error, PyTuple_GetItem(vals, 5));
+        PyList_Append(ambiguity, PyTuple_GetItem(vals, 6));
+        PyList_Append(coverage, PyTuple_GetItem(vals, 7));
+        Py_DECREF(vals);
+    }
+    PyDict_SetItemString(dict, "analysis", analysis);
+    PyDict_SetItemString(dict, "definition", definition);
+    PyDict_SetItemString(dict, "start", start);
+    PyDict_SetItemString(dict, "end", end);
+    PyDict_SetItemString(dict, "identity", identity);
+    PyDict_SetItemString(dict, "error", error);
+    PyDict_SetItemString(dict, "ambiguity", ambiguity);
+    PyDict_SetItemString(dict, "coverage", coverage);
+    Py_DECREF(analysis);
+    Py_DECREF(definition);
+    Py_DECREF(start);
+    Py_DECREF(end);
+    Py_DECREF(identity);
+    Py_DECREF(error);
+    Py_DECREF(ambiguity);
+    Py_DECREF(coverage);
+    $result  = dict;
+}
+
 %template(_IntVector) std::vector<int>;
 %template(_StringVector) std::vector<std::string>;
 %template(_SBOLObjectVector) std::vector<sbol::SBOLObject*>;
@@ -332,6 +440,11 @@
 %{
     consensus_sequence.thisown = False
 %}
+
+%pythonappend alignTarget
+%{
+    sequence.thisown = False
+%}
     
 /* @TODO remove methods should change thisown flag back to True */
 /* Currently this causes an exception (probably need a call to Py_INCREF */
@@ -391,13 +504,17 @@
 
 %pythonappend sbol::PartShop::sparqlQuery
 %{
-    return json.loads(val)
+    # The overload which fills a SPARQLResults table returns nothing
+    if val is not None:
+        return json.loads(val)
 %}
 
 %include "partshop.h"
     
 %include "document.h"
 
+%include "sequencefile.h"
+
 typedef std::string sbol::sbol_type;
 
 /* This macro is used to instantiate container properties (OwnedObjects) that can contain more than one type of object, eg, SequenceAnnotation::locations */
@@ -1141,6 +1258,62 @@ TEMPLATE_MACRO_3(Document);
     }
 }
 
+%extend sbol::SearchResults
+{
+    SearchResults* __iter__()
+    {
+        return $self;
+    }
+
+    Identified* __next__()
+    {
+        Identified* record = $self->next();
+        if (record == NULL)
+            throw SBOLError(END_OF_LIST, "");
+        return record;
+    }
+
+    %pythoncode %{
+    next = __next__
+    %}
+}
+
+%extend sbol::DerivationEnumerator
+{
+    unsigned long long __len__()
+    {
+        return $self->size();
+    }
+
+    DerivationEnumerator* __iter__()
+    {
+        $self->reset();
+        return $self;
+    }
+
+    ComponentDefinition* __next__()
+    {
+        return &$self->next();
+    }
+}
+
+// Deferral ends with the with-statement, since the destructor of a Python object may run much later
+%extend sbol::DeferredValidation
+{
+    DeferredValidation* __enter__()
+    {
+        return $self;
+    }
+
+    void __exit__(PyObject* exc_type, PyObject* exc_value, PyObject* traceback)
+    {
+        if (exc_type == Py_None)
+            $self->close();
+        else
+            $self->discard();
+    }
+}
+
 %extend sbol::Activity {
     %pythoncode %{
 
@@ -1529,6 +1702,54 @@ import json
 
     
     ModuleDefinition.applyToModuleHierarchy = applyToModuleHierarchy
+
+    def applyToUniqueComponentHierarchy(self, callback_fn = None, user_data = None):
+        # Like applyToComponentHierarchy, but a ComponentDefinition shared by several Components is visited only once
+        if not self.doc:
+            raise Exception('Cannot traverse Component hierarchy without a Document')
+
+        component_nodes = []
+        visited = set()
+        stack = [self]
+        while stack:
+            cdef = stack.pop()
+            if cdef.identity in visited:
+                continue
+            visited.add(cdef.identity)
+            component_nodes.append(cdef)
+            if callback_fn:
+                callback_fn(cdef, user_data)
+            for subc in reversed(list(cdef.components)):
+                if not self.doc.find(subc.definition):
+                    raise Exception(subc.definition + ' not found')
+                stack.append(self.doc.getComponentDefinition(subc.definition))
+        return component_nodes
+
+    ComponentDefinition.applyToUniqueComponentHierarchy = applyToUniqueComponentHierarchy
+
+    def applyToUniqueModuleHierarchy(self, callback_fn = None, user_data = None):
+        # Like applyToModuleHierarchy, but a ModuleDefinition shared by several Modules is visited only once
+        if not self.doc:
+            raise Exception('Cannot traverse Module hierarchy without a Document')
+
+        module_nodes = []
+        visited = set()
+        stack = [self]
+        while stack:
+            mdef = stack.pop()
+            if mdef.identity in visited:
+                continue
+            visited.add(mdef.identity)
+            module_nodes.append(mdef)
+            if callback_fn:
+                callback_fn(mdef, user_data)
+            for subm in reversed(list(mdef.modules)):
+                if not self.doc.find(subm.definition):
+                    raise Exception(subm.definition + ' not found')
+                stack.append(self.doc.getModuleDefinition(subm.definition))
+        return module_nodes
+
+    ModuleDefinition.applyToUniqueModuleHierarchy = applyToUniqueModuleHierarchy
     
     def testSBOL():
         """
@@ -4,6 +4,17 @@ import random
 import string
 import os, sys
 import tempfile, shutil
+import threading
+import hashlib
+import json, re, zlib
+try:
+    from http.server import HTTPServer, BaseHTTPRequestHandler
+    from socketserver import ThreadingMixIn
+    from urllib.parse import unquote
+except ImportError:
+    from BaseHTTPServer import HTTPServer, BaseHTTPRequestHandler
+    from SocketServer import ThreadingMixIn
+    from urllib import unquote
 
 #####################
 # utility functions
@@ -405,6 +416,85 @@ class TestAssemblyRoutines(unittest.TestCase):
         self.assertSequenceEqual(flattened_module_tree, expected_module_tree)
         self.assertEquals(level, 3)
 
+    def testApplyCallbackToUniqueHierarchy(self):
+        # Assemble a module hierarchy in which the leaf is shared by root and sub
+        doc = Document()
+        root = ModuleDefinition('root')
+        sub = ModuleDefinition('sub')
+        leaf = ModuleDefinition('leaf')
+        doc.addModuleDefinition([root, sub, leaf])
+        root.assemble([sub, leaf])
+        sub.assemble([leaf])
+
+        def callback(md, params):
+            params[0] += 1
+
+        params = [ 0 ]
+        flattened_module_tree = root.applyToModuleHierarchy(callback, params)
+        self.assertEquals(len(flattened_module_tree), 4)
+        self.assertEquals(params[0], 4)
+
+        params = [ 0 ]
+        flattened_module_tree = root.applyToUniqueModuleHierarchy(callback, params)
+        flattened_module_tree = [md.identity for md in flattened_module_tree]
+        expected_module_tree = [md.identity for md in [root, sub, leaf]]
+        self.assertSequenceEqual(flattened_module_tree, expected_module_tree)
+        self.assertEquals(params[0], 3)
+
+    def testEnumerateCombinatorialDerivation(self):
+        doc = Document()
+        template = ComponentDefinition('template')
+        promoter = ComponentDefinition('promoter')
+        cds = ComponentDefinition('cds')
+        doc.addComponentDefinition([template, promoter, cds])
+        template.assemblePrimaryStructure([promoter, cds])
+        variants = [ComponentDefinition('variant%d' % i) for i in range(3)]
+        doc.addComponentDefinition(variants)
+        derivation = CombinatorialDerivation('library')
+        doc.addCombinatorialDerivation(derivation)
+        derivation.masterTemplate = template.identity
+        promoter_variable = derivation.variableComponents.create('promoter_variable')
+        promoter_variable.variable = template.components[0].identity
+        promoter_variable.variants = [v.identity for v in variants]
+        cds_variable = derivation.variableComponents.create('cds_variable')
+        cds_variable.variable = template.components[1].identity
+        cds_variable.repeat = SBOL_REPEAT_ZERO_OR_ONE
+        cds_variable.variants = [variants[0].identity]
+
+        library = derivation.enumerate()
+        self.assertEqual(len(library), 6)
+        designs = [design for design in library]
+        self.assertEqual(len(designs), 6)
+        self.assertEqual(len(designs[0].components), 1)
+        self.assertEqual(len(designs[1].components), 2)
+        self.assertEqual(designs[5].components[0].definition, variants[2].identity)
+        self.assertEqual(designs[5].wasDerivedFrom[0], derivation.identity)
+        self.assertEqual(library.derive(5).identity, designs[5].identity)
+
+    def testCompileCombinatorialDerivation(self):
+        doc = Document()
+        template = ComponentDefinition('template')
+        doc.addComponentDefinition(template)
+        parts = []
+        for part_id, elements in [('prefix', 'aaa'), ('slot', 'c'), ('suffix', 'ttt')]:
+            part = ComponentDefinition(part_id)
+            doc.addComponentDefinition(part)
+            part.sequence = Sequence(part_id + '_seq', elements)
+            parts.append(part)
+        template.assemblePrimaryStructure(parts)
+        derivation = CombinatorialDerivation('library')
+        doc.addCombinatorialDerivation(derivation)
+        derivation.masterTemplate = template.identity
+        slot_variable = derivation.variableComponents.create('slot_variable')
+        slot_variable.variable = template.components[1].identity
+        for variant_id, elements in [('variant0', 'gg'), ('variant1', 'cc')]:
+            variant = ComponentDefinition(variant_id)
+            doc.addComponentDefinition(variant)
+            variant.sequence = Sequence(variant_id + '_seq', elements)
+            slot_variable.variants.add(variant.identity)
+        sequences = derivation.compile()
+        self.assertEqual([seq.elements for seq in sequences], ['aaaggttt', 'aaaccttt'])
+
 class TestSequences(unittest.TestCase):
 
     def setUp(self):
@@ -418,6 +508,32 @@ class TestSequences(unittest.TestCase):
 
         self.assertEqual(seq, 'ggctgca')
 
+    def testPackSequence(self):
+        test_seq = Sequence("R0010", "ggctgcaNNNNacgtRYac")
+        doc = Document()
+        doc.addSequence(test_seq)
+        test_seq.pack()
+        self.assertTrue(test_seq.isPacked())
+        self.assertEqual(test_seq.length(), 19)
+        self.assertEqual(test_seq.subsequence(6, 13), 'caNNNNac')
+        self.assertTrue(test_seq.isPacked())
+        self.assertEqual(test_seq.elements, 'ggctgcaNNNNacgtRYac')
+        self.assertFalse(test_seq.isPacked())
+
+    def testSequenceKernels(self):
+        test_seq = Sequence("R0010", "aacGTRyn-")
+        self.assertEqual(test_seq.reverseComplement(), '-nrYACgtt')
+        self.assertAlmostEqual(test_seq.gcContent(), 2.0 / 9)
+        self.assertTrue(test_seq.isValidIUPAC())
+        test_seq.elements = 'acgtx'
+        self.assertFalse(test_seq.isValidIUPAC())
+
+    def testAlignSequences(self):
+        alignment = align_sequences('aaaacccgggtttt', 'cccgagt')
+        self.assertEqual(alignment.score, 9)
+        self.assertEqual((alignment.target_start, alignment.target_end), (4, 11))
+        self.assertEqual((alignment.target, alignment.query), ('cccgggt', 'cccgagt'))
+
     def testRemoveSequence(self):
         test_seq = Sequence("R0010", "ggctgca")
         doc = Document()
@@ -731,6 +847,579 @@ class TestDBTL(unittest.TestCase):
         self.assertEquals(activity.agent.identity, activity.associations[0].agent)
         self.assertEquals(activity.plan.identity, activity.associations[0].plan)
 
+    def testReportQC(self):
+        doc = Document()
+        parts = []
+        for part_id, elements in [('part0', 'aaaaaggggg'), ('part1', 'cccccttttt')]:
+            part = ComponentDefinition(part_id)
+            doc.addComponentDefinition(part)
+            part.sequence = Sequence(part_id + '_seq', elements)
+            parts.append(part)
+        target = ComponentDefinition('target')
+        doc.addComponentDefinition(target)
+        target.assemblePrimaryStructure(parts)
+        target.compile()
+        design = doc.designs.create('design')
+        design.structure = target
+        build = doc.builds.create('build')
+        build.design = design.identity
+        test = doc.tests.create('test')
+        test.samples = [build.identity]
+        analysis = doc.analyses.create('analysis')
+        analysis.rawData = test.identity
+        analysis.verifyTarget(Sequence('consensus', 'aaataggggg' + 'cccnnttttt'))
+
+        report = analysis.reportQC()
+        self.assertEqual((report[target.identity]['start'], report[target.identity]['end']), (1, 20))
+        self.assertAlmostEqual(report[target.identity]['identity'], 0.85)
+        self.assertAlmostEqual(report[parts[0].identity]['error'], 0.1)
+        self.assertAlmostEqual(report[parts[1].identity]['ambiguity'], 0.2)
+        self.assertAlmostEqual(report[parts[1].identity]['coverage'], 1.0)
+        self.assertAlmostEqual(analysis.reportIdentity()[target.identity][2], report[target.identity]['identity'])
+
+        table = doc.reportQC([analysis.identity])
+        self.assertEqual(len(table['analysis']), 3)
+        i_row = table['definition'].index(target.identity)
+        self.assertEqual(table['analysis'][i_row], analysis.identity)
+        self.assertAlmostEqual(table['identity'][i_row], 0.85)
+
+    def testAlignTarget(self):
+        doc = Document()
+        parts = []
+        for part_id, elements in [('part0', 'aaaaaggggg'), ('part1', 'cccccttttt')]:
+            part = ComponentDefinition(part_id)
+            doc.addComponentDefinition(part)
+            part.sequence = Sequence(part_id + '_seq', elements)
+            parts.append(part)
+        target = ComponentDefinition('target')
+        doc.addComponentDefinition(target)
+        target.assemblePrimaryStructure(parts)
+        design = doc.designs.create('design')
+        design.structure = target
+        build = doc.builds.create('build')
+        build.design = design.identity
+        test = doc.tests.create('test')
+        test.samples = [build.identity]
+        analysis = doc.analyses.create('analysis')
+        analysis.rawData = test.identity
+
+        # The read is unaligned, covers bases 4-18 of the compiled target, and has a substitution at base 8
+        analysis.alignTarget(Sequence('read', 'aaggtggcccccttt'))
+        match = 'http://purl.obolibrary.org/obo/SO_0000347'
+        substitution = 'http://purl.obolibrary.org/obo/SO_1000002'
+        regions = sorted((sa.locations[0].start, sa.locations[0].end, sa.roles[0]) for sa in build.structure.sequenceAnnotations)
+        self.assertEqual(regions, [(4, 7, match), (8, 8, substitution), (9, 18, match)])
+        report = analysis.reportQC()
+        self.assertAlmostEqual(report[target.identity]['identity'], 0.7)
+        self.assertAlmostEqual(report[target.identity]['coverage'], 0.75)
+
+    def testProvenanceLineage(self):
+        doc = Document()
+        design = doc.designs.create('design')
+        build = doc.builds.create('build')
+        build.wasDerivedFrom = [design.identity]
+        assembly = doc.activities.create('assembly')
+        usage = assembly.usages.create('build_usage')
+        usage.entity = build.identity
+        usage.roles = [SBOL_BUILD]
+        clone = doc.builds.create('clone')
+        clone.wasGeneratedBy = assembly.identity
+
+        self.assertEqual(design.getDescendants(SBOL_IMPLEMENTATION), [build.identity, clone.identity])
+        self.assertEqual(clone.getAncestors(), [assembly.identity, build.identity, design.identity])
+        self.assertEqual(assembly.getDescendants(), [clone.identity])
+
+        # The index follows edits to the Document
+        redesign = doc.designs.create('redesign')
+        build.wasDerivedFrom = [redesign.identity]
+        self.assertEqual(design.getDescendants(), [])
+        self.assertEqual(redesign.getDescendants(SBOL_IMPLEMENTATION), [build.identity, clone.identity])
+
+class TestValidation(unittest.TestCase):
+
+    def setUp(self):
+        pass
+
+    def testLocalValidation(self):
+        doc = Document()
+        cd = doc.componentDefinitions.create('cd')
+        sub = doc.componentDefinitions.create('sub')
+        c = cd.components.create('c')
+        c.definition = sub.identity
+        self.assertEqual(len(validate_locally(doc)), 0)
+
+        # A ComponentDefinition which contains itself is reported without serializing the Document
+        c_self = sub.components.create('c_self')
+        c_self.definition = sub.identity
+        errors = validate_locally(doc)
+        self.assertEqual(len(errors), 1)
+        self.assertTrue(errors[0].startswith('sbol-10603'))
+
+        VALIDATE = Config.getOption('validate')
+        Config.setOption('validate', True)
+        Config.setOption('validator', 'local')
+        self.assertTrue(doc.validate().startswith('Invalid. sbol-10603'))
+        Config.setOption('validator', 'online')
+        Config.setOption('validate', VALIDATE)
+
+    def testValidateAll(self):
+        doc = Document()
+        for i in range(20):
+            doc.componentDefinitions.create('cd%d' % i)
+        activity = doc.activities.create('activity')
+        activity.startedAtTime = '2019-03-16T20:12:00Z'
+        self.assertEqual(doc.validateAll(4), [])
+
+        # Values which were never checked by a setter are reported with the rule they violate, rather than thrown
+        doc.componentDefinitions['cd3'].setPropertyValue(SBOL_DISPLAY_ID, '3cd')
+        activity.setPropertyValue(PROVO_STARTED_AT_TIME, 'yesterday')
+        diagnostics = doc.validateAll(4)
+        self.assertEqual(len(diagnostics), 2)
+        self.assertEqual(diagnostics[0][0], 'sbol-10204')
+        self.assertEqual(diagnostics[0][1], doc.componentDefinitions['cd3'].identity)
+        self.assertEqual(diagnostics[1][0], PROVO_STARTED_AT_TIME)
+        self.assertEqual(diagnostics, doc.validateAll(1))
+
+    def testDeferredValidation(self):
+        doc = Document()
+        activity = doc.activities.create('activity')
+
+        # Values are checked when the deferral ends, so an invalid intermediate value is not reported
+        with DeferredValidation(doc) as deferred:
+            activity.startedAtTime = 'yesterday'
+            activity.startedAtTime = '2019-03-16T20:12:00Z'
+            self.assertEqual(deferred.size(), 1)
+        with self.assertRaises(RuntimeError):
+            with DeferredValidation(doc):
+                activity.startedAtTime = 'yesterday'
+
+        # Once the deferral has ended, values are checked as they are set
+        with self.assertRaises(RuntimeError):
+            activity.startedAtTime = 'tomorrow'
+
+class TestSequenceFiles(unittest.TestCase):
+
+    def setUp(self):
+        self.path = tempfile.mkdtemp()
+
+    def tearDown(self):
+        shutil.rmtree(self.path)
+
+    def testFASTA(self):
+        fasta_path = os.path.join(self.path, 'records.fasta')
+        with open(fasta_path, 'w') as fasta:
+            fasta.write('>first A DNA record\nACGT\nTTGG\n>second\nMKVLA\n')
+        doc = Document()
+        doc.importFromFormat(fasta_path)
+        first = doc.componentDefinitions['first']
+        self.assertEqual(first.description, 'A DNA record')
+        self.assertEqual(doc.sequences.get(first.sequences[0]).elements, 'acgtttgg')
+        second = doc.componentDefinitions['second']
+        self.assertEqual(second.types, [BIOPAX_PROTEIN])
+
+        # Records are read one at a time, and written back in the same order
+        copy_path = os.path.join(self.path, 'copy.fasta')
+        reader = SequenceFileReader(fasta_path)
+        writer = SequenceFileWriter(copy_path, 'FASTA')
+        copy = Document()
+        cd = reader.next(copy)
+        while cd is not None:
+            writer.write(cd)
+            cd = reader.next(copy)
+        writer.close()
+        self.assertEqual(reader.size(), 2)
+        with open(copy_path) as fasta:
+            self.assertEqual(fasta.read(), '>first A DNA record\nacgtttgg\n>second\nMKVLA\n')
+
+    def testGenBank(self):
+        doc = Document()
+        cd = doc.componentDefinitions.create('plasmid')
+        cd.types = [BIOPAX_DNA, SO_CIRCULAR]
+        seq = doc.sequences.create('plasmid_sequence')
+        seq.elements = 'acgt' * 30
+        cd.sequences = [seq.identity]
+        promoter = cd.sequenceAnnotations.create('promoter')
+        promoter.roles = [SO_PROMOTER]
+        promoter.locations.createRange('range').end = 20
+        cds = cd.sequenceAnnotations.create('cds')
+        cds.roles = [SO_CDS]
+        cds.name = 'gfp'
+        for i_range, (start, end) in enumerate([(30, 50), (60, 80)]):
+            r = cds.locations.createRange('range%d' % i_range)
+            r.start = start
+            r.end = end
+            r.orientation = SBOL_ORIENTATION_REVERSE_COMPLEMENT
+        genbank_path = os.path.join(self.path, 'plasmid.gb')
+        doc.exportToFormat('GenBank', genbank_path)
+        with open(genbank_path) as genbank:
+            self.assertIn('complement(join(30..50,60..80))', genbank.read())
+
+        copy = Document()
+        copy.importFromFormat(genbank_path)
+        plasmid = copy.componentDefinitions['plasmid']
+        self.assertIn(SO_CIRCULAR, plasmid.types)
+        self.assertEqual(copy.sequences.get(plasmid.sequences[0]).elements, 'acgt' * 30)
+        self.assertEqual(len(plasmid.sequenceAnnotations), 2)
+        gfp = plasmid.sequenceAnnotations[1]
+        self.assertEqual(gfp.name, 'gfp')
+        self.assertEqual(gfp.roles, [SO_CDS])
+        self.assertEqual([(r.start, r.end) for r in gfp.locations], [(30, 50), (60, 80)])
+
+    def testSequencesAlone(self):
+        # Sequences which no ComponentDefinition refers to are written as records of their own
+        doc = Document()
+        cd = doc.componentDefinitions.create('part')
+        seq = doc.sequences.create('part_sequence')
+        seq.elements = 'acgt'
+        cd.sequences = [seq.persistentIdentity]
+        primer = doc.sequences.create('primer')
+        primer.elements = 'ggcc'
+        primer.description = 'A primer'
+        fasta_path = os.path.join(self.path, 'sequences.fasta')
+        doc.exportToFormat('FASTA', fasta_path)
+        with open(fasta_path) as fasta:
+            self.assertEqual(fasta.read(), '>part\nacgt\n>primer A primer\nggcc\n')
+
+class MockPartShopServer(ThreadingMixIn, HTTPServer):
+    daemon_threads = True
+
+class MockPartShopHandler(BaseHTTPRequestHandler):
+    # Serves the parts assigned to the server, keyed by displayId, over keep-alive connections
+    protocol_version = 'HTTP/1.1'
+
+    def setup(self):
+        BaseHTTPRequestHandler.setup(self)
+        self.server.n_connections += 1
+
+    def do_GET(self):
+        # Parts are keyed by the path which precedes the /sbol or /sbolnr endpoint
+        self.server.requests.append(self.path)
+        if self.path.startswith('/remoteSearch/'):
+            # Search records are the parts, in order of displayId
+            query = unquote(self.path)
+            offset = int(re.search('offset=([0-9]+)', query).group(1))
+            limit = int(re.search('limit=([0-9]+)', query).group(1))
+            records = [{'uri': self.server.url + '/' + display_id, 'displayId': display_id, 'name': '', 'description': '', 'version': ''} for display_id in sorted(self.server.parts)]
+            body = json.dumps(records[offset:offset + limit]).encode('utf-8')
+            self.send_response(200)
+            self.send_header('Content-Length', str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+            return
+        if self.path.startswith('/sparql?') and self.server.sparql is not None:
+            # A response given by the test is sent a byte at a time, and is cut short if fewer bytes are to be sent
+            status, body, n_sent = self.server.sparql
+            self.send_response(status)
+            self.send_header('Content-Type', 'application/sparql-results+json')
+            self.send_header('Content-Length', str(len(body)))
+            self.end_headers()
+            for i in range(min(n_sent, len(body))):
+                self.wfile.write(body[i:i + 1])
+                self.wfile.flush()
+            self.close_connection = n_sent < len(body)
+            return
+        if self.path.startswith('/sparql?'):
+            # Every query is answered with the identity and displayId of each part
+            bindings = [{'part': {'type': 'uri', 'value': self.server.url + '/' + display_id}, 'displayId': {'type': 'literal', 'value': display_id}} for display_id in sorted(self.server.parts)]
+            body = json.dumps({'head': {'vars': ['part', 'displayId']}, 'results': {'bindings': bindings}}).encode('utf-8')
+            self.send_response(200)
+            self.send_header('Content-Type', 'application/sparql-results+json')
+            self.send_header('Content-Length', str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+            return
+        display_id = self.path.rsplit('/', 1)[0].lstrip('/')
+        if self.path.endswith('/download') and display_id in self.server.attachments:
+            body = self.server.attachments[display_id]
+            self.send_response(200)
+            self.send_header('Content-Disposition', 'attachment; filename="%s"' % self.server.filenames.get(display_id, display_id))
+            self.send_header('Content-Length', str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+            return
+        if display_id not in self.server.parts:
+            self.send_response(404)
+            self.send_header('Content-Length', '0')
+            self.end_headers()
+            return
+        body = self.server.parts[display_id].encode('utf-8')
+        etag = '"%d"' % hash(body)
+        if self.headers.get('If-None-Match') == etag:
+            self.server.n_not_modified += 1
+            self.send_response(304)
+            self.send_header('ETag', etag)
+            self.send_header('Content-Length', '0')
+            self.end_headers()
+            return
+        self.send_response(200)
+        self.send_header('ETag', etag)
+        self.send_header('Content-Type', 'application/rdf+xml')
+        self.send_header('Content-Length', str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def do_POST(self):
+        # A submitted Document is streamed, so its body is chunked
+        self.server.requests.append(self.path)
+        if self.headers.get('Transfer-Encoding', '').lower() == 'chunked':
+            body = b''
+            while True:
+                size = int(self.rfile.readline().split(b';')[0], 16)
+                body += self.rfile.read(size)
+                self.rfile.readline()
+                if size == 0:
+                    break
+        else:
+            body = self.rfile.read(int(self.headers.get('Content-Length', '0')))
+        if self.path != '/submit':
+            self.send_response(404)
+            self.send_header('Content-Length', '0')
+            self.end_headers()
+            return
+
+        # The file part of the multipart form is recorded, decompressed if it was compressed
+        boundary = b'--' + self.headers.get('Content-Type').split('boundary=')[1].encode('utf-8')
+        file_part = [part for part in body.split(boundary) if b'name="file"' in part.split(b'\r\n\r\n', 1)[0]][0]
+        head, content = file_part.split(b'\r\n\r\n', 1)
+        content = content[:-2]  # The line break which precedes the next boundary
+        if b'application/gzip' in head:
+            content = zlib.decompress(content, 16 + zlib.MAX_WBITS)
+        self.server.submissions.append(content)
+        reply = b'Successfully uploaded'
+        self.send_response(200)
+        self.send_header('Content-Length', str(len(reply)))
+        self.end_headers()
+        self.wfile.write(reply)
+
+    def log_message(self, format, *args):
+        pass
+
+class TestPartShop(unittest.TestCase):
+    def setUp(self):
+        self.server = MockPartShopServer(('127.0.0.1', 0), MockPartShopHandler)
+        self.server.parts = {}
+        for i in range(5):
+            doc = Document()
+            doc.componentDefinitions.create('cd%d' % i)
+            self.server.parts['cd%d' % i] = doc.writeString()
+        self.server.n_connections = 0
+        self.server.n_not_modified = 0
+        self.server.requests = []
+        self.server.attachments = {}
+        self.server.filenames = {}
+        self.server.sparql = None
+        self.server.submissions = []
+        self.thread = threading.Thread(target=self.server.serve_forever)
+        self.thread.daemon = True
+        self.thread.start()
+        self.url = 'http://127.0.0.1:%d' % self.server.server_address[1]
+        self.server.url = self.url
+
+    def testConnectionReuse(self):
+        # Consecutive requests from a PartShop reuse one keep-alive connection
+        shop = PartShop(self.url)
+        for i in range(10):
+            doc = Document()
+            shop.pull(self.url + '/cd0', doc)
+            self.assertEqual(len(doc.componentDefinitions), 1)
+        self.assertEqual(self.server.n_connections, 1)
+
+    def testConcurrentPull(self):
+        Config.setOption('max_parallel_requests', '2')
+        shop = PartShop(self.url)
+        doc = Document()
+        shop.pull([self.url + '/cd%d' % i for i in range(5)], doc)
+        self.assertEqual(len(doc.componentDefinitions), 5)
+        self.assertLessEqual(self.server.n_connections, 2)
+
+        # A failed request leaves the Document unchanged
+        doc = Document()
+        with self.assertRaises(RuntimeError):
+            shop.pull([self.url + '/cd0', self.url + '/missing'], doc)
+        self.assertEqual(len(doc.componentDefinitions), 0)
+
+    def testCache(self):
+        cache_dir = tempfile.mkdtemp()
+        Config.setOption('cache_dir', cache_dir)
+        shop = PartShop(self.url)
+        doc = Document()
+        shop.pull(self.url + '/cd0', doc)
+        self.assertEqual(self.server.n_not_modified, 0)
+
+        # A cached response is revalidated rather than downloaded again
+        doc = Document()
+        shop.pull(self.url + '/cd0', doc)
+        self.assertEqual(self.server.n_not_modified, 1)
+        self.assertEqual(len(doc.componentDefinitions), 1)
+
+        # Cached responses are available offline, even when the server has gone
+        self.server.shutdown()
+        self.server.server_close()
+        Config.setOption('offline', True)
+        doc = Document()
+        shop.pull(self.url + '/cd0', doc)
+        self.assertEqual(len(doc.componentDefinitions), 1)
+        with self.assertRaises(RuntimeError):
+            shop.pull(self.url + '/cd1', doc)
+        shutil.rmtree(cache_dir)
+
+    def testSharedCache(self):
+        # The journal is not compacted over records which another process appended to it
+        cache_dir = tempfile.mkdtemp()
+        Config.setOption('cache_dir', cache_dir)
+        shop = PartShop(self.url)
+        shop.pull(self.url + '/cd0', Document())
+        record = 'S\tother\tother.cache\t5\t\t\t\n'
+        with open(os.path.join(cache_dir, 'journal.tsv'), 'a') as journal:
+            journal.write(record)
+        del shop
+        with open(os.path.join(cache_dir, 'journal.tsv')) as journal:
+            self.assertIn(record, journal.read())
+        shutil.rmtree(cache_dir)
+
+    def testDownloadAttachment(self):
+        # Binary files are written to disk intact, and checksummed as they arrive
+        data = bytes(bytearray(range(256))) * 1000
+        self.server.attachments['data.bin'] = data
+        shop = PartShop(self.url)
+        path = tempfile.mkdtemp()
+        checksum = shop.downloadAttachment(self.url + '/data.bin', path)
+        with open(os.path.join(path, 'data.bin'), 'rb') as f:
+            self.assertEqual(f.read(), data)
+        self.assertEqual(checksum, hashlib.sha1(data).hexdigest())
+        with self.assertRaises(RuntimeError):
+            shop.downloadAttachment(self.url + '/data.bin', path, '0' * 40)
+        self.assertFalse(os.path.exists(os.path.join(path, 'data.bin')))
+        shutil.rmtree(path)
+
+    def testDownloadAttachmentName(self):
+        # A file name chosen by the server cannot place the file outside the target directory
+        self.server.attachments['data.bin'] = b'data'
+        path = tempfile.mkdtemp()
+        target = os.path.join(path, 'target')
+        os.mkdir(target)
+        shop = PartShop(self.url)
+        self.server.filenames['data.bin'] = '../escaped.bin'
+        shop.downloadAttachment(self.url + '/data.bin', target)
+        self.assertFalse(os.path.exists(os.path.join(path, 'escaped.bin')))
+        self.assertTrue(os.path.exists(os.path.join(target, 'escaped.bin')))
+
+        # A name which is not a file name is replaced by one taken from the attachment URI
+        self.server.filenames['data.bin'] = '..'
+        shop.downloadAttachment(self.url + '/data.bin', target)
+        self.assertTrue(os.path.isdir(target))
+        self.assertTrue(os.path.exists(os.path.join(target, 'data.bin')))
+        shutil.rmtree(path)
+
+    def testSubmit(self):
+        # A Document is streamed to the server, compressed or not, and arrives intact
+        doc = Document()
+        doc.displayId = 'submission'
+        doc.name = 'submission'
+        doc.description = 'A streamed submission'
+        for i in range(3):
+            doc.componentDefinitions.create('part%d' % i)
+        shop = PartShop(self.url)
+        for compress in (False, True):
+            Config.setOption('compress_submissions', compress)
+            self.assertEqual(shop.submit(doc), 'Successfully uploaded')
+            received = Document()
+            received.readString(self.server.submissions[-1].decode('utf-8'))
+            self.assertEqual(sorted(cd.displayId for cd in received.componentDefinitions), ['part0', 'part1', 'part2'])
+        self.assertEqual(len(self.server.submissions), 2)
+
+    def testIncrementalPull(self):
+        # A design with one sub-part, each served without its dependencies
+        setHomespace(self.url)
+        Config.setOption('sbol_typed_uris', False)
+        doc = Document()
+        sub = doc.componentDefinitions.create('sub')
+        self.server.parts['sub'] = doc.writeString()
+        doc = Document()
+        root = doc.componentDefinitions.create('root')
+        root.components.create('c').definition = self.url + '/sub'
+        self.server.parts['root'] = doc.writeString()
+
+        Config.setOption('incremental_pull', True)
+        shop = PartShop(self.url)
+        doc = Document()
+        shop.pull(self.url + '/root', doc)
+        self.assertEqual(len(doc.componentDefinitions), 2)
+        self.assertEqual(self.server.requests, ['/root/sbolnr', '/sub/sbolnr'])
+
+        # Sub-parts which the Document already contains are not retrieved again
+        self.server.requests = []
+        doc = Document()
+        shop.pull(self.url + '/sub', doc, False)
+        shop.pull(self.url + '/root', doc)
+        self.assertEqual(len(doc.componentDefinitions), 2)
+        self.assertEqual(self.server.requests, ['/sub/sbolnr', '/root/sbolnr'])
+
+    def testSearchResults(self):
+        # Pages are requested until a short page arrives
+        shop = PartShop(self.url)
+        results = SearchResults(shop, 'cd', SBOL_COMPONENT_DEFINITION, 0, 2)
+        self.assertEqual([record.displayId for record in results], ['cd%d' % i for i in range(5)])
+        self.assertEqual(len(self.server.requests), 3)
+
+        # An advanced search starts from the offset of the query
+        self.server.requests = []
+        q = SearchQuery(SBOL_COMPONENT_DEFINITION, 1, 3)
+        q['name'] = 'cd'
+        results = SearchResults(shop, q)
+        self.assertEqual([record.displayId for record in results], ['cd%d' % i for i in range(1, 5)])
+        self.assertEqual(len(self.server.requests), 2)
+
+    def testSparqlResults(self):
+        shop = PartShop(self.url)
+        query = 'SELECT ?part ?displayId WHERE { ?part sbol:displayId ?displayId }'
+        results = SPARQLResults()
+        shop.sparqlQuery(query, results)
+        self.assertEqual(list(results.variables), ['part', 'displayId'])
+        self.assertEqual(results.size(), 5)
+        self.assertEqual(results.get('displayId', 2), 'cd2')
+        self.assertEqual(results.get('part', 2), self.url + '/cd2')
+
+        # The raw response is still available
+        response = shop.sparqlQuery(query)
+        self.assertEqual(len(response['results']['bindings']), 5)
+
+    def testSparqlStream(self):
+        # Escapes are decoded however the response is split, including surrogate pairs
+        shop = PartShop(self.url)
+        query = 'SELECT ?name WHERE { ?part dcterms:title ?name }'
+        body = b'{"head": {"vars": ["name"]}, "results": {"bindings": [' \
+               b'{"name": {"type": "literal", "value": "caf\\u00e9 \\ud83e\\uddec"}}, ' \
+               b'{"name": {"type": "literal", "value": "a \\"quoted\\"\\tname\\\\"}}]}}'
+        self.server.sparql = (200, body, len(body))
+        results = SPARQLResults()
+        shop.sparqlQuery(query, results)
+        self.assertEqual(results.size(), 2)
+        self.assertEqual(results.get('name', 0), u'caf\u00e9 \U0001f9ec')
+        self.assertEqual(results.get('name', 1), 'a "quoted"\tname\\')
+
+        # An error response is reported with its body
+        self.server.sparql = (400, b'Malformed query', 15)
+        with self.assertRaises(RuntimeError) as context:
+            shop.sparqlQuery(query, results)
+        self.assertIn('Malformed query', str(context.exception))
+
+        # A response which is cut short is an error, not a partial result
+        self.server.sparql = (200, body, len(body) // 2)
+        with self.assertRaises(RuntimeError):
+            shop.sparqlQuery(query, SPARQLResults())
+
+    def tearDown(self):
+        setHomespace('http://examples.org')
+        Config.setOption('sbol_typed_uris', True)
+        Config.setOption('incremental_pull', False)
+        Config.setOption('max_parallel_requests', '8')
+        Config.setOption('cache_dir', '')
+        Config.setOption('offline', False)
+        Config.setOption('compress_submissions', False)
+        self.server.shutdown()
+        self.server.server_close()
+
 class TestURIAutoConstruction(unittest.TestCase):
     def setUp(self):
         pass
@@ -806,7 +1495,7 @@ class TestURIAutoConstruction(unittest.TestCase):
         Config.setOption('sbol_compliant_uris', True)
         Config.setOption('sbol_typed_uris', True)
 
-def runTests(test_list = [TestComponentDefinitions, TestSequences, TestMemory, TestIterators, TestCopy, TestDBTL, TestAssemblyRoutines, TestExtensionClass, TestURIAutoConstruction ]):
+def runTests(test_list = [TestComponentDefinitions, TestSequences, TestMemory, TestIterators, TestCopy, TestDBTL, TestAssemblyRoutines, TestExtensionClass, TestURIAutoConstruction, TestValidation, TestSequenceFiles, TestPartShop ]):
     VALIDATE = Config.getOption('validate')
     Config.setOption('validate', False)
 